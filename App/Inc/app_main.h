@@ -15,6 +15,7 @@ void App_Init(void);
 // Task Loops
 void App_ControlLoop(void); // High Priority
 void App_OCPPLoop(void);    // Normal Priority
+void App_CANLoop(void);     // Highest Priority (Deferred CAN RX)
 
 #ifdef __cplusplus
 }
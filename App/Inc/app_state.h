@@ -3,12 +3,17 @@
  * @brief   Core EVSE State Machine Definitions
  * @author  Antigravity
  * @date    2026-01-31
+ *
+ * @note    One state machine per connector (EVSE_CONNECTOR_COUNT), driven
+ *          by its own SECC link, contactors, meter and power regulator. The
+ *          status LED follows the connector in the most urgent state.
  */
 
 #ifndef APP_APP_STATE_H_
 #define APP_APP_STATE_H_
 
 #include "main.h" // For HAL types if needed
+#include "evse_connector.h"
 #include <stdbool.h>
 
 // System States
@@ -28,22 +33,33 @@ typedef enum
 void StateMachine_Init(void);
 
 /**
- * @brief Main Loop for the State Machine (Non-blocking)
+ * @brief Main Loop for the State Machines (Non-blocking, every connector)
  */
 void StateMachine_Loop(void);
 
 /**
  * @brief Force a state transition (Debug/CLI use)
+ * @param conn Connector index
  * @param new_state Target state
  */
-void StateMachine_SetState(EVSE_State_t new_state);
+void StateMachine_SetState(uint8_t conn, EVSE_State_t new_state);
 
 /**
- * @brief Attempt to clear FAULT state.
+ * @brief Attempt to clear FAULT state of a connector.
  *        Checks safety conditions first.
  * @return true if cleared, false if safety still active
  */
-bool StateMachine_TryClearFault(void);
+bool StateMachine_TryClearFault(uint8_t conn);
+
+/**
+ * @brief Get current state of a connector
+ */
+EVSE_State_t StateMachine_GetState(uint8_t conn);
+
+/**
+ * @brief Any connector in PRECHARGE or CHARGING (fast measurement polls)
+ */
+bool StateMachine_IsSessionActive(void);
 
 /**
  * @brief Get current state name as string
@@ -53,15 +69,17 @@ const char* StateMachine_GetStateName(EVSE_State_t state);
 
 /**
  * @brief Handle Remote Start Transaction from OCPP
+ * @param conn Connector index
  * @param id_tag Authorization Tag
  * @return true if accepted, false if rejected
  */
-bool StateMachine_RemoteStart(const char* id_tag);
+bool StateMachine_RemoteStart(uint8_t conn, const char* id_tag);
 
 /**
  * @brief Handle Remote Stop Transaction from OCPP
+ * @param conn Connector index
  * @return true if accepted
  */
-bool StateMachine_RemoteStop(void);
+bool StateMachine_RemoteStop(uint8_t conn);
 
 #endif /* APP_APP_STATE_H_ */
@@ -2,17 +2,28 @@
 #include "main.h"
 #include "usart.h" 
 #include "fdcan.h"
+#include "tim.h"
 #include "cmsis_os.h"
 #include "uart_driver.h"
 #include "can_driver.h"
+#include "can_health.h"
+#include "can_sched.h"
+#include "recorder.h"
+#include "uds.h"
+#include "can_gateway.h"
 #include "control_pilot.h"
 #include "relay_driver.h"
 #include "safety_monitor.h"
 #include "secc_driver.h"
+#include "crc_service.h"
+#include "modbus_master.h"
 #include "meter_driver.h"
 #include "watchdog_driver.h"
 #include "config_manager.h"
 #include "infy_power.h"
+#include "power_reg.h"
+#include "power_alloc.h"
+#include "thermal_derate.h"
 #include "imd_driver.h"
 #include "ocpp_app.h"
 #include "cli.h"
@@ -20,12 +31,20 @@
 #include "logger.h" // For Async Logging
 #include <stdio.h>
 
+_Static_assert(PREG_PERIOD_MS == CAN_HEALTH_PERIOD_MS, "The regulator is ticked with the CAN health process");
+
 
 void App_Init(void)
 {
     // Initialize UART CLI (Targeting USART2 - Virtual COM)
     UART_CLI_Init(&huart2);
 
+    // Initialize 64-bit us Timebase (TIM3, also FDCAN timestamp source)
+    Timebase_Init(&htim3);
+
+    // Initialize CRC Service (CRC unit; Modbus, config record, UDS images)
+    Crc_Init();
+
     // Initialize FDCAN Driver (FDCAN1 - SECC)
     CAN_Driver_Init(&hfdcan1);
 
@@ -35,6 +54,9 @@ void App_Init(void)
     // Initialize FDCAN Driver (FDCAN3 - IMD)
     CAN_Driver_Init(&hfdcan3);
 
+    // Initialize Traffic Recorder (CAN taps, Modbus, OCPP)
+    Recorder_Init();
+
     // Initialize Control Pilot (PWM/ADC)
     CP_Init();
 
@@ -45,11 +67,17 @@ void App_Init(void)
     Safety_Init();
     
     // Initialize SECC (CAN Protocol - FDCAN1)
+    // Note: SECC/Infy/IMD Init register their own CAN ID routes (HW filters)
     SECC_Init(&hfdcan1);
-    
-    // Register Dispatcher for CAN Rx
-    void App_RxDispatcher(uint32_t id, uint8_t *data, uint8_t len); // Forward declaration
-    CAN_SetRxCallback(App_RxDispatcher);
+
+    // Initialize UDS Diagnostic Server (ISO-TP on FDCAN1)
+    UDS_Init(&hfdcan1);
+
+    // Initialize Modbus RTU Master (RS-485 on USART3, run by the control task)
+    Modbus_Init(&huart3);
+
+    // Initialize DC Meters (Polls of the Modbus master)
+    Meter_Init();
 
     // Initialize Command Line Interface
     CLI_Init();
@@ -60,9 +88,21 @@ void App_Init(void)
     // Initialize Config
     Config_Init();
 
+    // Initialize CAN-UDP Gateway (CAN tap; W5500 socket opened by the OCPP task)
+    Gateway_Init();
+
     // Initialize Power Module (FDCAN2)
     Infy_Init(&hfdcan2);
 
+    // Initialize DC Output Regulator (Ticked by the CAN task)
+    PowerReg_Init();
+
+    // Initialize Thermal Derating (Evaluated by the CAN task, limits the regulator)
+    Thermal_Init();
+
+    // Initialize Module Allocation Matrix (Groups -> Connectors, CAN task)
+    PowerAlloc_Init();
+
     // Initialize IMD (FDCAN3 - Independent Bus)
     IMD_Init(&hfdcan3);
 
@@ -72,6 +112,9 @@ void App_Init(void)
     // Initialize State Machine
     StateMachine_Init();
 
+    // Start CAN TX Scheduler (SECC/Infy declared their frames above)
+    CAN_Sched_Start();
+
     Logger_Print("[App] Initialization Complete. Tasks Starting...\r\n");
 }
 
@@ -79,6 +122,8 @@ void App_Init(void)
 void App_ControlLoop(void)
 {
     // --- Control Loop (High Priority, Non-Blocking) ---
+    Safety_SetNotifyThread(osThreadGetId());
+
     while (1)
     {
         // 1. Critical Safety & Watchdog
@@ -90,44 +135,89 @@ void App_ControlLoop(void)
         // 3. Execute State Machine Logic (Safety Check Inside)
         StateMachine_Loop();
 
-        // 4. SECC Communication (50ms interval)
-        static uint32_t last_secc_tx = 0;
-        if ((HAL_GetTick() - last_secc_tx) >= 50)
+        // 4. SECC Tx Snapshots (Frames are sent by the CAN TX scheduler)
+        Infy_SystemStatus_t pwr;
+        Infy_GetSystemStatus(&pwr);
+        for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
         {
-            float cp_v = CP_ReadVoltage();
-            // PWM Duty: Need getter, for now hardcode logic or 0
-            // Relay:
-            uint8_t relays = Relay_GetState();
-            // Fault: 
-            // 0 for now
-            SECC_TxStatus(cp_v, 0, relays, 0); 
-            
-            // 4. Meter Values (Every 4th cycle = 200ms) -> Too fast for OCPP
-            // Let's use a separate counter for OCPP (e.g. 5 seconds)
-            static uint32_t last_ocpp_meter = 0;
-            if ((HAL_GetTick() - last_ocpp_meter) >= 5000)
-            {
-                // Real Meter Values
-                OCPP_SendMeterValues(1, Meter_ReadEnergy(), Meter_ReadPower(), (int)Meter_ReadTemperature());
-
-                last_ocpp_meter = HAL_GetTick();
-            }
+            Infy_OutletStatus_t out;
+            Infy_GetOutletStatus(c, &out);
+            SECC_TxData_t tx = {0};
+
+            tx.cp_volts = CP_ReadVoltage(c);
+            // PWM Duty: Need getter, for now 0
+            tx.pwm_duty = 0;
+            tx.relay_state = Relay_GetState(c);
+            // Fault: 0 for now
+            tx.err_code = 0;
+            tx.ac_volts = Meter_ReadVoltage(c);
+            tx.ac_amps = Meter_ReadCurrent(c);
+            tx.temp_c = Thermal_GetTemperature(c);
+            tx.dc_volts = out.voltage;
+            tx.dc_amps = out.current;
+            tx.active_modules = (uint8_t)out.alive_modules;
+            tx.power_fault = (pwr.fault_mask & out.modules) != 0;
+
+            SECC_SetTxData(c, &tx);
+        }
 
-            static uint8_t meter_prescaler = 0;
-            if (++meter_prescaler >= 4)
+        // Meter Values to OCPP -> Separate counter (e.g. 5 seconds)
+        static uint32_t last_ocpp_meter = 0;
+        if ((HAL_GetTick() - last_ocpp_meter) >= 5000)
+        {
+            // Real Meter Values (connectors with a transaction)
+            for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
             {
-                SECC_TxMeter(Meter_ReadVoltage(), Meter_ReadCurrent(), Meter_ReadTemperature());
-                meter_prescaler = 0;
+                OCPP_SendMeterValues(EVSE_CONNECTOR_ID(c), Meter_ReadEnergy(c), Meter_ReadPower(c), (int)Thermal_GetTemperature(c));
             }
-            
-            last_secc_tx = HAL_GetTick();
+
+            last_ocpp_meter = HAL_GetTick();
         }
 
-        // Periodic Meter Processing (Modbus State Machine - Call Frequently)
+        // Modbus Master (Meter polls: fast while a connector is in a session)
+        Modbus_SetRate(StateMachine_IsSessionActive() ? MODBUS_RATE_ACTIVE : MODBUS_RATE_IDLE);
+        Modbus_Process();
         Meter_Process();
 
 
-        osDelay(10); // Maintain OS responsiveness (10ms tick)
+        // 10ms cycle, cut short by an urgent CAN event (IMD fault, SECC stop)
+        osThreadFlagsWait(SAFETY_THREAD_FLAG, osFlagsWaitAny, 10);
+    }
+}
+
+void App_CANLoop(void)
+{
+    // --- CAN RX Loop (Highest Priority, Woken by FDCAN ISR) ---
+    CAN_SetRxThread(osThreadGetId());
+    uint32_t last_health = HAL_GetTick();
+
+    while (1)
+    {
+        // Sleep until the ISR queues a frame (or the next health tick is due),
+        // 1 ms while an ISO-TP transfer is paced by STmin / queue room
+        uint32_t elapsed = HAL_GetTick() - last_health;
+        uint32_t wait = (elapsed < CAN_HEALTH_PERIOD_MS) ? (CAN_HEALTH_PERIOD_MS - elapsed) : 0;
+        if (UDS_IsBusy() && wait > 1) wait = 1;
+        osThreadFlagsWait(CAN_RX_THREAD_FLAG, osFlagsWaitAny, wait);
+
+        // Decode all queued frames (SECC, Infy, IMD, UDS) outside interrupt context
+        CAN_ProcessRx();
+
+        // UDS: pending consecutive frames, session timeout
+        UDS_Process();
+
+        // Bus-off recovery, TEC/REC snapshot, load window, power module timeouts,
+        // thermal derating, DC regulator step: fixed rate (a late tick does not shift the next)
+        if ((HAL_GetTick() - last_health) >= CAN_HEALTH_PERIOD_MS)
+        {
+            CAN_Health_Process();
+            PowerAlloc_Process();
+            Infy_Process();
+            Thermal_Process();
+            PowerReg_Tick();
+            last_health += CAN_HEALTH_PERIOD_MS;
+            if ((HAL_GetTick() - last_health) >= CAN_HEALTH_PERIOD_MS) last_health = HAL_GetTick(); // Overrun: no burst
+        }
     }
 }
 
@@ -139,31 +229,10 @@ void App_OCPPLoop(void)
         // Process OCPP (TCP/TLS connect may block here)
         OCPP_Process();
 
+        // CAN-UDP Gateway (Shares the W5500 with OCPP)
+        Gateway_Process();
+
         // Short delay to yield if idle
         osDelay(10); 
     }
 }
-
-/**
- * @brief Top-level CAN Rx Dispatcher
- * @note  Routes messages to specific modules based on CAN ID.
- */
-void App_RxDispatcher(uint32_t id, uint8_t *data, uint8_t len)
-{
-    // SECC Range Check (Assumed Single ID for now, but safer to dispatch specific ID)
-    if (id == SECC_CAN_ID_RX_CMD) 
-    {
-        SECC_RxHandler(id, data, len);
-    }
-    // Infy Power Module Range Check
-    // Range: 0x18005001 ~ 0x1800500A (Base + 1..Max)
-    else if (id > INFY_CAN_ID_CONTROL_BASE && id <= (INFY_CAN_ID_CONTROL_BASE + INFY_MAX_MODULES))
-    {
-        Infy_RxHandler(id, data, len);
-    }
-    // IMD Message Check
-    else if (id == IMD_CAN_ID_TX_INFO)
-    {
-        IMD_RxHandler(id, data, len);
-    }
-}
@@ -10,38 +10,94 @@
 #include "control_pilot.h"
 #include "safety_monitor.h"
 #include "infy_power.h"
+#include "power_reg.h"
 #include "ocpp_app.h" // For Auto-Stop
 #include "meter_driver.h" // For Welding Check
 #include <stdio.h>      // For printf
 #include <math.h>       // For fabsf
 
+#define DC_MAX_VOLTAGE       1000.0f // Charger output limit (V)
+#define PRECHARGE_CURRENT_A  2.0f    // Soft-start current limit (voltage ramped by the regulator)
+
+// Per Connector Context
+typedef struct
+{
+    EVSE_State_t state;
+    uint32_t precharge_tick;
+    uint32_t high_v_tick;          // Welding check: open relays with voltage since
+    // DC Fast Path: demand frames drive the power regulator from the SECC RX ISR
+    // while charging with the main relay closed (the loop arms it every pass)
+    volatile bool demand_armed;
+} StateMachine_Conn_t;
+
 // Internal Variables
-static EVSE_State_t current_state = STATE_BOOT;
+static StateMachine_Conn_t sm[EVSE_CONNECTOR_COUNT];
+static EVSE_State_t led_state = STATE_BOOT; // State the LED shows
 static uint32_t last_led_tick = 0;
 static uint32_t led_interval = 500; // Default blink interval (ms)
-static uint32_t precharge_tick = 0;
 
-// Charging Sequence Variables - REMOVED (AC/Standalone Logic Deleted) 
+static void StateMachine_OnDemand(uint8_t conn, uint64_t rx_us);
+
+// Charging Sequence Variables - REMOVED (AC/Standalone Logic Deleted)
 
 void StateMachine_Init(void)
 {
     printf("[State] Initializing... Set to BOOT\r\n");
-    // Ensure relays are open
-    Relay_SetMain(false);
-    Relay_SetPrecharge(false);
-    
-    StateMachine_SetState(STATE_BOOT);
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        // Ensure relays are open
+        Relay_SetMain(c, false);
+        Relay_SetPrecharge(c, false);
+
+        sm[c].demand_armed = false;
+        sm[c].high_v_tick = 0;
+    }
+    SECC_SetDemandHandler(StateMachine_OnDemand);
+
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        StateMachine_SetState(c, STATE_BOOT);
+    }
+}
+
+// Setpoint from the SECC DC demand, clamped to the EV and charger limits (task or ISR)
+static void StateMachine_DemandSetpoint(uint8_t conn, float *volts, float *amps)
+{
+    const SECC_Control_t *ctl = &secc_control[conn];
+    float v = ctl->ev_target_voltage;
+    float i = ctl->ev_target_current;
+
+    if (ctl->ev_max_voltage > 0.0f && v > ctl->ev_max_voltage) v = ctl->ev_max_voltage;
+    if (v > DC_MAX_VOLTAGE) v = DC_MAX_VOLTAGE;
+    if (ctl->ev_max_current > 0.0f && i > ctl->ev_max_current) i = ctl->ev_max_current;
+    if (i < 0.0f) i = 0.0f;
+    if (v < 10.0f) v = 350.0f; // Default if 0
+
+    *volts = v;
+    *amps = i;
 }
 
-bool StateMachine_TryClearFault(void)
+// SECC demand / limits frame (FDCAN1 line 1 ISR): setpoint on FDCAN2 now
+static void StateMachine_OnDemand(uint8_t conn, uint64_t rx_us)
 {
-    if (Safety_Check() == SAFETY_OK)
+    if (conn >= EVSE_CONNECTOR_COUNT || !sm[conn].demand_armed || !secc_control[conn].allow_power) return;
+
+    float target_v, target_i;
+    StateMachine_DemandSetpoint(conn, &target_v, &target_i);
+    PowerReg_SetTargetFast(conn, target_v, target_i, rx_us);
+}
+
+bool StateMachine_TryClearFault(uint8_t conn)
+{
+    if (conn >= EVSE_CONNECTOR_COUNT) return false;
+
+    if (Safety_Check(conn) == SAFETY_OK)
     {
-        printf("[State] Fault Cleared by User.\r\n");
-        StateMachine_SetState(STATE_STANDBY);
-        
+        printf("[State] Connector %d Fault Cleared by User.\r\n", conn + 1);
+        StateMachine_SetState(conn, STATE_STANDBY);
+
         // Notify OCPP Status
-        // OCPP_SendStatusNotification(1, "Available", "NoError"); 
+        // OCPP_SendStatusNotification(EVSE_CONNECTOR_ID(conn), "Available", "NoError");
         return true;
     }
     else
@@ -51,267 +107,349 @@ bool StateMachine_TryClearFault(void)
     }
 }
 
-bool StateMachine_RemoteStart(const char* id_tag)
+bool StateMachine_RemoteStart(uint8_t conn, const char* id_tag)
 {
-    if (current_state == STATE_CONNECTED)
+    if (conn >= EVSE_CONNECTOR_COUNT) return false;
+
+    if (sm[conn].state == STATE_CONNECTED)
     {
-        printf("[State] Remote Start Accepted (Tag: %s)\r\n", id_tag);
+        printf("[State] Connector %d Remote Start Accepted (Tag: %s)\r\n", conn + 1, id_tag);
         // In a real system, we might need to authorize first or check EV Ready
         // For now, simulate Auth Success and move to Charging
-        
+
         // Trigger EVSE to Allow Power
-        // But in this FW, we follow SECC. 
-        // If we are master, we tell SECC to charge. 
+        // But in this FW, we follow SECC.
+        // If we are master, we tell SECC to charge.
         // Since we are slave to SECC, we can only 'enable' our side.
-        
+
         // Logic: Send "Authorize" to SECC? Or just change state?
         // Let's assume we proceed to Pre-Charge State to check safety first
-        StateMachine_SetState(STATE_PRECHARGE);
+        StateMachine_SetState(conn, STATE_PRECHARGE);
         return true;
     }
-    
-    printf("[State] Remote Start Rejected. Current State: %s\r\n", StateMachine_GetStateName(current_state));
+
+    printf("[State] Connector %d Remote Start Rejected. Current State: %s\r\n", conn + 1,
+           StateMachine_GetStateName(sm[conn].state));
     return false;
 }
 
-bool StateMachine_RemoteStop(void)
+bool StateMachine_RemoteStop(uint8_t conn)
 {
-    if (current_state == STATE_CHARGING)
+    if (conn >= EVSE_CONNECTOR_COUNT) return false;
+
+    if (sm[conn].state == STATE_CHARGING)
     {
-        printf("[State] Remote Stop Received. Stopping...\r\n");
-        StateMachine_SetState(STATE_CONNECTED); // Return to Connected (B/C) -> Relays Open
-        
+        printf("[State] Connector %d Remote Stop Received. Stopping...\r\n", conn + 1);
+        StateMachine_SetState(conn, STATE_CONNECTED); // Return to Connected (B/C) -> Relays Open
+
         // [FIX] Send StopTransaction to Backend
-        OCPP_SendStopTransaction();
+        OCPP_SendStopTransaction(conn);
         return true;
     }
     return false;
 }
 
-void StateMachine_SetState(EVSE_State_t new_state)
+// LED pattern of a state, and how urgent it is to show
+static uint32_t StateMachine_LedInterval(EVSE_State_t state)
 {
-    if (current_state != new_state)
+    switch (state)
     {
-        printf("[State] Transition: %s -> %s\r\n", 
-               StateMachine_GetStateName(current_state), 
+        case STATE_BOOT:      return 0;    // Solid On logic
+        case STATE_STANDBY:   return 1000; // Slow Blink
+        case STATE_CONNECTED: return 500;  // Medium Blink
+        case STATE_PRECHARGE: return 200;  // Fast Blink (Preparing)
+        case STATE_CHARGING:  return 100;  // Very Fast Blink
+        case STATE_FAULT:     return 200;  // SOS Pattern
+        default:              return 500;
+    }
+}
+
+static int StateMachine_LedRank(EVSE_State_t state)
+{
+    switch (state)
+    {
+        case STATE_FAULT:     return 5;
+        case STATE_CHARGING:  return 4;
+        case STATE_PRECHARGE: return 3;
+        case STATE_CONNECTED: return 2;
+        case STATE_STANDBY:   return 1;
+        default:              return 0;
+    }
+}
+
+// One LED for the cabinet: show the most urgent connector
+static void StateMachine_UpdateLed(void)
+{
+    EVSE_State_t show = sm[0].state;
+    for (uint8_t c = 1; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        if (StateMachine_LedRank(sm[c].state) > StateMachine_LedRank(show)) show = sm[c].state;
+    }
+    led_state = show;
+    led_interval = StateMachine_LedInterval(show);
+
+    // Reset LED timer
+    last_led_tick = HAL_GetTick();
+}
+
+void StateMachine_SetState(uint8_t conn, EVSE_State_t new_state)
+{
+    if (conn >= EVSE_CONNECTOR_COUNT) return;
+    StateMachine_Conn_t *s = &sm[conn];
+
+    if (s->state != new_state)
+    {
+        s->demand_armed = false; // Re-armed by the loop in CHARGING
+
+        printf("[State] Connector %d Transition: %s -> %s\r\n", conn + 1,
+               StateMachine_GetStateName(s->state),
                StateMachine_GetStateName(new_state));
-        
+
         // On Exit Actions
-        if (current_state == STATE_CHARGING)
+        if (s->state == STATE_CHARGING)
         {
              // Safely open relays when leaving charging state
              printf("[Seq] Stopping Charge -> OPEN Relays\r\n");
-             Relay_SetMain(false);
-             Relay_SetPrecharge(false);
+             Relay_SetMain(conn, false);
+             Relay_SetPrecharge(conn, false);
         }
 
-        current_state = new_state;
-        
+        s->state = new_state;
+
         // On Entry Actions
-        switch (current_state)
+        switch (s->state)
         {
             case STATE_BOOT:
-                led_interval = 0; // Solid On logic
-                CP_SetPWM(100.0f);
+                CP_SetPWM(conn, 100.0f);
                 break;
             case STATE_STANDBY: // State A
-                led_interval = 1000; // Slow Blink
-                CP_SetPWM(100.0f);   // 12V DC
+                CP_SetPWM(conn, 100.0f);   // 12V DC
                 break;
             case STATE_CONNECTED: // State B
-                led_interval = 500;  // Medium Blink
-                CP_SetPWM(53.3f);    // PWM 53% (Approx 32A)
+                CP_SetPWM(conn, 53.3f);    // PWM 53% (Approx 32A)
                 break;
             case STATE_PRECHARGE:
-                led_interval = 200; // Fast Blink (Preparing)
                 // Entry Action: Check Welding
-                if (Meter_ReadVoltage() > 50.0f)
+                if (Meter_ReadVoltage(conn) > 50.0f)
                 {
                     printf("[Safety] Welding Detected on Entry! V > 50V\r\n");
                 }
-                precharge_tick = HAL_GetTick();
-                Relay_SetPrecharge(true); // Virtual Log (No physical relay)
-                
+                s->precharge_tick = HAL_GetTick();
+                Relay_SetPrecharge(conn, true); // Virtual Log (No physical relay)
+
+                // Output range from the highest voltage the EV may ask for
+                // (before the enable: groups switch while off)
+                float range_v = secc_control[conn].ev_max_voltage;
+                if (secc_control[conn].ev_target_voltage > range_v) range_v = secc_control[conn].ev_target_voltage;
+                if (range_v > 0.0f)
+                {
+                    Infy_OutputRange_t range = Infy_SelectRange(range_v);
+                    Infy_SetRange(conn, range);
+                    printf("[Seq] Output Range: %s (EV %.1fV)\r\n", (range == INFY_RANGE_HIGH) ? "HIGH" : "LOW", range_v);
+                }
+
                 // [Soft-Start] Set Target Voltage
                 // Priority: Measured Voltage > SECC Request > Default
-                float target_v = secc_control.ev_target_voltage;
-                if (Meter_ReadVoltage() > 20.0f) target_v = Meter_ReadVoltage(); 
+                float target_v = secc_control[conn].ev_target_voltage;
+                if (Meter_ReadVoltage(conn) > 20.0f) target_v = Meter_ReadVoltage(conn);
                 if (target_v < 10.0f) target_v = 350.0f; // Default if 0 to prevent 0V start
-                
-                Infy_SetOutput(target_v, 2.0f, true); // 2A Current Limit for Soft Start
+
+                PowerReg_SetTarget(conn, target_v, PRECHARGE_CURRENT_A, true); // Ramped by the regulator
                 printf("[Seq] Pre-Charge Soft-Start. Target: %.1fV\r\n", target_v);
                 break;
             case STATE_CHARGING: // State C
-                led_interval = 100; // Very Fast Blink
-                // PWM remains 53%
                 // PWM remains 53%
                 break;
             case STATE_FAULT:
-                led_interval = 200; // SOS Pattern
-                CP_SetPWM(0.0f);    // 0V or -12V (Error)
-                Relay_SetMain(false);      // Safety
-                Relay_SetPrecharge(false); // Safety
+                CP_SetPWM(conn, 0.0f);    // 0V or -12V (Error)
+                Relay_SetMain(conn, false);      // Safety
+                Relay_SetPrecharge(conn, false); // Safety
                 break;
         }
-        
-        // Reset LED timer
-        last_led_tick = HAL_GetTick();
+
+        StateMachine_UpdateLed();
     }
 }
 
-#include "secc_driver.h"
-
-void StateMachine_Loop(void)
+static void StateMachine_LoopConnector(uint8_t conn)
 {
+    StateMachine_Conn_t *s = &sm[conn];
+    const SECC_Control_t *ctl = &secc_control[conn];
+
     // 0. Safety Check (Highest Priority)
-    if (current_state != STATE_FAULT)
+    if (s->state != STATE_FAULT)
     {
-        if (Safety_Check() != SAFETY_OK)
+        if (Safety_Check(conn) != SAFETY_OK)
         {
             printf("[Safety] CRITICAL FAULT DETECTED!\r\n");
-            StateMachine_SetState(STATE_FAULT);
+            StateMachine_SetState(conn, STATE_FAULT);
             return; // Exit loop
         }
-        
+
         // [New] Welding Detection Check
-        if (current_state != STATE_CHARGING && current_state != STATE_FAULT)
+        if (s->state != STATE_CHARGING && s->state != STATE_FAULT)
         {
-             static uint32_t high_v_tick = 0;
-
              // If Relays are OPEN but Voltage is High (>60V)
-             if ((Relay_GetState() == 0) && (Meter_ReadVoltage() > 60.0f))
+             if ((Relay_GetState(conn) == 0) && (Meter_ReadVoltage(conn) > 60.0f))
              {
-                 if (high_v_tick == 0) high_v_tick = HAL_GetTick();
-                 
-                 if (HAL_GetTick() - high_v_tick > 2000) // > 2 Seconds
+                 if (s->high_v_tick == 0) s->high_v_tick = HAL_GetTick();
+
+                 if (HAL_GetTick() - s->high_v_tick > 2000) // > 2 Seconds
                  {
-                      printf("[Safety] WELDING DETECTED! Voltage: %.1fV\r\n", Meter_ReadVoltage());
-                      StateMachine_SetState(STATE_FAULT);
+                      printf("[Safety] WELDING DETECTED! Voltage: %.1fV\r\n", Meter_ReadVoltage(conn));
+                      StateMachine_SetState(conn, STATE_FAULT);
                       return;
                  }
              }
              else
              {
-                 high_v_tick = 0; // Reset
+                 s->high_v_tick = 0; // Reset
              }
         }
     }
 
-    // 1. Periodic Actions (LED Blinking)
-    uint32_t now = HAL_GetTick();
-    if (led_interval > 0)
-    {
-        if ((now - last_led_tick) >= led_interval)
-        {
-            HAL_GPIO_TogglePin(Status_LED_GPIO_Port, Status_LED_Pin);
-            last_led_tick = now;
-        }
-    }
-    else
-    {
-        // Solid On (Boot)
-        if (current_state == STATE_BOOT)
-        {
-            HAL_GPIO_WritePin(Status_LED_GPIO_Port, Status_LED_Pin, GPIO_PIN_SET);
-        }
-    }
-
     // 2. Control Logic (SECC vs Standalone)
-    if (SECC_IsConnected())
+    if (SECC_IsConnected(conn))
     {
         // --- Remote Control Mode ---
         // 1. PWM Control
-        CP_SetPWM((float)secc_control.target_pwm_duty);
-        
+        CP_SetPWM(conn, (float)ctl->target_pwm_duty);
+
         // 2. Pre-Charge Sequence Logic
-        if (current_state == STATE_PRECHARGE)
+        if (s->state == STATE_PRECHARGE)
         {
             // Dynamic Target Adjustment
-            float target_v = secc_control.ev_target_voltage;
-            float meter_v = Meter_ReadVoltage();
+            float target_v = ctl->ev_target_voltage;
+            float meter_v = Meter_ReadVoltage(conn);
             if (meter_v > 20.0f) target_v = meter_v;
             if (target_v < 10.0f) target_v = 350.0f; // Safety Default
 
             // Keep updating Output
-            Infy_SetOutput(target_v, 2.0f, true);
+            PowerReg_SetTarget(conn, target_v, PRECHARGE_CURRENT_A, true);
 
-            // Check Voltage Match
-            const Infy_SystemStatus_t* pwr_status = Infy_GetSystemStatus();
-            float internal_v = pwr_status->total_voltage;
+            // Check Voltage Match (the groups switched onto this outlet)
+            Infy_OutletStatus_t out;
+            Infy_GetOutletStatus(conn, &out);
+            float internal_v = out.voltage;
 
             // Debug Log every 500ms
             if ((HAL_GetTick() % 500) == 0)
             {
                  printf("[Seq] Pre-Charge: Int=%.1fV, Meter=%.1fV, Tgt=%.1fV\r\n", internal_v, meter_v, target_v);
             }
-            
+
             // Sync Condition: Voltage Diff < 20V AND Min Time > 1s
             if (fabsf(internal_v - target_v) < 20.0f)
             {
-                if (HAL_GetTick() - precharge_tick > 1000)
+                if (HAL_GetTick() - s->precharge_tick > 1000)
                 {
                     printf("[Seq] Voltage Matched. Transition to CHARGING.\r\n");
-                    StateMachine_SetState(STATE_CHARGING);
+                    StateMachine_SetState(conn, STATE_CHARGING);
                 }
             }
             // Timeout Check (10 Seconds)
-            else if (HAL_GetTick() - precharge_tick > 10000)
+            else if (HAL_GetTick() - s->precharge_tick > 10000)
             {
                 printf("[Seq] Pre-Charge Timeout! Failed to match voltage.\r\n");
-                StateMachine_SetState(STATE_FAULT);
+                StateMachine_SetState(conn, STATE_FAULT);
             }
         }
 
         // 3. Relay & Power Control (Remote)
         // [FIX] Only allow power if SECC requests IT AND we are logically in CHARGING state.
         // This ensures User App Stop (which sets state to CONNECTED) overrides SECC.
-        if (secc_control.allow_power && current_state == STATE_CHARGING)
+        if (ctl->allow_power && s->state == STATE_CHARGING)
         {
             // Simple Safe Close Sequence
-            if ((Relay_GetState() & 0x01) == 0) // Main Open
+            if ((Relay_GetState(conn) & 0x01) == 0) // Main Open
             {
-                 // DC Sequence: Voltage Match first? 
+                 // DC Sequence: Voltage Match first?
                  // Now handled by Pre-Charge State. Direct Close here is failsafe.
-                 Relay_SetMain(true);
-                 Relay_SetPrecharge(false); // Open Pre-Charge
+                 Relay_SetMain(conn, true);
+                 Relay_SetPrecharge(conn, false); // Open Pre-Charge
             }
-            
-            // Set Power Module Output (Remote Control)
-            float target_v = secc_control.ev_target_voltage;
-            float target_i = secc_control.ev_max_current;
-            if (target_v < 10.0f) target_v = 350.0f; // Default if 0
-            
-            Infy_SetOutput(target_v, target_i, true);
+
+            // Set Power Module Output (Remote Control, ramped by the regulator);
+            // demand drops between two passes already went out from the RX ISR
+            float target_v, target_i;
+            StateMachine_DemandSetpoint(conn, &target_v, &target_i);
+
+            PowerReg_SetTarget(conn, target_v, target_i, true);
+            s->demand_armed = (Relay_GetState(conn) & 0x01) != 0;
         }
-        else if (current_state != STATE_PRECHARGE) // Keep Pre-charge active if in that state
+        else if (s->state != STATE_PRECHARGE) // Keep Pre-charge active if in that state
         {
+            s->demand_armed = false;
+
             // Open Relays & Disable Power
-            Infy_SetOutput(0.0f, 0.0f, false);
-            Relay_SetMain(false);
-            Relay_SetPrecharge(false);
+            PowerReg_SetTarget(conn, 0.0f, 0.0f, false);
+            Relay_SetMain(conn, false);
+            Relay_SetPrecharge(conn, false);
 
             // [Auto-Stop] Check if we were charging but EV stopped requesting power
-            if (current_state == STATE_CHARGING)
+            if (s->state == STATE_CHARGING)
             {
                 printf("[State] EV Stopped Charge (AllowPower=0) -> Auto Stop Transaction\r\n");
                 // 1. Transition State (This opens relays again comfortably)
-                StateMachine_SetState(STATE_CONNECTED);
-                
+                StateMachine_SetState(conn, STATE_CONNECTED);
+
                 // 2. Trigger OCPP Stop
-                OCPP_SendStopTransaction();
+                OCPP_SendStopTransaction(conn);
             }
         }
-        
+
         // Skip Standalone State Logic
         return;
     }
 
     // 3. Standalone Mode (Removed per Design Requirement)
     // If SECC is not connected, ensure system is in safe state
-    CP_SetPWM(100.0f);    // 12V (State A)
-    Relay_SetMain(false); // Open Relays
-    Relay_SetPrecharge(false);
-    Infy_SetOutput(0.0f, 0.0f, false); // Disable Power Module
+    s->demand_armed = false;
+    CP_SetPWM(conn, 100.0f);    // 12V (State A)
+    Relay_SetMain(conn, false); // Open Relays
+    Relay_SetPrecharge(conn, false);
+    PowerReg_SetTarget(conn, 0.0f, 0.0f, false); // Disable Power Module
+}
+
+void StateMachine_Loop(void)
+{
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        StateMachine_LoopConnector(c);
+    }
+
+    // 1. Periodic Actions (LED Blinking)
+    uint32_t now = HAL_GetTick();
+    if (led_interval > 0)
+    {
+        if ((now - last_led_tick) >= led_interval)
+        {
+            HAL_GPIO_TogglePin(Status_LED_GPIO_Port, Status_LED_Pin);
+            last_led_tick = now;
+        }
+    }
+    else
+    {
+        // Solid On (Boot)
+        if (led_state == STATE_BOOT)
+        {
+            HAL_GPIO_WritePin(Status_LED_GPIO_Port, Status_LED_Pin, GPIO_PIN_SET);
+        }
+    }
+}
+
+EVSE_State_t StateMachine_GetState(uint8_t conn)
+{
+    return (conn < EVSE_CONNECTOR_COUNT) ? sm[conn].state : STATE_FAULT;
+}
+
+bool StateMachine_IsSessionActive(void)
+{
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        if (sm[c].state == STATE_PRECHARGE || sm[c].state == STATE_CHARGING) return true;
+    }
+    return false;
 }
 
 const char* StateMachine_GetStateName(EVSE_State_t state)
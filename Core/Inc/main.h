@@ -81,6 +81,48 @@ void Error_Handler(void);
 #define T_SWCLK_GPIO_Port GPIOA
 
 /* USER CODE BEGIN Private defines */
+// Contactors of the further connectors (EVSE_CONNECTOR_COUNT > 1, set up by Relay_Init)
+#define Relay2_Main_P_Pin GPIO_PIN_6
+#define Relay2_Main_P_GPIO_Port GPIOC
+#define Relay2_Main_N_Pin GPIO_PIN_7
+#define Relay2_Main_N_GPIO_Port GPIOC
+#define Relay2_Precharge_Pin GPIO_PIN_8
+#define Relay2_Precharge_GPIO_Port GPIOC
+#define Relay3_Main_P_Pin GPIO_PIN_9
+#define Relay3_Main_P_GPIO_Port GPIOC
+#define Relay3_Main_N_Pin GPIO_PIN_10
+#define Relay3_Main_N_GPIO_Port GPIOC
+#define Relay3_Precharge_Pin GPIO_PIN_11
+#define Relay3_Precharge_GPIO_Port GPIOC
+#define Relay4_Main_P_Pin GPIO_PIN_4
+#define Relay4_Main_P_GPIO_Port GPIOB
+#define Relay4_Main_N_Pin GPIO_PIN_5
+#define Relay4_Main_N_GPIO_Port GPIOB
+#define Relay4_Precharge_Pin GPIO_PIN_6
+#define Relay4_Precharge_GPIO_Port GPIOB
+// Allocation matrix contactors: TPIC6B595 chain (relay_driver.h), bit-banged
+#define Matrix_SER_Pin GPIO_PIN_7
+#define Matrix_SER_GPIO_Port GPIOB
+#define Matrix_SRCK_Pin GPIO_PIN_12
+#define Matrix_SRCK_GPIO_Port GPIOC
+#define Matrix_RCK_Pin GPIO_PIN_2
+#define Matrix_RCK_GPIO_Port GPIOD
+#define Matrix_OE_Pin GPIO_PIN_9          // /G, active low (pulled up on the board: outputs off)
+#define Matrix_OE_GPIO_Port GPIOB
+// Control pilot of the further connectors (set up by CP_Init): PWM on TIM1 CH2..CH4 (AF2)
+#define CP2_PWM_Pin GPIO_PIN_1
+#define CP2_PWM_GPIO_Port GPIOC
+#define CP3_PWM_Pin GPIO_PIN_2
+#define CP3_PWM_GPIO_Port GPIOC
+#define CP4_PWM_Pin GPIO_PIN_3
+#define CP4_PWM_GPIO_Port GPIOC
+// CP sense: connector 1 PA0 ADC1_IN1 (CubeMX); PA2/PA3 (ADC1_IN3/IN4) are the CLI's USART2
+#define CP2_Sense_Pin GPIO_PIN_1          // ADC1_IN2
+#define CP2_Sense_GPIO_Port GPIOA
+#define CP3_Sense_Pin GPIO_PIN_15         // ADC2_IN15
+#define CP3_Sense_GPIO_Port GPIOB
+#define CP4_Sense_Pin GPIO_PIN_9          // ADC5_IN2
+#define CP4_Sense_GPIO_Port GPIOA
 
 /* USER CODE END Private defines */
 
@@ -55,9 +55,16 @@ void DebugMon_Handler(void);
 void DMA1_Channel1_IRQHandler(void);
 void DMA1_Channel2_IRQHandler(void);
 void DMA1_Channel3_IRQHandler(void);
+void FDCAN1_IT0_IRQHandler(void);
+void TIM3_IRQHandler(void);
 void TIM4_IRQHandler(void);
+void USART3_IRQHandler(void);
+void FDCAN2_IT0_IRQHandler(void);
+void FDCAN3_IT0_IRQHandler(void);
 /* USER CODE BEGIN EFP */
-
+void FDCAN1_IT1_IRQHandler(void);
+void FDCAN2_IT1_IRQHandler(void);
+void FDCAN3_IT1_IRQHandler(void);
 /* USER CODE END EFP */
 
 #ifdef __cplusplus
@@ -63,6 +63,19 @@ const osThreadAttr_t ocppTask_attributes = {
   .stack_size = 512 * 4 // 2048 Bytes for TLS
 };
 
+/* Definitions for CAN Task (Deferred RX Processing) */
+osThreadId_t canTaskHandle;
+static StaticTask_t canTaskControlBlock;
+static uint32_t canTaskStack[256];
+const osThreadAttr_t canTask_attributes = {
+  .name = "CAN_Task",
+  .priority = (osPriority_t) osPriorityHigh, // Above ControlTask: drains ISR queues
+  .cb_mem = &canTaskControlBlock,
+  .cb_size = sizeof(canTaskControlBlock),
+  .stack_mem = &canTaskStack[0],
+  .stack_size = sizeof(canTaskStack) // 1024 Bytes (Static, heap is only 3KB)
+};
+
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
 
@@ -70,6 +83,7 @@ const osThreadAttr_t ocppTask_attributes = {
 
 void StartDefaultTask(void *argument);
 void StartOCPPTask(void *argument); // New Prototype
+void StartCANTask(void *argument);
 
 void MX_FREERTOS_Init(void); /* (MISRA C 2004 rule 8.1) */
 
@@ -106,6 +120,9 @@ void MX_FREERTOS_Init(void) {
   /* creation of OCPP Task */
   ocppTaskHandle = osThreadNew(StartOCPPTask, NULL, &ocppTask_attributes);
 
+  /* creation of CAN Task */
+  canTaskHandle = osThreadNew(StartCANTask, NULL, &canTask_attributes);
+
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
   /* USER CODE END RTOS_THREADS */
@@ -156,6 +173,18 @@ void StartOCPPTask(void *argument)
     }
 }
 
+/* CAN Task Entry */
+void StartCANTask(void *argument)
+{
+    // Drain per-bus RX queues filled by the FDCAN ISR
+    App_CANLoop();
+
+    for(;;)
+    {
+        osDelay(1);
+    }
+}
+
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
 
@@ -31,8 +31,9 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-#include "meter_driver.h"
+#include "modbus_master.h"
 #include "uart_driver.h"
+#include "timebase.h"
 /* USER CODE END Includes */
 
 #include "logger.h"
@@ -112,6 +113,7 @@ int main(void)
   MX_RNG_Init();
   MX_SPI1_Init();
   MX_IWDG_Init();
+  MX_TIM3_Init();
   /* USER CODE BEGIN 2 */
   Logger_Init();
   /* USER CODE END 2 */
@@ -204,7 +206,17 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
   UART_CLI_RxCpltCallback(huart);
-  Meter_RxCpltCallback(huart);
+}
+
+/**
+  * @brief  Reception event callback (ReceiveToIdle: line idle or buffer full)
+  * @param  huart: UART handle
+  * @param  Size: Bytes received
+  * @retval None
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  Modbus_RxEventCallback(huart, Size);
 }
 
 
@@ -227,6 +239,10 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
     HAL_IncTick();
   }
   /* USER CODE BEGIN Callback 1 */
+  if (htim->Instance == TIM3)
+  {
+    Timebase_OverflowCallback(); // 65.536 ms wrap of the 1 MHz counter
+  }
 
   /* USER CODE END Callback 1 */
 }
@@ -0,0 +1,45 @@
+/**
+ * @file    can_db_imd.h
+ * @brief   CAN Signal Pack/Unpack (imd.dbc)
+ *
+ * @note    Generated by Tools/dbc/dbcgen.py from Tools/dbc/imd.dbc.
+ *          Do not edit: change the DBC and run make in Tools/dbc.
+ *          Struct fields are raw signal values; scale is in the comment.
+ */
+
+#ifndef MODULES_CAN_CAN_DB_IMD_H_
+#define MODULES_CAN_CAN_DB_IMD_H_
+
+#include "can_driver.h"
+#include <stdint.h>
+
+// 0x24 IMD_Info: Periodic info (Bender iso165C-like, simplified)
+#define IMD_INFO_ID                  0x24U
+#define IMD_INFO_ID_TYPE             CAN_ID_STD
+#define IMD_INFO_FD                  0
+#define IMD_INFO_LEN                 4U
+#define IMD_INFO_MIN_LEN             3U // Bytes carrying signals
+
+typedef struct
+{
+    uint16_t r_iso;                  // 1 kOhm/bit
+    uint8_t  warning;                // x1
+    uint8_t  fault;                  // x1
+} IMD_Info_t;
+
+static inline void IMD_Info_Pack(const IMD_Info_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)((m->r_iso >> 8) & 0xFFU);
+    data[1] = (uint8_t)(m->r_iso & 0xFFU);
+    data[2] = (uint8_t)((m->warning & 0x1U) | ((m->fault & 0x1U) << 1));
+    data[3] = 0;
+}
+
+static inline void IMD_Info_Unpack(const uint8_t *data, IMD_Info_t *m)
+{
+    m->r_iso = (uint16_t)(((uint32_t)data[0] << 8) | (uint32_t)data[1]);
+    m->warning = (uint8_t)(data[2] & 0x1U);
+    m->fault = (uint8_t)((data[2] >> 1) & 0x1U);
+}
+
+#endif /* MODULES_CAN_CAN_DB_IMD_H_ */
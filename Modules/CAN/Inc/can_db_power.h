@@ -0,0 +1,327 @@
+/**
+ * @file    can_db_power.h
+ * @brief   CAN Signal Pack/Unpack (power.dbc)
+ *
+ * @note    Generated by Tools/dbc/dbcgen.py from Tools/dbc/power.dbc.
+ *          Do not edit: change the DBC and run make in Tools/dbc.
+ *          Struct fields are raw signal values; scale is in the comment.
+ */
+
+#ifndef MODULES_CAN_CAN_DB_POWER_H_
+#define MODULES_CAN_CAN_DB_POWER_H_
+
+#include "can_driver.h"
+#include <stdint.h>
+
+// 0x18005000 Infy_Control: Broadcast setpoint (assumed generic rectifier protocol)
+#define INFY_CONTROL_ID              0x18005000U
+#define INFY_CONTROL_ID_TYPE         CAN_ID_EXT
+#define INFY_CONTROL_FD              0
+#define INFY_CONTROL_LEN             8U
+#define INFY_CONTROL_MIN_LEN         6U // Bytes carrying signals
+
+typedef struct
+{
+    uint16_t voltage;                // 0.1 V/bit
+    uint16_t current;                // 0.1 A/bit (Per module (total split by the CCU))
+    uint8_t  enable;                 // x1
+    uint8_t  group_mask;             // x1 (Groups taking the setpoint (one output bus per outlet), 0 = all)
+} Infy_Control_t;
+
+static inline void Infy_Control_Pack(const Infy_Control_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)((m->voltage >> 8) & 0xFFU);
+    data[1] = (uint8_t)(m->voltage & 0xFFU);
+    data[2] = (uint8_t)((m->current >> 8) & 0xFFU);
+    data[3] = (uint8_t)(m->current & 0xFFU);
+    data[4] = (uint8_t)(m->enable & 0x1U);
+    data[5] = (uint8_t)(m->group_mask & 0xFFU);
+    data[6] = 0;
+    data[7] = 0;
+}
+
+static inline void Infy_Control_Unpack(const uint8_t *data, Infy_Control_t *m)
+{
+    m->voltage = (uint16_t)(((uint32_t)data[0] << 8) | (uint32_t)data[1]);
+    m->current = (uint16_t)(((uint32_t)data[2] << 8) | (uint32_t)data[3]);
+    m->enable = (uint8_t)(data[4] & 0x1U);
+    m->group_mask = (uint8_t)data[5];
+}
+
+// 0x18005100 Infy_Stage: Staging: modules of groups outside the mask hold their output off
+#define INFY_STAGE_ID                0x18005100U
+#define INFY_STAGE_ID_TYPE           CAN_ID_EXT
+#define INFY_STAGE_FD                0
+#define INFY_STAGE_LEN               8U
+#define INFY_STAGE_MIN_LEN           1U // Bytes carrying signals
+
+typedef struct
+{
+    uint8_t group_mask;              // x1 (Bit g = modules n / 8 == g run)
+} Infy_Stage_t;
+
+static inline void Infy_Stage_Pack(const Infy_Stage_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(m->group_mask & 0xFFU);
+    data[1] = 0;
+    data[2] = 0;
+    data[3] = 0;
+    data[4] = 0;
+    data[5] = 0;
+    data[6] = 0;
+    data[7] = 0;
+}
+
+static inline void Infy_Stage_Unpack(const uint8_t *data, Infy_Stage_t *m)
+{
+    m->group_mask = (uint8_t)data[0];
+}
+
+// 0x18005301 Infy_Trim: Current sharing: module n adds the trim on 0x18005301 + n to the broadcast current
+#define INFY_TRIM_ID                 0x18005301U
+#define INFY_TRIM_ID_TYPE            CAN_ID_EXT
+#define INFY_TRIM_FD                 0
+#define INFY_TRIM_LEN                2U
+#define INFY_TRIM_MIN_LEN            2U // Bytes carrying signals
+
+typedef struct
+{
+    int16_t current_trim;            // 0.1 A/bit (Held until the next trim or output disable)
+} Infy_Trim_t;
+
+static inline void Infy_Trim_Pack(const Infy_Trim_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(((uint32_t)m->current_trim >> 8) & 0xFFU);
+    data[1] = (uint8_t)((uint32_t)m->current_trim & 0xFFU);
+}
+
+static inline void Infy_Trim_Unpack(const uint8_t *data, Infy_Trim_t *m)
+{
+    m->current_trim = (int16_t)(((((uint32_t)data[0] << 8) | (uint32_t)data[1]) ^ 0x8000U) - 0x8000U);
+}
+
+// 0x18005400 Infy_Range: Output range: modules switch only while their output is off
+#define INFY_RANGE_ID                0x18005400U
+#define INFY_RANGE_ID_TYPE           CAN_ID_EXT
+#define INFY_RANGE_FD                0
+#define INFY_RANGE_LEN               8U
+#define INFY_RANGE_MIN_LEN           1U // Bytes carrying signals
+
+typedef struct
+{
+    uint8_t high_mask;               // x1 (Bit g = modules n / 8 == g in the high-voltage range (stages in series))
+} Infy_Range_t;
+
+static inline void Infy_Range_Pack(const Infy_Range_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(m->high_mask & 0xFFU);
+    data[1] = 0;
+    data[2] = 0;
+    data[3] = 0;
+    data[4] = 0;
+    data[5] = 0;
+    data[6] = 0;
+    data[7] = 0;
+}
+
+static inline void Infy_Range_Unpack(const uint8_t *data, Infy_Range_t *m)
+{
+    m->high_mask = (uint8_t)data[0];
+}
+
+// 0x18005501 Infy_Query: Extended status request to module n on 0x18005501 + n, answered with the item's frame
+#define INFY_QUERY_ID                0x18005501U
+#define INFY_QUERY_ID_TYPE           CAN_ID_EXT
+#define INFY_QUERY_FD                0
+#define INFY_QUERY_LEN               1U
+#define INFY_QUERY_MIN_LEN           1U // Bytes carrying signals
+
+typedef struct
+{
+    uint8_t item;                    // x1 (1 = Temps, 2 = AcInput, 3 = Faults, 4 = Derate)
+} Infy_Query_t;
+
+static inline void Infy_Query_Pack(const Infy_Query_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(m->item & 0xFFU);
+}
+
+static inline void Infy_Query_Unpack(const uint8_t *data, Infy_Query_t *m)
+{
+    m->item = (uint8_t)data[0];
+}
+
+// 0x18005001 Infy_Status: Module status; module n answers on 0x18005001 + n
+#define INFY_STATUS_ID               0x18005001U
+#define INFY_STATUS_ID_TYPE          CAN_ID_EXT
+#define INFY_STATUS_FD               0
+#define INFY_STATUS_LEN              5U
+#define INFY_STATUS_MIN_LEN          5U // Bytes carrying signals
+
+typedef struct
+{
+    uint16_t voltage;                // 0.1 V/bit
+    uint16_t current;                // 0.1 A/bit
+    uint8_t  is_on;                  // x1
+    uint8_t  fault_ov;               // x1
+    uint8_t  range_high;             // x1 (Active range (0 = low-voltage, high-current))
+} Infy_Status_t;
+
+static inline void Infy_Status_Pack(const Infy_Status_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)((m->voltage >> 8) & 0xFFU);
+    data[1] = (uint8_t)(m->voltage & 0xFFU);
+    data[2] = (uint8_t)((m->current >> 8) & 0xFFU);
+    data[3] = (uint8_t)(m->current & 0xFFU);
+    data[4] = (uint8_t)((m->is_on & 0x1U) | ((m->fault_ov & 0x1U) << 1) | ((m->range_high & 0x1U) << 2));
+}
+
+static inline void Infy_Status_Unpack(const uint8_t *data, Infy_Status_t *m)
+{
+    m->voltage = (uint16_t)(((uint32_t)data[0] << 8) | (uint32_t)data[1]);
+    m->current = (uint16_t)(((uint32_t)data[2] << 8) | (uint32_t)data[3]);
+    m->is_on = (uint8_t)(data[4] & 0x1U);
+    m->fault_ov = (uint8_t)((data[4] >> 1) & 0x1U);
+    m->range_high = (uint8_t)((data[4] >> 2) & 0x1U);
+}
+
+// 0x18005201 Infy_Info: Module rating, sent by module n on 0x18005201 + n after power-up
+#define INFY_INFO_ID                 0x18005201U
+#define INFY_INFO_ID_TYPE            CAN_ID_EXT
+#define INFY_INFO_FD                 0
+#define INFY_INFO_LEN                5U
+#define INFY_INFO_MIN_LEN            5U // Bytes carrying signals
+
+typedef struct
+{
+    uint16_t rated_power;            // 0.1 kW/bit
+    uint16_t max_current;            // 0.1 A/bit
+    uint8_t  sweet_spot;             // 1 %/bit (Load (percent of rated power) at peak efficiency)
+} Infy_Info_t;
+
+static inline void Infy_Info_Pack(const Infy_Info_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)((m->rated_power >> 8) & 0xFFU);
+    data[1] = (uint8_t)(m->rated_power & 0xFFU);
+    data[2] = (uint8_t)((m->max_current >> 8) & 0xFFU);
+    data[3] = (uint8_t)(m->max_current & 0xFFU);
+    data[4] = (uint8_t)(m->sweet_spot & 0xFFU);
+}
+
+static inline void Infy_Info_Unpack(const uint8_t *data, Infy_Info_t *m)
+{
+    m->rated_power = (uint16_t)(((uint32_t)data[0] << 8) | (uint32_t)data[1]);
+    m->max_current = (uint16_t)(((uint32_t)data[2] << 8) | (uint32_t)data[3]);
+    m->sweet_spot = (uint8_t)data[4];
+}
+
+// 0x18005601 Infy_Temps: Temperatures; module n answers item 1 on 0x18005601 + n
+#define INFY_TEMPS_ID                0x18005601U
+#define INFY_TEMPS_ID_TYPE           CAN_ID_EXT
+#define INFY_TEMPS_FD                0
+#define INFY_TEMPS_LEN               3U
+#define INFY_TEMPS_MIN_LEN           3U // Bytes carrying signals
+
+typedef struct
+{
+    int8_t temp_inlet;               // 1 degC/bit
+    int8_t temp_pfc;                 // 1 degC/bit
+    int8_t temp_dcdc;                // 1 degC/bit
+} Infy_Temps_t;
+
+static inline void Infy_Temps_Pack(const Infy_Temps_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)((uint32_t)m->temp_inlet & 0xFFU);
+    data[1] = (uint8_t)((uint32_t)m->temp_pfc & 0xFFU);
+    data[2] = (uint8_t)((uint32_t)m->temp_dcdc & 0xFFU);
+}
+
+static inline void Infy_Temps_Unpack(const uint8_t *data, Infy_Temps_t *m)
+{
+    m->temp_inlet = (int8_t)((((uint32_t)data[0]) ^ 0x80U) - 0x80U);
+    m->temp_pfc = (int8_t)((((uint32_t)data[1]) ^ 0x80U) - 0x80U);
+    m->temp_dcdc = (int8_t)((((uint32_t)data[2]) ^ 0x80U) - 0x80U);
+}
+
+// 0x18005701 Infy_AcInput: AC input line voltages; module n answers item 2 on 0x18005701 + n
+#define INFY_ACINPUT_ID              0x18005701U
+#define INFY_ACINPUT_ID_TYPE         CAN_ID_EXT
+#define INFY_ACINPUT_FD              0
+#define INFY_ACINPUT_LEN             6U
+#define INFY_ACINPUT_MIN_LEN         6U // Bytes carrying signals
+
+typedef struct
+{
+    uint16_t v_ab;                   // 0.1 V/bit
+    uint16_t v_bc;                   // 0.1 V/bit
+    uint16_t v_ca;                   // 0.1 V/bit
+} Infy_AcInput_t;
+
+static inline void Infy_AcInput_Pack(const Infy_AcInput_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)((m->v_ab >> 8) & 0xFFU);
+    data[1] = (uint8_t)(m->v_ab & 0xFFU);
+    data[2] = (uint8_t)((m->v_bc >> 8) & 0xFFU);
+    data[3] = (uint8_t)(m->v_bc & 0xFFU);
+    data[4] = (uint8_t)((m->v_ca >> 8) & 0xFFU);
+    data[5] = (uint8_t)(m->v_ca & 0xFFU);
+}
+
+static inline void Infy_AcInput_Unpack(const uint8_t *data, Infy_AcInput_t *m)
+{
+    m->v_ab = (uint16_t)(((uint32_t)data[0] << 8) | (uint32_t)data[1]);
+    m->v_bc = (uint16_t)(((uint32_t)data[2] << 8) | (uint32_t)data[3]);
+    m->v_ca = (uint16_t)(((uint32_t)data[4] << 8) | (uint32_t)data[5]);
+}
+
+// 0x18005801 Infy_Faults: Full fault word; module n answers item 3 on 0x18005801 + n
+#define INFY_FAULTS_ID               0x18005801U
+#define INFY_FAULTS_ID_TYPE          CAN_ID_EXT
+#define INFY_FAULTS_FD               0
+#define INFY_FAULTS_LEN              4U
+#define INFY_FAULTS_MIN_LEN          4U // Bytes carrying signals
+
+typedef struct
+{
+    uint32_t fault_word;             // x1 (Vendor fault bits (0 = none), the status frame only carries OV)
+} Infy_Faults_t;
+
+static inline void Infy_Faults_Pack(const Infy_Faults_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)((m->fault_word >> 24) & 0xFFU);
+    data[1] = (uint8_t)((m->fault_word >> 16) & 0xFFU);
+    data[2] = (uint8_t)((m->fault_word >> 8) & 0xFFU);
+    data[3] = (uint8_t)(m->fault_word & 0xFFU);
+}
+
+static inline void Infy_Faults_Unpack(const uint8_t *data, Infy_Faults_t *m)
+{
+    m->fault_word = (uint32_t)(((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3]);
+}
+
+// 0x18005901 Infy_Derate: Derating state; module n answers item 4 on 0x18005901 + n
+#define INFY_DERATE_ID               0x18005901U
+#define INFY_DERATE_ID_TYPE          CAN_ID_EXT
+#define INFY_DERATE_FD               0
+#define INFY_DERATE_LEN              2U
+#define INFY_DERATE_MIN_LEN          2U // Bytes carrying signals
+
+typedef struct
+{
+    uint8_t power_limit;             // 1 %/bit (Available power (percent of rated, 100 = not derated))
+    uint8_t reason;                  // x1 (Bit 0 = temperature, 1 = AC input, 2 = output voltage)
+} Infy_Derate_t;
+
+static inline void Infy_Derate_Pack(const Infy_Derate_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(m->power_limit & 0xFFU);
+    data[1] = (uint8_t)(m->reason & 0xFFU);
+}
+
+static inline void Infy_Derate_Unpack(const uint8_t *data, Infy_Derate_t *m)
+{
+    m->power_limit = (uint8_t)data[0];
+    m->reason = (uint8_t)data[1];
+}
+
+#endif /* MODULES_CAN_CAN_DB_POWER_H_ */
@@ -0,0 +1,271 @@
+/**
+ * @file    can_db_secc.h
+ * @brief   CAN Signal Pack/Unpack (secc.dbc)
+ *
+ * @note    Generated by Tools/dbc/dbcgen.py from Tools/dbc/secc.dbc.
+ *          Do not edit: change the DBC and run make in Tools/dbc.
+ *          Struct fields are raw signal values; scale is in the comment.
+ */
+
+#ifndef MODULES_CAN_CAN_DB_SECC_H_
+#define MODULES_CAN_CAN_DB_SECC_H_
+
+#include "can_driver.h"
+#include <stdint.h>
+
+// 0x600 CCU_Status: Status, Classic link (50 ms)
+#define CCU_STATUS_ID                0x600U
+#define CCU_STATUS_ID_TYPE           CAN_ID_STD
+#define CCU_STATUS_FD                0
+#define CCU_STATUS_LEN               8U
+#define CCU_STATUS_MIN_LEN           7U // Bytes carrying signals
+
+typedef struct
+{
+    uint16_t cp_voltage;             // 0.001 V/bit
+    uint16_t pp_voltage;             // 0.001 V/bit (Placeholder, always 0)
+    uint8_t  pwm_duty;               // 1 %/bit
+    uint8_t  relay_state;            // x1
+    uint8_t  err_code;               // x1
+} CCU_Status_t;
+
+static inline void CCU_Status_Pack(const CCU_Status_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(m->cp_voltage & 0xFFU);
+    data[1] = (uint8_t)((m->cp_voltage >> 8) & 0xFFU);
+    data[2] = (uint8_t)(m->pp_voltage & 0xFFU);
+    data[3] = (uint8_t)((m->pp_voltage >> 8) & 0xFFU);
+    data[4] = (uint8_t)(m->pwm_duty & 0xFFU);
+    data[5] = (uint8_t)(m->relay_state & 0xFFU);
+    data[6] = (uint8_t)(m->err_code & 0xFFU);
+    data[7] = 0;
+}
+
+static inline void CCU_Status_Unpack(const uint8_t *data, CCU_Status_t *m)
+{
+    m->cp_voltage = (uint16_t)((uint32_t)data[0] | ((uint32_t)data[1] << 8));
+    m->pp_voltage = (uint16_t)((uint32_t)data[2] | ((uint32_t)data[3] << 8));
+    m->pwm_duty = (uint8_t)data[4];
+    m->relay_state = (uint8_t)data[5];
+    m->err_code = (uint8_t)data[6];
+}
+
+// 0x601 CCU_Combined: Status + Meter + Power Stage, FD link (10 ms)
+#define CCU_COMBINED_ID              0x601U
+#define CCU_COMBINED_ID_TYPE         CAN_ID_STD
+#define CCU_COMBINED_FD              1
+#define CCU_COMBINED_LEN             24U
+#define CCU_COMBINED_MIN_LEN         23U // Bytes carrying signals
+
+typedef struct
+{
+    uint16_t cp_voltage;             // 0.001 V/bit
+    uint16_t pp_voltage;             // 0.001 V/bit
+    uint8_t  pwm_duty;               // 1 %/bit
+    uint8_t  relay_state;            // x1
+    uint8_t  err_code;               // x1
+    uint16_t ac_voltage;             // 0.1 V/bit
+    uint16_t ac_current;             // 0.1 A/bit
+    int8_t   temperature;            // 1 degC/bit
+    uint16_t dc_voltage;             // 0.1 V/bit
+    uint16_t dc_current;             // 0.1 A/bit
+    uint8_t  active_modules;         // x1
+    uint8_t  power_fault;            // x1
+    uint8_t  counter;                // x1 (Rolling counter, detects lost 10 ms frames)
+} CCU_Combined_t;
+
+static inline void CCU_Combined_Pack(const CCU_Combined_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(m->cp_voltage & 0xFFU);
+    data[1] = (uint8_t)((m->cp_voltage >> 8) & 0xFFU);
+    data[2] = (uint8_t)(m->pp_voltage & 0xFFU);
+    data[3] = (uint8_t)((m->pp_voltage >> 8) & 0xFFU);
+    data[4] = (uint8_t)(m->pwm_duty & 0xFFU);
+    data[5] = (uint8_t)(m->relay_state & 0xFFU);
+    data[6] = (uint8_t)(m->err_code & 0xFFU);
+    data[7] = 0;
+    data[8] = (uint8_t)(m->ac_voltage & 0xFFU);
+    data[9] = (uint8_t)((m->ac_voltage >> 8) & 0xFFU);
+    data[10] = (uint8_t)(m->ac_current & 0xFFU);
+    data[11] = (uint8_t)((m->ac_current >> 8) & 0xFFU);
+    data[12] = (uint8_t)((uint32_t)m->temperature & 0xFFU);
+    data[13] = 0;
+    data[14] = 0;
+    data[15] = 0;
+    data[16] = (uint8_t)(m->dc_voltage & 0xFFU);
+    data[17] = (uint8_t)((m->dc_voltage >> 8) & 0xFFU);
+    data[18] = (uint8_t)(m->dc_current & 0xFFU);
+    data[19] = (uint8_t)((m->dc_current >> 8) & 0xFFU);
+    data[20] = (uint8_t)(m->active_modules & 0xFFU);
+    data[21] = (uint8_t)(m->power_fault & 0xFFU);
+    data[22] = (uint8_t)(m->counter & 0xFFU);
+    data[23] = 0;
+}
+
+static inline void CCU_Combined_Unpack(const uint8_t *data, CCU_Combined_t *m)
+{
+    m->cp_voltage = (uint16_t)((uint32_t)data[0] | ((uint32_t)data[1] << 8));
+    m->pp_voltage = (uint16_t)((uint32_t)data[2] | ((uint32_t)data[3] << 8));
+    m->pwm_duty = (uint8_t)data[4];
+    m->relay_state = (uint8_t)data[5];
+    m->err_code = (uint8_t)data[6];
+    m->ac_voltage = (uint16_t)((uint32_t)data[8] | ((uint32_t)data[9] << 8));
+    m->ac_current = (uint16_t)((uint32_t)data[10] | ((uint32_t)data[11] << 8));
+    m->temperature = (int8_t)((((uint32_t)data[12]) ^ 0x80U) - 0x80U);
+    m->dc_voltage = (uint16_t)((uint32_t)data[16] | ((uint32_t)data[17] << 8));
+    m->dc_current = (uint16_t)((uint32_t)data[18] | ((uint32_t)data[19] << 8));
+    m->active_modules = (uint8_t)data[20];
+    m->power_fault = (uint8_t)data[21];
+    m->counter = (uint8_t)data[22];
+}
+
+// 0x602 CCU_Meter: Meter Values, Classic link (200 ms)
+#define CCU_METER_ID                 0x602U
+#define CCU_METER_ID_TYPE            CAN_ID_STD
+#define CCU_METER_FD                 0
+#define CCU_METER_LEN                8U
+#define CCU_METER_MIN_LEN            5U // Bytes carrying signals
+
+typedef struct
+{
+    uint16_t ac_voltage;             // 0.1 V/bit
+    uint16_t ac_current;             // 0.1 A/bit
+    int8_t   temperature;            // 1 degC/bit
+} CCU_Meter_t;
+
+static inline void CCU_Meter_Pack(const CCU_Meter_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(m->ac_voltage & 0xFFU);
+    data[1] = (uint8_t)((m->ac_voltage >> 8) & 0xFFU);
+    data[2] = (uint8_t)(m->ac_current & 0xFFU);
+    data[3] = (uint8_t)((m->ac_current >> 8) & 0xFFU);
+    data[4] = (uint8_t)((uint32_t)m->temperature & 0xFFU);
+    data[5] = 0;
+    data[6] = 0;
+    data[7] = 0;
+}
+
+static inline void CCU_Meter_Unpack(const uint8_t *data, CCU_Meter_t *m)
+{
+    m->ac_voltage = (uint16_t)((uint32_t)data[0] | ((uint32_t)data[1] << 8));
+    m->ac_current = (uint16_t)((uint32_t)data[2] | ((uint32_t)data[3] << 8));
+    m->temperature = (int8_t)((((uint32_t)data[4]) ^ 0x80U) - 0x80U);
+}
+
+// 0x610 SECC_Command: Command; sent as FD by an FD-capable SECC
+#define SECC_COMMAND_ID              0x610U
+#define SECC_COMMAND_ID_TYPE         CAN_ID_STD
+#define SECC_COMMAND_FD              0
+#define SECC_COMMAND_LEN             3U
+#define SECC_COMMAND_MIN_LEN         3U // Bytes carrying signals
+
+typedef struct
+{
+    uint8_t target_pwm_duty;         // 1 %/bit
+    uint8_t allow_power;             // x1
+    uint8_t reset_fault;             // x1
+} SECC_Command_t;
+
+static inline void SECC_Command_Pack(const SECC_Command_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(m->target_pwm_duty & 0xFFU);
+    data[1] = (uint8_t)(m->allow_power & 0xFFU);
+    data[2] = (uint8_t)(m->reset_fault & 0xFFU);
+}
+
+static inline void SECC_Command_Unpack(const uint8_t *data, SECC_Command_t *m)
+{
+    m->target_pwm_duty = (uint8_t)data[0];
+    m->allow_power = (uint8_t)data[1];
+    m->reset_fault = (uint8_t)data[2];
+}
+
+// 0x611 SECC_DcDemand: DC demand (CurrentDemandReq), sent by the SECC on every change while charging
+#define SECC_DCDEMAND_ID             0x611U
+#define SECC_DCDEMAND_ID_TYPE        CAN_ID_STD
+#define SECC_DCDEMAND_FD             0
+#define SECC_DCDEMAND_LEN            5U
+#define SECC_DCDEMAND_MIN_LEN        5U // Bytes carrying signals
+
+typedef struct
+{
+    uint16_t target_voltage;         // 0.1 V/bit
+    uint16_t target_current;         // 0.1 A/bit
+    uint8_t  soc;                    // 1 %/bit
+} SECC_DcDemand_t;
+
+static inline void SECC_DcDemand_Pack(const SECC_DcDemand_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(m->target_voltage & 0xFFU);
+    data[1] = (uint8_t)((m->target_voltage >> 8) & 0xFFU);
+    data[2] = (uint8_t)(m->target_current & 0xFFU);
+    data[3] = (uint8_t)((m->target_current >> 8) & 0xFFU);
+    data[4] = (uint8_t)(m->soc & 0xFFU);
+}
+
+static inline void SECC_DcDemand_Unpack(const uint8_t *data, SECC_DcDemand_t *m)
+{
+    m->target_voltage = (uint16_t)((uint32_t)data[0] | ((uint32_t)data[1] << 8));
+    m->target_current = (uint16_t)((uint32_t)data[2] | ((uint32_t)data[3] << 8));
+    m->soc = (uint8_t)data[4];
+}
+
+// 0x612 SECC_DcLimits: EV DC limits (ChargeParameterDiscoveryReq)
+#define SECC_DCLIMITS_ID             0x612U
+#define SECC_DCLIMITS_ID_TYPE        CAN_ID_STD
+#define SECC_DCLIMITS_FD             0
+#define SECC_DCLIMITS_LEN            4U
+#define SECC_DCLIMITS_MIN_LEN        4U // Bytes carrying signals
+
+typedef struct
+{
+    uint16_t ev_max_voltage;         // 0.1 V/bit
+    uint16_t ev_max_current;         // 0.1 A/bit
+} SECC_DcLimits_t;
+
+static inline void SECC_DcLimits_Pack(const SECC_DcLimits_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)(m->ev_max_voltage & 0xFFU);
+    data[1] = (uint8_t)((m->ev_max_voltage >> 8) & 0xFFU);
+    data[2] = (uint8_t)(m->ev_max_current & 0xFFU);
+    data[3] = (uint8_t)((m->ev_max_current >> 8) & 0xFFU);
+}
+
+static inline void SECC_DcLimits_Unpack(const uint8_t *data, SECC_DcLimits_t *m)
+{
+    m->ev_max_voltage = (uint16_t)((uint32_t)data[0] | ((uint32_t)data[1] << 8));
+    m->ev_max_current = (uint16_t)((uint32_t)data[2] | ((uint32_t)data[3] << 8));
+}
+
+// 0x613 SECC_Temps: Connector DC pin and cable NTCs, measured by the SECC board at the gun (1 s)
+#define SECC_TEMPS_ID                0x613U
+#define SECC_TEMPS_ID_TYPE           CAN_ID_STD
+#define SECC_TEMPS_FD                0
+#define SECC_TEMPS_LEN               6U
+#define SECC_TEMPS_MIN_LEN           6U // Bytes carrying signals
+
+typedef struct
+{
+    int16_t temp_dc_plus;            // 0.1 degC/bit (-3276.8 (0x8000) = sensor open or shorted, same for all three)
+    int16_t temp_dc_minus;           // 0.1 degC/bit
+    int16_t temp_cable;              // 0.1 degC/bit
+} SECC_Temps_t;
+
+static inline void SECC_Temps_Pack(const SECC_Temps_t *m, uint8_t *data)
+{
+    data[0] = (uint8_t)((uint32_t)m->temp_dc_plus & 0xFFU);
+    data[1] = (uint8_t)(((uint32_t)m->temp_dc_plus >> 8) & 0xFFU);
+    data[2] = (uint8_t)((uint32_t)m->temp_dc_minus & 0xFFU);
+    data[3] = (uint8_t)(((uint32_t)m->temp_dc_minus >> 8) & 0xFFU);
+    data[4] = (uint8_t)((uint32_t)m->temp_cable & 0xFFU);
+    data[5] = (uint8_t)(((uint32_t)m->temp_cable >> 8) & 0xFFU);
+}
+
+static inline void SECC_Temps_Unpack(const uint8_t *data, SECC_Temps_t *m)
+{
+    m->temp_dc_plus = (int16_t)((((uint32_t)data[0] | ((uint32_t)data[1] << 8)) ^ 0x8000U) - 0x8000U);
+    m->temp_dc_minus = (int16_t)((((uint32_t)data[2] | ((uint32_t)data[3] << 8)) ^ 0x8000U) - 0x8000U);
+    m->temp_cable = (int16_t)((((uint32_t)data[4] | ((uint32_t)data[5] << 8)) ^ 0x8000U) - 0x8000U);
+}
+
+#endif /* MODULES_CAN_CAN_DB_SECC_H_ */
@@ -3,21 +3,143 @@
  * @brief   FDCAN Driver (HAL Wrapper)
  * @author  Antigravity
  * @date    2026-01-31
+ *
+ * @note    RX path is deferred: the FDCAN ISR only copies frames into a
+ *          per-bus SPSC queue and notifies the CAN task, which drains the
+ *          queues (CAN_ProcessRx) and calls the registered route handler.
+ *
+ * @note    Routing: each protocol driver registers its ID ranges per bus
+ *          (CAN_RegisterRxRange). Every range is programmed into one FDCAN
+ *          standard/extended filter element; frames outside all ranges are
+ *          rejected by the hardware. The matched filter index reported in
+ *          the RX header selects the handler in O(1).
+ *
+ * @note    Urgent routes (CAN_RegisterRxRangeUrgent) are filtered into RX
+ *          FIFO1, which signals on FDCAN interrupt line 1 at
+ *          CAN_URGENT_IRQ_PRIORITY (above line 0). Their handler runs right
+ *          in that ISR, so safety frames are decoded within microseconds of
+ *          EOF even when FIFO0 and the CAN task are flooded.
+ *
+ * @note    CAN FD: FDCAN1 runs FD with bit rate switching (500k / 2M).
+ *          An FD-enabled controller still accepts classic frames, so
+ *          CAN_Transmit() keeps sending classic frames and CAN_TransmitFD()
+ *          is used only once the peer is known to be FD-capable.
+ *
+ * @note    TX path: frames go into a software queue per bus and priority
+ *          class, and are moved into the 3-slot hardware TX queue from the
+ *          TX-complete interrupt. The hardware runs in queue mode (lowest
+ *          ID first) and stores a TX event per frame; the event's message
+ *          marker carries the class so delivery is counted per class.
+ *          Queueing is allowed from tasks and ISRs, including an urgent
+ *          handler of one bus sending on another: the queues, the hardware
+ *          put index and the TX statistics are only touched under PRIMASK,
+ *          in the TX interrupts as well.
+ *
+ * @note    Timestamps: the FDCAN timestamp counter runs from TIM3 (1 MHz,
+ *          external source) and is extended to the 64-bit Timebase, so
+ *          timestamp_us is the start-of-frame time on the wire.
  */
 
 #ifndef MODULES_CAN_CAN_DRIVER_H_
 #define MODULES_CAN_CAN_DRIVER_H_
 
 #include "stm32g4xx_hal.h"
+#include "cmsis_os.h"
+#include "timebase.h"
 #include <stdbool.h>
 
+// --- Configuration ---
+#define CAN_BUS_COUNT        3   // FDCAN1..3
+#define CAN_RX_QUEUE_SIZE    32  // Frames per bus (Must be power of 2)
+#define CAN_MAX_STD_ROUTES   28  // Standard filter elements per FDCAN (Message RAM limit)
+#define CAN_MAX_EXT_ROUTES   8   // Extended filter elements per FDCAN (Message RAM limit)
+
+#define CAN_STD_ID_MAX       0x7FFU // IDs above this are sent/received as 29-bit
+
+#define CAN_CLASSIC_MAX_LEN  8   // Classic CAN payload
+#define CAN_FD_MAX_LEN       64  // CAN FD payload
+
+#define CAN_TX_QUEUE_SIZE    8   // Frames per bus and priority class
+#define CAN_PROBE_ANY_BYTE   0xFFU // CAN_TxProbeArm(): match the ID only
+
+#define CAN_MAX_TAPS         2   // Traffic observers (recorder, gateway)
+
+// Interrupt line 1 (RX FIFO1, urgent routes). Line 0 runs at 6 (TestFw.ioc);
+// 5 is the highest priority allowed to call the RTOS API
+#define CAN_URGENT_IRQ_PRIORITY  5
+
+// Thread flag used to wake the CAN task from the ISR
+#define CAN_RX_THREAD_FLAG   0x0001U
+
+// Bus Index (One per FDCAN instance)
+typedef enum
+{
+    CAN_BUS_SECC = 0,  // FDCAN1
+    CAN_BUS_POWER,     // FDCAN2
+    CAN_BUS_IMD,       // FDCAN3
+} CAN_Bus_t;
+
+// Identifier Type
+typedef enum
+{
+    CAN_ID_STD = 0,    // 11-bit
+    CAN_ID_EXT,        // 29-bit
+} CAN_IdType_t;
+
 typedef struct
 {
+    uint64_t timestamp_us; // SOF time (Timebase, us)
     uint32_t id;
     uint8_t  len;
-    uint8_t  data[8];
+    uint8_t  bus;          // CAN_Bus_t
+    uint8_t  id_type;      // CAN_IdType_t
+    uint8_t  filter_index; // Matched hardware filter element
+    uint8_t  fd;           // 1 = CAN FD frame (FDF set), 0 = Classic
+    uint8_t  brs;          // 1 = Data phase at the data bit rate
+    uint8_t  data[CAN_FD_MAX_LEN];
 } CAN_Message_t;
 
+// TX Priority Class (Lower value is sent first)
+typedef enum
+{
+    CAN_TX_PRIO_CRITICAL = 0,  // Power setpoints, safety
+    CAN_TX_PRIO_STATUS,        // Periodic status
+    CAN_TX_PRIO_DIAG,          // Diagnostics, test frames
+    CAN_TX_PRIO_COUNT
+} CAN_TxPriority_t;
+
+// Route Handler (Called from CAN task context; urgent routes: from the FIFO1 ISR)
+typedef void (*CAN_RxHandler_t)(const CAN_Message_t *msg);
+
+// Traffic Tap (RX: called from the FDCAN ISR for every received frame,
+// TX: called from the sender's context when a frame is queued)
+typedef void (*CAN_TapFn_t)(const CAN_Message_t *msg, bool tx);
+
+// Per-bus RX Queue Statistics
+typedef struct
+{
+    uint32_t rx_count;    // Frames queued by the ISR
+    uint32_t overruns;    // Frames dropped because the queue was full
+    uint16_t high_water;  // Max queue depth observed
+    uint32_t latency_last_us; // SOF on the wire -> handler, last frame
+    uint32_t latency_max_us;  // SOF on the wire -> handler, max
+    uint32_t urgent_count;    // Frames handled in the FIFO1 ISR
+    uint32_t urgent_latency_max_us; // SOF on the wire -> urgent handler, max
+} CAN_RxStats_t;
+
+// Per-bus TX Statistics (Indexed by CAN_TxPriority_t)
+typedef struct
+{
+    uint32_t queued[CAN_TX_PRIO_COUNT];     // Accepted into the software queue
+    uint32_t delivered[CAN_TX_PRIO_COUNT];  // Confirmed by the TX event FIFO
+    uint32_t drops[CAN_TX_PRIO_COUNT];      // Rejected because the class queue was full
+    uint8_t  high_water[CAN_TX_PRIO_COUNT]; // Max software queue depth observed
+    uint32_t events_lost;                   // TX event FIFO overflow (delivery unknown)
+    uint32_t latency_last_us[CAN_TX_PRIO_COUNT]; // Queue -> SOF on the wire, last frame
+    uint32_t latency_max_us[CAN_TX_PRIO_COUNT];  // Queue -> SOF on the wire, max
+    uint64_t last_tx_us;                    // SOF of the last confirmed frame
+} CAN_TxStats_t;
+
 /**
  * @brief Initialize FDCAN
  *        - Configures Filters
@@ -27,26 +149,154 @@ typedef struct
  */
 void CAN_Driver_Init(FDCAN_HandleTypeDef *hfdcan);
 
-// Callback Type
-typedef void (*CAN_RxCallback_t)(uint32_t id, uint8_t *data, uint8_t len);
+/**
+ * @brief Register an RX ID range on a bus
+ * @note  Programs one FDCAN filter element (range type). Frames matching it
+ *        are dispatched to the handler; everything else is dropped by HW.
+ * @param hfdcan FDCAN Handle (must be initialized by CAN_Driver_Init)
+ * @param id_type CAN_ID_STD or CAN_ID_EXT
+ * @param first_id First ID of the range (inclusive)
+ * @param last_id Last ID of the range (inclusive)
+ * @param handler Handler for matching frames
+ * @return true if success, false if filter table full or invalid range
+ */
+bool CAN_RegisterRxRange(FDCAN_HandleTypeDef *hfdcan, CAN_IdType_t id_type,
+                         uint32_t first_id, uint32_t last_id, CAN_RxHandler_t handler);
+
+/**
+ * @brief Register an urgent RX ID range (RX FIFO1, handled in the ISR)
+ * @note  For the few frames that must act with bounded latency (safety
+ *        trips, stop commands). The handler runs at CAN_URGENT_IRQ_PRIORITY:
+ *        it must be short, must not block or print, and has to treat data
+ *        shared with tasks as ISR data (PRIMASK on the task side).
+ * @return true if success, false if filter table full or invalid range
+ */
+bool CAN_RegisterRxRangeUrgent(FDCAN_HandleTypeDef *hfdcan, CAN_IdType_t id_type,
+                               uint32_t first_id, uint32_t last_id, CAN_RxHandler_t handler);
+
+/**
+ * @brief FDCAN interrupt line 1 handler (RX FIFO1 only)
+ * @note  Called from FDCANx_IT1_IRQHandler instead of HAL_FDCAN_IRQHandler,
+ *        so line 0 (HAL) and line 1 never drain the same FIFO.
+ */
+void CAN_UrgentIRQHandler(FDCAN_HandleTypeDef *hfdcan);
+
+/**
+ * @brief Register the thread that drains the RX queues
+ * @note  The ISR sets CAN_RX_THREAD_FLAG on this thread for every burst.
+ * @param thread_id CMSIS-RTOS2 thread ID
+ */
+void CAN_SetRxThread(osThreadId_t thread_id);
 
-// Register Rx Callback
-void CAN_SetRxCallback(CAN_RxCallback_t callback);
+/**
+ * @brief Drain all RX queues and dispatch to the route handlers
+ * @note  Call from the CAN task after CAN_RX_THREAD_FLAG is raised.
+ */
+void CAN_ProcessRx(void);
 
 /**
- * @brief Send a Standard CAN Frame
+ * @brief Queue a CAN Frame (Classic)
  * @param hfdcan FDCAN Handle
- * @param id Standard ID (11-bit)
+ * @param id Identifier (IDs above CAN_STD_ID_MAX are sent as 29-bit extended)
  * @param data Data buffer (max 8 bytes)
  * @param len Data length
- * @return true if success
+ * @param prio Priority class
+ * @return true if queued, false if the class queue is full (counted as drop)
+ */
+bool CAN_Transmit(FDCAN_HandleTypeDef *hfdcan, uint32_t id, const uint8_t *data, uint8_t len,
+                  CAN_TxPriority_t prio);
+
+/**
+ * @brief Send a CAN FD Frame with Bit Rate Switching
+ * @note  len is rounded up to the next valid FD length (12,16,20,24,32,48,64)
+ *        and the tail is zero-padded. Instance must be configured for FD_BRS.
+ * @param hfdcan FDCAN Handle
+ * @param id Identifier (IDs above CAN_STD_ID_MAX are sent as 29-bit extended)
+ * @param data Data buffer (max 64 bytes)
+ * @param len Data length
+ * @param prio Priority class
+ * @return true if queued, false if the class queue is full (counted as drop)
+ */
+bool CAN_TransmitFD(FDCAN_HandleTypeDef *hfdcan, uint32_t id, const uint8_t *data, uint8_t len,
+                    CAN_TxPriority_t prio);
+
+/**
+ * @brief Arm the one-shot TX probe of a bus (task or ISR)
+ * @param byte  Payload byte that must equal value as well, CAN_PROBE_ANY_BYTE
+ *              to match the ID only (frames several senders share an ID with)
+ * @note  Catches the SOF of the first matching frame queued from now on
+ *        (TX event), for end-to-end latency of event-driven frames.
+ *        Re-arming discards a pending probe.
  */
-bool CAN_Transmit(FDCAN_HandleTypeDef *hfdcan, uint32_t id, uint8_t *data, uint8_t len);
+void CAN_TxProbeArm(FDCAN_HandleTypeDef *hfdcan, uint32_t id, uint8_t byte, uint8_t value);
 
 /**
- * @brief Check if a message was received (Simple flag check, or buffer availability)
- *        (Implementation depends on buffering strategy)
+ * @brief Read the TX probe result
+ * @param sof_us Output: SOF of the probed frame on the wire
+ * @return true once the probed frame was sent (then the probe is idle)
+ */
+bool CAN_TxProbeRead(FDCAN_HandleTypeDef *hfdcan, uint64_t *sof_us);
+
+/**
+ * @brief Attach a traffic tap (all buses, RX and TX)
+ * @note  RX taps run in the ISR and see frames the queue had to drop, so
+ *        they must be short and must not block.
+ * @return true if attached, false if the tap table is full
+ */
+bool CAN_AddTap(CAN_TapFn_t tap);
+
+/**
+ * @brief Inject a received frame as if it came from the bus
+ * @note  The route is looked up by ID in software (no filter index), the
+ *        frame is queued and dispatched by the next CAN_ProcessRx().
+ *        Used by replay; taps are not called.
+ * @param msg Frame (bus, id, id_type, len, fd, data, timestamp_us)
+ * @return true if queued, false if no route matches or the queue is full
+ */
+bool CAN_InjectRx(const CAN_Message_t *msg);
+
+/**
+ * @brief Check if any RX queue holds undispatched frames
  */
 bool CAN_IsMessageAvailable(void);
 
+/**
+ * @brief Get RX queue statistics for a bus
+ * @param bus Bus index
+ * @param stats Output
+ * @return false if bus index is invalid
+ */
+bool CAN_GetRxStats(CAN_Bus_t bus, CAN_RxStats_t *stats);
+
+/**
+ * @brief Get TX statistics for a bus
+ * @param bus Bus index
+ * @param stats Output
+ * @return false if bus index is invalid
+ */
+bool CAN_GetTxStats(CAN_Bus_t bus, CAN_TxStats_t *stats);
+
+/**
+ * @brief Free slots in a class queue (for senders that pace themselves)
+ * @note  A hint, not a reservation: a class can have several senders
+ *        (DIAG: ISO-TP, the CLI can_test frame and the Infy status queries),
+ *        so a CAN_Transmit() after it can still fail. Senders keep their
+ *        data on failure and retry (ISO-TP sends the same CF next call).
+ * @return Free slots, 0 if the handle or class is invalid
+ */
+uint8_t CAN_TxFree(FDCAN_HandleTypeDef *hfdcan, CAN_TxPriority_t prio);
+
+/**
+ * @brief Restart the TX pump after the controller was re-initialized
+ * @note  Used by bus-off recovery: frames still in the software queue
+ *        would otherwise wait for a TX-complete that never comes.
+ */
+void CAN_TxResume(FDCAN_HandleTypeDef *hfdcan);
+
+/**
+ * @brief Get bus index for an FDCAN handle
+ * @return Bus index, or -1 if not an FDCAN instance
+ */
+int CAN_GetBusIndex(FDCAN_HandleTypeDef *hfdcan);
+
 #endif /* MODULES_CAN_CAN_DRIVER_H_ */
@@ -0,0 +1,81 @@
+/**
+ * @file    can_gateway.h
+ * @brief   CAN-over-UDP Gateway (Remote Bus Observation on the W5500)
+ *
+ * @note    Frames seen by the CAN driver taps (RX and TX) are filtered by
+ *          bus and ID range, rate limited and queued from the tap; the OCPP
+ *          task (owner of the W5500 SPI) batches them into UDP datagrams.
+ *          Only frames the controller accepts (routed IDs) or sends are
+ *          visible, the hardware filters drop the rest.
+ *
+ * @note    Wire format is cannelloni v2 (one UDP port per bus: gw_port +
+ *          CAN_Bus_t), so a Linux host can bridge each bus to SocketCAN:
+ *              cannelloni -I vcan1 -R <controller ip> -r 20001 -l 20001
+ *          Tools/gateway/canudp.py prints or bridges all buses without it.
+ *          Datagram: u8 version (2), u8 op (0 = data), u8 seq, u16 count (BE),
+ *          then per frame u32 can_id (BE, bit 31 = EFF), u8 len (| 0x80 = FD),
+ *          [u8 flags (0x01 = BRS) if FD], len data bytes.
+ *
+ * @note    Settings (SystemConfig_t gw_*) are read by Gateway_Start(); with
+ *          gw_enable set the gateway starts at boot, so a cabinet can be
+ *          observed remotely after a UDS config download.
+ */
+
+#ifndef MODULES_CAN_CAN_GATEWAY_H_
+#define MODULES_CAN_CAN_GATEWAY_H_
+
+#include "can_driver.h"
+
+// --- Configuration ---
+#define GW_SOCKET            1      // W5500 socket (0 = OCPP)
+#define GW_LOCAL_PORT        20000
+#define GW_QUEUE_SIZE        64     // Frames between tap and OCPP task (Must be power of 2)
+#define GW_DATAGRAM_MAX      1200   // Bytes per datagram (below the Ethernet MTU)
+#define GW_BATCH_MS          20     // Max age of a frame waiting for its datagram to fill
+#define GW_BURST_MS          100    // Rate limit bucket depth (time at gw_rate_fps)
+#define GW_RETRY_MS          5000   // Socket open retry while started
+
+typedef struct
+{
+    bool     running;
+    uint32_t forwarded;          // Frames in confirmed datagrams
+    uint32_t filtered;           // Frames outside the bus mask / ID range
+    uint32_t rate_drops;         // Frames over the rate limit
+    uint32_t queue_drops;        // Frames dropped, queue full (OCPP task blocked)
+    uint32_t datagrams;          // Datagrams sent
+    uint32_t send_fails;         // Datagrams the W5500 did not confirm (frames lost)
+} GW_Stats_t;
+
+/**
+ * @brief Attach to the CAN driver taps, start if gw_enable is set
+ * @note  Call after CAN_Driver_Init and Config_Init.
+ */
+void Gateway_Init(void);
+
+/**
+ * @brief Request forwarding with the current config (gw_* fields)
+ * @note  Any task: the socket is opened by the next Gateway_Process().
+ */
+void Gateway_Start(void);
+
+/**
+ * @brief Request stop (taps stop at once, socket closed by Gateway_Process)
+ */
+void Gateway_Stop(void);
+
+/**
+ * @brief Batch queued frames and send due datagrams (OCPP task)
+ */
+void Gateway_Process(void);
+
+/**
+ * @brief CAN driver tap (RX from ISR, TX at enqueue)
+ */
+void Gateway_CanTap(const CAN_Message_t *msg, bool tx);
+
+/**
+ * @brief Get gateway statistics
+ */
+void Gateway_GetStats(GW_Stats_t *stats);
+
+#endif /* MODULES_CAN_CAN_GATEWAY_H_ */
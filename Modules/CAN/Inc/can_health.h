@@ -0,0 +1,103 @@
+/**
+ * @file    can_health.h
+ * @brief   FDCAN Bus Health (Error States, Bus-Off Recovery, Load)
+ *
+ * @note    Error-warning / error-passive / bus-off are reported by interrupt
+ *          and recorded immediately. Recovery and counter snapshots run from
+ *          CAN_Health_Process() in the CAN task (every CAN_HEALTH_PERIOD_MS):
+ *          after a bus-off the controller is restarted (CCCR.INIT cleared)
+ *          with exponential backoff, so a shorted bus is not hammered.
+ *
+ * @note    Load is estimated from frame lengths (RX + own TX confirmed by the
+ *          TX event FIFO) and the configured bit timings, ~10% stuffing.
+ */
+
+#ifndef MODULES_CAN_CAN_HEALTH_H_
+#define MODULES_CAN_CAN_HEALTH_H_
+
+#include "can_driver.h"
+
+// --- Configuration ---
+#define CAN_HEALTH_PERIOD_MS       10    // Process interval (CAN task)
+#define CAN_HEALTH_BACKOFF_MIN_MS  10    // First recovery attempt after bus-off
+#define CAN_HEALTH_BACKOFF_MAX_MS  1000  // Backoff cap (doubles per bus-off)
+#define CAN_HEALTH_STABLE_MS       5000  // Error-free time that resets the backoff
+#define CAN_HEALTH_FAULT_MS        1000  // Bus-off longer than this is a fault
+#define CAN_HEALTH_LOAD_WINDOW_MS  1000  // Utilisation window
+
+// Buses whose failure faults the state machine (SECC loss is handled by heartbeat)
+#define CAN_HEALTH_FAULT_MASK      ((1U << CAN_BUS_POWER) | (1U << CAN_BUS_IMD))
+
+// Error State (Fault confinement)
+typedef enum
+{
+    CAN_STATE_ACTIVE = 0,  // TEC/REC < 96
+    CAN_STATE_WARNING,     // TEC or REC >= 96
+    CAN_STATE_PASSIVE,     // TEC or REC >= 128
+    CAN_STATE_BUS_OFF,     // TEC > 255, controller stopped
+} CAN_ErrorState_t;
+
+typedef struct
+{
+    CAN_ErrorState_t state;
+    uint8_t  tec;                // Transmit Error Counter (Snapshot)
+    uint8_t  rec;                // Receive Error Counter (Snapshot)
+    uint8_t  last_error_code;    // PSR.LEC (0=None, 1=Stuff, 2=Form, 3=Ack, 4=Bit1, 5=Bit0, 6=CRC)
+    uint32_t warning_count;      // Entries into error-warning
+    uint32_t passive_count;      // Entries into error-passive
+    uint32_t bus_off_count;      // Entries into bus-off
+    uint32_t recoveries;         // Successful rejoins after bus-off
+    uint32_t rx_lost;            // RX FIFO message lost (RF0L / RF1L)
+    uint16_t load_permille;      // Utilisation, last window (0..1000)
+    uint16_t load_peak_permille; // Highest window since boot
+    uint32_t backoff_ms;         // Current recovery backoff
+    bool     fault;              // Bus-off too long or flapping
+} CAN_HealthStatus_t;
+
+/**
+ * @brief Initialize health tracking for an FDCAN instance
+ * @note  Called by CAN_Driver_Init() before the instance is started.
+ */
+void CAN_Health_Init(FDCAN_HandleTypeDef *hfdcan);
+
+/**
+ * @brief Bus-off recovery, TEC/REC snapshot and load window
+ * @note  Call every CAN_HEALTH_PERIOD_MS from the CAN task.
+ */
+void CAN_Health_Process(void);
+
+/**
+ * @brief Account one frame on the bus for the load estimate (ISR safe)
+ * @param bus Bus index
+ * @param ext 29-bit identifier
+ * @param len Payload bytes
+ * @param fd CAN FD frame
+ * @param brs Data phase at the data bit rate
+ */
+void CAN_Health_OnFrame(int bus, bool ext, uint8_t len, bool fd, bool brs);
+
+/**
+ * @brief Wire time of one frame (same estimate as the load, ISR safe)
+ * @return ns at the bus' configured bit timings, 0 for an unknown bus
+ * @note  For drivers that budget their own share of the bus.
+ */
+uint32_t CAN_Health_FrameNs(int bus, bool ext, uint8_t len, bool fd, bool brs);
+
+/**
+ * @brief Count an RX FIFO message-lost event (ISR)
+ */
+void CAN_Health_OnRxLost(int bus);
+
+/**
+ * @brief Get health status snapshot for a bus
+ * @return false if bus index is invalid
+ */
+bool CAN_Health_GetStatus(CAN_Bus_t bus, CAN_HealthStatus_t *status);
+
+/**
+ * @brief Check buses in CAN_HEALTH_FAULT_MASK for a fault
+ * @return true if any of them is faulted
+ */
+bool CAN_Health_IsFaulted(void);
+
+#endif /* MODULES_CAN_CAN_HEALTH_H_ */
@@ -0,0 +1,115 @@
+/**
+ * @file    can_sched.h
+ * @brief   Cyclic / Event-Triggered CAN TX Scheduler
+ *
+ * @note    Every outgoing periodic frame is declared once by its driver:
+ *          period, phase offset within the period, and optionally an
+ *          on-change trigger with a minimum interval between sends. The
+ *          scheduler ticks every CAN_SCHED_TICK_MS from a periodic osTimer
+ *          and asks the owner to pack the frame when it is due, so periods
+ *          no longer depend on how long the control loop iteration took.
+ *
+ * @note    Periodic slots are always served (a pending event never delays
+ *          them). Events (on-change or CAN_Sched_Trigger()) are sent on the
+ *          next tick unless the last send of that frame is younger than
+ *          min_interval_ms, in which case they wait for it to expire.
+ *
+ * @note    Offsets spread the frames of one bus over distinct ticks, so the
+ *          queue never receives a burst at the start of every period.
+ */
+
+#ifndef MODULES_CAN_CAN_SCHED_H_
+#define MODULES_CAN_CAN_SCHED_H_
+
+#include "can_driver.h"
+
+// --- Configuration ---
+#define CAN_SCHED_MAX_MSGS   20  // Declared frames (all buses)
+#define CAN_SCHED_TICK_MS    1   // Timer period (periods/offsets are in ms)
+
+// Declaration Flags
+#define CAN_SCHED_FD         0x01 // Send with CAN_TransmitFD() (FD BRS bus only)
+#define CAN_SCHED_ON_CHANGE  0x02 // Send when the packed payload changes
+
+/**
+ * @brief Pack callback (runs in the timer task)
+ * @param data Output payload (CAN_FD_MAX_LEN bytes available)
+ * @param arg  Declaration's arg (e.g. connector / outlet of the frame)
+ * @return Payload length, 0 = nothing to send in this slot
+ * @note  For CAN_SCHED_ON_CHANGE frames it runs every tick to compare the
+ *        payload, so it must not have side effects (counters etc.).
+ */
+typedef uint8_t (*CAN_SchedPackFn_t)(uint8_t *data, uint8_t arg);
+
+typedef struct
+{
+    FDCAN_HandleTypeDef *hfdcan;
+    uint32_t id;                 // >0x7FF is sent as 29-bit
+    uint16_t period_ms;          // 0 = event only
+    uint16_t offset_ms;          // Phase within the period (< period_ms)
+    uint16_t min_interval_ms;    // Minimum gap before an event send
+    uint8_t  flags;              // CAN_SCHED_*
+    CAN_TxPriority_t prio;
+    CAN_SchedPackFn_t pack;
+    uint8_t  arg;                // Passed to pack (one packer, several instances)
+} CAN_SchedMsg_t;
+
+typedef struct
+{
+    uint32_t periodic;           // Sent in their periodic slot
+    uint32_t events;             // Sent on change / trigger
+    uint32_t held;               // Ticks an event waited for min_interval_ms
+    uint32_t tx_fail;            // Rejected by the TX queue
+    uint32_t superseded;         // Packed frame dropped: CAN_Sched_MarkSent() in between
+} CAN_SchedStats_t;
+
+/**
+ * @brief Declare a frame (before CAN_Sched_Start())
+ * @param msg Declaration (copied)
+ * @return Handle (>= 0), -1 if the table is full or the declaration is invalid
+ */
+int CAN_Sched_Register(const CAN_SchedMsg_t *msg);
+
+/**
+ * @brief Request an event send of a declared frame (task or ISR)
+ */
+void CAN_Sched_Trigger(int handle);
+
+/**
+ * @brief Record a send the owner made itself (task or ISR)
+ * @note  For event-driven fast paths that queue a declared frame with
+ *        CAN_Transmit() right away: the payload becomes the on-change
+ *        reference, so the next tick does not send it a second time.
+ *        A tick that packed the frame before the call drops its payload
+ *        instead of queueing the older value behind the new one.
+ */
+void CAN_Sched_MarkSent(int handle, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Create and start the periodic tick timer
+ * @note  Call once the drivers have registered their frames.
+ */
+void CAN_Sched_Start(void);
+
+/**
+ * @brief One scheduler tick (timer callback body; host tools call it directly)
+ */
+void CAN_Sched_Tick(void);
+
+/**
+ * @brief Get declaration and counters of a frame
+ * @return false if the handle is invalid
+ */
+bool CAN_Sched_GetMsg(int handle, CAN_SchedMsg_t *msg, CAN_SchedStats_t *stats);
+
+/**
+ * @brief Number of declared frames
+ */
+int CAN_Sched_GetCount(void);
+
+/**
+ * @brief Largest tick lateness seen (timer task preempted), us
+ */
+uint32_t CAN_Sched_GetMaxLateUs(void);
+
+#endif /* MODULES_CAN_CAN_SCHED_H_ */
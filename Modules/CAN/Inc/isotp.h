@@ -0,0 +1,114 @@
+/**
+ * @file    isotp.h
+ * @brief   ISO 15765-2 Transport (ISO-TP) on top of the CAN driver
+ *
+ * @note    One link = one pair of physical IDs (RX/TX) on one bus. The
+ *          owner routes the RX ID to its handler and forwards frames with
+ *          ISOTP_OnFrame(); complete messages come back through the rx
+ *          callback. Everything runs in the CAN task (no locking).
+ *
+ * @note    Frame format follows the peer: a request received as CAN FD is
+ *          answered with FD frames (TX_DL 64, SF escape for > 7 bytes),
+ *          a classic request with 8-byte frames padded with 0xCC.
+ *
+ * @note    Sending is paced by flow control (BS / STmin from the peer) and
+ *          by the free slots of the DIAG class queue, so a long message
+ *          never pushes out status or critical frames. While a transfer
+ *          is active call ISOTP_Process() every 1 ms (ISOTP_IsBusy()).
+ */
+
+#ifndef MODULES_CAN_ISOTP_H_
+#define MODULES_CAN_ISOTP_H_
+
+#include "can_driver.h"
+
+// --- Configuration ---
+#define ISOTP_BUF_SIZE       4095  // Max message (12-bit FF_DL, no escape)
+#define ISOTP_RX_BS          0     // Our block size (0 = no further FC)
+#define ISOTP_RX_STMIN       0     // Our STmin (ms)
+#define ISOTP_TIMEOUT_MS     1000  // N_Bs / N_Cr
+#define ISOTP_MAX_WFT        10    // FC.WAIT frames accepted per block
+#define ISOTP_PAD_BYTE       0xCC
+
+/**
+ * @brief Complete message received (CAN task)
+ * @param data Payload (valid until the callback returns)
+ * @param len Payload length
+ * @param fd Received as CAN FD
+ */
+typedef void (*ISOTP_RxFn_t)(const uint8_t *data, uint16_t len, bool fd);
+
+typedef struct
+{
+    uint32_t rx_msgs;            // Complete messages received
+    uint32_t tx_msgs;            // Complete messages sent
+    uint32_t rx_errors;          // Wrong SN, unexpected CF, bad length
+    uint32_t rx_overflow;        // FF_DL above ISOTP_BUF_SIZE (FC.OVFLW sent)
+    uint32_t timeouts;           // N_Bs / N_Cr expired
+    uint32_t tx_aborted;         // FC.OVFLW or too many FC.WAIT from the peer
+} ISOTP_Stats_t;
+
+typedef struct
+{
+    FDCAN_HandleTypeDef *hfdcan;
+    uint32_t tx_id;
+    ISOTP_RxFn_t on_rx;
+    bool     fd;                 // Frame format of the last received frame
+
+    // Reception
+    uint8_t  rx_state;
+    uint8_t  rx_sn;              // Next expected sequence number
+    uint8_t  rx_block;           // CFs received in the current block
+    uint16_t rx_len;
+    uint16_t rx_pos;
+    uint8_t  rx_dl;              // Frame length of the FF (CF length)
+    uint32_t rx_tick;
+    uint8_t  rx_buf[ISOTP_BUF_SIZE];
+
+    // Transmission
+    uint8_t  tx_state;
+    uint8_t  tx_sn;
+    uint8_t  tx_bs;              // Block size from the peer FC
+    uint8_t  tx_block;           // CFs sent in the current block
+    uint8_t  tx_wft;             // FC.WAIT received in the current block
+    uint8_t  tx_dl;              // 8 or 64
+    uint16_t tx_len;
+    uint16_t tx_pos;
+    uint32_t tx_stmin_ms;
+    uint32_t tx_tick;
+    uint8_t  tx_buf[ISOTP_BUF_SIZE];
+
+    ISOTP_Stats_t stats;
+} ISOTP_Link_t;
+
+/**
+ * @brief Initialize a link
+ * @param link Link state (static storage, ~8KB)
+ * @param hfdcan Bus
+ * @param tx_id ID of our frames (responses, flow control)
+ * @param on_rx Complete message callback
+ */
+void ISOTP_Init(ISOTP_Link_t *link, FDCAN_HandleTypeDef *hfdcan, uint32_t tx_id, ISOTP_RxFn_t on_rx);
+
+/**
+ * @brief Feed a received frame of the link's RX ID (CAN task)
+ */
+void ISOTP_OnFrame(ISOTP_Link_t *link, const CAN_Message_t *msg);
+
+/**
+ * @brief Start sending a message
+ * @return false if a transmission is in progress or len is too long
+ */
+bool ISOTP_Send(ISOTP_Link_t *link, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Send pending consecutive frames and check timeouts (CAN task)
+ */
+void ISOTP_Process(ISOTP_Link_t *link);
+
+/**
+ * @brief Check if a transfer (either direction) is in progress
+ */
+bool ISOTP_IsBusy(const ISOTP_Link_t *link);
+
+#endif /* MODULES_CAN_ISOTP_H_ */
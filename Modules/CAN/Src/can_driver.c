@@ -1,101 +1,785 @@
 /**
  * @file    can_driver.c
  * @brief   FDCAN Driver Implementation
+ *
+ * @details
+ * RX frames are copied by the ISR into a lock-free single-producer /
+ * single-consumer queue per FDCAN instance (producer: FDCAN ISR,
+ * consumer: CAN task). Decoding happens in CAN_ProcessRx(), so the ISR
+ * cost does not depend on the protocol behind the ID.
+ *
+ * Acceptance filtering is done in hardware from the route table: the
+ * global filter rejects everything that no registered range matches.
+ *
+ * Queue slots hold full 64-byte FD payloads; classic frames use 8.
+ *
+ * TX frames wait in per-class rings (critical > status > diag). The pump
+ * moves the highest class into the hardware TX queue while it has free
+ * slots; it runs on enqueue (inside a critical section) and from the
+ * TX-complete interrupt. Delivery is confirmed from the TX event FIFO.
+ *
+ * The message marker is (tag << 2) | class. The tag indexes a small table
+ * holding the enqueue time of each frame in the hardware, so the TX event
+ * timestamp gives queue-to-wire latency per class.
+ *
+ * Urgent routes are filtered into RX FIFO1, which is the only interrupt
+ * routed to line 1. Its ISR preempts line 0 and calls the route handler
+ * directly; it never touches the SPSC queues (their producer is the line 0
+ * ISR). Should the HAL line 0 handler see a FIFO1 flag first, it only
+ * re-pends line 1, so a FIFO is always drained from one context.
+ *
+ * Taps see every frame: RX before the queue (so overruns are still
+ * observed), TX when the frame is accepted into the software queue.
  */
 
 #include "can_driver.h"
+#include "can_health.h"
 #include <stdio.h>
 #include <string.h>
 
-static FDCAN_HandleTypeDef *drv_hfdcan = NULL;
-static CAN_RxCallback_t rx_callback = NULL;
+#define CAN_RX_QUEUE_MASK  (CAN_RX_QUEUE_SIZE - 1U)
+
+// TX Message Marker: [7:2] in-flight tag, [1:0] priority class
+#define CAN_TX_MARKER_PRIO_MASK  0x03U
+#define CAN_TX_MARKER_TAG_SHIFT  2U
+#define CAN_TX_TAG_COUNT         16U  // > 3 HW buffers + 3 TX events outstanding
+
+// TX Probe State
+#define CAN_PROBE_IDLE   0U
+#define CAN_PROBE_ARMED  1U  // Waiting for a matching frame to reach the hardware
+#define CAN_PROBE_QUEUED 2U  // In a TX buffer (probe_tag), waiting for its TX event
+#define CAN_PROBE_DONE   3U
+
+#if (CAN_RX_QUEUE_SIZE & CAN_RX_QUEUE_MASK) != 0
+#error "CAN_RX_QUEUE_SIZE must be a power of 2"
+#endif
+
+// SPSC Frame Queue (One per FDCAN instance)
+typedef struct
+{
+    CAN_Message_t     slots[CAN_RX_QUEUE_SIZE];
+    volatile uint16_t head;   // Free-running, written by ISR only
+    volatile uint16_t tail;   // Free-running, written by CAN task only
+    CAN_RxStats_t     stats;
+} CAN_RxQueue_t;
+
+// Route Table Entry (Index == FDCAN filter element index)
+typedef struct
+{
+    uint32_t        first_id;
+    uint32_t        last_id;
+    CAN_RxHandler_t handler;
+    bool            urgent;   // RX FIFO1, handler runs in the line 1 ISR
+} CAN_Route_t;
+
+// Pending TX Frame
+typedef struct
+{
+    uint64_t queued_us; // Enqueue time (latency)
+    uint32_t id;
+    uint8_t  dlc_code;  // FDCAN_DLC_BYTES_x
+    uint8_t  fd;
+    uint8_t  data[CAN_FD_MAX_LEN];
+} CAN_TxFrame_t;
+
+// TX Ring (One per bus and priority class)
+typedef struct
+{
+    CAN_TxFrame_t slots[CAN_TX_QUEUE_SIZE];
+    uint8_t       head;
+    uint8_t       tail;
+    uint8_t       count;
+} CAN_TxRing_t;
+
+typedef struct
+{
+    CAN_TxRing_t  ring[CAN_TX_PRIO_COUNT];
+    CAN_TxStats_t stats;
+    uint64_t      inflight_us[CAN_TX_TAG_COUNT]; // Enqueue time by marker tag
+    uint8_t       next_tag;
+    // One-shot probe (CAN_TxProbeArm)
+    volatile uint8_t probe_state;            // CAN_PROBE_x
+    uint32_t      probe_id;
+    uint8_t       probe_byte;                // Payload byte to match, CAN_PROBE_ANY_BYTE = ID only
+    uint8_t       probe_value;
+    uint8_t       probe_tag;                 // Marker tag of the probed frame (CAN_PROBE_QUEUED)
+    uint64_t      probe_from_us;             // Frames queued before are not the probed one
+    uint64_t      probe_sof_us;
+} CAN_TxQueue_t;
+
+typedef struct
+{
+    CAN_Route_t std[CAN_MAX_STD_ROUTES];
+    CAN_Route_t ext[CAN_MAX_EXT_ROUTES];
+    uint8_t     std_count;
+    uint8_t     ext_count;
+} CAN_RouteTable_t;
+
+static osThreadId_t rx_thread = NULL;
+static CAN_RxQueue_t rx_queues[CAN_BUS_COUNT];
+static CAN_RouteTable_t routes[CAN_BUS_COUNT];
+static CAN_TxQueue_t tx_queues[CAN_BUS_COUNT];
+static FDCAN_HandleTypeDef *bus_handles[CAN_BUS_COUNT];
+static CAN_TapFn_t taps[CAN_MAX_TAPS];
+static uint8_t tap_count = 0;
+
+static const IRQn_Type urgent_irqs[CAN_BUS_COUNT] = {FDCAN1_IT1_IRQn, FDCAN2_IT1_IRQn, FDCAN3_IT1_IRQn};
+
+// DLC Code -> Payload Bytes
+static const uint8_t dlc_to_len[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+
+// Smallest DLC code that holds len bytes
+static uint8_t CAN_LenToDlcCode(uint8_t len)
+{
+    uint8_t code = 0;
+    while (code < 15 && dlc_to_len[code] < len) code++;
+    return code;
+}
+
+// G4 HAL DataLength is the raw DLC code (FDCAN_DLC_BYTES_x)
+static bool CAN_SendFrame(FDCAN_HandleTypeDef *hfdcan, const CAN_TxFrame_t *frame, uint8_t marker)
+{
+    FDCAN_TxHeaderTypeDef TxHeader;
+
+    TxHeader.Identifier = frame->id;
+    TxHeader.IdType = (frame->id > CAN_STD_ID_MAX) ? FDCAN_EXTENDED_ID : FDCAN_STANDARD_ID;
+    TxHeader.TxFrameType = FDCAN_DATA_FRAME;
+    TxHeader.DataLength = frame->dlc_code;
+    TxHeader.ErrorStateIndicator = FDCAN_ESI_ACTIVE;
+    TxHeader.BitRateSwitch = frame->fd ? FDCAN_BRS_ON : FDCAN_BRS_OFF;
+    TxHeader.FDFormat = frame->fd ? FDCAN_FD_CAN : FDCAN_CLASSIC_CAN;
+    TxHeader.TxEventFifoControl = FDCAN_STORE_TX_EVENTS;
+    TxHeader.MessageMarker = marker; // Returned in the TX event
+
+    if (HAL_FDCAN_AddMessageToTxFifoQ(hfdcan, &TxHeader, (uint8_t *)frame->data) != HAL_OK)
+    {
+        return false;
+    }
+    return true;
+}
+
+// Move queued frames into free hardware slots, highest class first.
+// Caller must hold the critical section, the FDCAN ISR as well: a
+// higher-priority ISR (the urgent RX line of another bus, e.g. the
+// Infy_SetOutputFast path) can enqueue on this bus and pump it.
+static void CAN_TxPump(int bus)
+{
+    FDCAN_HandleTypeDef *hfdcan = bus_handles[bus];
+    CAN_TxQueue_t *q = &tx_queues[bus];
+    if (hfdcan == NULL) return;
+
+    for (uint8_t prio = 0; prio < CAN_TX_PRIO_COUNT; prio++)
+    {
+        CAN_TxRing_t *ring = &q->ring[prio];
+        while (ring->count > 0)
+        {
+            if (HAL_FDCAN_GetTxFifoFreeLevel(hfdcan) == 0) return;
+
+            uint8_t tag = q->next_tag;
+            uint8_t marker = (uint8_t)((tag << CAN_TX_MARKER_TAG_SHIFT) | prio);
+            if (!CAN_SendFrame(hfdcan, &ring->slots[ring->tail], marker)) return;
+
+            const CAN_TxFrame_t *frame = &ring->slots[ring->tail];
+            q->inflight_us[tag] = frame->queued_us;
+            if (q->probe_state == CAN_PROBE_ARMED && frame->id == q->probe_id &&
+                frame->queued_us >= q->probe_from_us &&
+                (q->probe_byte == CAN_PROBE_ANY_BYTE || frame->data[q->probe_byte] == q->probe_value))
+            {
+                q->probe_tag = tag;
+                q->probe_state = CAN_PROBE_QUEUED;
+            }
+            q->next_tag = (uint8_t)((tag + 1U) % CAN_TX_TAG_COUNT);
+            ring->tail = (ring->tail + 1U) % CAN_TX_QUEUE_SIZE;
+            ring->count--;
+        }
+    }
+}
+
+static bool CAN_Enqueue(FDCAN_HandleTypeDef *hfdcan, uint32_t id, const uint8_t *data,
+                        uint8_t len, uint8_t dlc_code, bool fd, CAN_TxPriority_t prio)
+{
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0 || (int)prio < 0 || prio >= CAN_TX_PRIO_COUNT) return false;
+
+    CAN_TxQueue_t *q = &tx_queues[bus];
+    CAN_TxRing_t *ring = &q->ring[prio];
+    bool ok = false;
+
+    // FDCAN ISR runs the pump too; mask it while we touch the rings
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (ring->count >= CAN_TX_QUEUE_SIZE)
+    {
+        q->stats.drops[prio]++;
+    }
+    else
+    {
+        CAN_TxFrame_t *frame = &ring->slots[ring->head];
+        frame->queued_us = Timebase_GetMicros();
+        frame->id = id;
+        frame->dlc_code = dlc_code;
+        frame->fd = fd ? 1U : 0U;
+        memcpy(frame->data, data, len);
+        memset(&frame->data[len], 0, dlc_to_len[dlc_code] - len); // FD padding
+
+        ring->head = (ring->head + 1U) % CAN_TX_QUEUE_SIZE;
+        ring->count++;
+        q->stats.queued[prio]++;
+        if (ring->count > q->stats.high_water[prio]) q->stats.high_water[prio] = ring->count;
+        ok = true;
+
+        CAN_TxPump(bus);
+    }
+
+    __set_PRIMASK(primask);
+
+    if (ok && tap_count > 0)
+    {
+        CAN_Message_t msg;
+        msg.timestamp_us = Timebase_GetMicros();
+        msg.id = id;
+        msg.len = fd ? dlc_to_len[dlc_code] : len;
+        msg.bus = (uint8_t)bus;
+        msg.id_type = (id > CAN_STD_ID_MAX) ? CAN_ID_EXT : CAN_ID_STD;
+        msg.filter_index = 0;
+        msg.fd = fd ? 1U : 0U;
+        msg.brs = msg.fd;
+        memcpy(msg.data, data, len);
+        memset(&msg.data[len], 0, msg.len - len);
+
+        for (uint8_t i = 0; i < tap_count; i++) taps[i](&msg, true);
+    }
+    return ok;
+}
+
+// Producer side of the RX queue (FDCAN ISR, or task context under PRIMASK)
+static bool CAN_QueuePush(CAN_RxQueue_t *q, const CAN_Message_t *msg)
+{
+    uint16_t head = q->head;
+    uint16_t depth = (uint16_t)(head - q->tail);
+    if (depth >= CAN_RX_QUEUE_SIZE)
+    {
+        q->stats.overruns++; // Consumer too slow, drop newest
+        return false;
+    }
+
+    q->slots[head & CAN_RX_QUEUE_MASK] = *msg;
+
+    __DMB(); // Slot must be visible before the head moves
+    q->head = head + 1U;
+
+    q->stats.rx_count++;
+    if (depth + 1U > q->stats.high_water) q->stats.high_water = depth + 1U;
+    return true;
+}
+
+int CAN_GetBusIndex(FDCAN_HandleTypeDef *hfdcan)
+{
+    if (hfdcan == NULL) return -1;
+    if (hfdcan->Instance == FDCAN1) return CAN_BUS_SECC;
+    if (hfdcan->Instance == FDCAN2) return CAN_BUS_POWER;
+    if (hfdcan->Instance == FDCAN3) return CAN_BUS_IMD;
+    return -1;
+}
 
 void CAN_Driver_Init(FDCAN_HandleTypeDef *hfdcan)
 {
     if (hfdcan == NULL) return;
-    drv_hfdcan = hfdcan;
 
-    // 1. Configure Filter (Accept All Standard Frames)
-    FDCAN_FilterTypeDef sFilterConfig;
-    sFilterConfig.IdType = FDCAN_STANDARD_ID;
-    sFilterConfig.FilterIndex = 0;
-    sFilterConfig.FilterType = FDCAN_FILTER_MASK;
-    sFilterConfig.FilterConfig = FDCAN_FILTER_TO_RXFIFO0;
-    sFilterConfig.FilterID1 = 0x000;
-    sFilterConfig.FilterID2 = 0x000; // Mask 0x000 = Accept All
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus >= 0)
+    {
+        memset(&rx_queues[bus], 0, sizeof(CAN_RxQueue_t));
+        memset(&routes[bus], 0, sizeof(CAN_RouteTable_t));
+        memset(&tx_queues[bus], 0, sizeof(CAN_TxQueue_t));
+        bus_handles[bus] = hfdcan;
+    }
 
-    if (HAL_FDCAN_ConfigFilter(hfdcan, &sFilterConfig) != HAL_OK)
+    // Error state / bus-off / message-lost tracking
+    CAN_Health_Init(hfdcan);
+
+    // 1. Configure Global Filter (Reject everything no route matches)
+    //    Filter elements are added later by CAN_RegisterRxRange().
+    if (HAL_FDCAN_ConfigGlobalFilter(hfdcan, FDCAN_REJECT, FDCAN_REJECT,
+                                     FDCAN_REJECT_REMOTE, FDCAN_REJECT_REMOTE) != HAL_OK)
     {
         printf("[CAN] Filter Config Error\r\n");
     }
 
-    // 2. Start FDCAN
+    // 2. Timestamp Counter from TIM3 (1 MHz, see Timebase)
+    HAL_FDCAN_ConfigTimestampCounter(hfdcan, FDCAN_TIMESTAMP_PRESC_1);
+    HAL_FDCAN_EnableTimestampCounter(hfdcan, FDCAN_TIMESTAMP_EXTERNAL);
+
+    // 3. RX FIFO1 (urgent routes) on interrupt line 1, above line 0
+    HAL_FDCAN_ConfigInterruptLines(hfdcan, FDCAN_IT_GROUP_RX_FIFO1, FDCAN_INTERRUPT_LINE1);
+    if (bus >= 0)
+    {
+        HAL_NVIC_SetPriority(urgent_irqs[bus], CAN_URGENT_IRQ_PRIORITY, 0);
+        HAL_NVIC_EnableIRQ(urgent_irqs[bus]);
+    }
+
+    // 4. Start FDCAN
     if (HAL_FDCAN_Start(hfdcan) != HAL_OK)
     {
         printf("[CAN] Start Error\r\n");
     }
 
-    // 3. Activate Notification (RX FIFO 0 New Message)
-    if (HAL_FDCAN_ActivateNotification(hfdcan, FDCAN_IT_RX_FIFO0_NEW_MESSAGE, 0) != HAL_OK)
+    // 5. Activate Notification (RX FIFO 0/1, TX Complete -> Pump, TX Event -> Delivery)
+    if (HAL_FDCAN_ActivateNotification(hfdcan,
+                                       FDCAN_IT_RX_FIFO0_NEW_MESSAGE | FDCAN_IT_RX_FIFO1_NEW_MESSAGE |
+                                       FDCAN_IT_RX_FIFO1_MESSAGE_LOST | FDCAN_IT_TX_COMPLETE |
+                                       FDCAN_IT_TX_EVT_FIFO_NEW_DATA | FDCAN_IT_TX_EVT_FIFO_ELT_LOST,
+                                       FDCAN_TX_BUFFER0 | FDCAN_TX_BUFFER1 | FDCAN_TX_BUFFER2) != HAL_OK)
     {
         printf("[CAN] Notification Error\r\n");
     }
 
-    printf("[CAN] Initialized (Rate: 500k/2MB)\r\n");
+    if (hfdcan->Init.FrameFormat == FDCAN_FRAME_FD_BRS)
+    {
+        printf("[CAN] Initialized (Bus %d, FD BRS)\r\n", bus);
+    }
+    else
+    {
+        printf("[CAN] Initialized (Bus %d, Classic)\r\n", bus);
+    }
+}
+
+static bool CAN_AddRoute(FDCAN_HandleTypeDef *hfdcan, CAN_IdType_t id_type,
+                         uint32_t first_id, uint32_t last_id, CAN_RxHandler_t handler, bool urgent)
+{
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0 || handler == NULL || first_id > last_id) return false;
+
+    CAN_RouteTable_t *tbl = &routes[bus];
+    CAN_Route_t *route;
+    FDCAN_FilterTypeDef sFilterConfig;
+
+    if (id_type == CAN_ID_STD)
+    {
+        if (last_id > CAN_STD_ID_MAX || tbl->std_count >= CAN_MAX_STD_ROUTES) return false;
+        sFilterConfig.IdType = FDCAN_STANDARD_ID;
+        sFilterConfig.FilterIndex = tbl->std_count;
+        route = &tbl->std[tbl->std_count];
+    }
+    else
+    {
+        if (last_id > 0x1FFFFFFFU || tbl->ext_count >= CAN_MAX_EXT_ROUTES) return false;
+        sFilterConfig.IdType = FDCAN_EXTENDED_ID;
+        sFilterConfig.FilterIndex = tbl->ext_count;
+        route = &tbl->ext[tbl->ext_count];
+    }
+
+    sFilterConfig.FilterType = FDCAN_FILTER_RANGE;
+    sFilterConfig.FilterConfig = urgent ? FDCAN_FILTER_TO_RXFIFO1 : FDCAN_FILTER_TO_RXFIFO0;
+    sFilterConfig.FilterID1 = first_id;
+    sFilterConfig.FilterID2 = last_id;
+
+    // Route must be valid before the filter element can match
+    route->first_id = first_id;
+    route->last_id = last_id;
+    route->handler = handler;
+    route->urgent = urgent;
+
+    if (HAL_FDCAN_ConfigFilter(hfdcan, &sFilterConfig) != HAL_OK)
+    {
+        route->handler = NULL;
+        printf("[CAN] Filter Config Error (Bus %d, 0x%lX-0x%lX)\r\n", bus, first_id, last_id);
+        return false;
+    }
+
+    if (id_type == CAN_ID_STD) tbl->std_count++;
+    else tbl->ext_count++;
+
+    return true;
 }
 
-void CAN_SetRxCallback(CAN_RxCallback_t callback)
+bool CAN_RegisterRxRange(FDCAN_HandleTypeDef *hfdcan, CAN_IdType_t id_type,
+                         uint32_t first_id, uint32_t last_id, CAN_RxHandler_t handler)
 {
-    rx_callback = callback;
+    return CAN_AddRoute(hfdcan, id_type, first_id, last_id, handler, false);
 }
 
-bool CAN_Transmit(FDCAN_HandleTypeDef *hfdcan, uint32_t id, uint8_t *data, uint8_t len)
+bool CAN_RegisterRxRangeUrgent(FDCAN_HandleTypeDef *hfdcan, CAN_IdType_t id_type,
+                               uint32_t first_id, uint32_t last_id, CAN_RxHandler_t handler)
 {
-    FDCAN_TxHeaderTypeDef TxHeader;
+    return CAN_AddRoute(hfdcan, id_type, first_id, last_id, handler, true);
+}
 
-    TxHeader.Identifier = id;
-    TxHeader.IdType = FDCAN_STANDARD_ID;
-    TxHeader.TxFrameType = FDCAN_DATA_FRAME;
-    
-    switch(len) {
-        case 0: TxHeader.DataLength = FDCAN_DLC_BYTES_0; break;
-        case 1: TxHeader.DataLength = FDCAN_DLC_BYTES_1; break;
-        case 2: TxHeader.DataLength = FDCAN_DLC_BYTES_2; break;
-        case 3: TxHeader.DataLength = FDCAN_DLC_BYTES_3; break;
-        case 4: TxHeader.DataLength = FDCAN_DLC_BYTES_4; break;
-        case 5: TxHeader.DataLength = FDCAN_DLC_BYTES_5; break;
-        case 6: TxHeader.DataLength = FDCAN_DLC_BYTES_6; break;
-        case 7: TxHeader.DataLength = FDCAN_DLC_BYTES_7; break;
-        case 8: TxHeader.DataLength = FDCAN_DLC_BYTES_8; break;
-        default: TxHeader.DataLength = FDCAN_DLC_BYTES_8; break;
+void CAN_SetRxThread(osThreadId_t thread_id)
+{
+    rx_thread = thread_id;
+}
+
+bool CAN_Transmit(FDCAN_HandleTypeDef *hfdcan, uint32_t id, const uint8_t *data, uint8_t len,
+                  CAN_TxPriority_t prio)
+{
+    if (len > CAN_CLASSIC_MAX_LEN) len = CAN_CLASSIC_MAX_LEN;
+    return CAN_Enqueue(hfdcan, id, data, len, len, false, prio);
+}
+
+bool CAN_TransmitFD(FDCAN_HandleTypeDef *hfdcan, uint32_t id, const uint8_t *data, uint8_t len,
+                    CAN_TxPriority_t prio)
+{
+    if (hfdcan == NULL || hfdcan->Init.FrameFormat != FDCAN_FRAME_FD_BRS) return false;
+    if (len > CAN_FD_MAX_LEN) len = CAN_FD_MAX_LEN;
+
+    // HAL copies the full DLC length, so the frame is padded up to it
+    return CAN_Enqueue(hfdcan, id, data, len, CAN_LenToDlcCode(len), true, prio);
+}
+
+void CAN_ProcessRx(void)
+{
+    for (int bus = 0; bus < CAN_BUS_COUNT; bus++)
+    {
+        CAN_RxQueue_t *q = &rx_queues[bus];
+        CAN_RouteTable_t *tbl = &routes[bus];
+        uint16_t head = q->head;
+        __DMB(); // Slot contents must be read after the published head
+
+        while (q->tail != head)
+        {
+            CAN_Message_t *msg = &q->slots[q->tail & CAN_RX_QUEUE_MASK];
+
+            // O(1) Dispatch by matched filter element
+            const CAN_Route_t *route = NULL;
+            if (msg->id_type == CAN_ID_STD)
+            {
+                if (msg->filter_index < CAN_MAX_STD_ROUTES) route = &tbl->std[msg->filter_index];
+            }
+            else
+            {
+                if (msg->filter_index < CAN_MAX_EXT_ROUTES) route = &tbl->ext[msg->filter_index];
+            }
+
+            // Wire-to-dispatch latency
+            uint32_t latency = (uint32_t)(Timebase_GetMicros() - msg->timestamp_us);
+            q->stats.latency_last_us = latency;
+            if (latency > q->stats.latency_max_us) q->stats.latency_max_us = latency;
+
+            if (route != NULL && route->handler != NULL)
+            {
+                route->handler(msg);
+            }
+            q->tail = q->tail + 1U; // Release slot to the ISR
+        }
     }
+}
 
-    TxHeader.ErrorStateIndicator = FDCAN_ESI_ACTIVE;
-    TxHeader.BitRateSwitch = FDCAN_BRS_OFF; // Classic CAN
-    TxHeader.FDFormat = FDCAN_CLASSIC_CAN;
-    TxHeader.TxEventFifoControl = FDCAN_NO_TX_EVENTS;
-    TxHeader.MessageMarker = 0;
+void CAN_TxProbeArm(FDCAN_HandleTypeDef *hfdcan, uint32_t id, uint8_t byte, uint8_t value)
+{
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0 || (byte != CAN_PROBE_ANY_BYTE && byte >= CAN_FD_MAX_LEN)) return;
+
+    CAN_TxQueue_t *q = &tx_queues[bus];
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    q->probe_id = id;
+    q->probe_byte = byte;
+    q->probe_value = value;
+    q->probe_from_us = Timebase_GetMicros();
+    q->probe_state = CAN_PROBE_ARMED;
+    __set_PRIMASK(primask);
+}
 
-    if (HAL_FDCAN_AddMessageToTxFifoQ(hfdcan, &TxHeader, data) != HAL_OK)
+bool CAN_TxProbeRead(FDCAN_HandleTypeDef *hfdcan, uint64_t *sof_us)
+{
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0) return false;
+
+    CAN_TxQueue_t *q = &tx_queues[bus];
+    bool done = false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (q->probe_state == CAN_PROBE_DONE)
+    {
+        *sof_us = q->probe_sof_us;
+        q->probe_state = CAN_PROBE_IDLE;
+        done = true;
+    }
+    __set_PRIMASK(primask);
+    return done;
+}
+
+bool CAN_AddTap(CAN_TapFn_t tap)
+{
+    if (tap == NULL || tap_count >= CAN_MAX_TAPS) return false;
+
+    // Publish the entry before the count the ISR reads
+    taps[tap_count] = tap;
+    __DMB();
+    tap_count++;
+    return true;
+}
+
+bool CAN_InjectRx(const CAN_Message_t *msg)
+{
+    if (msg == NULL || msg->bus >= CAN_BUS_COUNT) return false;
+
+    // Same lookup the hardware filter does, first matching element wins
+    CAN_RouteTable_t *tbl = &routes[msg->bus];
+    const CAN_Route_t *table = (msg->id_type == CAN_ID_STD) ? tbl->std : tbl->ext;
+    uint8_t count = (msg->id_type == CAN_ID_STD) ? tbl->std_count : tbl->ext_count;
+    int index = -1;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (msg->id >= table[i].first_id && msg->id <= table[i].last_id)
+        {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) return false;
+
+    CAN_Message_t frame = *msg;
+    frame.filter_index = (uint8_t)index;
+    if (frame.len > CAN_FD_MAX_LEN) frame.len = CAN_FD_MAX_LEN;
+
+    // The ISR is the regular producer; keep it out while we push
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (table[index].urgent)
+    {
+        // FIFO1 path: handled on arrival, as in the line 1 ISR
+        rx_queues[msg->bus].stats.urgent_count++;
+        table[index].handler(&frame);
+        __set_PRIMASK(primask);
+        return true;
+    }
+    bool queued = CAN_QueuePush(&rx_queues[msg->bus], &frame);
+    __set_PRIMASK(primask);
+
+    if (queued && rx_thread != NULL)
+    {
+        osThreadFlagsSet(rx_thread, CAN_RX_THREAD_FLAG);
+    }
+    return queued;
+}
+
+bool CAN_IsMessageAvailable(void)
+{
+    for (int bus = 0; bus < CAN_BUS_COUNT; bus++)
+    {
+        if (rx_queues[bus].head != rx_queues[bus].tail) return true;
+    }
+    return false;
+}
+
+bool CAN_GetRxStats(CAN_Bus_t bus, CAN_RxStats_t *stats)
+{
+    if ((int)bus < 0 || bus >= CAN_BUS_COUNT || stats == NULL) return false;
+    *stats = rx_queues[bus].stats;
+    return true;
+}
+
+bool CAN_GetTxStats(CAN_Bus_t bus, CAN_TxStats_t *stats)
+{
+    if ((int)bus < 0 || bus >= CAN_BUS_COUNT || stats == NULL) return false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = tx_queues[bus].stats;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+uint8_t CAN_TxFree(FDCAN_HandleTypeDef *hfdcan, CAN_TxPriority_t prio)
+{
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0 || (int)prio < 0 || prio >= CAN_TX_PRIO_COUNT) return 0;
+
+    // Single byte read, a snapshot: the TX ISR can make more room and the
+    // urgent RX ISR of another bus (fast path) can take some meanwhile
+    return (uint8_t)(CAN_TX_QUEUE_SIZE - tx_queues[bus].ring[prio].count);
+}
+
+void CAN_TxResume(FDCAN_HandleTypeDef *hfdcan)
+{
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0) return;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    CAN_TxPump(bus);
+    __set_PRIMASK(primask);
+}
+
+void HAL_FDCAN_TxBufferCompleteCallback(FDCAN_HandleTypeDef *hfdcan, uint32_t BufferIndexes)
+{
+    (void)BufferIndexes;
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0) return;
+
+    // Hardware slot freed: refill from the software queue (masked, see CAN_TxPump)
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    CAN_TxPump(bus);
+    __set_PRIMASK(primask);
+}
+
+void HAL_FDCAN_TxEventFifoCallback(FDCAN_HandleTypeDef *hfdcan, uint32_t TxEventFifoITs)
+{
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0) return;
+
+    CAN_TxQueue_t *q = &tx_queues[bus];
+    CAN_TxStats_t *st = &q->stats;
+
+    if ((TxEventFifoITs & FDCAN_IT_TX_EVT_FIFO_ELT_LOST) != RESET)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        st->events_lost++;
+        __set_PRIMASK(primask);
+    }
+
+    if ((TxEventFifoITs & FDCAN_IT_TX_EVT_FIFO_NEW_DATA) != RESET)
+    {
+        FDCAN_TxEventFifoTypeDef event;
+
+        // Each event is one frame acknowledged on the bus. The stats, probe
+        // and in-flight times are shared with CAN_Enqueue(), which a
+        // higher-priority ISR can run: one event at a time under PRIMASK.
+        while ((hfdcan->Instance->TXEFS & FDCAN_TXEFS_EFFL) != 0U)
+        {
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+
+            if (HAL_FDCAN_GetTxEvent(hfdcan, &event) != HAL_OK)
+            {
+                __set_PRIMASK(primask);
+                break;
+            }
+            uint8_t prio = event.MessageMarker & CAN_TX_MARKER_PRIO_MASK;
+            uint8_t tag = (uint8_t)(event.MessageMarker >> CAN_TX_MARKER_TAG_SHIFT) % CAN_TX_TAG_COUNT;
+            uint64_t sof_us = Timebase_Extend16((uint16_t)event.TxTimestamp);
+
+            if (prio < CAN_TX_PRIO_COUNT)
+            {
+                uint32_t latency = (uint32_t)(sof_us - q->inflight_us[tag]);
+                st->delivered[prio]++;
+                st->latency_last_us[prio] = latency;
+                if (latency > st->latency_max_us[prio]) st->latency_max_us[prio] = latency;
+            }
+            st->last_tx_us = sof_us;
+
+            if (q->probe_state == CAN_PROBE_QUEUED && tag == q->probe_tag)
+            {
+                q->probe_sof_us = sof_us;
+                q->probe_state = CAN_PROBE_DONE;
+            }
+            CAN_Health_OnFrame(bus, event.IdType == FDCAN_EXTENDED_ID, dlc_to_len[event.DataLength & 0x0F],
+                               event.FDFormat == FDCAN_FD_CAN, event.BitRateSwitch == FDCAN_BRS_ON);
+
+            __set_PRIMASK(primask);
+        }
+    }
+}
+
+// Read one frame from a hardware RX FIFO into a message (ISR)
+static bool CAN_ReadFrame(FDCAN_HandleTypeDef *hfdcan, int bus, uint32_t fifo, CAN_Message_t *msg)
+{
+    FDCAN_RxHeaderTypeDef RxHeader;
+    uint8_t RxData[64]; // HAL copies up to DLC bytes (12..64 for DLC > 8)
+
+    if (HAL_FDCAN_GetRxMessage(hfdcan, fifo, &RxHeader, RxData) != HAL_OK)
     {
         return false;
     }
+
+    bool fd = (RxHeader.FDFormat == FDCAN_FD_CAN);
+    uint8_t len = dlc_to_len[RxHeader.DataLength & 0x0F];
+    CAN_Health_OnFrame(bus, RxHeader.IdType == FDCAN_EXTENDED_ID, len, fd,
+                       RxHeader.BitRateSwitch == FDCAN_BRS_ON);
+    if (!fd && len > CAN_CLASSIC_MAX_LEN) len = CAN_CLASSIC_MAX_LEN; // Classic: DLC 9..15 = 8 bytes
+
+    msg->timestamp_us = Timebase_Extend16((uint16_t)RxHeader.RxTimestamp);
+    msg->id = RxHeader.Identifier;
+    msg->len = len;
+    msg->bus = (uint8_t)bus;
+    msg->id_type = (RxHeader.IdType == FDCAN_EXTENDED_ID) ? CAN_ID_EXT : CAN_ID_STD;
+    msg->filter_index = (uint8_t)RxHeader.FilterIndex;
+    msg->fd = fd ? 1U : 0U;
+    msg->brs = (RxHeader.BitRateSwitch == FDCAN_BRS_ON) ? 1U : 0U;
+    memcpy(msg->data, RxData, len);
+
+    for (uint8_t i = 0; i < tap_count; i++) taps[i](msg, false);
     return true;
 }
 
 void HAL_FDCAN_RxFifo0Callback(FDCAN_HandleTypeDef *hfdcan, uint32_t RxFifo0ITs)
 {
+    if ((RxFifo0ITs & FDCAN_IT_RX_FIFO0_MESSAGE_LOST) != RESET)
+    {
+        CAN_Health_OnRxLost(CAN_GetBusIndex(hfdcan)); // HW FIFO overflow (ISR latency)
+    }
+
     if((RxFifo0ITs & FDCAN_IT_RX_FIFO0_NEW_MESSAGE) != RESET)
     {
-        FDCAN_RxHeaderTypeDef RxHeader;
-        uint8_t RxData[8];
+        int bus = CAN_GetBusIndex(hfdcan);
+        if (bus < 0) return;
 
-        if (HAL_FDCAN_GetRxMessage(hfdcan, FDCAN_RX_FIFO0, &RxHeader, RxData) == HAL_OK)
+        CAN_RxQueue_t *q = &rx_queues[bus];
+        CAN_Message_t msg;
+        bool queued = false;
+
+        // Drain the hardware FIFO in one interrupt
+        while (HAL_FDCAN_GetRxFifoFillLevel(hfdcan, FDCAN_RX_FIFO0) > 0)
         {
-            if (rx_callback != NULL)
-            {
-                rx_callback(RxHeader.Identifier, RxData, 8); // Assume 8 or calculate real len
-            }
+            if (!CAN_ReadFrame(hfdcan, bus, FDCAN_RX_FIFO0, &msg)) break;
+
+            if (!CAN_QueuePush(q, &msg)) continue;
+            queued = true;
+        }
+
+        if (queued && rx_thread != NULL)
+        {
+            osThreadFlagsSet(rx_thread, CAN_RX_THREAD_FLAG);
         }
     }
 }
+
+void HAL_FDCAN_RxFifo1Callback(FDCAN_HandleTypeDef *hfdcan, uint32_t RxFifo1ITs)
+{
+    // Line 0 (HAL) caught a FIFO1 flag before line 1 ran: hand it over
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus >= 0) HAL_NVIC_SetPendingIRQ(urgent_irqs[bus]);
+}
+
+void CAN_UrgentIRQHandler(FDCAN_HandleTypeDef *hfdcan)
+{
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0) return;
+
+    // Clear first: a frame arriving while we drain raises the line again
+    uint32_t flags = hfdcan->Instance->IR & (FDCAN_FLAG_RX_FIFO1_NEW_MESSAGE | FDCAN_FLAG_RX_FIFO1_MESSAGE_LOST);
+    __HAL_FDCAN_CLEAR_FLAG(hfdcan, flags);
+    if (flags & FDCAN_FLAG_RX_FIFO1_MESSAGE_LOST) CAN_Health_OnRxLost(bus);
+
+    CAN_RouteTable_t *tbl = &routes[bus];
+    CAN_RxStats_t *st = &rx_queues[bus].stats;
+    CAN_Message_t msg;
+
+    while (HAL_FDCAN_GetRxFifoFillLevel(hfdcan, FDCAN_RX_FIFO1) > 0)
+    {
+        if (!CAN_ReadFrame(hfdcan, bus, FDCAN_RX_FIFO1, &msg)) break;
+
+        const CAN_Route_t *route = NULL;
+        if (msg.id_type == CAN_ID_STD)
+        {
+            if (msg.filter_index < CAN_MAX_STD_ROUTES) route = &tbl->std[msg.filter_index];
+        }
+        else
+        {
+            if (msg.filter_index < CAN_MAX_EXT_ROUTES) route = &tbl->ext[msg.filter_index];
+        }
+        if (route == NULL || route->handler == NULL) continue;
+
+        route->handler(&msg);
+
+        uint32_t latency = (uint32_t)(Timebase_GetMicros() - msg.timestamp_us);
+        st->urgent_count++;
+        if (latency > st->urgent_latency_max_us) st->urgent_latency_max_us = latency;
+    }
+}
@@ -0,0 +1,310 @@
+/**
+ * @file    can_gateway.c
+ * @brief   CAN-over-UDP Gateway Implementation
+ *
+ * @details
+ * The tap runs in the FDCAN ISRs (RX) and in every sending task (TX), so
+ * the filter, the rate limit bucket and the queue push share one PRIMASK
+ * section. The filter settings are only rewritten while the taps are off
+ * (gw_active false). The OCPP task is the only consumer: it moves queued
+ * frames into one datagram per bus and sends a datagram when the next
+ * frame no longer fits or its oldest frame is GW_BATCH_MS old. The W5500
+ * is only touched from that task, Start/Stop from the CLI just raise a
+ * request.
+ *
+ * The rate limit is a token bucket in frame-microseconds (a frame costs
+ * 1e6, one microsecond refills gw_rate_fps), so it is exact for any rate
+ * without floating point.
+ */
+
+#include "can_gateway.h"
+#include "w5500_driver.h"
+#include "config_manager.h"
+#include <stdio.h>
+#include <string.h>
+
+#define GW_QUEUE_MASK       (GW_QUEUE_SIZE - 1U)
+
+#if (GW_QUEUE_SIZE & GW_QUEUE_MASK) != 0
+#error "GW_QUEUE_SIZE must be a power of 2"
+#endif
+
+// cannelloni v2
+#define GW_PROTO_VERSION    2U
+#define GW_OP_DATA          0U
+#define GW_HEADER_SIZE      5U
+#define GW_FRAME_HEADER     5U           // can_id + len (FD: + flags)
+#define GW_ID_EFF           0x80000000U  // SocketCAN CAN_EFF_FLAG
+#define GW_LEN_FD           0x80U        // len byte: FD frame, flags byte follows
+#define GW_FD_BRS           0x01U        // SocketCAN CANFD_BRS
+
+#define GW_FRAME_COST       1000000ULL   // Bucket units per frame
+
+// Queued Frame (Tap -> OCPP task)
+typedef struct
+{
+    uint32_t id;          // With GW_ID_EFF
+    uint8_t  bus;
+    uint8_t  len;
+    uint8_t  fd;
+    uint8_t  brs;
+    uint8_t  data[CAN_FD_MAX_LEN];
+} GW_Frame_t;
+
+// Datagram being filled (One per bus)
+typedef struct
+{
+    uint8_t  buf[GW_DATAGRAM_MAX];
+    uint16_t len;
+    uint16_t count;
+    uint8_t  seq;
+    uint32_t first_tick;  // HAL tick of the first frame
+} GW_Datagram_t;
+
+static GW_Frame_t gw_queue[GW_QUEUE_SIZE];
+static volatile uint32_t gw_head = 0;  // Producers (PRIMASK)
+static volatile uint32_t gw_tail = 0;  // OCPP task
+
+static GW_Datagram_t gw_dgram[CAN_BUS_COUNT];
+static GW_Stats_t gw_stats;
+
+// Requests (Any task) and socket state (OCPP task)
+static volatile bool gw_active = false;   // Taps forward
+static volatile bool gw_want = false;     // Started
+static volatile bool gw_restart = false;  // Reload config, reopen
+static bool gw_open = false;
+static bool gw_retry_wait = false;
+static uint32_t gw_retry_tick = 0;
+
+// Settings snapshot (Written while gw_active is false)
+static uint8_t  gw_bus_mask;
+static uint32_t gw_id_min[CAN_BUS_COUNT];
+static uint32_t gw_id_max[CAN_BUS_COUNT];
+static uint32_t gw_rate_fps;
+static uint8_t  gw_ip[4];
+static uint16_t gw_port;
+
+// Rate limit bucket (PRIMASK)
+static uint64_t gw_credit;
+static uint64_t gw_credit_cap;
+static uint64_t gw_credit_us;
+
+void Gateway_Init(void)
+{
+    memset(&gw_stats, 0, sizeof(gw_stats));
+    CAN_AddTap(Gateway_CanTap);
+
+    if (Config_Get()->gw_enable) Gateway_Start();
+
+    printf("[GW] Initialized (%s)\r\n", gw_want ? "Enabled" : "Off");
+}
+
+void Gateway_Start(void)
+{
+    gw_active = false;
+    gw_restart = true;
+    gw_want = true;
+}
+
+void Gateway_Stop(void)
+{
+    gw_active = false;
+    gw_want = false;
+}
+
+// PRIMASK held
+static bool Gateway_TakeCredit(void)
+{
+    if (gw_rate_fps == 0) return true;
+
+    uint64_t now = Timebase_GetMicros();
+    gw_credit += (now - gw_credit_us) * gw_rate_fps;
+    gw_credit_us = now;
+    if (gw_credit > gw_credit_cap) gw_credit = gw_credit_cap;
+
+    if (gw_credit < GW_FRAME_COST) return false;
+    gw_credit -= GW_FRAME_COST;
+    return true;
+}
+
+void Gateway_CanTap(const CAN_Message_t *msg, bool tx)
+{
+    (void)tx; // cannelloni carries no direction
+
+    if (!gw_active || msg->bus >= CAN_BUS_COUNT) return;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (!(gw_bus_mask & (1U << msg->bus)) ||
+        msg->id < gw_id_min[msg->bus] || msg->id > gw_id_max[msg->bus])
+    {
+        gw_stats.filtered++;
+    }
+    else if (!Gateway_TakeCredit())
+    {
+        gw_stats.rate_drops++;
+    }
+    else if ((gw_head - gw_tail) >= GW_QUEUE_SIZE)
+    {
+        gw_stats.queue_drops++;
+    }
+    else
+    {
+        GW_Frame_t *f = &gw_queue[gw_head & GW_QUEUE_MASK];
+        f->id = msg->id | ((msg->id_type == CAN_ID_EXT) ? GW_ID_EFF : 0U);
+        f->bus = msg->bus;
+        f->len = (msg->len > CAN_FD_MAX_LEN) ? CAN_FD_MAX_LEN : msg->len;
+        f->fd = msg->fd;
+        f->brs = msg->brs;
+        memcpy(f->data, msg->data, f->len);
+        gw_head++;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+static void Gateway_Flush(uint8_t bus)
+{
+    GW_Datagram_t *d = &gw_dgram[bus];
+    if (d->count == 0) return;
+
+    d->buf[0] = GW_PROTO_VERSION;
+    d->buf[1] = GW_OP_DATA;
+    d->buf[2] = d->seq++;
+    d->buf[3] = (uint8_t)(d->count >> 8);
+    d->buf[4] = (uint8_t)d->count;
+
+    if (W5500_SendTo(GW_SOCKET, d->buf, d->len, gw_ip, (uint16_t)(gw_port + bus)) == d->len)
+    {
+        gw_stats.datagrams++;
+        gw_stats.forwarded += d->count;
+    }
+    else
+    {
+        gw_stats.send_fails++;
+    }
+
+    d->len = 0;
+    d->count = 0;
+}
+
+static void Gateway_Append(const GW_Frame_t *f)
+{
+    GW_Datagram_t *d = &gw_dgram[f->bus];
+    uint16_t need = (uint16_t)(GW_FRAME_HEADER + (f->fd ? 1U : 0U) + f->len);
+
+    if (d->count > 0 && (d->len + need) > GW_DATAGRAM_MAX) Gateway_Flush(f->bus);
+
+    if (d->count == 0)
+    {
+        d->len = GW_HEADER_SIZE;
+        d->first_tick = HAL_GetTick();
+    }
+
+    uint8_t *p = &d->buf[d->len];
+    *p++ = (uint8_t)(f->id >> 24);
+    *p++ = (uint8_t)(f->id >> 16);
+    *p++ = (uint8_t)(f->id >> 8);
+    *p++ = (uint8_t)f->id;
+    *p++ = (uint8_t)(f->len | (f->fd ? GW_LEN_FD : 0U));
+    if (f->fd) *p++ = f->brs ? GW_FD_BRS : 0U;
+    memcpy(p, f->data, f->len);
+
+    d->len += need;
+    d->count++;
+}
+
+// Socket open and settings snapshot (Taps are off)
+static bool Gateway_Open(void)
+{
+    const SystemConfig_t *cfg = Config_Get();
+
+    if (!W5500_Socket(GW_SOCKET, SN_MR_UDP, GW_LOCAL_PORT)) return false;
+
+    gw_bus_mask = cfg->gw_bus_mask;
+    for (int bus = 0; bus < CAN_BUS_COUNT; bus++)
+    {
+        gw_id_min[bus] = cfg->gw_id_min[bus];
+        gw_id_max[bus] = cfg->gw_id_max[bus];
+        gw_dgram[bus].len = 0;
+        gw_dgram[bus].count = 0;
+    }
+    memcpy(gw_ip, cfg->gw_ip, sizeof(gw_ip));
+    gw_port = cfg->gw_port;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    gw_rate_fps = cfg->gw_rate_fps;
+    gw_credit_cap = (uint64_t)gw_rate_fps * GW_BURST_MS * 1000U;
+    if (gw_credit_cap < GW_FRAME_COST) gw_credit_cap = GW_FRAME_COST;
+    gw_credit = gw_credit_cap;
+    gw_credit_us = Timebase_GetMicros();
+    gw_tail = gw_head;
+    __set_PRIMASK(primask);
+
+    printf("[GW] Forwarding to %d.%d.%d.%d:%u+bus (Bus Mask 0x%02X, %lu fps)\r\n",
+           gw_ip[0], gw_ip[1], gw_ip[2], gw_ip[3], gw_port, gw_bus_mask, gw_rate_fps);
+    return true;
+}
+
+void Gateway_Process(void)
+{
+    if (gw_restart || !gw_want)
+    {
+        gw_restart = false;
+        gw_retry_wait = false;
+        if (gw_open)
+        {
+            W5500_Close(GW_SOCKET);
+            gw_open = false;
+            printf("[GW] Stopped\r\n");
+        }
+    }
+
+    if (!gw_want) return;
+
+    if (!gw_open)
+    {
+        if (gw_retry_wait && (HAL_GetTick() - gw_retry_tick) < GW_RETRY_MS) return;
+
+        if (!Gateway_Open())
+        {
+            if (!gw_retry_wait) printf("[GW] UDP Socket Open Failed, Retrying\r\n");
+            gw_retry_wait = true;
+            gw_retry_tick = HAL_GetTick();
+            return;
+        }
+        gw_open = true;
+        gw_retry_wait = false;
+        gw_active = true;
+    }
+
+    // Drain the queue into the per-bus datagrams
+    while (gw_tail != gw_head)
+    {
+        __DMB(); // Frame written before gw_head was advanced
+        Gateway_Append(&gw_queue[gw_tail & GW_QUEUE_MASK]);
+        gw_tail++;
+    }
+
+    // Send datagrams whose oldest frame has waited long enough
+    uint32_t now = HAL_GetTick();
+    for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++)
+    {
+        if (gw_dgram[bus].count > 0 && (now - gw_dgram[bus].first_tick) >= GW_BATCH_MS)
+        {
+            Gateway_Flush(bus);
+        }
+    }
+}
+
+void Gateway_GetStats(GW_Stats_t *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = gw_stats;
+    __set_PRIMASK(primask);
+
+    stats->running = gw_open && gw_active;
+}
@@ -0,0 +1,291 @@
+/**
+ * @file    can_health.c
+ * @brief   FDCAN Bus Health Implementation
+ *
+ * @details
+ * The error status interrupt (EW/EP/BO change) only records the new state.
+ * Everything that touches the controller configuration runs in the CAN
+ * task: on bus-off the FDCAN sets CCCR.INIT by itself; clearing INIT after
+ * the backoff starts the ISO 11898 recovery (129 x 11 recessive bits).
+ */
+
+#include "can_health.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct
+{
+    FDCAN_HandleTypeDef *hfdcan;
+    CAN_HealthStatus_t   status;
+    uint32_t nominal_bit_ns;
+    uint32_t data_bit_ns;
+    volatile uint32_t busy_ns;   // Accumulated frame time, current window (ISR)
+    bool     off;                // Bus-off observed by the CAN task
+    uint32_t bus_off_tick;       // Entry into bus-off (CAN task view)
+    uint32_t last_restart_tick;  // Last CCCR.INIT clear
+    uint32_t stable_since_tick;  // Error-active since
+} CAN_HealthCtx_t;
+
+static CAN_HealthCtx_t health[CAN_BUS_COUNT];
+static uint32_t load_window_tick = 0;
+
+// Bit time from FDCAN kernel clock and segment config
+static uint32_t CAN_Health_BitNs(uint32_t clk_hz, uint32_t prescaler, uint32_t seg1, uint32_t seg2)
+{
+    uint64_t tq_per_bit = (uint64_t)prescaler * (1U + seg1 + seg2);
+    if (clk_hz == 0) return 0;
+    return (uint32_t)((tq_per_bit * 1000000000ULL) / clk_hz);
+}
+
+// Read PSR and map to fault confinement state (PSR read clears LEC)
+static CAN_ErrorState_t CAN_Health_ReadState(CAN_HealthCtx_t *ctx)
+{
+    FDCAN_ProtocolStatusTypeDef psr;
+    HAL_FDCAN_GetProtocolStatus(ctx->hfdcan, &psr);
+
+    if (psr.LastErrorCode != FDCAN_PROTOCOL_ERROR_NO_CHANGE &&
+        psr.LastErrorCode != FDCAN_PROTOCOL_ERROR_NONE)
+    {
+        ctx->status.last_error_code = (uint8_t)psr.LastErrorCode;
+    }
+
+    if (psr.BusOff) return CAN_STATE_BUS_OFF;
+    if (psr.ErrorPassive) return CAN_STATE_PASSIVE;
+    if (psr.Warning) return CAN_STATE_WARNING;
+    return CAN_STATE_ACTIVE;
+}
+
+void CAN_Health_Init(FDCAN_HandleTypeDef *hfdcan)
+{
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0) return;
+
+    CAN_HealthCtx_t *ctx = &health[bus];
+    memset(ctx, 0, sizeof(CAN_HealthCtx_t));
+    ctx->hfdcan = hfdcan;
+    ctx->status.backoff_ms = CAN_HEALTH_BACKOFF_MIN_MS;
+    ctx->stable_since_tick = HAL_GetTick();
+
+    uint32_t clk = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_FDCAN);
+    ctx->nominal_bit_ns = CAN_Health_BitNs(clk, hfdcan->Init.NominalPrescaler,
+                                           hfdcan->Init.NominalTimeSeg1, hfdcan->Init.NominalTimeSeg2);
+    ctx->data_bit_ns = CAN_Health_BitNs(clk, hfdcan->Init.DataPrescaler,
+                                        hfdcan->Init.DataTimeSeg1, hfdcan->Init.DataTimeSeg2);
+    if (hfdcan->Init.FrameFormat != FDCAN_FRAME_FD_BRS) ctx->data_bit_ns = ctx->nominal_bit_ns;
+
+    load_window_tick = HAL_GetTick();
+
+    // Error state changes + RX FIFO 0 message lost
+    if (HAL_FDCAN_ActivateNotification(hfdcan,
+                                       FDCAN_IT_ERROR_WARNING | FDCAN_IT_ERROR_PASSIVE |
+                                       FDCAN_IT_BUS_OFF | FDCAN_IT_RX_FIFO0_MESSAGE_LOST, 0) != HAL_OK)
+    {
+        printf("[CAN] Health Notification Error (Bus %d)\r\n", bus);
+    }
+}
+
+uint32_t CAN_Health_FrameNs(int bus, bool ext, uint8_t len, bool fd, bool brs)
+{
+    if (bus < 0 || bus >= CAN_BUS_COUNT) return 0;
+    const CAN_HealthCtx_t *ctx = &health[bus];
+    uint32_t nominal_bits;
+    uint32_t data_bits = 0;
+
+    if (!fd)
+    {
+        // SOF..CRC is stuffed; CRC delim, ACK, EOF, IFS are not
+        uint32_t stuffed = (ext ? 54U : 34U) + 8U * len;
+        nominal_bits = stuffed + stuffed / 10U + 13U;
+    }
+    else
+    {
+        // Arbitration (SOF..BRS) and tail run at the nominal rate
+        uint32_t arb = ext ? 36U : 17U;
+        nominal_bits = arb + arb / 10U + 13U;
+
+        // ESI, DLC, data, stuff count, CRC and fixed stuff bits
+        uint32_t payload = 5U + 8U * len;
+        data_bits = payload + payload / 10U + 4U + ((len > 16U) ? 21U : 17U) + 6U;
+    }
+
+    return nominal_bits * ctx->nominal_bit_ns +
+           data_bits * (brs ? ctx->data_bit_ns : ctx->nominal_bit_ns);
+}
+
+void CAN_Health_OnFrame(int bus, bool ext, uint8_t len, bool fd, bool brs)
+{
+    if (bus < 0 || bus >= CAN_BUS_COUNT) return;
+    CAN_HealthCtx_t *ctx = &health[bus];
+    uint32_t ns = CAN_Health_FrameNs(bus, ext, len, fd, brs);
+
+    // Line 1 (FIFO1) preempts line 0 on the same bus; task side resets under PRIMASK too
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ctx->busy_ns += ns;
+    __set_PRIMASK(primask);
+}
+
+void CAN_Health_OnRxLost(int bus)
+{
+    if (bus < 0 || bus >= CAN_BUS_COUNT) return;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    health[bus].status.rx_lost++;
+    __set_PRIMASK(primask);
+}
+
+void HAL_FDCAN_ErrorStatusCallback(FDCAN_HandleTypeDef *hfdcan, uint32_t ErrorStatusITs)
+{
+    int bus = CAN_GetBusIndex(hfdcan);
+    if (bus < 0) return;
+
+    CAN_HealthCtx_t *ctx = &health[bus];
+    CAN_ErrorState_t prev = ctx->status.state;
+    CAN_ErrorState_t now = CAN_Health_ReadState(ctx);
+
+    // Flags report a change in either direction; count entries only
+    if ((ErrorStatusITs & FDCAN_IT_ERROR_WARNING) && now >= CAN_STATE_WARNING && prev < CAN_STATE_WARNING)
+    {
+        ctx->status.warning_count++;
+    }
+    if ((ErrorStatusITs & FDCAN_IT_ERROR_PASSIVE) && now >= CAN_STATE_PASSIVE && prev < CAN_STATE_PASSIVE)
+    {
+        ctx->status.passive_count++;
+    }
+    if ((ErrorStatusITs & FDCAN_IT_BUS_OFF) && now == CAN_STATE_BUS_OFF && prev != CAN_STATE_BUS_OFF)
+    {
+        ctx->status.bus_off_count++;
+    }
+
+    ctx->status.state = now;
+}
+
+void CAN_Health_Process(void)
+{
+    uint32_t now = HAL_GetTick();
+
+    for (int bus = 0; bus < CAN_BUS_COUNT; bus++)
+    {
+        CAN_HealthCtx_t *ctx = &health[bus];
+        if (ctx->hfdcan == NULL) continue;
+
+        // 1. TEC/REC Snapshot
+        FDCAN_ErrorCountersTypeDef ecr;
+        HAL_FDCAN_GetErrorCounters(ctx->hfdcan, &ecr);
+        ctx->status.tec = (uint8_t)ecr.TxErrorCnt;
+        ctx->status.rec = (uint8_t)ecr.RxErrorCnt;
+
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        CAN_ErrorState_t state = CAN_Health_ReadState(ctx);
+        ctx->status.state = state;
+        __set_PRIMASK(primask);
+
+        // 2. Bus-Off Recovery with Backoff
+        if (state == CAN_STATE_BUS_OFF)
+        {
+            if (!ctx->off)
+            {
+                ctx->off = true;
+                ctx->bus_off_tick = now;
+            }
+
+            if ((now - ctx->bus_off_tick) >= CAN_HEALTH_FAULT_MS && !ctx->status.fault)
+            {
+                ctx->status.fault = true;
+                printf("[CAN] Bus %d Bus-Off > %d ms. Fault!\r\n", bus, CAN_HEALTH_FAULT_MS);
+            }
+
+            if ((now - ctx->bus_off_tick) >= ctx->status.backoff_ms &&
+                (now - ctx->last_restart_tick) >= ctx->status.backoff_ms &&
+                READ_BIT(ctx->hfdcan->Instance->CCCR, FDCAN_CCCR_INIT) != 0U)
+            {
+                // Rejoin: controller waits 129 x 11 recessive bits by itself
+                CLEAR_BIT(ctx->hfdcan->Instance->CCCR, FDCAN_CCCR_INIT);
+                ctx->last_restart_tick = now;
+
+                if (ctx->status.backoff_ms < CAN_HEALTH_BACKOFF_MAX_MS)
+                {
+                    ctx->status.backoff_ms *= 2U;
+                    if (ctx->status.backoff_ms > CAN_HEALTH_BACKOFF_MAX_MS)
+                    {
+                        ctx->status.backoff_ms = CAN_HEALTH_BACKOFF_MAX_MS;
+                    }
+                }
+                else if (!ctx->status.fault)
+                {
+                    // Backoff saturated: bus keeps dropping off
+                    ctx->status.fault = true;
+                    printf("[CAN] Bus %d Repeated Bus-Off. Fault!\r\n", bus);
+                }
+            }
+            ctx->stable_since_tick = now;
+        }
+        else
+        {
+            if (ctx->off)
+            {
+                ctx->off = false;
+                ctx->status.recoveries++;
+                printf("[CAN] Bus %d Recovered from Bus-Off (TEC %u)\r\n", bus, ctx->status.tec);
+                CAN_TxResume(ctx->hfdcan); // HW TX buffers were flushed
+            }
+
+            if (state != CAN_STATE_ACTIVE) ctx->stable_since_tick = now;
+
+            if ((now - ctx->stable_since_tick) >= CAN_HEALTH_STABLE_MS)
+            {
+                ctx->status.backoff_ms = CAN_HEALTH_BACKOFF_MIN_MS;
+                if (ctx->status.fault)
+                {
+                    ctx->status.fault = false;
+                    printf("[CAN] Bus %d Stable. Fault Cleared\r\n", bus);
+                }
+            }
+        }
+    }
+
+    // 3. Load Window
+    uint32_t elapsed = now - load_window_tick;
+    if (elapsed >= CAN_HEALTH_LOAD_WINDOW_MS)
+    {
+        for (int bus = 0; bus < CAN_BUS_COUNT; bus++)
+        {
+            CAN_HealthCtx_t *ctx = &health[bus];
+
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            uint32_t busy = ctx->busy_ns;
+            ctx->busy_ns = 0;
+            __set_PRIMASK(primask);
+
+            // busy_ns / (elapsed_ms * 1e6) * 1000
+            uint32_t permille = (uint32_t)(((uint64_t)busy) / ((uint64_t)elapsed * 1000U));
+            if (permille > 1000U) permille = 1000U;
+            ctx->status.load_permille = (uint16_t)permille;
+            if (permille > ctx->status.load_peak_permille) ctx->status.load_peak_permille = (uint16_t)permille;
+        }
+        load_window_tick = now;
+    }
+}
+
+bool CAN_Health_GetStatus(CAN_Bus_t bus, CAN_HealthStatus_t *status)
+{
+    if ((int)bus < 0 || bus >= CAN_BUS_COUNT || status == NULL) return false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = health[bus].status;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+bool CAN_Health_IsFaulted(void)
+{
+    for (int bus = 0; bus < CAN_BUS_COUNT; bus++)
+    {
+        if ((CAN_HEALTH_FAULT_MASK & (1U << bus)) && health[bus].status.fault) return true;
+    }
+    return false;
+}
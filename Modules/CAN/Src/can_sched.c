@@ -0,0 +1,215 @@
+/**
+ * @file    can_sched.c
+ * @brief   CAN TX Scheduler Implementation
+ *
+ * @details
+ * The tick runs in the FreeRTOS timer task (configTIMER_TASK_PRIORITY is
+ * above the application tasks), so a blocking OCPP/TLS call or a long
+ * control loop iteration cannot stretch a period. Work per tick is a
+ * modulo per frame plus the pack callbacks of the frames that are due;
+ * the frames themselves go through the driver priority queues as before.
+ */
+
+#include "can_sched.h"
+#include "timebase.h"
+#include "cmsis_os.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct
+{
+    CAN_SchedMsg_t decl;
+    CAN_SchedStats_t stats;
+    volatile bool pending;       // Event requested (trigger or change)
+    volatile uint32_t gen;       // Bumped by CAN_Sched_MarkSent()
+    bool     sent_once;
+    uint32_t last_tx_ms;         // Scheduler time of the last send (any kind)
+    uint8_t  last_len;           // Last sent payload (on-change compare)
+    uint8_t  last_data[CAN_FD_MAX_LEN];
+} CAN_SchedEntry_t;
+
+static CAN_SchedEntry_t entries[CAN_SCHED_MAX_MSGS];
+static int entry_count = 0;
+
+static uint32_t sched_tick = 0;
+static uint64_t sched_epoch_us = 0;
+static uint32_t sched_late_max_us = 0;
+
+// Static control block (heap is only 3KB)
+static osTimerId_t sched_timer = NULL;
+static StaticTimer_t sched_timer_cb;
+static const osTimerAttr_t sched_timer_attr = {
+    .name = "CAN_Sched",
+    .cb_mem = &sched_timer_cb,
+    .cb_size = sizeof(sched_timer_cb),
+};
+
+static void CAN_Sched_TimerCallback(void *argument)
+{
+    CAN_Sched_Tick();
+}
+
+int CAN_Sched_Register(const CAN_SchedMsg_t *msg)
+{
+    if (msg == NULL || msg->hfdcan == NULL || msg->pack == NULL) return -1;
+    if (msg->period_ms != 0 && msg->offset_ms >= msg->period_ms) return -1;
+    if (entry_count >= CAN_SCHED_MAX_MSGS)
+    {
+        printf("[CAN] Scheduler Table Full (ID 0x%lX)\r\n", (unsigned long)msg->id);
+        return -1;
+    }
+
+    CAN_SchedEntry_t *e = &entries[entry_count];
+    memset(e, 0, sizeof(*e));
+    e->decl = *msg;
+    return entry_count++;
+}
+
+void CAN_Sched_Trigger(int handle)
+{
+    if (handle < 0 || handle >= entry_count) return;
+    entries[handle].pending = true;
+}
+
+void CAN_Sched_MarkSent(int handle, const uint8_t *data, uint8_t len)
+{
+    if (handle < 0 || handle >= entry_count || len > CAN_FD_MAX_LEN) return;
+
+    CAN_SchedEntry_t *e = &entries[handle];
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(e->last_data, data, len);
+    e->last_len = len;
+    e->last_tx_ms = sched_tick * CAN_SCHED_TICK_MS;
+    e->sent_once = true;
+    e->pending = false;
+    e->gen++;
+    e->stats.events++;
+    __set_PRIMASK(primask);
+}
+
+void CAN_Sched_Start(void)
+{
+    if (sched_timer != NULL) return;
+
+    sched_timer = osTimerNew(CAN_Sched_TimerCallback, osTimerPeriodic, NULL, &sched_timer_attr);
+    if (sched_timer == NULL || osTimerStart(sched_timer, CAN_SCHED_TICK_MS) != osOK)
+    {
+        printf("[CAN] Scheduler Timer Start Failed\r\n");
+        return;
+    }
+    printf("[CAN] Scheduler Started (%d Frames, %dms Tick)\r\n", entry_count, CAN_SCHED_TICK_MS);
+}
+
+// gen: entry generation read before the pack callback. If the owner sent
+// the frame itself since (CAN_Sched_MarkSent() from an ISR fast path), the
+// packed payload is older than the one on the queue and is dropped, so it
+// cannot follow and undo it.
+static void CAN_Sched_Send(CAN_SchedEntry_t *e, const uint8_t *data, uint8_t len, bool periodic, uint32_t gen)
+{
+    const CAN_SchedMsg_t *d = &e->decl;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (e->gen != gen)
+    {
+        e->stats.superseded++;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    bool ok = (d->flags & CAN_SCHED_FD) ? CAN_TransmitFD(d->hfdcan, d->id, data, len, d->prio)
+                                        : CAN_Transmit(d->hfdcan, d->id, data, len, d->prio);
+    if (!ok)
+    {
+        // Queue full / bus-off: the next slot or change retries
+        e->stats.tx_fail++;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    if (periodic) e->stats.periodic++;
+    else e->stats.events++;
+
+    e->pending = false;
+    e->sent_once = true;
+    e->last_tx_ms = sched_tick * CAN_SCHED_TICK_MS;
+    e->last_len = len;
+    memcpy(e->last_data, data, len);
+    __set_PRIMASK(primask);
+}
+
+void CAN_Sched_Tick(void)
+{
+    // Lateness against the ideal grid started at the first tick
+    uint64_t now_us = Timebase_GetMicros();
+    if (sched_tick == 0) sched_epoch_us = now_us;
+    uint64_t due_us = sched_epoch_us + (uint64_t)sched_tick * CAN_SCHED_TICK_MS * 1000U;
+    if (now_us > due_us && (now_us - due_us) > sched_late_max_us)
+    {
+        sched_late_max_us = (uint32_t)(now_us - due_us);
+    }
+
+    uint32_t now_ms = sched_tick * CAN_SCHED_TICK_MS;
+
+    for (int i = 0; i < entry_count; i++)
+    {
+        CAN_SchedEntry_t *e = &entries[i];
+        const CAN_SchedMsg_t *d = &e->decl;
+        uint8_t data[CAN_FD_MAX_LEN];
+        uint8_t len = 0;
+        bool packed = false;
+        uint32_t gen = e->gen;
+
+        bool due = (d->period_ms != 0) && ((now_ms % d->period_ms) == d->offset_ms);
+
+        if (d->flags & CAN_SCHED_ON_CHANGE)
+        {
+            len = d->pack(data, d->arg);
+            packed = true;
+            if (len != 0 && (!e->sent_once || len != e->last_len || memcmp(data, e->last_data, len) != 0))
+            {
+                e->pending = true;
+            }
+        }
+
+        if (due)
+        {
+            if (!packed) len = d->pack(data, d->arg);
+            if (len != 0) CAN_Sched_Send(e, data, len, true, gen);
+            continue;
+        }
+
+        if (!e->pending) continue;
+
+        if (e->sent_once && (now_ms - e->last_tx_ms) < d->min_interval_ms)
+        {
+            e->stats.held++;
+            continue;
+        }
+
+        if (!packed) len = d->pack(data, d->arg);
+        if (len != 0) CAN_Sched_Send(e, data, len, false, gen);
+        else e->pending = false; // Nothing to send in the current mode
+    }
+
+    sched_tick++;
+}
+
+bool CAN_Sched_GetMsg(int handle, CAN_SchedMsg_t *msg, CAN_SchedStats_t *stats)
+{
+    if (handle < 0 || handle >= entry_count) return false;
+    if (msg) *msg = entries[handle].decl;
+    if (stats) *stats = entries[handle].stats;
+    return true;
+}
+
+int CAN_Sched_GetCount(void)
+{
+    return entry_count;
+}
+
+uint32_t CAN_Sched_GetMaxLateUs(void)
+{
+    return sched_late_max_us;
+}
@@ -0,0 +1,331 @@
+/**
+ * @file    isotp.c
+ * @brief   ISO-TP Transport Implementation
+ *
+ * @details
+ * PCI types: SF (0x0), FF (0x1), CF (0x2), FC (0x3). Reception answers a
+ * FF with FC.CTS (BS = ISOTP_RX_BS, STmin = ISOTP_RX_STMIN) and collects
+ * CFs until FF_DL bytes are in. Transmission sends the FF, waits for the
+ * peer's FC and then emits CFs from ISOTP_Process(), as many per call as
+ * STmin, block size and the DIAG queue allow. STmin is honoured on the
+ * 1 ms tick, sub-millisecond values are rounded up to one tick.
+ */
+
+#include "isotp.h"
+#include <string.h>
+
+#define ISOTP_PCI_SF  0x00U
+#define ISOTP_PCI_FF  0x10U
+#define ISOTP_PCI_CF  0x20U
+#define ISOTP_PCI_FC  0x30U
+
+#define ISOTP_FC_CTS    0x00U
+#define ISOTP_FC_WAIT   0x01U
+#define ISOTP_FC_OVFLW  0x02U
+
+#define ISOTP_SF_MAX_CLASSIC  7U
+#define ISOTP_SF_MAX_FD       (CAN_FD_MAX_LEN - 2U) // Escape SF (PCI 0x00, SF_DL byte)
+
+enum { ISOTP_RX_IDLE = 0, ISOTP_RX_BUSY };
+enum { ISOTP_TX_IDLE = 0, ISOTP_TX_WAIT_FC, ISOTP_TX_SENDING };
+
+// Smallest valid CAN FD frame length >= len (at least 8, padding included)
+static uint8_t ISOTP_FrameLen(uint8_t len)
+{
+    static const uint8_t fd_len[] = {8, 12, 16, 20, 24, 32, 48, 64};
+    for (uint8_t i = 0; i < sizeof(fd_len); i++)
+    {
+        if (len <= fd_len[i]) return fd_len[i];
+    }
+    return CAN_FD_MAX_LEN;
+}
+
+// Pad and queue one frame in the link's format
+static bool ISOTP_SendFrame(ISOTP_Link_t *link, uint8_t *frame, uint8_t len)
+{
+    uint8_t dl = link->fd ? ISOTP_FrameLen(len) : CAN_CLASSIC_MAX_LEN;
+    memset(&frame[len], ISOTP_PAD_BYTE, dl - len);
+
+    if (link->fd) return CAN_TransmitFD(link->hfdcan, link->tx_id, frame, dl, CAN_TX_PRIO_DIAG);
+    return CAN_Transmit(link->hfdcan, link->tx_id, frame, dl, CAN_TX_PRIO_DIAG);
+}
+
+static void ISOTP_SendFc(ISOTP_Link_t *link, uint8_t status)
+{
+    uint8_t frame[CAN_FD_MAX_LEN];
+    frame[0] = ISOTP_PCI_FC | status;
+    frame[1] = ISOTP_RX_BS;
+    frame[2] = ISOTP_RX_STMIN;
+    ISOTP_SendFrame(link, frame, 3);
+}
+
+// FC STmin byte -> ms (0xF1..0xF9 = 100..900 us -> one tick, reserved -> 127 ms)
+static uint32_t ISOTP_DecodeStmin(uint8_t stmin)
+{
+    if (stmin <= 0x7FU) return stmin;
+    if (stmin >= 0xF1U && stmin <= 0xF9U) return 1;
+    return 0x7FU;
+}
+
+static void ISOTP_RxComplete(ISOTP_Link_t *link)
+{
+    link->rx_state = ISOTP_RX_IDLE;
+    link->stats.rx_msgs++;
+    if (link->on_rx) link->on_rx(link->rx_buf, link->rx_len, link->fd);
+}
+
+static void ISOTP_OnFlowControl(ISOTP_Link_t *link, const uint8_t *data)
+{
+    if (link->tx_state != ISOTP_TX_WAIT_FC) return;
+
+    switch (data[0] & 0x0FU)
+    {
+        case ISOTP_FC_CTS:
+            link->tx_bs = data[1];
+            link->tx_stmin_ms = ISOTP_DecodeStmin(data[2]);
+            link->tx_block = 0;
+            link->tx_wft = 0;
+            link->tx_state = ISOTP_TX_SENDING;
+            link->tx_tick = HAL_GetTick() - link->tx_stmin_ms - 1U; // First CF right away
+            ISOTP_Process(link);
+            break;
+
+        case ISOTP_FC_WAIT:
+            link->tx_tick = HAL_GetTick(); // Restart N_Bs
+            if (++link->tx_wft > ISOTP_MAX_WFT)
+            {
+                link->tx_state = ISOTP_TX_IDLE;
+                link->stats.tx_aborted++;
+            }
+            break;
+
+        default: // Overflow or invalid
+            link->tx_state = ISOTP_TX_IDLE;
+            link->stats.tx_aborted++;
+            break;
+    }
+}
+
+void ISOTP_Init(ISOTP_Link_t *link, FDCAN_HandleTypeDef *hfdcan, uint32_t tx_id, ISOTP_RxFn_t on_rx)
+{
+    memset(link, 0, sizeof(*link));
+    link->hfdcan = hfdcan;
+    link->tx_id = tx_id;
+    link->on_rx = on_rx;
+}
+
+void ISOTP_OnFrame(ISOTP_Link_t *link, const CAN_Message_t *msg)
+{
+    const uint8_t *data = msg->data;
+    if (msg->len < 1) return;
+
+    switch (data[0] & 0xF0U)
+    {
+        case ISOTP_PCI_SF:
+        {
+            uint16_t len = data[0] & 0x0FU;
+            uint8_t off = 1;
+            if (len == 0 && msg->fd && msg->len > CAN_CLASSIC_MAX_LEN)
+            {
+                len = data[1]; // Escape SF
+                off = 2;
+            }
+            if (len == 0 || off + len > msg->len || (off == 1 && len > ISOTP_SF_MAX_CLASSIC))
+            {
+                link->stats.rx_errors++;
+                return;
+            }
+            if (link->rx_state != ISOTP_RX_IDLE) link->stats.rx_errors++; // Interrupted message
+
+            link->fd = msg->fd;
+            memcpy(link->rx_buf, &data[off], len);
+            link->rx_len = len;
+            ISOTP_RxComplete(link);
+            break;
+        }
+
+        case ISOTP_PCI_FF:
+        {
+            if (msg->len < CAN_CLASSIC_MAX_LEN)
+            {
+                link->stats.rx_errors++;
+                return;
+            }
+            if (link->rx_state != ISOTP_RX_IDLE) link->stats.rx_errors++;
+
+            link->fd = msg->fd;
+            uint16_t len = (uint16_t)(((data[0] & 0x0FU) << 8) | data[1]);
+            if (len == 0 || len > ISOTP_BUF_SIZE) // 0 = 32-bit escape, never that large here
+            {
+                link->rx_state = ISOTP_RX_IDLE;
+                link->stats.rx_overflow++;
+                ISOTP_SendFc(link, ISOTP_FC_OVFLW);
+                return;
+            }
+
+            uint16_t first = msg->len - 2U;
+            if (first >= len)
+            {
+                link->stats.rx_errors++; // Would have fit a SF
+                return;
+            }
+            memcpy(link->rx_buf, &data[2], first);
+            link->rx_len = len;
+            link->rx_pos = first;
+            link->rx_dl = msg->len;
+            link->rx_sn = 1;
+            link->rx_block = 0;
+            link->rx_tick = HAL_GetTick();
+            link->rx_state = ISOTP_RX_BUSY;
+            ISOTP_SendFc(link, ISOTP_FC_CTS);
+            break;
+        }
+
+        case ISOTP_PCI_CF:
+        {
+            if (link->rx_state != ISOTP_RX_BUSY) return; // Not for us (ISO: ignore)
+
+            if ((data[0] & 0x0FU) != link->rx_sn)
+            {
+                link->rx_state = ISOTP_RX_IDLE;
+                link->stats.rx_errors++;
+                return;
+            }
+
+            uint16_t n = link->rx_len - link->rx_pos;
+            if (n > link->rx_dl - 1U) n = link->rx_dl - 1U;
+            if (msg->len < n + 1U)
+            {
+                link->rx_state = ISOTP_RX_IDLE;
+                link->stats.rx_errors++;
+                return;
+            }
+
+            memcpy(&link->rx_buf[link->rx_pos], &data[1], n);
+            link->rx_pos += n;
+            link->rx_sn = (link->rx_sn + 1U) & 0x0FU;
+            link->rx_tick = HAL_GetTick();
+
+            if (link->rx_pos >= link->rx_len)
+            {
+                ISOTP_RxComplete(link);
+                break;
+            }
+#if ISOTP_RX_BS != 0
+            if (++link->rx_block >= ISOTP_RX_BS)
+            {
+                link->rx_block = 0;
+                ISOTP_SendFc(link, ISOTP_FC_CTS);
+            }
+#endif
+            break;
+        }
+
+        case ISOTP_PCI_FC:
+            if (msg->len >= 3) ISOTP_OnFlowControl(link, data);
+            break;
+
+        default:
+            link->stats.rx_errors++;
+            break;
+    }
+}
+
+bool ISOTP_Send(ISOTP_Link_t *link, const uint8_t *data, uint16_t len)
+{
+    if (link->tx_state != ISOTP_TX_IDLE || len == 0 || len > ISOTP_BUF_SIZE) return false;
+
+    uint8_t frame[CAN_FD_MAX_LEN];
+    link->tx_dl = link->fd ? CAN_FD_MAX_LEN : CAN_CLASSIC_MAX_LEN;
+
+    // Single Frame
+    if (len <= ISOTP_SF_MAX_CLASSIC)
+    {
+        frame[0] = ISOTP_PCI_SF | (uint8_t)len;
+        memcpy(&frame[1], data, len);
+        if (!ISOTP_SendFrame(link, frame, (uint8_t)(len + 1U))) return false;
+        link->stats.tx_msgs++;
+        return true;
+    }
+    if (link->fd && len <= ISOTP_SF_MAX_FD)
+    {
+        frame[0] = ISOTP_PCI_SF;
+        frame[1] = (uint8_t)len;
+        memcpy(&frame[2], data, len);
+        if (!ISOTP_SendFrame(link, frame, (uint8_t)(len + 2U))) return false;
+        link->stats.tx_msgs++;
+        return true;
+    }
+
+    // First Frame, rest after the peer's FC
+    memcpy(link->tx_buf, data, len);
+    uint16_t first = link->tx_dl - 2U;
+    frame[0] = ISOTP_PCI_FF | (uint8_t)(len >> 8);
+    frame[1] = (uint8_t)(len & 0xFFU);
+    memcpy(&frame[2], link->tx_buf, first);
+    if (!ISOTP_SendFrame(link, frame, link->tx_dl)) return false;
+
+    link->tx_len = len;
+    link->tx_pos = first;
+    link->tx_sn = 1;
+    link->tx_wft = 0;
+    link->tx_tick = HAL_GetTick();
+    link->tx_state = ISOTP_TX_WAIT_FC;
+    return true;
+}
+
+void ISOTP_Process(ISOTP_Link_t *link)
+{
+    uint32_t now = HAL_GetTick();
+
+    if (link->rx_state == ISOTP_RX_BUSY && (now - link->rx_tick) > ISOTP_TIMEOUT_MS)
+    {
+        link->rx_state = ISOTP_RX_IDLE; // N_Cr
+        link->stats.timeouts++;
+    }
+    if (link->tx_state == ISOTP_TX_WAIT_FC && (now - link->tx_tick) > ISOTP_TIMEOUT_MS)
+    {
+        link->tx_state = ISOTP_TX_IDLE; // N_Bs
+        link->stats.timeouts++;
+    }
+
+    while (link->tx_state == ISOTP_TX_SENDING)
+    {
+        // Strictly more than STmin ticks, so a partial tick never counts
+        if (link->tx_stmin_ms > 0 && (now - link->tx_tick) <= link->tx_stmin_ms) break;
+        if (CAN_TxFree(link->hfdcan, CAN_TX_PRIO_DIAG) == 0) break;
+
+        uint8_t frame[CAN_FD_MAX_LEN];
+        uint16_t n = link->tx_len - link->tx_pos;
+        if (n > link->tx_dl - 1U) n = link->tx_dl - 1U;
+
+        frame[0] = ISOTP_PCI_CF | link->tx_sn;
+        memcpy(&frame[1], &link->tx_buf[link->tx_pos], n);
+        if (!ISOTP_SendFrame(link, frame, (uint8_t)(n + 1U))) break;
+
+        link->tx_pos += n;
+        link->tx_sn = (link->tx_sn + 1U) & 0x0FU;
+        link->tx_tick = now;
+
+        if (link->tx_pos >= link->tx_len)
+        {
+            link->tx_state = ISOTP_TX_IDLE;
+            link->stats.tx_msgs++;
+        }
+        else if (link->tx_bs != 0 && ++link->tx_block >= link->tx_bs)
+        {
+            link->tx_block = 0;
+            link->tx_wft = 0;
+            link->tx_state = ISOTP_TX_WAIT_FC;
+        }
+        else if (link->tx_stmin_ms > 0)
+        {
+            break;
+        }
+    }
+}
+
+bool ISOTP_IsBusy(const ISOTP_Link_t *link)
+{
+    return link->rx_state != ISOTP_RX_IDLE || link->tx_state != ISOTP_TX_IDLE;
+}
@@ -14,12 +14,25 @@
 
 static char cli_buffer[CLI_MAX_CMD_LENGTH];
 static uint8_t cli_buffer_index = 0;
+static uint8_t cli_conn = 0; // Connector the state / CP / relay / meter / power commands act on
 
 // Function Prototypes for Commands
 static void Cmd_Help(void);
 static void Cmd_Status(void);
 static void Cmd_Reset(void);
 static void Cmd_CanTest(void);
+static void Cmd_CanStats(void);
+static void Cmd_CanHealth(void);
+static void Cmd_CanSched(void);
+static void Cmd_Uds(void);
+static void Cmd_GwStart(void);
+static void Cmd_GwStop(void);
+static void Cmd_GwStats(void);
+static void Cmd_RecStats(void);
+static void Cmd_RecClear(void);
+static void Cmd_RecCandump(void);
+static void Cmd_RecJsonl(void);
+static void Cmd_Conn(void);
 static void Cmd_StateBoot(void);
 static void Cmd_StateStandby(void);
 static void Cmd_StateCharge(void);
@@ -29,12 +42,21 @@ static void Cmd_PWMTest(void);
 static void Cmd_RelayTest(void);
 static void Cmd_MeterStatus(void);
 static void Cmd_MeterSet(void);
+static void Cmd_Modbus(void);
 // Config Commands
 #include "config_manager.h"
 
 static void Cmd_ConfigSave(void);
 static void Cmd_ConfigShow(void);
+static void Cmd_CrcBench(void);
 static void Cmd_PowerTest(void);
+static void Cmd_PowerGroups(void);
+static void Cmd_PowerShare(void);
+static void Cmd_PowerPoll(void);
+static void Cmd_PowerReg(void);
+static void Cmd_PowerAlloc(void);
+static void Cmd_Thermal(void);
+static void Cmd_SeccDemand(void);
 static void Cmd_OCPPStart(void);
 static void Cmd_OCPPStop(void);
 static void Cmd_FaultClear(void);
@@ -53,6 +75,18 @@ static const CLI_Command_t cli_commands[] = {
     {"status", "Show system status",     Cmd_Status},
     {"reset",  "Reset the microcontroller",   Cmd_Reset},
     {"can_test", "Send Test CAN Frame (ID 0x123)", Cmd_CanTest},
+    {"can_stats", "Show CAN RX/TX Queue Stats (Per Bus)", Cmd_CanStats},
+    {"can_health", "Show CAN Error State / TEC / REC / Load", Cmd_CanHealth},
+    {"can_sched", "Show CAN TX Schedule (Period / Offset / Counters)", Cmd_CanSched},
+    {"uds", "Show UDS Session / Download / ISO-TP Stats", Cmd_Uds},
+    {"gw_start", "Start CAN-UDP Gateway (Config gw_*)", Cmd_GwStart},
+    {"gw_stop", "Stop CAN-UDP Gateway", Cmd_GwStop},
+    {"gw_stats", "Show CAN-UDP Gateway Stats", Cmd_GwStats},
+    {"rec_stats", "Show Traffic Recorder Stats", Cmd_RecStats},
+    {"rec_clear", "Clear Traffic Recorder", Cmd_RecClear},
+    {"rec_candump", "Dump Recorded CAN Frames (candump -L)", Cmd_RecCandump},
+    {"rec_jsonl", "Dump All Recorded Traffic (JSONL, for Replay)", Cmd_RecJsonl},
+    {"conn", "Select Connector (Cycle 1..N)", Cmd_Conn},
     {"state_boot", "Force State: BOOT", Cmd_StateBoot},
     {"state_wait", "Force State: STANDBY", Cmd_StateStandby},
     {"state_charge", "Force State: CHARGING", Cmd_StateCharge},
@@ -62,9 +96,18 @@ static const CLI_Command_t cli_commands[] = {
     {"relay_test", "Cycle Relays (Safe -> Pre -> Main -> Dual)", Cmd_RelayTest},
     {"meter_status", "Show V/I/P/T", Cmd_MeterStatus},
     {"meter_test", "Cycle Sim Current (0->16->32)", Cmd_MeterSet},
+    {"modbus", "Show Modbus Master Stats (Per Slave)", Cmd_Modbus},
     {"config_save", "Save Config to Flash", Cmd_ConfigSave},
     {"config_show", "Show Config Data", Cmd_ConfigShow},
+    {"crc_bench", "Time CRC Service vs Bit Loop (1 KiB)", Cmd_CrcBench},
     {"power_test",  "Toggle 400V Output (Sim)", Cmd_PowerTest},
+    {"power_groups", "Show Power Module Groups / Staging", Cmd_PowerGroups},
+    {"power_share", "Show Current Sharing / Module Trims", Cmd_PowerShare},
+    {"power_poll",  "Show Module Temperatures / AC Input / Derating", Cmd_PowerPoll},
+    {"power_reg",   "Show DC Regulator (Ramp / PI Trim)", Cmd_PowerReg},
+    {"power_alloc", "Show Module Allocation Matrix (Groups -> Connectors)", Cmd_PowerAlloc},
+    {"thermal",     "Show Thermal Derating (Temperatures / Current Limit)", Cmd_Thermal},
+    {"secc_demand", "Show DC Demand / Fast Path Latency", Cmd_SeccDemand},
     {"ocpp_start",  "Send StartTransaction",    Cmd_OCPPStart},
     {"ocpp_stop",   "Send StopTransaction",     Cmd_OCPPStop},
     {"fault_clear", "Try to clear FAULT state", Cmd_FaultClear},
@@ -199,6 +242,11 @@ static void Cmd_Reset(void)
 // Ensure FDCAN handle is accessible
 #include "fdcan.h" 
 #include "can_driver.h"
+#include "can_health.h"
+#include "can_sched.h"
+#include "uds.h"
+#include "can_gateway.h"
+#include "recorder.h"
 #include "app_state.h"
 
 static void Cmd_CanTest(void)
@@ -206,21 +254,159 @@ static void Cmd_CanTest(void)
     uint8_t test_data[] = {0xDE, 0xAD, 0xBE, 0xEF, 0x01, 0x02, 0x03, 0x04};
     printf("Sending CAN Frame ID: 0x123... ");
     
-    if (CAN_Transmit(&hfdcan1, 0x123, test_data, 8))
+    if (CAN_Transmit(&hfdcan1, 0x123, test_data, 8, CAN_TX_PRIO_DIAG))
     {
-        printf("Success\r\n");
+        printf("Queued\r\n");
     }
     else
     {
-        printf("Failed (Tx FIFO Full?)\r\n");
+        printf("Failed (Tx Queue Full?)\r\n");
     }
 }
 
+static void Cmd_CanStats(void)
+{
+    static const char *bus_names[CAN_BUS_COUNT] = {"FDCAN1(SECC)", "FDCAN2(PWR)", "FDCAN3(IMD)"};
+    static const char *prio_names[CAN_TX_PRIO_COUNT] = {"Crit", "Stat", "Diag"};
+    CAN_RxStats_t st;
+    CAN_TxStats_t tx;
+
+    for (int bus = 0; bus < CAN_BUS_COUNT; bus++)
+    {
+        if (CAN_GetRxStats((CAN_Bus_t)bus, &st))
+        {
+            printf("[CAN] %-12s Rx: %lu, Overrun: %lu, HighWater: %u/%u, Latency: %lu us (Max %lu)\r\n",
+                   bus_names[bus], st.rx_count, st.overruns, st.high_water, CAN_RX_QUEUE_SIZE,
+                   st.latency_last_us, st.latency_max_us);
+            if (st.urgent_count)
+            {
+                printf("[CAN] %-12s Urgent: %lu, Latency Max %lu us\r\n",
+                       "", st.urgent_count, st.urgent_latency_max_us);
+            }
+        }
+
+        if (CAN_GetTxStats((CAN_Bus_t)bus, &tx))
+        {
+            for (int p = 0; p < CAN_TX_PRIO_COUNT; p++)
+            {
+                printf("      Tx %s: Queued %lu, Delivered %lu, Drop %lu, HighWater %u/%u, Latency %lu us (Max %lu)\r\n",
+                       prio_names[p], tx.queued[p], tx.delivered[p], tx.drops[p],
+                       tx.high_water[p], CAN_TX_QUEUE_SIZE,
+                       tx.latency_last_us[p], tx.latency_max_us[p]);
+            }
+            if (tx.events_lost > 0) printf("      Tx Event Lost: %lu\r\n", tx.events_lost);
+        }
+    }
+}
+
+static void Cmd_CanHealth(void)
+{
+    static const char *bus_names[CAN_BUS_COUNT] = {"FDCAN1(SECC)", "FDCAN2(PWR)", "FDCAN3(IMD)"};
+    static const char *state_names[] = {"Active", "Warning", "Passive", "Bus-Off"};
+    CAN_HealthStatus_t h;
+
+    for (int bus = 0; bus < CAN_BUS_COUNT; bus++)
+    {
+        if (!CAN_Health_GetStatus((CAN_Bus_t)bus, &h)) continue;
+
+        printf("[CAN] %-12s %s%s TEC: %u, REC: %u, LEC: %u, Load: %u.%u%% (Peak %u.%u%%)\r\n",
+               bus_names[bus], state_names[h.state], h.fault ? " [FAULT]" : "",
+               h.tec, h.rec, h.last_error_code,
+               h.load_permille / 10, h.load_permille % 10,
+               h.load_peak_permille / 10, h.load_peak_permille % 10);
+        printf("      Warn: %lu, Passive: %lu, BusOff: %lu, Recovered: %lu, RxLost: %lu, Backoff: %lu ms\r\n",
+               h.warning_count, h.passive_count, h.bus_off_count, h.recoveries, h.rx_lost, h.backoff_ms);
+    }
+}
+
+static void Cmd_CanSched(void)
+{
+    CAN_SchedMsg_t m;
+    CAN_SchedStats_t st;
+
+    printf("[CAN] Scheduler: %d Frames, Max Tick Lateness %lu us\r\n",
+           CAN_Sched_GetCount(), CAN_Sched_GetMaxLateUs());
+    for (int i = 0; i < CAN_Sched_GetCount(); i++)
+    {
+        if (!CAN_Sched_GetMsg(i, &m, &st)) continue;
+
+        printf("      Bus %d ID 0x%08lX %s Period %u ms @%u, MinGap %u ms%s: Periodic %lu, Event %lu, Held %lu, Superseded %lu, Fail %lu\r\n",
+               CAN_GetBusIndex(m.hfdcan), m.id, (m.flags & CAN_SCHED_FD) ? "FD" : "  ",
+               m.period_ms, m.offset_ms, m.min_interval_ms,
+               (m.flags & CAN_SCHED_ON_CHANGE) ? " OnChange" : "",
+               st.periodic, st.events, st.held, st.superseded, st.tx_fail);
+    }
+}
 
-static void Cmd_StateBoot(void) { StateMachine_SetState(STATE_BOOT); }
-static void Cmd_StateStandby(void) { StateMachine_SetState(STATE_STANDBY); }
-static void Cmd_StateCharge(void) { StateMachine_SetState(STATE_CHARGING); }
-static void Cmd_StateFault(void) { StateMachine_SetState(STATE_FAULT); }
+static void Cmd_Uds(void)
+{
+    UDS_Status_t st;
+    UDS_GetStatus(&st);
+
+    printf("[UDS] Session 0x%02X, Requests: %lu, Negative: %lu, Busy Drops: %lu\r\n",
+           st.session, st.requests, st.negative, st.busy_drops);
+    if (st.dl_active)
+    {
+        printf("      Download 0x%08lX: %lu/%lu bytes\r\n", st.dl_addr, st.dl_received, st.dl_size);
+    }
+    printf("      ISO-TP Rx: %lu, Tx: %lu, RxErr: %lu, Overflow: %lu, Timeout: %lu, TxAbort: %lu\r\n",
+           st.isotp.rx_msgs, st.isotp.tx_msgs, st.isotp.rx_errors, st.isotp.rx_overflow,
+           st.isotp.timeouts, st.isotp.tx_aborted);
+}
+
+static void Cmd_GwStart(void)
+{
+    Gateway_Start();
+    printf("[GW] Start Requested\r\n");
+}
+
+static void Cmd_GwStop(void)
+{
+    Gateway_Stop();
+    printf("[GW] Stop Requested\r\n");
+}
+
+static void Cmd_GwStats(void)
+{
+    const SystemConfig_t *cfg = Config_Get();
+    GW_Stats_t st;
+    Gateway_GetStats(&st);
+
+    printf("[GW] %s, Target %d.%d.%d.%d:%u+bus, Bus Mask 0x%02X, Rate %u fps\r\n",
+           st.running ? "Running" : "Stopped", cfg->gw_ip[0], cfg->gw_ip[1], cfg->gw_ip[2], cfg->gw_ip[3],
+           cfg->gw_port, cfg->gw_bus_mask, cfg->gw_rate_fps);
+    printf("     Forwarded: %lu, Datagrams: %lu, SendFail: %lu, Filtered: %lu, RateDrop: %lu, QueueDrop: %lu\r\n",
+           st.forwarded, st.datagrams, st.send_fails, st.filtered, st.rate_drops, st.queue_drops);
+}
+
+static void Cmd_RecStats(void)
+{
+    Rec_Stats_t st;
+    Recorder_GetStats(&st);
+    printf("[REC] Records: %lu, Used: %lu/%u bytes, Written: %lu, Evicted: %lu, Missed: %lu\r\n",
+           st.records, st.bytes_used, REC_BUFFER_SIZE, st.written, st.evicted, st.missed);
+}
+
+static void Cmd_RecClear(void)
+{
+    Recorder_Clear();
+    printf("[REC] Cleared\r\n");
+}
+
+static void Cmd_RecCandump(void) { Recorder_DumpCandump(); }
+static void Cmd_RecJsonl(void) { Recorder_DumpJsonl(); }
+
+static void Cmd_Conn(void)
+{
+    cli_conn = (uint8_t)((cli_conn + 1U) % EVSE_CONNECTOR_COUNT);
+    printf("[CLI] Connector %d of %d (%s)\r\n", cli_conn + 1, EVSE_CONNECTOR_COUNT,
+           StateMachine_GetStateName(StateMachine_GetState(cli_conn)));
+}
+
+static void Cmd_StateBoot(void) { StateMachine_SetState(cli_conn, STATE_BOOT); }
+static void Cmd_StateStandby(void) { StateMachine_SetState(cli_conn, STATE_STANDBY); }
+static void Cmd_StateCharge(void) { StateMachine_SetState(cli_conn, STATE_CHARGING); }
+static void Cmd_StateFault(void) { StateMachine_SetState(cli_conn, STATE_FAULT); }
 
 // Control Pilot Commands
 #include "control_pilot.h"
@@ -228,7 +414,7 @@ static void Cmd_StateFault(void) { StateMachine_SetState(STATE_FAULT); }
 
 static void Cmd_CPStatus(void)
 {
-    float volts = CP_ReadVoltage();
+    float volts = CP_ReadVoltage(cli_conn);
     CP_State_t state = CP_GetStateFromVoltage(volts);
     const char *state_str = "?";
     
@@ -242,7 +428,7 @@ static void Cmd_CPStatus(void)
         default: break;
     }
     
-    printf("[CP] Voltage: %.2f V, State: %s\r\n", volts, state_str);
+    printf("[CP] Connector %d Voltage: %.2f V, State: %s\r\n", cli_conn + 1, volts, state_str);
 }
 
 static void Cmd_PWMTest(void)
@@ -259,7 +445,7 @@ static void Cmd_PWMTest(void)
         case 3: duty = 0.0f; break;   // Off/-12V
     }
     
-    CP_SetPWM(duty);
+    CP_SetPWM(cli_conn, duty);
     printf("[CP] PWM Set to %.1f%%\r\n", duty);
 }
 
@@ -275,24 +461,24 @@ static void Cmd_RelayTest(void)
     {
         case 1:
             printf("[Relay] Precharge CLOSED\r\n");
-            Relay_SetPrecharge(true);
-            Relay_SetMain(false);
+            Relay_SetPrecharge(cli_conn, true);
+            Relay_SetMain(cli_conn, false);
             break;
         case 2:
             printf("[Relay] Main CLOSED, Precharge OPEN\r\n");
-            Relay_SetMain(true);
-            Relay_SetPrecharge(false);
+            Relay_SetMain(cli_conn, true);
+            Relay_SetPrecharge(cli_conn, false);
             break;
         case 3:
             printf("[Relay] Main CLOSED, Precharge CLOSED (Dual)\r\n");
-            Relay_SetMain(true);
-            Relay_SetPrecharge(true);
+            Relay_SetMain(cli_conn, true);
+            Relay_SetPrecharge(cli_conn, true);
             break;
         case 0:
         default:
             printf("[Relay] ALL OPEN (Safe)\r\n");
-            Relay_SetMain(false);
-            Relay_SetPrecharge(false);
+            Relay_SetMain(cli_conn, false);
+            Relay_SetPrecharge(cli_conn, false);
             break;
     }
 }
@@ -302,11 +488,11 @@ static void Cmd_RelayTest(void)
 
 static void Cmd_MeterStatus(void)
 {
-    printf("[Meter] %.1f V, %.1f A, %.1f W, %.1f C\r\n",
-           Meter_ReadVoltage(),
-           Meter_ReadCurrent(),
-           Meter_ReadPower(),
-           Meter_ReadTemperature());
+    printf("[Meter] Connector %d: %.1f V, %.1f A, %.1f W, %.1f C\r\n", cli_conn + 1,
+           Meter_ReadVoltage(cli_conn),
+           Meter_ReadCurrent(cli_conn),
+           Meter_ReadPower(cli_conn),
+           Meter_ReadTemperature(cli_conn));
 }
 
 static void Cmd_MeterSet(void)
@@ -317,10 +503,35 @@ static void Cmd_MeterSet(void)
     if (level == 1) target = 16.0f;
     if (level == 2) target = 32.0f;
     
-    Meter_Sim_SetCurrent(target);
+    Meter_Sim_SetCurrent(cli_conn, target);
     printf("[Meter] Sim Current Set to %.1f A\r\n", target);
 }
 
+#include "modbus_master.h"
+
+static void Cmd_Modbus(void)
+{
+    Modbus_MasterStatus_t st;
+    Modbus_GetStatus(&st);
+    printf("[Modbus] Rate: %s, Polls: %u, Queued: %u, Late: %lu, Queue Full: %lu, Unsolicited: %lu\r\n",
+           st.rate == MODBUS_RATE_ACTIVE ? "ACTIVE" : "IDLE", st.polls, st.queued,
+           st.late_polls, st.queue_full, st.unsolicited);
+
+    for (uint8_t i = 0; i < MODBUS_MAX_SLAVES; i++)
+    {
+        Modbus_SlaveStats_t s;
+        if (!Modbus_GetSlaveStats(i, &s)) continue;
+
+        uint32_t avg = s.ok ? (uint32_t)(s.latency_sum_us / s.ok) : 0;
+        printf("  Slave %3u%s: Req %lu, OK %lu, Failed %lu, Retries %lu | Latency %lu/%lu/%lu us (last/avg/max)\r\n",
+               s.slave, s.offline ? " (Offline)" : "", s.requests, s.ok, s.failed, s.retries,
+               s.latency_last_us, avg, s.latency_max_us);
+        printf("             Errors: Timeout %lu, CRC %lu, Frame %lu, Exception %lu | Offline %lu times\r\n",
+               s.errors[MODBUS_ERR_TIMEOUT], s.errors[MODBUS_ERR_CRC],
+               s.errors[MODBUS_ERR_FRAME], s.errors[MODBUS_ERR_EXCEPTION], s.offline_events);
+    }
+}
+
 // Config Commands
 #include "config_manager.h"
 
@@ -334,11 +545,34 @@ static void Cmd_ConfigShow(void)
     SystemConfig_t *cfg = Config_Get();
     printf("[Config] Max Current: %.1f A, Fault: %d, Boots: %lu\r\n",
            cfg->max_current_a, cfg->last_fault_code, cfg->boot_count);
+    printf("[Config] DC Ramp: %u V/s, %u A/s\r\n", cfg->reg_ramp_v_s, cfg->reg_ramp_a_s);
+}
+
+#include "crc_service.h"
+#include "timebase.h"
+
+static void Cmd_CrcBench(void)
+{
+    static uint8_t buf[1024];
+    for (uint32_t i = 0; i < sizeof(buf); i++) buf[i] = (uint8_t)(i * 151U + 7U);
+
+    for (int a = 0; a < CRC_ALGO_COUNT; a++)
+    {
+        uint64_t t0 = Timebase_GetMicros();
+        uint32_t ref = Crc_ComputeBitwise((Crc_Algo_t)a, buf, sizeof(buf));
+        uint64_t t1 = Timebase_GetMicros();
+        uint32_t crc = Crc_Compute((Crc_Algo_t)a, buf, sizeof(buf));
+        uint64_t t2 = Timebase_GetMicros();
+
+        printf("[CRC] %s: Bit Loop %lu us, %s %lu us, 0x%08lX %s\r\n", Crc_GetParams((Crc_Algo_t)a)->name,
+               (uint32_t)(t1 - t0), Crc_IsHardware() ? "CRC Unit" : "Tables", (uint32_t)(t2 - t1),
+               crc, (crc == ref) ? "OK" : "MISMATCH");
+    }
 }
 
 static void Cmd_FaultClear(void)
 {
-    StateMachine_TryClearFault();
+    StateMachine_TryClearFault(cli_conn);
 }
 
 // Power Module Test
@@ -352,30 +586,181 @@ static void Cmd_PowerTest(void)
     {
         printf("[Power] Test Starting... Targeting 400V @ 10A\r\n");
         // Example: Set 400V, 10A, Enabled
-        Infy_SetOutput(400.0f, 10.0f, true);
+        Infy_SetOutput(cli_conn, 400.0f, 10.0f, true);
     }
     else
     {
         printf("[Power] Test Stopping... Targeting 0V (Disable)\r\n");
         // Safe Shutdown: Voltage 0, Current 0, Disable
-        Infy_SetOutput(0.0f, 0.0f, false);
+        Infy_SetOutput(cli_conn, 0.0f, 0.0f, false);
     }
     
     // Readback Immediate Status
-    // Readback Immediate Status
-    const Infy_SystemStatus_t *st = Infy_GetSystemStatus();
-    printf("[Power] Status: %.1f V, %.1f A, Fault=%d\r\n", 
-           st->total_voltage, st->total_current, st->system_fault);
+    Infy_SystemStatus_t st;
+    Infy_GetSystemStatus(&st);
+    printf("[Power] Status: %.1f V, %.1f A, Fault=%d, Modules %d (On 0x%08lX%08lX), Running %d\r\n",
+           st.total_voltage, st.total_current, st.system_fault, st.active_modules,
+           (uint32_t)((uint64_t)st.on_mask >> 32), (uint32_t)st.on_mask, st.running_modules);
+}
+
+static void Cmd_PowerGroups(void)
+{
+    Infy_SystemStatus_t st;
+    Infy_GetSystemStatus(&st);
+    printf("[Power] Discovered %d, Alive %d, Running %d (Stage 0x%02X), High 0x%02X, Ready 0x%02X\r\n",
+           __builtin_popcountll(st.discovered_mask), st.active_modules, st.running_modules, st.stage_mask,
+           st.range_high_mask, st.range_ready_mask);
+    for (uint8_t o = 0; o < INFY_OUTLETS; o++)
+    {
+        Infy_OutletStatus_t out;
+        Infy_GetOutletStatus(o, &out);
+        printf("  Outlet %d: Groups 0x%02X (Stage 0x%02X), %d Running, %.1f V %.1f A, Range %s\r\n",
+               o + 1, out.groups, out.stage_mask, out.running_modules, out.voltage, out.current,
+               (out.range == INFY_RANGE_HIGH) ? "HIGH" : "LOW");
+    }
+
+    for (uint8_t g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        Infy_GroupStatus_t grp;
+        Infy_GetGroupStatus(g, &grp);
+        if (grp.discovered == 0) continue;
+        printf("  Group %d: %d/%d Alive, Outlet %d, %s, %s%s, Sweet %.1f kW, Rated %.1f kW\r\n",
+               g, grp.alive, grp.discovered, (grp.outlet == INFY_OUTLET_NONE) ? 0 : grp.outlet + 1,
+               grp.staged ? "Staged" : "Off", grp.range_high ? "HIGH" : "LOW",
+               grp.range_ready ? "" : " (Switching)", grp.sweet_kw, grp.rated_kw);
+    }
+}
+
+static void Cmd_PowerShare(void)
+{
+    Infy_ShareStatus_t sh;
+    Infy_GetShareStatus(cli_conn, &sh);
+    printf("[Power] Outlet %d Sharing: %s%s, %d Modules, Mean %.1f A, Max Dev %.1f A (%.1f%%, Module %d)\r\n",
+           cli_conn + 1, sh.active ? "Active" : "Idle", sh.converged ? " Converged" : "", sh.modules,
+           sh.mean_current, sh.max_deviation, sh.imbalance_pct, sh.worst_module);
+    printf("  Trim Frames %lu, Drops %lu, Failovers %lu\r\n", sh.trim_frames, sh.trim_drops, sh.failovers);
+
+    for (uint8_t i = 0; i < INFY_MAX_MODULES; i++)
+    {
+        Infy_ModuleStatus_t m;
+        Infy_GetModuleStatus(i, &m);
+        if (m.comm_timeout || !m.is_on) continue;
+        printf("  Module %2d: %6.1f A, Trim %+5.1f A%s\r\n", i, m.output_current, m.current_trim,
+               m.fault_ov || m.fault_uv || m.fault_ot ? " FAULT" : "");
+    }
+}
+
+#include "power_reg.h"
+static void Cmd_PowerPoll(void)
+{
+    Infy_PollStatus_t ps;
+    Infy_GetPollStatus(&ps);
+    printf("[Power] Polling: %lu Queries, %lu Replies, Holds %lu, Drops %lu, Wire %lu/%lu us/s\r\n",
+           ps.queries, ps.replies, ps.budget_holds, ps.tx_drops, ps.used_ns_per_s / 1000U, ps.budget_ns_per_s / 1000U);
+    printf("  Rounds: Temps %lu ms, AC %lu ms, Faults %lu ms, Derate %lu ms\r\n",
+           ps.round_ms[INFY_POLL_TEMPS], ps.round_ms[INFY_POLL_AC], ps.round_ms[INFY_POLL_FAULTS], ps.round_ms[INFY_POLL_DERATE]);
+
+    for (uint8_t i = 0; i < INFY_MAX_MODULES; i++)
+    {
+        Infy_ModuleStatus_t m;
+        Infy_GetModuleStatus(i, &m);
+        if (m.comm_timeout || m.polled == 0) continue;
+        printf("  Module %2d: %d/%d/%d C, AC %.0f/%.0f/%.0f V, Faults 0x%08lX, Power %d%% (0x%02X)\r\n", i,
+               m.temp_inlet, m.temp_pfc, m.temp_dcdc, m.ac_voltage[0], m.ac_voltage[1], m.ac_voltage[2],
+               m.fault_word, m.derate_pct, m.derate_reason);
+    }
+}
+
+static void Cmd_PowerReg(void)
+{
+    PowerReg_Status_t rs;
+    PowerReg_GetStatus(cli_conn, &rs);
+    printf("[Power] Connector %d Regulator: %s, %s Loop, %lu Ticks (Max Period %lu us), Fast Cuts %lu, Rises to Tick %lu\r\n",
+           cli_conn + 1, rs.enabled ? "On" : "Off", rs.cv_mode ? "CV" : "CC", rs.ticks, rs.period_max_us,
+           rs.fast_cuts, rs.fast_rises);
+    printf("  Target %6.1f V %6.1f A, Ref %6.1f V %6.1f A\r\n",
+           rs.target_voltage, rs.target_current, rs.ref_voltage, rs.ref_current);
+    printf("  Trim   %+6.1f V %+6.1f A, Cmd %6.1f V %6.1f A, Meas %6.1f V %6.1f A\r\n",
+           rs.trim_voltage, rs.trim_current, rs.cmd_voltage, rs.cmd_current, rs.meas_voltage, rs.meas_current);
+    if (rs.thermal_limited) printf("  Thermal Limit %6.1f A (Current Target Clamped)\r\n", rs.limit_current);
+}
+
+#include "power_alloc.h"
+static void Cmd_PowerAlloc(void)
+{
+    PowerAlloc_Status_t as;
+    PowerAlloc_GetStatus(&as);
+    printf("[Power] Allocation: %d Connector(s), %lu Moves, %lu Off Timeouts, %lu Close Holds, %lu Evaluations\r\n",
+           EVSE_CONNECTOR_COUNT, as.moves, as.off_timeouts, as.close_holds, as.evaluations);
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        printf("  Connector %d: %s, Need %6.1f A, Group %6.1f A, Groups %d (Target %d), Matrix 0x%02X\r\n",
+               c + 1, as.active[c] ? "On " : "Off", as.need_a[c], as.group_a[c], as.held[c], as.target[c],
+               Relay_GetMatrix(c));
+    }
+    static const char *phase_names[] = {"", " Draining", " Opening", " Closing"};
+    for (uint8_t g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        if (as.phase[g] == PALLOC_GROUP_IDLE && as.owner[g] == INFY_OUTLET_NONE) continue;
+        printf("  Group %d: Connector %d%s", g, (as.owner[g] == INFY_OUTLET_NONE) ? 0 : as.owner[g] + 1,
+               phase_names[as.phase[g] & 3U]);
+        if (as.dest[g] != INFY_OUTLET_NONE && as.dest[g] != as.owner[g]) printf(" -> %d", as.dest[g] + 1);
+        printf("\r\n");
+    }
+}
+
+#include "thermal_derate.h"
+static void Cmd_Thermal(void)
+{
+    Thermal_Status_t ts;
+    Thermal_GetStatus(cli_conn, &ts);
+    if (ts.limit_a < THERMAL_NO_LIMIT_A)
+        printf("[Thermal] Connector %d Limit %.1f A by %s, Derating %lu s\r\n", cli_conn + 1, ts.limit_a,
+               (ts.limiting == THERMAL_CH_COUNT) ? "Module Derating" : Thermal_ChannelName(ts.limiting), ts.derating_ms / 1000U);
+    else
+        printf("[Thermal] Connector %d No Limit, Derating %lu s\r\n", cli_conn + 1, ts.derating_ms / 1000U);
+    printf("  Ambient %.1f C%s, Modules %.1f kW%s\r\n", ts.ambient_c, ts.ambient_valid ? "" : " (Default)",
+           ts.module_cap_kw, ts.module_derated ? " (Derated)" : "");
+
+    for (int ch = 0; ch < THERMAL_CH_COUNT; ch++)
+    {
+        const Thermal_Channel_t *c = &ts.ch[ch];
+        if (!c->valid && !c->stale)
+        {
+            printf("  %-6s No Sensor\r\n", Thermal_ChannelName(ch));
+            continue;
+        }
+        printf("  %-6s %5.1f C (Predicted %5.1f C), %5.1f%%%s\r\n", Thermal_ChannelName(ch),
+               c->temp_c, c->predict_c, c->limit_pct, c->stale ? " (Stale)" : "");
+    }
+}
+
+#include "secc_driver.h"
+static void Cmd_SeccDemand(void)
+{
+    const SECC_Control_t *ctl = &secc_control[cli_conn];
+    printf("[SECC] Connector %d Demand: %.1f V %.1f A, EV Max %.1f V %.1f A, SoC %d%%%s\r\n", cli_conn + 1,
+           ctl->ev_target_voltage, ctl->ev_target_current,
+           ctl->ev_max_voltage, ctl->ev_max_current, ctl->ev_soc,
+           ctl->demand_valid ? "" : " (No Demand)");
+
+    Infy_FastStats_t fs;
+    Infy_GetFastStats(&fs);
+    printf("  Fast Path (Cuts): %lu Triggers, %lu Sent, %lu Unchanged, %lu Rejected\r\n",
+           fs.triggers, fs.sent, fs.unchanged, fs.rejected);
+    printf("  Queued %lu us (Max %lu), On Wire %lu us (Max %lu), Over %d us: %lu\r\n",
+           fs.queue_last_us, fs.queue_max_us, fs.wire_last_us, fs.wire_max_us,
+           INFY_FAST_BUDGET_US, fs.over_budget);
 }
 
 // OCPP Commands
 #include "ocpp_app.h"
 static void Cmd_OCPPStart(void)
 {
-    OCPP_SendStartTransaction("RFID_1234");
+    OCPP_SendStartTransaction(cli_conn, "RFID_1234");
 }
 
 static void Cmd_OCPPStop(void)
 {
-    OCPP_SendStopTransaction();
+    OCPP_SendStopTransaction(cli_conn);
 }
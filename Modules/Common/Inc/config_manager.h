@@ -17,6 +17,21 @@ typedef struct {
     uint8_t  server_ip[4];    // OCPP Server IP
     uint16_t server_port;     // OCPP Server Port
     char     charge_box_id[32]; // Charger ID (for WS URL)
+
+    // CAN-over-UDP Gateway (can_gateway.h)
+    uint8_t  gw_enable;       // Start forwarding at boot
+    uint8_t  gw_bus_mask;     // Bit n = CAN_Bus_t n forwarded
+    uint8_t  gw_ip[4];        // Listener IP
+    uint16_t gw_port;         // Listener port of FDCAN1 (FDCAN2/3: +1/+2)
+    uint16_t gw_rate_fps;     // Frames per second, all buses (0 = unlimited)
+    uint32_t gw_id_min[3];    // Forwarded ID range per bus (inclusive)
+    uint32_t gw_id_max[3];
+
+    // DC Output Regulator (power_reg.h)
+    uint16_t reg_ramp_v_s;    // Voltage ramp (V/s, 0 = step)
+    uint16_t reg_ramp_a_s;    // Current ramp (A/s, 0 = step)
+
+    uint32_t crc32;           // CRC-32 of the record up to here (Config_Save)
 } SystemConfig_t;
 
 /**
@@ -39,4 +54,9 @@ void Config_Save(void);
  */
 void Config_ResetDefaults(void);
 
+/**
+ * @brief Check a config record (magic, CRC-32)
+ */
+bool Config_IsValid(const SystemConfig_t *cfg);
+
 #endif /* MODULES_COMMON_CONFIG_MANAGER_H_ */
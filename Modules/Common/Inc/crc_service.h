@@ -0,0 +1,87 @@
+/**
+ * @file    crc_service.h
+ * @brief   CRC Service (STM32G4 CRC Unit, Table-Driven Software Fallback)
+ *
+ * @note    Algorithms are rows of a parameter table (width, polynomial,
+ *          init, input / output reflection, final XOR; the usual
+ *          "Rocksoft" model), selected with Crc_Algo_t. Another algorithm
+ *          is another row; widths 8, 16 and 32 are supported.
+ *
+ * @note    Target: the CRC unit with the row's polynomial, size and input
+ *          reflection, fed one big-endian word per bus write; output
+ *          reflection and final XOR are applied after. The unit is shared:
+ *          every CRC_HW_CHUNK bytes it is loaded with the configuration and
+ *          the running value and runs with interrupts masked, so tasks and
+ *          ISRs can use it at the same time. That adds well under 1 us of
+ *          interrupt latency.
+ *
+ * @note    Host (no CRC unit) or CRC_USE_HW 0: one 256-entry table per
+ *          algorithm, built by Crc_Init() and only read afterwards, so the
+ *          software path is reentrant as well.
+ */
+
+#ifndef MODULES_COMMON_CRC_SERVICE_H_
+#define MODULES_COMMON_CRC_SERVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Configuration ---
+#define CRC_USE_HW          1       // Use the CRC unit where there is one (0 = tables)
+#define CRC_HW_CHUNK        256U    // Bytes per interrupts-masked run of the unit
+
+typedef enum
+{
+    CRC_ALGO_MODBUS = 0,     // CRC-16/MODBUS (RTU frames)
+    CRC_ALGO_CRC32,          // CRC-32 (IEEE 802.3, as zlib): config record, images
+    CRC_ALGO_COUNT
+} Crc_Algo_t;
+
+typedef struct
+{
+    const char *name;
+    uint8_t  width;          // Bits: 8, 16 or 32
+    bool     reflect_in;     // Bytes LSB first
+    bool     reflect_out;    // Result bit-reversed before the final XOR
+    uint32_t poly;           // Normal form (MSB first, top bit implied)
+    uint32_t init;           // Register before the first byte (normal form)
+    uint32_t xor_out;        // XORed into the result
+    uint32_t check;          // CRC of "123456789" (self-test)
+} Crc_Params_t;
+
+/**
+ * @brief Enable the CRC unit / build the tables, run the self-test
+ * @note  Call once before the first CRC (App_Init, before the scheduler).
+ * @return false if an algorithm fails its check value
+ */
+bool Crc_Init(void);
+
+/**
+ * @brief CRC of a buffer
+ */
+uint32_t Crc_Compute(Crc_Algo_t algo, const void *data, uint32_t len);
+
+/**
+ * @brief Continue a CRC over more data
+ * @param crc Result of Crc_Compute / Crc_Update over the data before
+ *            (Crc_Compute(algo, NULL, 0) for none, 0 for CRC-32)
+ */
+uint32_t Crc_Update(Crc_Algo_t algo, uint32_t crc, const void *data, uint32_t len);
+
+/**
+ * @brief Bit-serial reference (one shift per bit, no table, no unit)
+ * @note  For the self-test and benchmarks only.
+ */
+uint32_t Crc_ComputeBitwise(Crc_Algo_t algo, const void *data, uint32_t len);
+
+/**
+ * @brief Parameters of an algorithm
+ */
+const Crc_Params_t *Crc_GetParams(Crc_Algo_t algo);
+
+/**
+ * @brief true if the CRC unit computes the CRCs (false: tables)
+ */
+bool Crc_IsHardware(void);
+
+#endif /* MODULES_COMMON_CRC_SERVICE_H_ */
@@ -0,0 +1,34 @@
+/**
+ * @file    evse_connector.h
+ * @brief   Charging Outlets (Connectors) of the Cabinet
+ *
+ * @note    Each connector has its own state machine, SECC link, DC meter,
+ *          contactor set and Infy outlet; the power module groups are
+ *          shared between them through the allocation matrix (power_alloc).
+ *          Firmware indices are 0-based, OCPP connectorId is index + 1.
+ *
+ * @note    The count is a build option (e.g. -DEVSE_CONNECTOR_COUNT=2); the
+ *          default is the single-gun board, on which everything behaves as
+ *          before (no matrix, all groups on the one output bus).
+ */
+
+#ifndef MODULES_COMMON_EVSE_CONNECTOR_H_
+#define MODULES_COMMON_EVSE_CONNECTOR_H_
+
+#include <stdint.h>
+
+#ifndef EVSE_CONNECTOR_COUNT
+#define EVSE_CONNECTOR_COUNT  1
+#endif
+
+#define EVSE_CONNECTOR_MAX    4   // Pin / CAN ID budget of the board
+
+_Static_assert(EVSE_CONNECTOR_COUNT >= 1 && EVSE_CONNECTOR_COUNT <= EVSE_CONNECTOR_MAX,
+               "EVSE_CONNECTOR_COUNT out of range");
+
+// OCPP connectorId <-> connector index
+#define EVSE_CONNECTOR_ID(conn)     ((int)(conn) + 1)
+#define EVSE_CONNECTOR_INDEX(id)    ((uint8_t)((id) - 1))
+#define EVSE_CONNECTOR_VALID(id)    ((id) >= 1 && (id) <= EVSE_CONNECTOR_COUNT)
+
+#endif /* MODULES_COMMON_EVSE_CONNECTOR_H_ */
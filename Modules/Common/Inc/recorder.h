@@ -0,0 +1,119 @@
+/**
+ * @file    recorder.h
+ * @brief   Traffic Recorder (CAN / Modbus RTU / OCPP) in a RAM Ring
+ *
+ * @note    Every record carries a 64-bit Timebase timestamp (us). CAN frames
+ *          use the hardware SOF time; Modbus and OCPP use the time the
+ *          buffer was handed to / received from the driver. When the ring is
+ *          full the oldest records are evicted.
+ *
+ * @note    Dump formats (CLI):
+ *          - rec_candump: candump -L compatible, CAN sources only
+ *          - rec_jsonl:   one JSON object per record, all sources. This is
+ *                         the input format of Tools/replay.
+ */
+
+#ifndef MODULES_COMMON_RECORDER_H_
+#define MODULES_COMMON_RECORDER_H_
+
+#include "can_driver.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Configuration ---
+#define REC_BUFFER_SIZE      8192  // RAM ring (bytes, power of 2)
+#define REC_MAX_PAYLOAD      1024  // Longer payloads are truncated (REC_FLAG_TRUNC)
+#define REC_ENABLE_DEFAULT   1     // Record from boot
+
+// Record Source
+typedef enum
+{
+    REC_SRC_CAN0 = 0,      // FDCAN1 (CAN_BUS_SECC)
+    REC_SRC_CAN1,          // FDCAN2 (CAN_BUS_POWER)
+    REC_SRC_CAN2,          // FDCAN3 (CAN_BUS_IMD)
+    REC_SRC_MODBUS,        // USART3 Modbus RTU (Meter)
+    REC_SRC_OCPP,          // OCPP JSON (after TLS)
+    REC_SRC_COUNT
+} Rec_Source_t;
+
+// Record Flags
+#define REC_FLAG_TX      0x01U  // Sent by this controller (else received)
+#define REC_FLAG_EXT     0x02U  // CAN 29-bit ID
+#define REC_FLAG_FD      0x04U  // CAN FD frame
+#define REC_FLAG_BRS     0x08U  // CAN FD bit rate switch
+#define REC_FLAG_TRUNC   0x10U  // Payload truncated to REC_MAX_PAYLOAD
+
+// Raw Record (Recorder_ReadRecords): little-endian header, then len bytes
+//   u64 timestamp_us, u32 id, u16 len, u8 src, u8 flags
+#define REC_HEADER_SIZE  16U
+#define REC_CURSOR_OLDEST  0xFFFFFFFFU // Start (or restart) at the oldest record
+
+// Recorder Statistics
+typedef struct
+{
+    uint32_t records;      // Records currently in the ring
+    uint32_t written;      // Records written since clear
+    uint32_t evicted;      // Oldest records overwritten
+    uint32_t missed;       // Records dropped (disabled / paused for dump)
+    uint32_t bytes_used;   // Ring occupancy
+} Rec_Stats_t;
+
+/**
+ * @brief Initialize recorder and attach to the CAN driver taps
+ */
+void Recorder_Init(void);
+
+/**
+ * @brief Append one record (ISR and task safe)
+ * @param src Source interface
+ * @param id CAN ID (0 for Modbus / OCPP)
+ * @param flags REC_FLAG_x
+ * @param timestamp_us Timebase time of the record
+ * @param data Payload
+ * @param len Payload length
+ */
+void Recorder_Write(Rec_Source_t src, uint32_t id, uint8_t flags, uint64_t timestamp_us,
+                    const uint8_t *data, uint16_t len);
+
+/**
+ * @brief CAN driver tap (RX from ISR, TX at enqueue)
+ */
+void Recorder_CanTap(const CAN_Message_t *msg, bool tx);
+
+/**
+ * @brief Enable or disable recording
+ */
+void Recorder_SetEnabled(bool enable);
+
+/**
+ * @brief Drop all records and reset statistics
+ */
+void Recorder_Clear(void);
+
+/**
+ * @brief Get recorder statistics
+ */
+void Recorder_GetStats(Rec_Stats_t *stats);
+
+/**
+ * @brief Copy whole raw records, oldest first, starting at a cursor
+ * @param cursor In: position of the next record, REC_CURSOR_OLDEST or a
+ *               position already evicted restarts at the oldest record.
+ *               Out: position after the last copied record.
+ * @param buf Output buffer
+ * @param max Buffer size (>= REC_HEADER_SIZE + REC_MAX_PAYLOAD always progresses)
+ * @return Bytes copied, 0 = no newer record
+ */
+uint16_t Recorder_ReadRecords(uint32_t *cursor, uint8_t *buf, uint16_t max);
+
+/**
+ * @brief Print CAN records in candump -L format (recording paused while dumping)
+ */
+void Recorder_DumpCandump(void);
+
+/**
+ * @brief Print all records as JSON Lines (recording paused while dumping)
+ */
+void Recorder_DumpJsonl(void);
+
+#endif /* MODULES_COMMON_RECORDER_H_ */
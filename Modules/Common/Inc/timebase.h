@@ -0,0 +1,53 @@
+/**
+ * @file    timebase.h
+ * @brief   64-bit Microsecond Timebase (TIM3, 1 MHz)
+ *
+ * @note    TIM3 is a free-running 16-bit counter at 1 MHz. It is also the
+ *          FDCAN external timestamp source, so RX/TX timestamps captured by
+ *          the FDCAN (16-bit) can be extended to the same 64-bit time as
+ *          long as they are converted within one wrap (65.536 ms).
+ */
+
+#ifndef MODULES_COMMON_TIMEBASE_H_
+#define MODULES_COMMON_TIMEBASE_H_
+
+#include "main.h"
+#include <stdint.h>
+
+#define TIMEBASE_US_PER_MS   1000ULL
+#define TIMEBASE_US_PER_SEC  1000000ULL
+
+/**
+ * @brief Start the timebase counter and its overflow interrupt
+ * @param htim 1 MHz, 16-bit free-running timer (htim3)
+ */
+void Timebase_Init(TIM_HandleTypeDef *htim);
+
+/**
+ * @brief Current time in microseconds since Timebase_Init (ISR safe)
+ */
+uint64_t Timebase_GetMicros(void);
+
+/**
+ * @brief Extend a 16-bit hardware capture of the timebase counter
+ * @note  Capture must be less than 65.536 ms old (FDCAN ISR context).
+ * @param capture Counter value captured by hardware (e.g. RxTimestamp)
+ * @return Capture time in the 64-bit microsecond timebase
+ */
+uint64_t Timebase_Extend16(uint16_t capture);
+
+/**
+ * @brief Time elapsed since a stored timestamp
+ * @note  Reads the 64-bit stamp atomically, so it may be updated by a
+ *        higher-priority task or ISR (e.g. CAN RX handler).
+ * @param stamp_us Stored timebase value (0 = never set -> age since boot)
+ * @return now - *stamp_us (us)
+ */
+uint64_t Timebase_GetAge(const volatile uint64_t *stamp_us);
+
+/**
+ * @brief Counter wrap handler (Called from HAL_TIM_PeriodElapsedCallback)
+ */
+void Timebase_OverflowCallback(void);
+
+#endif /* MODULES_COMMON_TIMEBASE_H_ */
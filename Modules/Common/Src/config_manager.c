@@ -4,6 +4,8 @@
  */
 
 #include "config_manager.h"
+#include "crc_service.h"
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -11,6 +13,11 @@
 
 static SystemConfig_t sys_config;
 
+static uint32_t Config_Crc(const SystemConfig_t *cfg)
+{
+    return Crc_Compute(CRC_ALGO_CRC32, cfg, offsetof(SystemConfig_t, crc32));
+}
+
 void Config_ResetDefaults(void)
 {
     sys_config.magic_code = CONFIG_MAGIC;
@@ -25,6 +32,22 @@ void Config_ResetDefaults(void)
     sys_config.server_ip[3] = 100;
     sys_config.server_port = 8080;
     strcpy(sys_config.charge_box_id, "CP1");
+
+    // CAN-UDP Gateway: off, power bus to the OCPP host when enabled
+    sys_config.gw_enable = 0;
+    sys_config.gw_bus_mask = 0x02;
+    memcpy(sys_config.gw_ip, sys_config.server_ip, 4);
+    sys_config.gw_port = 20000;
+    sys_config.gw_rate_fps = 2000;
+    for (int bus = 0; bus < 3; bus++)
+    {
+        sys_config.gw_id_min[bus] = 0;
+        sys_config.gw_id_max[bus] = 0x1FFFFFFF;
+    }
+
+    // DC Regulator: 0 -> 500 V in 2.5 s, 0 -> 100 A in 1 s
+    sys_config.reg_ramp_v_s = 200;
+    sys_config.reg_ramp_a_s = 100;
     
     printf("[Config] Reset to Defaults.\r\n");
 }
@@ -34,8 +57,8 @@ void Config_Init(void)
     // Simulate Load from Flash Address
     // memcpy(&sys_config, (void*)0x0807F800, sizeof(SystemConfig_t));
     
-    // Check Validity (Mock)
-    if (sys_config.magic_code != CONFIG_MAGIC)
+    // Check Validity (magic, CRC-32)
+    if (!Config_IsValid(&sys_config))
     {
         printf("[Config] Invalid/Empty Flash. Loading Defaults.\r\n");
         Config_ResetDefaults();
@@ -54,6 +77,8 @@ SystemConfig_t* Config_Get(void)
 
 void Config_Save(void)
 {
+    sys_config.crc32 = Config_Crc(&sys_config);
+
     // Simulate Flash Erase/Write
     printf("[Config] Saving to Flash... ");
     // HAL_FLASH_Unlock();
@@ -61,3 +86,8 @@ void Config_Save(void)
     // HAL_FLASH_Lock();
     printf("Done. (Mock)\r\n");
 }
+
+bool Config_IsValid(const SystemConfig_t *cfg)
+{
+    return cfg->magic_code == CONFIG_MAGIC && cfg->crc32 == Config_Crc(cfg);
+}
@@ -0,0 +1,263 @@
+/**
+ * @file    crc_service.c
+ * @brief   CRC Service Implementation
+ *
+ * @details
+ * The running value is the engine's register: MSB first in the CRC unit's
+ * data register, LSB first in the table of an algorithm with reflect_in
+ * (so the byte loop needs no reflection). Output reflection and final XOR
+ * are applied to it at the end, and undone by Crc_Update() to continue a
+ * result; a reflected register with reflect_out needs neither reflection.
+ *
+ * The unit takes its data as 32-bit words, MSB first: four bytes are
+ * loaded little-endian and byte-swapped, so they go in in buffer order,
+ * and REV_IN (by byte) reflects each of them for LSB-first algorithms. The
+ * tail goes in as byte writes.
+ */
+
+#include "crc_service.h"
+#include "main.h"
+#include <stdio.h>
+#include <string.h>
+
+#if CRC_USE_HW && defined(CRC_BASE)
+#define CRC_HW 1
+#else
+#define CRC_HW 0
+#endif
+
+static const Crc_Params_t crc_params[CRC_ALGO_COUNT] = {
+    [CRC_ALGO_MODBUS] = { "CRC-16/MODBUS", 16, true, true, 0x8005U,     0xFFFFU,     0x0000U,     0x4B37U     },
+    [CRC_ALGO_CRC32]  = { "CRC-32",        32, true, true, 0x04C11DB7U, 0xFFFFFFFFU, 0xFFFFFFFFU, 0xCBF43926U },
+};
+
+static uint32_t crc_start[CRC_ALGO_COUNT]; // init as a running register
+
+#if !CRC_HW
+// Per algorithm: reflected table (reflect_in) or MSB-first table
+static uint32_t crc_table[CRC_ALGO_COUNT][256];
+#endif
+
+static uint32_t Crc_Mask(uint8_t width)
+{
+    return (width >= 32U) ? 0xFFFFFFFFU : ((1UL << width) - 1U);
+}
+
+static uint32_t Crc_Reflect(uint32_t v, uint8_t width)
+{
+#if CRC_HW
+    return __RBIT(v) >> (32U - width);
+#else
+    uint32_t r = 0;
+    for (uint8_t b = 0; b < width; b++)
+    {
+        r = (r << 1) | (v & 1U);
+        v >>= 1;
+    }
+    return r;
+#endif
+}
+
+// The running register is MSB first on the unit, LSB first (reflected) in
+// the tables of a reflect_in algorithm
+static bool Crc_RegReflected(const Crc_Params_t *p)
+{
+    return !CRC_HW && p->reflect_in;
+}
+
+// Result -> running register
+static uint32_t Crc_ToRegister(const Crc_Params_t *p, uint32_t crc)
+{
+    crc = (crc ^ p->xor_out) & Crc_Mask(p->width);
+    return (p->reflect_out != Crc_RegReflected(p)) ? Crc_Reflect(crc, p->width) : crc;
+}
+
+// Running register -> result
+static uint32_t Crc_FromRegister(const Crc_Params_t *p, uint32_t reg)
+{
+    if (p->reflect_out != Crc_RegReflected(p)) reg = Crc_Reflect(reg, p->width);
+    return (reg ^ p->xor_out) & Crc_Mask(p->width);
+}
+
+#if CRC_HW
+
+static uint32_t Crc_RunHw(const Crc_Params_t *p, uint32_t reg, const uint8_t *d, uint32_t len)
+{
+    uint32_t cr = (p->width == 16U) ? CRC_CR_POLYSIZE_0 : (p->width == 8U) ? CRC_CR_POLYSIZE_1 : 0U;
+    if (p->reflect_in) cr |= CRC_CR_REV_IN_0; // Bit reversal by byte
+
+    while (len > 0)
+    {
+        uint32_t n = (len < CRC_HW_CHUNK) ? len : CRC_HW_CHUNK;
+        len -= n;
+
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        CRC->CR = cr;
+        CRC->POL = p->poly;
+        CRC->INIT = reg;
+        CRC->CR = cr | CRC_CR_RESET; // DR = INIT
+
+        for (; n >= 4U; n -= 4U, d += 4)
+        {
+            uint32_t w;
+            memcpy(&w, d, 4);
+            CRC->DR = __REV(w);
+        }
+        for (; n > 0; n--)
+        {
+            *(__IO uint8_t *)&CRC->DR = *d++;
+        }
+        reg = CRC->DR & Crc_Mask(p->width);
+
+        __set_PRIMASK(primask);
+    }
+    return reg;
+}
+
+#else
+
+static void Crc_BuildTable(Crc_Algo_t algo)
+{
+    const Crc_Params_t *p = &crc_params[algo];
+    uint32_t mask = Crc_Mask(p->width);
+
+    for (uint32_t i = 0; i < 256U; i++)
+    {
+        uint32_t r;
+        if (p->reflect_in)
+        {
+            uint32_t poly = Crc_Reflect(p->poly, p->width);
+            r = i;
+            for (int b = 0; b < 8; b++) r = (r & 1U) ? (r >> 1) ^ poly : r >> 1;
+        }
+        else
+        {
+            uint32_t top = 1UL << (p->width - 1U);
+            r = i << (p->width - 8U);
+            for (int b = 0; b < 8; b++) r = (r & top) ? (r << 1) ^ p->poly : r << 1;
+        }
+        crc_table[algo][i] = r & mask;
+    }
+}
+
+static uint32_t Crc_RunTable(Crc_Algo_t algo, uint32_t reg, const uint8_t *d, uint32_t len)
+{
+    const Crc_Params_t *p = &crc_params[algo];
+    const uint32_t *t = crc_table[algo];
+
+    if (p->reflect_in)
+    {
+        for (uint32_t i = 0; i < len; i++) reg = (reg >> 8) ^ t[(reg ^ d[i]) & 0xFFU];
+        return reg;
+    }
+
+    uint32_t mask = Crc_Mask(p->width);
+    uint8_t shift = p->width - 8U;
+    for (uint32_t i = 0; i < len; i++) reg = ((reg << 8) ^ t[((reg >> shift) ^ d[i]) & 0xFFU]) & mask;
+    return reg;
+}
+
+#endif
+
+static uint32_t Crc_Run(Crc_Algo_t algo, uint32_t reg, const void *data, uint32_t len)
+{
+    if (len == 0) return reg;
+#if CRC_HW
+    return Crc_RunHw(&crc_params[algo], reg, (const uint8_t *)data, len);
+#else
+    return Crc_RunTable(algo, reg, (const uint8_t *)data, len);
+#endif
+}
+
+uint32_t Crc_Update(Crc_Algo_t algo, uint32_t crc, const void *data, uint32_t len)
+{
+    if (algo >= CRC_ALGO_COUNT) return 0;
+    const Crc_Params_t *p = &crc_params[algo];
+
+    return Crc_FromRegister(p, Crc_Run(algo, Crc_ToRegister(p, crc), data, len));
+}
+
+uint32_t Crc_Compute(Crc_Algo_t algo, const void *data, uint32_t len)
+{
+    if (algo >= CRC_ALGO_COUNT) return 0;
+    const Crc_Params_t *p = &crc_params[algo];
+
+    return Crc_FromRegister(p, Crc_Run(algo, crc_start[algo], data, len));
+}
+
+uint32_t Crc_ComputeBitwise(Crc_Algo_t algo, const void *data, uint32_t len)
+{
+    if (algo >= CRC_ALGO_COUNT) return 0;
+    const Crc_Params_t *p = &crc_params[algo];
+    const uint8_t *d = (const uint8_t *)data;
+    uint32_t mask = Crc_Mask(p->width);
+    uint32_t reg;
+
+    if (p->reflect_in)
+    {
+        uint32_t poly = Crc_Reflect(p->poly, p->width);
+        reg = Crc_Reflect(p->init, p->width);
+        for (uint32_t i = 0; i < len; i++)
+        {
+            reg ^= d[i];
+            for (int b = 0; b < 8; b++) reg = (reg & 1U) ? (reg >> 1) ^ poly : reg >> 1;
+        }
+        if (!p->reflect_out) reg = Crc_Reflect(reg, p->width);
+    }
+    else
+    {
+        uint32_t top = 1UL << (p->width - 1U);
+        reg = p->init & mask;
+        for (uint32_t i = 0; i < len; i++)
+        {
+            reg ^= (uint32_t)d[i] << (p->width - 8U);
+            for (int b = 0; b < 8; b++) reg = ((reg & top) ? (reg << 1) ^ p->poly : reg << 1) & mask;
+        }
+        if (p->reflect_out) reg = Crc_Reflect(reg, p->width);
+    }
+    return (reg ^ p->xor_out) & mask;
+}
+
+bool Crc_Init(void)
+{
+    static const uint8_t check[] = "123456789";
+    bool ok = true;
+
+#if CRC_HW
+    __HAL_RCC_CRC_CLK_ENABLE();
+#else
+    for (int a = 0; a < CRC_ALGO_COUNT; a++) Crc_BuildTable((Crc_Algo_t)a);
+#endif
+    for (int a = 0; a < CRC_ALGO_COUNT; a++)
+    {
+        const Crc_Params_t *p = &crc_params[a];
+        crc_start[a] = Crc_RegReflected(p) ? Crc_Reflect(p->init, p->width) : (p->init & Crc_Mask(p->width));
+    }
+
+    for (int a = 0; a < CRC_ALGO_COUNT; a++)
+    {
+        const Crc_Params_t *p = &crc_params[a];
+        uint32_t whole = Crc_Compute((Crc_Algo_t)a, check, 9);
+        uint32_t split = Crc_Update((Crc_Algo_t)a, Crc_Compute((Crc_Algo_t)a, check, 4), &check[4], 5);
+        if (whole != p->check || split != p->check || Crc_ComputeBitwise((Crc_Algo_t)a, check, 9) != p->check)
+        {
+            printf("[CRC] %s Self-Test Failed: 0x%08lX (expected 0x%08lX)\r\n", p->name, whole, p->check);
+            ok = false;
+        }
+    }
+
+    printf("[CRC] Initialized (%s), Self-Test %s\r\n", CRC_HW ? "CRC Unit" : "Tables", ok ? "OK" : "FAILED");
+    return ok;
+}
+
+const Crc_Params_t *Crc_GetParams(Crc_Algo_t algo)
+{
+    return (algo < CRC_ALGO_COUNT) ? &crc_params[algo] : NULL;
+}
+
+bool Crc_IsHardware(void)
+{
+    return CRC_HW != 0;
+}
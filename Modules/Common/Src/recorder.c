@@ -0,0 +1,282 @@
+/**
+ * @file    recorder.c
+ * @brief   Traffic Recorder Implementation
+ *
+ * @details
+ * Records are packed back to back into a byte ring: a fixed header
+ * followed by the payload. Writers (FDCAN ISRs, Meter UART callback, OCPP
+ * task) append under PRIMASK; when there is not enough room the oldest
+ * records are evicted first, so the ring always holds the most recent
+ * traffic. Dumps walk the ring from the oldest record with recording
+ * paused, so the printed window is consistent.
+ */
+
+#include "recorder.h"
+#include <stdio.h>
+#include <string.h>
+
+#define REC_BUFFER_MASK  (REC_BUFFER_SIZE - 1U)
+
+#if (REC_BUFFER_SIZE & REC_BUFFER_MASK) != 0
+#error "REC_BUFFER_SIZE must be a power of 2"
+#endif
+
+// Record Header (Followed by len payload bytes)
+typedef struct
+{
+    uint64_t timestamp_us;
+    uint32_t id;
+    uint16_t len;
+    uint8_t  src;     // Rec_Source_t
+    uint8_t  flags;   // REC_FLAG_x
+} Rec_Header_t;
+
+_Static_assert(sizeof(Rec_Header_t) == REC_HEADER_SIZE, "Rec_Header_t layout is exported");
+
+static uint8_t rec_buffer[REC_BUFFER_SIZE];
+static uint32_t rec_head = 0;    // Free-running write offset
+static uint32_t rec_tail = 0;    // Free-running offset of the oldest record
+static Rec_Stats_t rec_stats;
+static volatile bool rec_enabled = false;
+static volatile bool rec_paused = false;
+
+static const char *const rec_src_names[REC_SRC_COUNT] = {"can0", "can1", "can2", "modbus", "ocpp"};
+
+// Byte copies with wrap (offsets are free-running)
+static void Rec_CopyIn(uint32_t offset, const void *src, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)src;
+    uint32_t pos = offset & REC_BUFFER_MASK;
+    uint32_t first = REC_BUFFER_SIZE - pos;
+    if (first > len) first = len;
+
+    memcpy(&rec_buffer[pos], p, first);
+    memcpy(rec_buffer, p + first, len - first);
+}
+
+static void Rec_CopyOut(uint32_t offset, void *dst, uint32_t len)
+{
+    uint8_t *p = (uint8_t *)dst;
+    uint32_t pos = offset & REC_BUFFER_MASK;
+    uint32_t first = REC_BUFFER_SIZE - pos;
+    if (first > len) first = len;
+
+    memcpy(p, &rec_buffer[pos], first);
+    memcpy(p + first, rec_buffer, len - first);
+}
+
+// Print 64-bit microseconds without 64-bit printf support (newlib-nano)
+static void Rec_PrintMicros(uint64_t us, bool seconds)
+{
+    uint32_t sec = (uint32_t)(us / TIMEBASE_US_PER_SEC);
+    uint32_t usec = (uint32_t)(us % TIMEBASE_US_PER_SEC);
+
+    if (seconds) printf("%lu.%06lu", sec, usec);
+    else if (sec > 0) printf("%lu%06lu", sec, usec);
+    else printf("%lu", usec);
+}
+
+static void Rec_PrintHex(uint32_t offset, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        printf("%02X", rec_buffer[(offset + i) & REC_BUFFER_MASK]);
+    }
+}
+
+void Recorder_Init(void)
+{
+    Recorder_Clear();
+    rec_enabled = (REC_ENABLE_DEFAULT != 0);
+
+    CAN_AddTap(Recorder_CanTap);
+
+    printf("[REC] Initialized (%d bytes)\r\n", REC_BUFFER_SIZE);
+}
+
+void Recorder_Write(Rec_Source_t src, uint32_t id, uint8_t flags, uint64_t timestamp_us,
+                    const uint8_t *data, uint16_t len)
+{
+    if ((int)src < 0 || src >= REC_SRC_COUNT) return;
+
+    if (len > REC_MAX_PAYLOAD)
+    {
+        len = REC_MAX_PAYLOAD;
+        flags |= REC_FLAG_TRUNC;
+    }
+
+    Rec_Header_t hdr;
+    hdr.timestamp_us = timestamp_us;
+    hdr.id = id;
+    hdr.len = len;
+    hdr.src = (uint8_t)src;
+    hdr.flags = flags;
+
+    uint32_t need = sizeof(Rec_Header_t) + len;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (!rec_enabled || rec_paused)
+    {
+        rec_stats.missed++;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    // Evict oldest records until the new one fits
+    while ((REC_BUFFER_SIZE - (rec_head - rec_tail)) < need)
+    {
+        Rec_Header_t old;
+        Rec_CopyOut(rec_tail, &old, sizeof(Rec_Header_t));
+        rec_tail += sizeof(Rec_Header_t) + old.len;
+        rec_stats.records--;
+        rec_stats.evicted++;
+    }
+
+    Rec_CopyIn(rec_head, &hdr, sizeof(Rec_Header_t));
+    Rec_CopyIn(rec_head + sizeof(Rec_Header_t), data, len);
+    rec_head += need;
+
+    rec_stats.records++;
+    rec_stats.written++;
+
+    __set_PRIMASK(primask);
+}
+
+void Recorder_CanTap(const CAN_Message_t *msg, bool tx)
+{
+    uint8_t flags = 0;
+    if (tx) flags |= REC_FLAG_TX;
+    if (msg->id_type == CAN_ID_EXT) flags |= REC_FLAG_EXT;
+    if (msg->fd) flags |= REC_FLAG_FD;
+    if (msg->brs) flags |= REC_FLAG_BRS;
+
+    Recorder_Write((Rec_Source_t)(REC_SRC_CAN0 + msg->bus), msg->id, flags, msg->timestamp_us,
+                   msg->data, msg->len);
+}
+
+void Recorder_SetEnabled(bool enable)
+{
+    rec_enabled = enable;
+}
+
+void Recorder_Clear(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    rec_head = 0;
+    rec_tail = 0;
+    memset(&rec_stats, 0, sizeof(Rec_Stats_t));
+    __set_PRIMASK(primask);
+}
+
+void Recorder_GetStats(Rec_Stats_t *stats)
+{
+    if (stats == NULL) return;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = rec_stats;
+    stats->bytes_used = rec_head - rec_tail;
+    __set_PRIMASK(primask);
+}
+
+uint16_t Recorder_ReadRecords(uint32_t *cursor, uint8_t *buf, uint16_t max)
+{
+    uint16_t copied = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // Cursors are record boundaries between tail and head; anything else
+    // was evicted (or the ring was cleared) since the last call
+    uint32_t offset = *cursor;
+    if (offset == REC_CURSOR_OLDEST || (int32_t)(offset - rec_tail) < 0 || (int32_t)(rec_head - offset) < 0)
+    {
+        offset = rec_tail;
+    }
+
+    while (offset != rec_head)
+    {
+        Rec_Header_t hdr;
+        Rec_CopyOut(offset, &hdr, sizeof(Rec_Header_t));
+        uint32_t size = sizeof(Rec_Header_t) + hdr.len;
+        if (copied + size > max) break;
+
+        Rec_CopyOut(offset, &buf[copied], size);
+        copied += (uint16_t)size;
+        offset += size;
+    }
+
+    *cursor = offset;
+    __set_PRIMASK(primask);
+    return copied;
+}
+
+void Recorder_DumpCandump(void)
+{
+    rec_paused = true; // Writers only touch the ring while not paused
+
+    uint32_t offset = rec_tail;
+    while (offset != rec_head)
+    {
+        Rec_Header_t hdr;
+        Rec_CopyOut(offset, &hdr, sizeof(Rec_Header_t));
+        uint32_t data = offset + sizeof(Rec_Header_t);
+        offset = data + hdr.len;
+
+        if (hdr.src > REC_SRC_CAN2) continue;
+
+        // (sec.usec) canN ID#DATA, FD: ID##<flags>DATA (flags bit 0 = BRS)
+        // Direction is not part of the format; rec_jsonl has it
+        printf("(");
+        Rec_PrintMicros(hdr.timestamp_us, true);
+        printf(") %s ", rec_src_names[hdr.src]);
+        if (hdr.flags & REC_FLAG_EXT) printf("%08lX", hdr.id);
+        else printf("%03lX", hdr.id);
+
+        if (hdr.flags & REC_FLAG_FD) printf("##%X", (hdr.flags & REC_FLAG_BRS) ? 1U : 0U);
+        else printf("#");
+
+        Rec_PrintHex(data, hdr.len);
+        printf("\r\n");
+    }
+
+    rec_paused = false;
+}
+
+void Recorder_DumpJsonl(void)
+{
+    rec_paused = true;
+
+    uint32_t offset = rec_tail;
+    while (offset != rec_head)
+    {
+        Rec_Header_t hdr;
+        Rec_CopyOut(offset, &hdr, sizeof(Rec_Header_t));
+        uint32_t data = offset + sizeof(Rec_Header_t);
+        offset = data + hdr.len;
+
+        if (hdr.src >= REC_SRC_COUNT) continue;
+
+        printf("{\"t_us\":");
+        Rec_PrintMicros(hdr.timestamp_us, false);
+        printf(",\"src\":\"%s\",\"dir\":\"%s\"", rec_src_names[hdr.src],
+               (hdr.flags & REC_FLAG_TX) ? "tx" : "rx");
+
+        if (hdr.src <= REC_SRC_CAN2)
+        {
+            printf(",\"id\":%lu,\"ext\":%d,\"fd\":%d,\"brs\":%d", hdr.id,
+                   (hdr.flags & REC_FLAG_EXT) ? 1 : 0, (hdr.flags & REC_FLAG_FD) ? 1 : 0,
+                   (hdr.flags & REC_FLAG_BRS) ? 1 : 0);
+        }
+        if (hdr.flags & REC_FLAG_TRUNC) printf(",\"trunc\":1");
+
+        printf(",\"len\":%u,\"data\":\"", hdr.len);
+        Rec_PrintHex(data, hdr.len);
+        printf("\"}\r\n");
+    }
+
+    rec_paused = false;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file    timebase.c
+ * @brief   64-bit Microsecond Timebase Implementation
+ *
+ * @details
+ * Upper bits are a software wrap counter incremented by the TIM3 update
+ * interrupt. A reader that runs with the wrap pending (update flag set but
+ * ISR not yet executed, e.g. from a same-priority FDCAN ISR) accounts for
+ * it by checking UIF and re-reading the counter.
+ */
+
+#include "timebase.h"
+
+static TIM_HandleTypeDef *tb_htim = NULL;
+static volatile uint64_t tb_wrap_us = 0; // Accumulated wraps (65536 us each)
+
+void Timebase_Init(TIM_HandleTypeDef *htim)
+{
+    tb_htim = htim;
+    tb_wrap_us = 0;
+
+    __HAL_TIM_SET_COUNTER(htim, 0);
+    __HAL_TIM_CLEAR_FLAG(htim, TIM_FLAG_UPDATE);
+    HAL_TIM_Base_Start_IT(htim);
+}
+
+uint64_t Timebase_GetMicros(void)
+{
+    if (tb_htim == NULL) return (uint64_t)HAL_GetTick() * TIMEBASE_US_PER_MS;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint64_t wrap = tb_wrap_us;
+    uint32_t cnt = __HAL_TIM_GET_COUNTER(tb_htim);
+    if (__HAL_TIM_GET_FLAG(tb_htim, TIM_FLAG_UPDATE) != RESET)
+    {
+        // Wrap happened but ISR has not run yet
+        cnt = __HAL_TIM_GET_COUNTER(tb_htim);
+        wrap += 65536U;
+    }
+
+    __set_PRIMASK(primask);
+    return wrap + cnt;
+}
+
+uint64_t Timebase_Extend16(uint16_t capture)
+{
+    uint64_t now = Timebase_GetMicros();
+    uint16_t age = (uint16_t)((uint16_t)now - capture);
+    return now - age;
+}
+
+uint64_t Timebase_GetAge(const volatile uint64_t *stamp_us)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t stamp = *stamp_us;
+    __set_PRIMASK(primask);
+
+    return Timebase_GetMicros() - stamp;
+}
+
+void Timebase_OverflowCallback(void)
+{
+    tb_wrap_us += 65536U;
+}
@@ -9,6 +9,11 @@
 #define MODULES_CP_CONTROL_PILOT_H_
 
 #include "main.h"
+#include "evse_connector.h"
+
+// Connector n: TIM1 channel n+1 (CH1 PC0, CH2 PC1, CH3 PC2, CH4 PC3),
+// CP sense on PA0 ADC1_IN1, PA1 ADC1_IN2, PB15 ADC2_IN15, PA9 ADC5_IN2
+// (pin map in main.h)
 
 // CP State Definitions (IEC 61851)
 typedef enum
@@ -23,24 +28,26 @@ typedef enum
 
 /**
  * @brief Initialize Control Pilot Drivers (PWM & ADC)
- *        Configures TIM1 for 1kHz output.
+ *        Configures TIM1 for 1kHz output, one channel per connector.
  */
 void CP_Init(void);
 
 /**
  * @brief Set Control Pilot PWM Duty Cycle
+ * @param conn Connector index
  * @param duty_percent Duty Cycle (0.0 to 100.0)
  *                     - 100.0: DC +12V
  *                     - 0.0:   DC -12V (or 0V/Error)
  *                     - 5.0 - 96.0: Active PWM
  */
-void CP_SetPWM(float duty_percent);
+void CP_SetPWM(uint8_t conn, float duty_percent);
 
 /**
- * @brief Read Control Pilot Voltage
+ * @brief Read Control Pilot Voltage (control task)
+ * @param conn Connector index
  * @return float Voltage in Volts (0.0 - 12.0+)
  */
-float CP_ReadVoltage(void);
+float CP_ReadVoltage(uint8_t conn);
 
 /**
  * @brief Determine IEC 61851 State from Voltage
@@ -28,6 +28,133 @@
 // If 12V = 3V at pin -> Scale = 4
 #define CP_HARDWARE_SCALE   4.0f 
 
+#define CP_ADC_TIMEOUT_MS   1 // One conversion (2.5 + 12.5 ADC clocks) takes well under 1 us
+
+// Connector n: TIM1 channel n+1 on PC0..PC3 (AF2). CP sense (main.h): ADC1 IN1
+// (PA0) and IN2 (PA1), then the only free analog pins, PB15 on ADC2 IN15 and
+// PA9 on ADC5 IN2 (ADC1 IN3/IN4 are the CLI's USART2 pins).
+typedef struct
+{
+    ADC_HandleTypeDef *hadc;
+    uint32_t      channel;
+    GPIO_TypeDef *port;      // Further connectors: set up by CP_Init
+    uint16_t      pin;
+} CP_Sense_t;
+
+static const uint32_t cp_tim_channel[EVSE_CONNECTOR_MAX] = {
+    TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4,
+};
+
+#if EVSE_CONNECTOR_COUNT > 2
+static ADC_HandleTypeDef cp_hadc2;
+static ADC_HandleTypeDef cp_hadc5;
+#define CP_HADC2 (&cp_hadc2)
+#define CP_HADC5 (&cp_hadc5)
+#else
+#define CP_HADC2 NULL
+#define CP_HADC5 NULL
+#endif
+
+static const CP_Sense_t cp_sense[EVSE_CONNECTOR_MAX] = {
+    { &hadc1,   ADC_CHANNEL_1,  GPIOA,               GPIO_PIN_0    },
+    { &hadc1,   ADC_CHANNEL_2,  CP2_Sense_GPIO_Port, CP2_Sense_Pin },
+    { CP_HADC2, ADC_CHANNEL_15, CP3_Sense_GPIO_Port, CP3_Sense_Pin },
+    { CP_HADC5, ADC_CHANNEL_2,  CP4_Sense_GPIO_Port, CP4_Sense_Pin },
+};
+
+#if EVSE_CONNECTOR_COUNT > 1
+static GPIO_TypeDef *const cp_pwm_port[EVSE_CONNECTOR_MAX] = {
+    GPIOC, CP2_PWM_GPIO_Port, CP3_PWM_GPIO_Port, CP4_PWM_GPIO_Port,
+};
+static const uint16_t cp_pwm_pin[EVSE_CONNECTOR_MAX] = {
+    GPIO_PIN_0, CP2_PWM_Pin, CP3_PWM_Pin, CP4_PWM_Pin,
+};
+
+static void CP_ConfigChannel(ADC_HandleTypeDef *hadc, uint32_t channel)
+{
+    ADC_ChannelConfTypeDef cfg = {0};
+    cfg.Channel = channel;
+    cfg.Rank = ADC_REGULAR_RANK_1;
+    cfg.SamplingTime = ADC_SAMPLETIME_2CYCLES_5; // As CubeMX configures IN1
+    cfg.SingleDiff = ADC_SINGLE_ENDED;
+    cfg.OffsetNumber = ADC_OFFSET_NONE;
+    HAL_ADC_ConfigChannel(hadc, &cfg);
+}
+
+#if EVSE_CONNECTOR_COUNT > 2
+// ADC2 / ADC5 are not in the CubeMX configuration: same setup as ADC1
+static void CP_InitAdc(ADC_HandleTypeDef *hadc, ADC_TypeDef *instance, uint32_t channel)
+{
+    hadc->Instance = instance;
+    hadc->Init = hadc1.Init;
+    if (HAL_ADC_Init(hadc) != HAL_OK)
+    {
+        printf("[CP] ADC Init Error\r\n");
+        return;
+    }
+    CP_ConfigChannel(hadc, channel);
+    HAL_ADCEx_Calibration_Start(hadc, ADC_SINGLE_ENDED);
+}
+#endif
+
+// Channels past the first are not in the CubeMX configuration
+static void CP_InitExtraChannels(void)
+{
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Mode = GPIO_MODE_AF_PP;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_LOW;
+    gpio.Alternate = GPIO_AF2_TIM1;
+
+    TIM_OC_InitTypeDef oc = {0};
+    oc.OCMode = TIM_OCMODE_PWM1;
+    oc.Pulse = 1000; // 100 %
+    oc.OCPolarity = TIM_OCPOLARITY_HIGH;
+    oc.OCFastMode = TIM_OCFAST_DISABLE;
+
+    for (uint8_t c = 1; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        gpio.Pin = cp_pwm_pin[c];
+        HAL_GPIO_Init(cp_pwm_port[c], &gpio);
+        HAL_TIM_PWM_ConfigChannel(&htim1, &oc, cp_tim_channel[c]);
+    }
+
+    // Sense inputs (ADC1 / ADC2 kernel clock is enabled by CubeMX's ADC1)
+    GPIO_InitTypeDef analog = {0};
+    analog.Mode = GPIO_MODE_ANALOG;
+    analog.Pull = GPIO_NOPULL;
+    for (uint8_t c = 1; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        analog.Pin = cp_sense[c].pin;
+        HAL_GPIO_Init(cp_sense[c].port, &analog);
+    }
+
+#if EVSE_CONNECTOR_COUNT > 2
+    CP_InitAdc(&cp_hadc2, ADC2, cp_sense[2].channel);
+#endif
+#if EVSE_CONNECTOR_COUNT > 3
+    RCC_PeriphCLKInitTypeDef clk = {0};
+    clk.PeriphClockSelection = RCC_PERIPHCLK_ADC345;
+    clk.Adc345ClockSelection = RCC_ADC345CLKSOURCE_SYSCLK;
+    HAL_RCCEx_PeriphCLKConfig(&clk);
+    __HAL_RCC_ADC345_CLK_ENABLE();
+    CP_InitAdc(&cp_hadc5, ADC5, cp_sense[3].channel);
+#endif
+}
+
+// ADC1 serves connectors 1 and 2 and is switched between them, the others
+// have an ADC each
+static void CP_SelectChannel(uint8_t conn)
+{
+    static int8_t selected = 0; // CubeMX: IN1
+    if (cp_sense[conn].hadc != &hadc1 || selected == (int8_t)conn) return;
+
+    HAL_ADC_Stop(&hadc1);
+    CP_ConfigChannel(&hadc1, cp_sense[conn].channel);
+    selected = (int8_t)conn;
+}
+#endif
+
 void CP_Init(void)
 {
     // 1. Reconfigure TIM1 for 1kHz PWM
@@ -37,7 +164,7 @@ void CP_Init(void)
     // Period: 999 -> 1000 ticks = 1ms = 1kHz
     
     // Stop timer first
-    HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_1);
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++) HAL_TIM_PWM_Stop(&htim1, cp_tim_channel[c]);
     
     htim1.Init.Prescaler = 169; 
     htim1.Init.Period = 999;
@@ -47,21 +174,27 @@ void CP_Init(void)
         printf("[CP] PWM Constants Init Error\r\n");
     }
     
-    // Start with 100% Duty (State A/B DC)
-    CP_SetPWM(100.0f);
-    
-    // Start PWM
-    HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_1);
+#if EVSE_CONNECTOR_COUNT > 1
+    CP_InitExtraChannels();
+#endif
+
+    // Start with 100% Duty (State A/B DC), then the PWM
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        CP_SetPWM(c, 100.0f);
+        HAL_TIM_PWM_Start(&htim1, cp_tim_channel[c]);
+    }
     
-    // 2. Start ADC Calibration & Enable
+    // 2. ADC Calibration (conversions are started by CP_ReadVoltage)
     HAL_ADCEx_Calibration_Start(&hadc1, ADC_SINGLE_ENDED);
-    HAL_ADC_Start(&hadc1);
     
-    printf("[CP] Driver Initialized (1kHz PWM, ADC Running)\r\n");
+    printf("[CP] Driver Initialized (1kHz PWM, ADC Calibrated, %d Connector(s))\r\n", EVSE_CONNECTOR_COUNT);
 }
 
-void CP_SetPWM(float duty_percent)
+void CP_SetPWM(uint8_t conn, float duty_percent)
 {
+    if (conn >= EVSE_CONNECTOR_COUNT) return;
+
     // Limit capability
     if (duty_percent < 0.0f) duty_percent = 0.0f;
     if (duty_percent > 100.0f) duty_percent = 100.0f;
@@ -69,13 +202,26 @@ void CP_SetPWM(float duty_percent)
     // Period is 999 (0-999 is 1000 steps)
     uint32_t pulse = (uint32_t)((duty_percent / 100.0f) * 1000.0f);
     
-    __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, pulse);
+    __HAL_TIM_SET_COMPARE(&htim1, cp_tim_channel[conn], pulse);
 }
 
-float CP_ReadVoltage(void)
+float CP_ReadVoltage(uint8_t conn)
 {
-    HAL_ADC_PollForConversion(&hadc1, 10);
-    uint32_t adc_val = HAL_ADC_GetValue(&hadc1);
+    if (conn >= EVSE_CONNECTOR_COUNT) return 0.0f;
+#if EVSE_CONNECTOR_COUNT > 1
+    CP_SelectChannel(conn);
+#endif
+    // Single conversion mode (CubeMX ADC1, copied for ADC2 / ADC5): one
+    // conversion per read, so the value is current and the poll never waits
+    // for a conversion nobody started
+    ADC_HandleTypeDef *hadc = cp_sense[conn].hadc;
+    HAL_ADC_Start(hadc);
+    if (HAL_ADC_PollForConversion(hadc, CP_ADC_TIMEOUT_MS) != HAL_OK)
+    {
+        HAL_ADC_Stop(hadc);
+        return 0.0f; // State E/F: the charger stops rather than guessing
+    }
+    uint32_t adc_val = HAL_ADC_GetValue(hadc);
     
     // Convert to Voltage
     float pin_voltage = (adc_val / ADC_MAX_COUNT) * ADC_VREF;
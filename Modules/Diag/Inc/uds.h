@@ -0,0 +1,114 @@
+/**
+ * @file    uds.h
+ * @brief   UDS (ISO 14229) Diagnostic Server on the SECC Bus
+ *
+ * @note    Transport is ISO-TP on FDCAN1: physical requests on 0x7E0,
+ *          functional requests on 0x7DF (single frame only), responses on
+ *          0x7E8. Runs entirely in the CAN task.
+ *
+ * @note    Services:
+ *          - 0x10 DiagnosticSessionControl (default / programming / extended)
+ *          - 0x3E TesterPresent
+ *          - 0x22 ReadDataByIdentifier (several DIDs per request)
+ *          - 0x2E WriteDataByIdentifier (non-default session)
+ *          - 0x34/0x36/0x37 RequestDownload / TransferData / TransferExit
+ *            (programming session)
+ *          A non-default session falls back to default after UDS_S3_MS
+ *          without a request; an unfinished download is dropped then.
+ *
+ * @note    Download targets (addressAndLengthFormatIdentifier 0x44):
+ *          - UDS_DL_CONFIG_ADDR: a SystemConfig_t image, checked (size,
+ *            magic, CRC-32) and applied with Config_Save() at TransferExit.
+ *          - UDS_DL_STAGING_ADDR: firmware image into flash bank 2. Only
+ *            accepted in dual-bank mode with the running image in bank 1.
+ *            The image is staged, read back against the CRC32 of the
+ *            received bytes and that CRC32 returned; installing it is left
+ *            to the bootloader.
+ *          Flash pages are erased as the transfer enters them, the CAN task
+ *          is blocked for the erase (~22 ms per page, bank 1 keeps running).
+ *
+ * @note    Flash is only written while no connector is in a session
+ *          (StateMachine_IsSessionActive()): the programming session,
+ *          RequestDownload, flash TransferData, TransferExit and the config
+ *          DID write are answered with NRC 0x22 (conditionsNotCorrect)
+ *          during one, so erases never stall the CAN task while charging.
+ */
+
+#ifndef MODULES_DIAG_UDS_H_
+#define MODULES_DIAG_UDS_H_
+
+#include "isotp.h"
+
+// --- Configuration ---
+#define UDS_CAN_ID_PHYS       0x7E0U
+#define UDS_CAN_ID_FUNC       0x7DFU
+#define UDS_CAN_ID_RESP       0x7E8U
+
+#define UDS_P2_MS             50     // Reported in the session response
+#define UDS_P2_EXT_MS         5000
+#define UDS_S3_MS             5000   // Session timeout without requests
+
+#define UDS_RESP_SIZE         1536   // Response buffer (log chunk DID uses the rest)
+#define UDS_MAX_BLOCK_LEN     (2U + FLASH_PAGE_SIZE) // TransferData request, SID + counter + one page
+
+#define UDS_DL_CONFIG_ADDR    0x0807F800U // Config page (bank 2, last page)
+#define UDS_DL_STAGING_ADDR   0x08040000U // Bank 2 start (dual-bank mode)
+#define UDS_DL_STAGING_SIZE   (UDS_DL_CONFIG_ADDR - UDS_DL_STAGING_ADDR)
+
+// Sessions
+#define UDS_SESSION_DEFAULT      0x01U
+#define UDS_SESSION_PROGRAMMING  0x02U
+#define UDS_SESSION_EXTENDED     0x03U
+
+// Data Identifiers (big-endian values)
+#define UDS_DID_SESSION       0xF186U // u8 active session
+// Connector DIDs repeat their record per connector (EVSE_CONNECTOR_COUNT, connector 1 first)
+#define UDS_DID_STATE         0x0100U // u8 EVSE_State_t (per connector)
+#define UDS_DID_METER         0x0102U // u16 V x10, u16 A x100, u32 W, u32 Wh, s16 degC x10 thermal (per connector)
+#define UDS_DID_POWER         0x0103U // u16 V x10, u16 A x10, u8 modules, u8 fault
+#define UDS_DID_IMD           0x0104U // u32 R_iso kOhm, u8 valid | warning << 1 | fault << 2
+#define UDS_DID_RELAY         0x0105U // u8 relay state (per connector)
+#define UDS_DID_POWER_SHARE   0x0106U // u8 active | converged << 1, u8 modules, u16 mean A x10, u16 max dev A x10, u16 imbalance % x10, u8 worst module (0xFF none), u32 failovers (per connector)
+#define UDS_DID_POWER_FAST    0x0107U // u32 triggers, u32 sent, u32 wire last us, u32 wire max us, u32 queue max us, u32 over budget
+#define UDS_DID_CAN_HEALTH    0x0110U // Per bus: u8 state, u8 TEC, u8 REC, u16 bus-off, u16 load permille
+#define UDS_DID_REC_STATS     0x0200U // u32 records, written, evicted, missed, bytes used
+#define UDS_DID_REC_LOG       0x0201U // Raw records (recorder.h) from the read cursor, empty = caught up
+                                      // Write (any data): rewind the cursor to the oldest record
+#define UDS_DID_CONFIG        0x0300U // u16 max current A x10, u8 IP[4], u16 port, char id[32]
+
+typedef struct
+{
+    uint8_t  session;
+    bool     dl_active;          // Download in progress
+    uint32_t dl_addr;
+    uint32_t dl_size;
+    uint32_t dl_received;
+    uint32_t requests;           // Requests dispatched
+    uint32_t negative;           // Negative responses (incl. suppressed)
+    uint32_t busy_drops;         // Response dropped, previous one still sending
+    ISOTP_Stats_t isotp;
+} UDS_Status_t;
+
+/**
+ * @brief Initialize the server and register its CAN routes
+ * @param hfdcan SECC bus (FDCAN1)
+ */
+void UDS_Init(FDCAN_HandleTypeDef *hfdcan);
+
+/**
+ * @brief Transport pacing and session timeout (CAN task)
+ * @note  Call every CAN task iteration, every 1 ms while UDS_IsBusy().
+ */
+void UDS_Process(void);
+
+/**
+ * @brief Check if a multi-frame transfer is in progress
+ */
+bool UDS_IsBusy(void);
+
+/**
+ * @brief Get server status snapshot
+ */
+void UDS_GetStatus(UDS_Status_t *status);
+
+#endif /* MODULES_DIAG_UDS_H_ */
@@ -0,0 +1,749 @@
+/**
+ * @file    uds.c
+ * @brief   UDS Diagnostic Server Implementation
+ *
+ * @details
+ * Requests come in complete from the ISO-TP link (physical) or directly as
+ * single frames (functional), are dispatched by SID and answered through
+ * the link. Negative responses to functional requests for unsupported
+ * services / DIDs are suppressed as ISO 14229 requires.
+ *
+ * Download data is programmed in doublewords: bytes are collected into an
+ * 8-byte word and programmed when it is full, so blocks need no alignment.
+ * The CRC32 (IEEE, as zlib) of all received bytes is returned at exit; a
+ * staged image is read back from flash and must have the same CRC.
+ */
+
+#include "uds.h"
+#include "app_state.h"
+#include "can_health.h"
+#include "config_manager.h"
+#include "crc_service.h"
+#include "imd_driver.h"
+#include "infy_power.h"
+#include "meter_driver.h"
+#include "recorder.h"
+#include "relay_driver.h"
+#include "thermal_derate.h"
+#include <stdio.h>
+#include <string.h>
+
+// Service IDs
+#define UDS_SID_SESSION_CONTROL   0x10U
+#define UDS_SID_READ_DID          0x22U
+#define UDS_SID_WRITE_DID         0x2EU
+#define UDS_SID_REQUEST_DOWNLOAD  0x34U
+#define UDS_SID_TRANSFER_DATA     0x36U
+#define UDS_SID_TRANSFER_EXIT     0x37U
+#define UDS_SID_TESTER_PRESENT    0x3EU
+#define UDS_SID_NEGATIVE          0x7FU
+#define UDS_POSITIVE              0x40U
+
+#define UDS_SUPPRESS_POS          0x80U // Sub-function bit
+
+// Negative Response Codes
+#define UDS_NRC_SERVICE_NOT_SUPPORTED    0x11U
+#define UDS_NRC_SUBFUNC_NOT_SUPPORTED    0x12U
+#define UDS_NRC_INCORRECT_LENGTH         0x13U
+#define UDS_NRC_RESPONSE_TOO_LONG        0x14U
+#define UDS_NRC_CONDITIONS_NOT_CORRECT   0x22U
+#define UDS_NRC_SEQUENCE_ERROR           0x24U
+#define UDS_NRC_OUT_OF_RANGE             0x31U
+#define UDS_NRC_DOWNLOAD_NOT_ACCEPTED    0x70U
+#define UDS_NRC_TRANSFER_SUSPENDED       0x71U
+#define UDS_NRC_PROGRAMMING_FAILURE      0x72U
+#define UDS_NRC_WRONG_BLOCK_COUNTER      0x73U
+#define UDS_NRC_NOT_IN_SESSION           0x7FU
+
+#define UDS_DL_FORMAT_PLAIN       0x00U // No compression / encryption
+#define UDS_DL_ALFID              0x44U // 4-byte size, 4-byte address
+
+#define UDS_DID_MAX_LEN           56U   // Largest fixed-size DID record (meter x EVSE_CONNECTOR_MAX)
+
+// Linker symbols of the running image (flash end = .data load image end)
+extern uint32_t _sidata, _sdata, _edata;
+
+static FDCAN_HandleTypeDef *uds_hfdcan = NULL;
+static ISOTP_Link_t uds_link;
+static uint8_t uds_resp[UDS_RESP_SIZE];
+
+static uint8_t  uds_session = UDS_SESSION_DEFAULT;
+static uint32_t uds_last_request = 0;
+static bool     uds_functional = false;
+static uint32_t uds_log_cursor = REC_CURSOR_OLDEST;
+
+static uint32_t uds_requests = 0;
+static uint32_t uds_negative = 0;
+static uint32_t uds_busy_drops = 0;
+
+// Download State
+static bool     dl_active = false;
+static bool     dl_flash = false;   // Staging (flash) or config (RAM)
+static uint32_t dl_addr = 0;
+static uint32_t dl_size = 0;
+static uint32_t dl_received = 0;
+static uint8_t  dl_counter = 1;     // Next expected blockSequenceCounter
+static uint32_t dl_crc = 0;
+static uint8_t  dl_word[8];         // Doubleword being assembled (flash)
+static SystemConfig_t dl_config;    // Config image (RAM)
+
+static void UDS_OnRequest(const uint8_t *data, uint16_t len, bool fd);
+
+// --- Helpers ---
+
+static void UDS_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void UDS_Put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint32_t UDS_Get32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void UDS_Respond(uint16_t len)
+{
+    if (!ISOTP_Send(&uds_link, uds_resp, len)) uds_busy_drops++;
+}
+
+static void UDS_Negative(uint8_t sid, uint8_t nrc)
+{
+    uds_negative++;
+
+    // Functional requests: no NRC for what this server simply does not support
+    if (uds_functional && (nrc == UDS_NRC_SERVICE_NOT_SUPPORTED || nrc == UDS_NRC_SUBFUNC_NOT_SUPPORTED ||
+                           nrc == UDS_NRC_OUT_OF_RANGE || nrc == UDS_NRC_NOT_IN_SESSION))
+    {
+        return;
+    }
+
+    uds_resp[0] = UDS_SID_NEGATIVE;
+    uds_resp[1] = sid;
+    uds_resp[2] = nrc;
+    UDS_Respond(3);
+}
+
+// --- Download ---
+
+// Erasing / programming flash blocks the CAN task (~22 ms per page), which
+// also decodes the SECC and module frames: not while a connector charges
+static bool UDS_FlashAllowed(void)
+{
+    return !StateMachine_IsSessionActive();
+}
+
+static void UDS_DownloadAbort(void)
+{
+    if (dl_active && dl_flash) HAL_FLASH_Lock();
+    dl_active = false;
+}
+
+// Program one doubleword, erasing its page first when the word opens it
+static bool UDS_FlashWord(uint32_t addr)
+{
+    if ((addr % FLASH_PAGE_SIZE) == 0)
+    {
+        FLASH_EraseInitTypeDef erase = {0};
+        uint32_t page_error = 0;
+        erase.TypeErase = FLASH_TYPEERASE_PAGES;
+        erase.Banks = FLASH_BANK_2;
+        erase.Page = (addr - UDS_DL_STAGING_ADDR) / FLASH_PAGE_SIZE;
+        erase.NbPages = 1;
+        if (HAL_FLASHEx_Erase(&erase, &page_error) != HAL_OK) return false;
+    }
+
+    uint64_t word;
+    memcpy(&word, dl_word, sizeof(word));
+    return HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, addr, word) == HAL_OK;
+}
+
+static bool UDS_DownloadWrite(const uint8_t *data, uint16_t len)
+{
+    if (!dl_flash)
+    {
+        memcpy((uint8_t *)&dl_config + dl_received, data, len);
+        dl_received += len;
+        return true;
+    }
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        uint32_t pos = dl_received + i;
+        dl_word[pos % 8U] = data[i];
+        if ((pos % 8U) == 7U && !UDS_FlashWord(dl_addr + pos - 7U))
+        {
+            dl_received = pos - 7U;
+            return false;
+        }
+    }
+    dl_received += len;
+    return true;
+}
+
+static void UDS_RequestDownload(const uint8_t *req, uint16_t len)
+{
+    if (uds_session != UDS_SESSION_PROGRAMMING)
+    {
+        UDS_Negative(req[0], UDS_NRC_NOT_IN_SESSION);
+        return;
+    }
+    if (len != 11)
+    {
+        UDS_Negative(req[0], UDS_NRC_INCORRECT_LENGTH);
+        return;
+    }
+    if (req[1] != UDS_DL_FORMAT_PLAIN || req[2] != UDS_DL_ALFID)
+    {
+        UDS_Negative(req[0], UDS_NRC_OUT_OF_RANGE);
+        return;
+    }
+    if (dl_active || !UDS_FlashAllowed())
+    {
+        UDS_Negative(req[0], UDS_NRC_CONDITIONS_NOT_CORRECT);
+        return;
+    }
+
+    uint32_t addr = UDS_Get32(&req[3]);
+    uint32_t size = UDS_Get32(&req[7]);
+
+    if (addr == UDS_DL_CONFIG_ADDR && size == sizeof(SystemConfig_t))
+    {
+        dl_flash = false;
+    }
+    else if (addr == UDS_DL_STAGING_ADDR && size > 0 && size <= UDS_DL_STAGING_SIZE)
+    {
+        // Bank 2 must be a separate bank that does not hold the running image
+        uint32_t image_end = (uint32_t)&_sidata + ((uint32_t)&_edata - (uint32_t)&_sdata);
+        if (READ_BIT(FLASH->OPTR, FLASH_OPTR_DBANK) == 0 || image_end > UDS_DL_STAGING_ADDR)
+        {
+            UDS_Negative(req[0], UDS_NRC_DOWNLOAD_NOT_ACCEPTED);
+            return;
+        }
+        HAL_FLASH_Unlock();
+        __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+        dl_flash = true;
+    }
+    else
+    {
+        UDS_Negative(req[0], UDS_NRC_OUT_OF_RANGE);
+        return;
+    }
+
+    dl_active = true;
+    dl_addr = addr;
+    dl_size = size;
+    dl_received = 0;
+    dl_counter = 1;
+    dl_crc = 0;
+    memset(dl_word, 0xFF, sizeof(dl_word));
+    printf("[UDS] Download 0x%08lX, %lu bytes\r\n", addr, size);
+
+    uds_resp[0] = req[0] + UDS_POSITIVE;
+    uds_resp[1] = 0x20; // 2-byte maxNumberOfBlockLength
+    UDS_Put16(&uds_resp[2], UDS_MAX_BLOCK_LEN);
+    UDS_Respond(4);
+}
+
+static void UDS_TransferData(const uint8_t *req, uint16_t len)
+{
+    if (len < 2 || len > UDS_MAX_BLOCK_LEN)
+    {
+        UDS_Negative(req[0], UDS_NRC_INCORRECT_LENGTH);
+        return;
+    }
+    if (!dl_active)
+    {
+        UDS_Negative(req[0], UDS_NRC_SEQUENCE_ERROR);
+        return;
+    }
+
+    uint8_t bsc = req[1];
+    if (bsc == (uint8_t)(dl_counter - 1U) && dl_received > 0)
+    {
+        // Repeated block (our response was lost): acknowledge, do not write
+    }
+    else if (bsc != dl_counter)
+    {
+        UDS_Negative(req[0], UDS_NRC_WRONG_BLOCK_COUNTER);
+        return;
+    }
+    else
+    {
+        uint16_t n = len - 2U;
+        if (n == 0 || n > dl_size - dl_received)
+        {
+            UDS_Negative(req[0], UDS_NRC_TRANSFER_SUSPENDED);
+            return;
+        }
+        if (dl_flash && !UDS_FlashAllowed())
+        {
+            // A session started meanwhile: the tester may repeat the block later
+            UDS_Negative(req[0], UDS_NRC_CONDITIONS_NOT_CORRECT);
+            return;
+        }
+        if (!UDS_DownloadWrite(&req[2], n))
+        {
+            printf("[UDS] Programming Failed at 0x%08lX\r\n", dl_addr + dl_received);
+            UDS_DownloadAbort();
+            UDS_Negative(req[0], UDS_NRC_PROGRAMMING_FAILURE);
+            return;
+        }
+        dl_crc = Crc_Update(CRC_ALGO_CRC32, dl_crc, &req[2], n);
+        dl_counter++; // Wraps 0xFF -> 0x00
+    }
+
+    uds_resp[0] = req[0] + UDS_POSITIVE;
+    uds_resp[1] = bsc;
+    UDS_Respond(2);
+}
+
+static void UDS_TransferExit(const uint8_t *req, uint16_t len)
+{
+    if (len != 1)
+    {
+        UDS_Negative(req[0], UDS_NRC_INCORRECT_LENGTH);
+        return;
+    }
+    if (!dl_active || dl_received != dl_size)
+    {
+        UDS_Negative(req[0], UDS_NRC_SEQUENCE_ERROR);
+        return;
+    }
+    if (!UDS_FlashAllowed())
+    {
+        UDS_Negative(req[0], UDS_NRC_CONDITIONS_NOT_CORRECT);
+        return;
+    }
+
+    bool ok = true;
+    if (dl_flash)
+    {
+        // Last partial doubleword, erased-flash padding
+        if ((dl_size % 8U) != 0)
+        {
+            memset(&dl_word[dl_size % 8U], 0xFF, 8U - (dl_size % 8U));
+            ok = UDS_FlashWord(dl_addr + dl_size - (dl_size % 8U));
+        }
+        // Verify the staged image: read back from flash, same CRC as received
+        if (ok && Crc_Compute(CRC_ALGO_CRC32, (const void *)dl_addr, dl_size) != dl_crc)
+        {
+            printf("[UDS] Staged Image CRC Mismatch\r\n");
+            ok = false;
+        }
+    }
+    else if (!Config_IsValid(&dl_config))
+    {
+        ok = false;
+    }
+    else
+    {
+        *Config_Get() = dl_config;
+        Config_Save();
+    }
+
+    UDS_DownloadAbort();
+    if (!ok)
+    {
+        UDS_Negative(req[0], UDS_NRC_PROGRAMMING_FAILURE);
+        return;
+    }
+    printf("[UDS] Download Complete, CRC32 0x%08lX\r\n", dl_crc);
+
+    uds_resp[0] = req[0] + UDS_POSITIVE;
+    UDS_Put32(&uds_resp[1], dl_crc);
+    UDS_Respond(5);
+}
+
+// --- Data Identifiers ---
+
+// Append one DID record at pos; returns the new length, pos = no room, 0 = unknown DID
+static uint16_t UDS_ReadDid(uint16_t did, uint16_t pos)
+{
+    uint8_t p[UDS_DID_MAX_LEN];
+    uint16_t n;
+
+    if (pos + 2U > UDS_RESP_SIZE) return pos;
+    uint16_t room = UDS_RESP_SIZE - pos - 2U;
+
+    // The log takes whatever room is left (empty when caught up)
+    if (did == UDS_DID_REC_LOG)
+    {
+        UDS_Put16(&uds_resp[pos], did);
+        return pos + 2U + Recorder_ReadRecords(&uds_log_cursor, &uds_resp[pos + 2U], room);
+    }
+
+    switch (did)
+    {
+        case UDS_DID_SESSION:
+            p[0] = uds_session;
+            n = 1;
+            break;
+
+        case UDS_DID_STATE:
+            for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++) p[c] = (uint8_t)StateMachine_GetState(c);
+            n = EVSE_CONNECTOR_COUNT;
+            break;
+
+        case UDS_DID_METER:
+            n = 0;
+            for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++, n += 14)
+            {
+                UDS_Put16(&p[n], (uint16_t)(Meter_ReadVoltage(c) * 10.0f));
+                UDS_Put16(&p[n + 2], (uint16_t)(Meter_ReadCurrent(c) * 100.0f));
+                UDS_Put32(&p[n + 4], (uint32_t)Meter_ReadPower(c));
+                UDS_Put32(&p[n + 8], (uint32_t)(Meter_ReadEnergy(c) * 1000.0f));
+                UDS_Put16(&p[n + 12], (uint16_t)(int16_t)(Thermal_GetTemperature(c) * 10.0f));
+            }
+            break;
+
+        case UDS_DID_POWER:
+        {
+            Infy_SystemStatus_t pwr;
+            Infy_GetSystemStatus(&pwr);
+            UDS_Put16(&p[0], (uint16_t)(pwr.total_voltage * 10.0f));
+            UDS_Put16(&p[2], (uint16_t)(pwr.total_current * 10.0f));
+            p[4] = (uint8_t)pwr.active_modules;
+            p[5] = pwr.system_fault ? 1 : 0;
+            n = 6;
+            break;
+        }
+
+        case UDS_DID_POWER_SHARE:
+            n = 0;
+            for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++, n += 13)
+            {
+                Infy_ShareStatus_t sh;
+                Infy_GetShareStatus(c, &sh);
+                p[n] = (sh.active ? 0x01U : 0) | (sh.converged ? 0x02U : 0);
+                p[n + 1] = (uint8_t)sh.modules;
+                UDS_Put16(&p[n + 2], (uint16_t)(sh.mean_current * 10.0f));
+                UDS_Put16(&p[n + 4], (uint16_t)(sh.max_deviation * 10.0f));
+                UDS_Put16(&p[n + 6], (uint16_t)(sh.imbalance_pct * 10.0f));
+                p[n + 8] = (sh.worst_module < 0) ? 0xFFU : (uint8_t)sh.worst_module;
+                UDS_Put32(&p[n + 9], sh.failovers);
+            }
+            break;
+
+        case UDS_DID_POWER_FAST:
+        {
+            Infy_FastStats_t fs;
+            Infy_GetFastStats(&fs);
+            UDS_Put32(&p[0], fs.triggers);
+            UDS_Put32(&p[4], fs.sent);
+            UDS_Put32(&p[8], fs.wire_last_us);
+            UDS_Put32(&p[12], fs.wire_max_us);
+            UDS_Put32(&p[16], fs.queue_max_us);
+            UDS_Put32(&p[20], fs.over_budget);
+            n = 24;
+            break;
+        }
+
+        case UDS_DID_IMD:
+        {
+            const IMD_Status_t *imd = IMD_GetStatus();
+            UDS_Put32(&p[0], (uint32_t)imd->insulation_resistance_kohm);
+            p[4] = (imd->valid ? 0x01U : 0) | (imd->warning ? 0x02U : 0) | (imd->fault ? 0x04U : 0);
+            n = 5;
+            break;
+        }
+
+        case UDS_DID_RELAY:
+            for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++) p[c] = Relay_GetState(c);
+            n = EVSE_CONNECTOR_COUNT;
+            break;
+
+        case UDS_DID_CAN_HEALTH:
+            n = 0;
+            for (int bus = 0; bus < CAN_BUS_COUNT; bus++)
+            {
+                CAN_HealthStatus_t h = {0};
+                CAN_Health_GetStatus((CAN_Bus_t)bus, &h);
+                p[n + 0] = (uint8_t)h.state;
+                p[n + 1] = h.tec;
+                p[n + 2] = h.rec;
+                UDS_Put16(&p[n + 3], (uint16_t)h.bus_off_count);
+                UDS_Put16(&p[n + 5], h.load_permille);
+                n += 7;
+            }
+            break;
+
+        case UDS_DID_REC_STATS:
+        {
+            Rec_Stats_t st;
+            Recorder_GetStats(&st);
+            UDS_Put32(&p[0], st.records);
+            UDS_Put32(&p[4], st.written);
+            UDS_Put32(&p[8], st.evicted);
+            UDS_Put32(&p[12], st.missed);
+            UDS_Put32(&p[16], st.bytes_used);
+            n = 20;
+            break;
+        }
+
+        case UDS_DID_CONFIG:
+        {
+            const SystemConfig_t *cfg = Config_Get();
+            UDS_Put16(&p[0], (uint16_t)(cfg->max_current_a * 10.0f));
+            memcpy(&p[2], cfg->server_ip, 4);
+            UDS_Put16(&p[6], cfg->server_port);
+            memset(&p[8], 0, sizeof(cfg->charge_box_id));
+            memcpy(&p[8], cfg->charge_box_id, strnlen(cfg->charge_box_id, sizeof(cfg->charge_box_id) - 1U));
+            n = 8 + sizeof(cfg->charge_box_id);
+            break;
+        }
+
+        default:
+            return 0;
+    }
+
+    if (n > room) return pos;
+    UDS_Put16(&uds_resp[pos], did);
+    memcpy(&uds_resp[pos + 2U], p, n);
+    return pos + 2U + n;
+}
+
+static void UDS_ReadDataByIdentifier(const uint8_t *req, uint16_t len)
+{
+    if (len < 3 || (len % 2U) != 1U)
+    {
+        UDS_Negative(req[0], UDS_NRC_INCORRECT_LENGTH);
+        return;
+    }
+
+    uint16_t pos = 1;
+    uds_resp[0] = req[0] + UDS_POSITIVE;
+
+    for (uint16_t i = 1; i < len; i += 2)
+    {
+        uint16_t did = (uint16_t)((req[i] << 8) | req[i + 1]);
+        uint16_t next = UDS_ReadDid(did, pos);
+        if (next == 0)
+        {
+            UDS_Negative(req[0], UDS_NRC_OUT_OF_RANGE);
+            return;
+        }
+        if (next == pos)
+        {
+            UDS_Negative(req[0], UDS_NRC_RESPONSE_TOO_LONG);
+            return;
+        }
+        pos = next;
+    }
+
+    UDS_Respond(pos);
+}
+
+static void UDS_WriteDataByIdentifier(const uint8_t *req, uint16_t len)
+{
+    if (len < 3)
+    {
+        UDS_Negative(req[0], UDS_NRC_INCORRECT_LENGTH);
+        return;
+    }
+
+    uint16_t did = (uint16_t)((req[1] << 8) | req[2]);
+    const uint8_t *d = &req[3];
+    uint16_t n = len - 3U;
+
+    if (did != UDS_DID_CONFIG && did != UDS_DID_REC_LOG)
+    {
+        UDS_Negative(req[0], UDS_NRC_OUT_OF_RANGE);
+        return;
+    }
+    if (uds_session == UDS_SESSION_DEFAULT)
+    {
+        UDS_Negative(req[0], UDS_NRC_NOT_IN_SESSION);
+        return;
+    }
+
+    if (did == UDS_DID_CONFIG && !UDS_FlashAllowed())
+    {
+        UDS_Negative(req[0], UDS_NRC_CONDITIONS_NOT_CORRECT);
+        return;
+    }
+
+    if (did == UDS_DID_REC_LOG)
+    {
+        uds_log_cursor = REC_CURSOR_OLDEST;
+    }
+    else
+    {
+        SystemConfig_t *cfg = Config_Get();
+        if (n != 8 + sizeof(cfg->charge_box_id))
+        {
+            UDS_Negative(req[0], UDS_NRC_INCORRECT_LENGTH);
+            return;
+        }
+        uint16_t current = (uint16_t)((d[0] << 8) | d[1]);
+        uint16_t port = (uint16_t)((d[6] << 8) | d[7]);
+        if (current == 0 || port == 0 || memchr(&d[8], 0, sizeof(cfg->charge_box_id)) == NULL)
+        {
+            UDS_Negative(req[0], UDS_NRC_OUT_OF_RANGE);
+            return;
+        }
+
+        cfg->max_current_a = current / 10.0f;
+        memcpy(cfg->server_ip, &d[2], 4);
+        cfg->server_port = port;
+        memcpy(cfg->charge_box_id, &d[8], sizeof(cfg->charge_box_id));
+        Config_Save();
+    }
+
+    uds_resp[0] = req[0] + UDS_POSITIVE;
+    uds_resp[1] = req[1];
+    uds_resp[2] = req[2];
+    UDS_Respond(3);
+}
+
+// --- Session ---
+
+static void UDS_SetSession(uint8_t session)
+{
+    if (session != UDS_SESSION_PROGRAMMING) UDS_DownloadAbort();
+    if (session != uds_session) printf("[UDS] Session 0x%02X\r\n", session);
+    uds_session = session;
+}
+
+static void UDS_SessionControl(const uint8_t *req, uint16_t len)
+{
+    if (len != 2)
+    {
+        UDS_Negative(req[0], UDS_NRC_INCORRECT_LENGTH);
+        return;
+    }
+
+    uint8_t session = req[1] & (uint8_t)~UDS_SUPPRESS_POS;
+    if (session != UDS_SESSION_DEFAULT && session != UDS_SESSION_PROGRAMMING && session != UDS_SESSION_EXTENDED)
+    {
+        UDS_Negative(req[0], UDS_NRC_SUBFUNC_NOT_SUPPORTED);
+        return;
+    }
+    if (session == UDS_SESSION_PROGRAMMING && !UDS_FlashAllowed())
+    {
+        UDS_Negative(req[0], UDS_NRC_CONDITIONS_NOT_CORRECT);
+        return;
+    }
+
+    UDS_SetSession(session);
+    if (req[1] & UDS_SUPPRESS_POS) return;
+
+    uds_resp[0] = req[0] + UDS_POSITIVE;
+    uds_resp[1] = session;
+    UDS_Put16(&uds_resp[2], UDS_P2_MS);
+    UDS_Put16(&uds_resp[4], UDS_P2_EXT_MS / 10U); // 10 ms resolution
+    UDS_Respond(6);
+}
+
+static void UDS_TesterPresent(const uint8_t *req, uint16_t len)
+{
+    if (len != 2)
+    {
+        UDS_Negative(req[0], UDS_NRC_INCORRECT_LENGTH);
+        return;
+    }
+    if ((req[1] & (uint8_t)~UDS_SUPPRESS_POS) != 0)
+    {
+        UDS_Negative(req[0], UDS_NRC_SUBFUNC_NOT_SUPPORTED);
+        return;
+    }
+    if (req[1] & UDS_SUPPRESS_POS) return;
+
+    uds_resp[0] = req[0] + UDS_POSITIVE;
+    uds_resp[1] = 0;
+    UDS_Respond(2);
+}
+
+// --- Dispatch ---
+
+static void UDS_OnRequest(const uint8_t *data, uint16_t len, bool fd)
+{
+    if (len == 0) return;
+
+    uds_requests++;
+    uds_last_request = HAL_GetTick();
+
+    switch (data[0])
+    {
+        case UDS_SID_SESSION_CONTROL:  UDS_SessionControl(data, len); break;
+        case UDS_SID_TESTER_PRESENT:   UDS_TesterPresent(data, len); break;
+        case UDS_SID_READ_DID:         UDS_ReadDataByIdentifier(data, len); break;
+        case UDS_SID_WRITE_DID:        UDS_WriteDataByIdentifier(data, len); break;
+        case UDS_SID_REQUEST_DOWNLOAD: UDS_RequestDownload(data, len); break;
+        case UDS_SID_TRANSFER_DATA:    UDS_TransferData(data, len); break;
+        case UDS_SID_TRANSFER_EXIT:    UDS_TransferExit(data, len); break;
+        default:                       UDS_Negative(data[0], UDS_NRC_SERVICE_NOT_SUPPORTED); break;
+    }
+}
+
+static void UDS_RxHandler(const CAN_Message_t *msg)
+{
+    if (msg->id == UDS_CAN_ID_PHYS)
+    {
+        ISOTP_OnFrame(&uds_link, msg);
+        return;
+    }
+
+    // Functional: single frame only, classic PCI (ISO 15765-2)
+    uint8_t sf_len = msg->data[0] & 0x0FU;
+    if (msg->len < 1 || (msg->data[0] & 0xF0U) != 0 || sf_len == 0 || sf_len > 7 || sf_len >= msg->len) return;
+
+    uds_functional = true;
+    UDS_OnRequest(&msg->data[1], sf_len, msg->fd);
+    uds_functional = false;
+}
+
+void UDS_Init(FDCAN_HandleTypeDef *hfdcan)
+{
+    uds_hfdcan = hfdcan;
+    ISOTP_Init(&uds_link, hfdcan, UDS_CAN_ID_RESP, UDS_OnRequest);
+
+    // 0x7DF (functional) and 0x7E0 (physical) are adjacent: one filter element
+    if (!CAN_RegisterRxRange(hfdcan, CAN_ID_STD, UDS_CAN_ID_FUNC, UDS_CAN_ID_PHYS, UDS_RxHandler))
+    {
+        printf("[UDS] CAN Route Registration Failed\r\n");
+        return;
+    }
+    printf("[UDS] Server Ready (Req 0x%03X / Resp 0x%03X)\r\n", UDS_CAN_ID_PHYS, UDS_CAN_ID_RESP);
+}
+
+void UDS_Process(void)
+{
+    if (uds_hfdcan == NULL) return;
+
+    ISOTP_Process(&uds_link);
+
+    // S3: back to default when the tester went away
+    if (uds_session != UDS_SESSION_DEFAULT && (HAL_GetTick() - uds_last_request) > UDS_S3_MS)
+    {
+        UDS_SetSession(UDS_SESSION_DEFAULT);
+    }
+}
+
+bool UDS_IsBusy(void)
+{
+    return ISOTP_IsBusy(&uds_link);
+}
+
+void UDS_GetStatus(UDS_Status_t *status)
+{
+    if (status == NULL) return;
+
+    status->session = uds_session;
+    status->dl_active = dl_active;
+    status->dl_addr = dl_addr;
+    status->dl_size = dl_size;
+    status->dl_received = dl_received;
+    status->requests = uds_requests;
+    status->negative = uds_negative;
+    status->busy_drops = uds_busy_drops;
+    status->isotp = uds_link.stats;
+}
@@ -36,6 +36,7 @@ void W5500_Init(void);
 #define SOCK_TIME_WAIT      0x1B
 #define SOCK_CLOSE_WAIT     0x1C
 #define SOCK_LAST_ACK       0x1D
+#define SOCK_UDP            0x22
 
 /**
  * @brief Open a Socket
@@ -68,6 +69,15 @@ uint8_t W5500_Connect_Poll(uint8_t sn);
  */
 uint16_t W5500_Send(uint8_t sn, uint8_t *buf, uint16_t len);
 
+/**
+ * @brief Send one UDP Datagram (Socket opened with SN_MR_UDP)
+ * @note  Waits for SEND_OK (ARP + wire, < 1 ms on a LAN once the peer's MAC
+ *        is cached; the first datagram to a new peer may take the ARP timeout).
+ * @return len if sent, 0 if the socket is not UDP, there is no room, the
+ *         previous datagram is still pending or this one was not confirmed in time
+ */
+uint16_t W5500_SendTo(uint8_t sn, const uint8_t *buf, uint16_t len, const uint8_t *addr, uint16_t port);
+
 /**
  * @brief Receive Data
  */
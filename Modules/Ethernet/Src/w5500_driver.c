@@ -44,6 +44,14 @@ extern SPI_HandleTypeDef hspi1;
 #define CR_SEND_KEEP 0x22
 #define CR_RECV      0x40
 
+// Socket Interrupts (Sn_IR, write 1 to clear)
+#define IR_TIMEOUT   0x08
+#define IR_SEND_OK   0x10
+
+#define W5500_SENDTO_TIMEOUT_MS  10 // ARP retries alone take longer: report, don't block
+
+static uint8_t w5500_send_pending = 0; // Bit per socket: UDP SEND not yet confirmed
+
 // --- Low Level SPI ---
 
 static void W5500_Select(void)
@@ -90,7 +98,7 @@ static uint8_t W5500_ReadReg(uint8_t sn, uint16_t addr)
     return data;
 }
 
-static void W5500_WriteBuf(uint8_t sn, uint16_t addr, uint8_t *buf, uint16_t len)
+static void W5500_WriteBuf(uint8_t sn, uint16_t addr, const uint8_t *buf, uint16_t len)
 {
     // Block Select: (4*sn + 2) for TX Buffer
     uint8_t bsb = (4 * sn + 2) << 3;
@@ -162,9 +170,10 @@ bool W5500_Socket(uint8_t sn, uint8_t protocol, uint16_t port)
     W5500_WriteReg(sn, Sn_PORT + 1, port & 0xFF);
     W5500_WriteReg(sn, Sn_CR, CR_OPEN);
     
-    // Wait for OPEN
+    // Wait for OPEN (UDP sockets go straight to SOCK_UDP)
+    uint8_t open_sr = (protocol == SN_MR_UDP) ? SOCK_UDP : SOCK_INIT;
     uint32_t start = HAL_GetTick();
-    while(W5500_ReadReg(sn, Sn_SR) != SOCK_INIT)
+    while(W5500_ReadReg(sn, Sn_SR) != open_sr)
     {
          if(HAL_GetTick() - start > 100) return false;
     }
@@ -238,6 +247,55 @@ uint16_t W5500_Send(uint8_t sn, uint8_t *buf, uint16_t len)
     return len;
 }
 
+uint16_t W5500_SendTo(uint8_t sn, const uint8_t *buf, uint16_t len, const uint8_t *addr, uint16_t port)
+{
+    if (sn > 7 || len == 0) return 0;
+    if (W5500_ReadReg(sn, Sn_SR) != SOCK_UDP) return 0;
+
+    // Previous datagram timed out here: wait for the chip to finish it
+    uint8_t ir;
+    if (w5500_send_pending & (1U << sn))
+    {
+        ir = W5500_ReadReg(sn, Sn_IR) & (IR_SEND_OK | IR_TIMEOUT);
+        if (ir == 0) return 0;
+        W5500_WriteReg(sn, Sn_IR, ir);
+        w5500_send_pending &= (uint8_t)~(1U << sn);
+    }
+
+    // A datagram is all or nothing
+    if (W5500_GetTxFreeSize(sn) < len) return 0;
+
+    // Set Dest IP & Port (Per datagram)
+    for(int i=0; i<4; i++) W5500_WriteReg(sn, Sn_DIPR + i, addr[i]);
+    W5500_WriteReg(sn, Sn_DPORT, (port >> 8) & 0xFF);
+    W5500_WriteReg(sn, Sn_DPORT + 1, port & 0xFF);
+
+    uint16_t ptr = W5500_ReadReg(sn, Sn_TX_WR) << 8;
+    ptr |= W5500_ReadReg(sn, Sn_TX_WR + 1);
+
+    W5500_WriteBuf(sn, ptr, buf, len);
+
+    ptr += len;
+    W5500_WriteReg(sn, Sn_TX_WR, (ptr >> 8) & 0xFF);
+    W5500_WriteReg(sn, Sn_TX_WR + 1, ptr & 0xFF);
+
+    W5500_WriteReg(sn, Sn_CR, CR_SEND);
+
+    // UDP: next SEND only after SEND_OK (or TIMEOUT, ARP failed)
+    uint32_t start = HAL_GetTick();
+    do {
+        ir = W5500_ReadReg(sn, Sn_IR) & (IR_SEND_OK | IR_TIMEOUT);
+        if (ir == 0 && HAL_GetTick() - start > W5500_SENDTO_TIMEOUT_MS)
+        {
+            w5500_send_pending |= (uint8_t)(1U << sn);
+            return 0;
+        }
+    } while (ir == 0);
+    W5500_WriteReg(sn, Sn_IR, ir);
+
+    return (ir & IR_SEND_OK) ? len : 0;
+}
+
 uint16_t W5500_Recv(uint8_t sn, uint8_t *buf, uint16_t len)
 {
     if (sn > 7) return 0;
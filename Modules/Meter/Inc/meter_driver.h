@@ -3,12 +3,26 @@
  * @brief   Power Meter & Sensor Driver (Voltage, Current, Temp)
  * @author  Antigravity
  * @date    2026-01-31
+ *
+ * @note    One DC meter per connector on the same RS-485 line: connector n
+ *          answers on slave address METER_MODBUS_ADDR + n. Each meter's
+ *          reads are polls of the Modbus master (modbus_master.h), every
+ *          METER_POLL_ACTIVE_MS in a session and METER_POLL_IDLE_MS otherwise;
+ *          the values are decoded in the control task.
+ *
+ * @note    The values come from a register map (meter_driver.c). Meter_Init
+ *          merges map entries whose registers are at most METER_COALESCE_GAP
+ *          apart into one function 0x03 read (bridged registers are read and
+ *          ignored), so a cycle is one round trip per block instead of one
+ *          per value: the default map (0x10, 0x12, 0x14..0x15) is one read
+ *          of 6 registers.
  */
 
 #ifndef MODULES_METER_METER_DRIVER_H_
 #define MODULES_METER_METER_DRIVER_H_
 
 #include "main.h"
+#include "evse_connector.h"
 
 // Configuration: Virtual or Real
 // Configuration: Virtual or Real
@@ -17,60 +31,64 @@
 #define METER_USE_MODBUS       1
 
 // Modbus Config
-#define METER_MODBUS_ADDR      1
+#define METER_MODBUS_ADDR      1      // Connector 1 (connector n: + n)
 #define METER_REG_VOLTAGE      0x0010
 #define METER_REG_CURRENT      0x0012
 #define METER_REG_ENERGY       0x0014 // Total Active Energy (kWh) - 2 Registers
+#define METER_COALESCE_GAP     2      // Unused registers a block read may bridge (0 = contiguous only)
+#define METER_BLOCK_MAX_REGS   16     // Largest block read (Modbus allows 125)
+#define METER_POLL_ACTIVE_MS   50     // Refresh during pre-charge / charging (welding, pre-charge checks)
+#define METER_POLL_IDLE_MS     500    // Refresh without a session
 
 
 // Sim helper
-void Meter_Sim_SetCurrent(float amps);
+void Meter_Sim_SetCurrent(uint8_t conn, float amps);
 
 /**
- * @brief Initialize Meter Driver (ADC)
+ * @brief Initialize Meter Driver (Builds the block reads from the register map)
+ * @note  Registers the polls: call after Modbus_Init().
  */
 void Meter_Init(void);
 
 /**
- * @brief Process Meter Data (Polling)
+ * @brief Process Meter Data (Derived values; the reads run in Modbus_Process)
  */
 void Meter_Process(void);
 
 /**
  * @brief Read AC Voltage (RMS)
+ * @param conn Connector index
  * @return Voltage in Volts (e.g., 220.5)
  */
-float Meter_ReadVoltage(void);
+float Meter_ReadVoltage(uint8_t conn);
 
 /**
  * @brief Read AC Current (RMS)
+ * @param conn Connector index
  * @return Current in Amps (e.g., 32.1)
  */
-float Meter_ReadCurrent(void);
+float Meter_ReadCurrent(uint8_t conn);
 
 /**
  * @brief Read Temperature
+ * @param conn Connector index
  * @return Temperature in Celsius (e.g., 45.0)
  */
-float Meter_ReadTemperature(void);
+float Meter_ReadTemperature(uint8_t conn);
 
 /**
  * @brief Read Power (Calculated)
+ * @param conn Connector index
  * @return Power in Watts
  */
-float Meter_ReadPower(void);
+float Meter_ReadPower(uint8_t conn);
 
 /**
  * @brief Read Energy (Accumulated)
+ * @param conn Connector index
  * @return Energy in kWh
  */
-float Meter_ReadEnergy(void);
-
-/**
- * @brief UART Rx Complete Callback (Hook from HAL_UART_RxCpltCallback)
- * @param huart UART Handle
- */
-void Meter_RxCpltCallback(UART_HandleTypeDef *huart);
+float Meter_ReadEnergy(uint8_t conn);
 
 
 #endif /* MODULES_METER_METER_DRIVER_H_ */
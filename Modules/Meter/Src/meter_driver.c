@@ -1,259 +1,181 @@
 /**
  * @file    meter_driver.c
- * @brief   Power Meter Driver Implementation (Modbus RTU Support) - Async/DMA
+ * @brief   Power Meter Driver Implementation (Modbus RTU Master Polls)
  */
 
 #include "meter_driver.h"
-#include "usart.h" // For huart3
+#include "modbus_master.h"
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
 
-// --- Configuration ---
-#define MODBUS_TIMEOUT_MS  200
-
-// --- State Machine ---
-typedef enum {
-    METER_IDLE,
-    METER_TX_VOLTAGE,
-    METER_RX_VOLTAGE,
-    METER_TX_CURRENT,
-    METER_RX_CURRENT,
-    METER_TX_ENERGY,
-    METER_RX_ENERGY,
-    METER_PROCESS_DATA
-} Meter_State_t;
-
-static Meter_State_t meter_state = METER_IDLE;
-static uint32_t meter_tick = 0;
-
-// --- Data Storage ---
-static float meter_voltage = 0.0f;
-static float meter_current = 0.0f;
-static float meter_power   = 0.0f;
-static float meter_energy  = 0.0f;
-static float meter_temp    = 25.0f;
+// --- Data Storage (Per connector) ---
+static float meter_voltage[EVSE_CONNECTOR_COUNT];
+static float meter_current[EVSE_CONNECTOR_COUNT];
+static float meter_power[EVSE_CONNECTOR_COUNT];
+static float meter_energy[EVSE_CONNECTOR_COUNT];
+static float meter_temp[EVSE_CONNECTOR_COUNT] = { [0 ... EVSE_CONNECTOR_COUNT - 1] = 25.0f };
 
 // Simulation fallback
-static float sim_current_target = 0.0f;
+static float sim_current_target[EVSE_CONNECTOR_COUNT];
 
-// --- Modbus Buffers ---
-static uint8_t modbus_tx_buf[8];
-static uint8_t modbus_rx_buf[16]; // Increased for multi-register read (Max 9 bytes for 2 regs)
-
-// --- Helper Prototypes ---
-static uint16_t Modbus_CRC16(uint8_t *buffer, uint16_t buffer_length);
-static void Modbus_SendReadRequest(uint16_t reg_addr, uint16_t num_regs);
+// --- Register Map ---
+typedef enum {
+    METER_FMT_U16,      // 1 register, unsigned, times scale
+    METER_FMT_FLOAT32,  // 2 registers, IEEE 754, big endian words
+} Meter_Format_t;
+
+typedef struct {
+    uint16_t reg;
+    uint8_t  format;    // Meter_Format_t
+    float    scale;
+    float   *value;     // Per connector array
+} Meter_MapEntry_t;
+
+static const Meter_MapEntry_t meter_map[] = {
+    { METER_REG_VOLTAGE, METER_FMT_U16,     0.1f, meter_voltage },
+    { METER_REG_CURRENT, METER_FMT_U16,     0.1f, meter_current },
+    { METER_REG_ENERGY,  METER_FMT_FLOAT32, 1.0f, meter_energy },  // kWh
+};
+#define METER_MAP_SIZE  (sizeof(meter_map) / sizeof(meter_map[0]))
+
+// Block Reads (built from the map by Meter_Init)
+typedef struct {
+    uint16_t reg;       // First register
+    uint16_t count;     // Registers, gaps included
+    uint8_t  first;     // Range in meter_order[]
+    uint8_t  entries;
+} Meter_Block_t;
+
+static uint8_t meter_order[METER_MAP_SIZE];       // Map entries by register
+static Meter_Block_t meter_block[METER_MAP_SIZE];
+static uint8_t meter_block_count = 0;
+
+static void Meter_BuildBlocks(void);
+static void Meter_OnBlock(const Modbus_Result_t *result, uint32_t arg);
+
+static uint8_t Meter_MapRegs(const Meter_MapEntry_t *e)
+{
+    return (e->format == METER_FMT_FLOAT32) ? 2 : 1;
+}
 
 void Meter_Init(void)
 {
-    meter_state = METER_IDLE;
+    Meter_BuildBlocks();
     #if METER_USE_MODBUS
-        printf("[Meter] Initialized (Async Modbus). Addr: %d\r\n", METER_MODBUS_ADDR);
+        // One poll per block and meter, answered in the control task
+        static const uint16_t period_ms[MODBUS_RATE_COUNT] = {
+            [MODBUS_RATE_IDLE] = METER_POLL_IDLE_MS,
+            [MODBUS_RATE_ACTIVE] = METER_POLL_ACTIVE_MS,
+        };
+        for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+        {
+            for (uint8_t b = 0; b < meter_block_count; b++)
+            {
+                const Modbus_Request_t req = {
+                    .slave = (uint8_t)(METER_MODBUS_ADDR + c), .function = MODBUS_FC_READ_HOLDING,
+                    .reg = meter_block[b].reg, .count = meter_block[b].count,
+                    .prio = MODBUS_PRIO_NORMAL, .retries = MODBUS_RETRIES,
+                    .callback = Meter_OnBlock, .arg = ((uint32_t)c << 8) | b,
+                };
+                if (Modbus_AddPoll(&req, period_ms) < 0) printf("[Meter] Poll table full\r\n");
+            }
+        }
+        printf("[Meter] Initialized (Modbus). Addr: %d..%d, %d Values in %d Read(s)\r\n", METER_MODBUS_ADDR,
+               METER_MODBUS_ADDR + EVSE_CONNECTOR_COUNT - 1, (int)METER_MAP_SIZE, meter_block_count);
     #else
         printf("[Meter] Initialized (Simulation Mode).\r\n");
     #endif
 }
 
-void Meter_Process(void)
+// Sort the map by register and merge neighbours into block reads: the next
+// value joins the block if at most METER_COALESCE_GAP unused registers lie
+// between them and the block stays within METER_BLOCK_MAX_REGS
+static void Meter_BuildBlocks(void)
 {
-    #if METER_USE_MODBUS
-    
-    switch (meter_state)
+    for (uint8_t k = 0; k < METER_MAP_SIZE; k++)
     {
-        case METER_IDLE:
-            // Start Sequence: Request Voltage
-            Modbus_SendReadRequest(METER_REG_VOLTAGE, 1);
-            meter_state = METER_TX_VOLTAGE;
-            meter_tick = HAL_GetTick();
-            break;
-
-        case METER_TX_VOLTAGE:
-            // Wait for TX Complete (handled by DMA basically mostly instant)
-            // But we transit to RX immediately after starting TX in DMA usually?
-            // Let's assume we start RX immediately after TX starts if using half-duplex properly,
-            // or we wait for TC. For simplicity, we moved to RX state in the Request function?
-            // Actually, HAL_UART_Transmit_DMA is non-blocking. 
-            // We should wait for TC or just rely on RX? Modbus Slave replies after processing.
-            // Let's stay in TX state until we decide to switch to RX, OR just switch to RX_WAIT.
-            
-            // Timeout Check
-            if (HAL_GetTick() - meter_tick > 50) 
-            {
-                 // TX Stuck? Reset
-                 meter_state = METER_IDLE; 
-            }
-            break;
-
-        case METER_RX_VOLTAGE:
-            // Waiting for RX Callback
-            if (HAL_GetTick() - meter_tick > MODBUS_TIMEOUT_MS)
-            {
-                // Timeout
-                // printf("[Meter] Vol Timeout\r\n"); // Heavy?
-                meter_state = METER_IDLE; // Retry next cycle
-            }
-            break;
-            
-        case METER_TX_CURRENT:
-             if (HAL_GetTick() - meter_tick > 50) 
-             {
-                 meter_state = METER_IDLE; 
-             }
-             break;
-
-        case METER_RX_CURRENT:
-            if (HAL_GetTick() - meter_tick > MODBUS_TIMEOUT_MS)
-            {
-                meter_state = METER_IDLE;
-            }
-            break;
+        uint8_t j = k;
+        while (j > 0 && meter_map[meter_order[j - 1]].reg > meter_map[k].reg)
+        {
+            meter_order[j] = meter_order[j - 1];
+            j--;
+        }
+        meter_order[j] = k;
+    }
 
-        case METER_TX_ENERGY:
-             if (HAL_GetTick() - meter_tick > 50) 
-             {
-                 meter_state = METER_IDLE; 
-             }
-             break;
+    meter_block_count = 0;
+    for (uint8_t k = 0; k < METER_MAP_SIZE; k++)
+    {
+        const Meter_MapEntry_t *e = &meter_map[meter_order[k]];
+        uint16_t end = (uint16_t)(e->reg + Meter_MapRegs(e));
 
-        case METER_RX_ENERGY:
-            if (HAL_GetTick() - meter_tick > MODBUS_TIMEOUT_MS)
+        if (meter_block_count > 0)
+        {
+            Meter_Block_t *blk = &meter_block[meter_block_count - 1];
+            uint16_t blk_end = (uint16_t)(blk->reg + blk->count);
+            if (e->reg <= blk_end + METER_COALESCE_GAP && end - blk->reg <= METER_BLOCK_MAX_REGS)
             {
-                meter_state = METER_IDLE;
+                if (end > blk_end) blk->count = (uint16_t)(end - blk->reg);
+                blk->entries++;
+                continue;
             }
-            break;
-            
-        default:
-            meter_state = METER_IDLE;
-            break;
+        }
+        meter_block[meter_block_count++] = (Meter_Block_t){
+            .reg = e->reg, .count = Meter_MapRegs(e), .first = k, .entries = 1,
+        };
     }
-    
-    // Calc Power
-    meter_power = meter_voltage * meter_current;
+}
+
+void Meter_Process(void)
+{
+    #if METER_USE_MODBUS
+    // Values arrive through Meter_OnBlock (Modbus_Process)
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++) meter_power[c] = meter_voltage[c] * meter_current[c];
 
     #else
         // Simulation Logic
-        meter_voltage = 220.0f + ((rand() % 100) - 50) / 100.0f;
-        meter_current = sim_current_target;
-        meter_power = meter_voltage * meter_current;
+        for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+        {
+            meter_voltage[c] = 220.0f + ((rand() % 100) - 50) / 100.0f;
+            meter_current[c] = sim_current_target[c];
+            meter_power[c] = meter_voltage[c] * meter_current[c];
+        }
     #endif
 }
 
-// Internal: Trigger Modbus Read
-static void Modbus_SendReadRequest(uint16_t reg_addr, uint16_t num_regs)
+// Every value of the block from the one response (task context)
+static void Meter_OnBlock(const Modbus_Result_t *result, uint32_t arg)
 {
-    // 1. Build Packet
-    modbus_tx_buf[0] = METER_MODBUS_ADDR;
-    modbus_tx_buf[1] = 0x03; // Read Holding
-    modbus_tx_buf[2] = (reg_addr >> 8) & 0xFF;
-    modbus_tx_buf[3] = reg_addr & 0xFF;
-    modbus_tx_buf[4] = (num_regs >> 8) & 0xFF;
-    modbus_tx_buf[5] = num_regs & 0xFF;
-    
-    uint16_t crc = Modbus_CRC16(modbus_tx_buf, 6);
-    modbus_tx_buf[6] = crc & 0xFF;
-    modbus_tx_buf[7] = (crc >> 8) & 0xFF;
-    
-    // 2. Start DMA Transmit
-    HAL_UART_Transmit_DMA(&huart3, modbus_tx_buf, 8);
-    
-    // 3. Prepare DMA Receive (Variable Length)
-    // 1 Register: 3 Header + 2 Data + 2 CRC = 7 Bytes
-    // 2 Registers: 3 Header + 4 Data + 2 CRC = 9 Bytes
-    uint16_t rx_len = 5 + (num_regs * 2);
-    
-    if (HAL_UART_Receive_DMA(&huart3, modbus_rx_buf, rx_len) == HAL_OK)
-    {
-        // Good
-    }
-}
+    uint8_t conn = (uint8_t)(arg >> 8);
+    uint8_t b = (uint8_t)arg;
+    if (result->status != MODBUS_OK || conn >= EVSE_CONNECTOR_COUNT || b >= meter_block_count) return;
 
-// ISR Callback (Hooked from main.c)
-void Meter_RxCpltCallback(UART_HandleTypeDef *huart)
-{
-    if (huart->Instance == USART3)
+    const Meter_Block_t *blk = &meter_block[b];
+    for (uint8_t k = 0; k < blk->entries; k++)
     {
-        #if METER_USE_MODBUS
-        // Parse what we received
-        // Check CRC
-        uint16_t rx_crc = Modbus_CRC16(modbus_rx_buf, 5);
-        uint16_t pkt_crc = modbus_rx_buf[5] | (modbus_rx_buf[6] << 8);
-        
-        bool valid = (rx_crc == pkt_crc && modbus_rx_buf[0] == METER_MODBUS_ADDR);
-        uint16_t val = (modbus_rx_buf[3] << 8) | modbus_rx_buf[4];
-        
-        // State Transition
-        switch (meter_state)
-        {
-            case METER_TX_VOLTAGE: // Should be RX really
-            case METER_RX_VOLTAGE:
-                if (valid) meter_voltage = val / 10.0f;
-                
-                // Trigger Next: Current
-                Modbus_SendReadRequest(METER_REG_CURRENT, 1);
-                meter_state = METER_TX_CURRENT; // Or RX_CURRENT directly
-                meter_state = METER_RX_CURRENT; // Skip TX wait logic for simplicity
-                meter_tick = HAL_GetTick();
-                break;
-                
-            case METER_TX_CURRENT:
-            case METER_RX_CURRENT:
-                if (valid) meter_current = val / 10.0f;
-                
-                // Trigger Next: Energy (2 Registers)
-                Modbus_SendReadRequest(METER_REG_ENERGY, 2);
-                meter_state = METER_RX_ENERGY;
-                meter_tick = HAL_GetTick();
-                break;
+        const Meter_MapEntry_t *e = &meter_map[meter_order[blk->first + k]];
+        const uint8_t *p = &result->data[2 * (e->reg - blk->reg)];
 
-            case METER_TX_ENERGY:
-            case METER_RX_ENERGY:
-                if (valid) 
-                {
-                    // Parse 32-bit Float (IEEE 754 Big Endian)
-                    // Byte 3,4 = Reg1 (High?), Byte 5,6 = Reg2 (Low?)
-                    // Standard Modbus float is usually Big Endian Words.
-                    uint32_t raw = (modbus_rx_buf[3] << 24) | (modbus_rx_buf[4] << 16) |
-                                   (modbus_rx_buf[5] << 8)  | (modbus_rx_buf[6]);
-                    
-                    float f_val;
-                    memcpy(&f_val, &raw, 4);
-                    meter_energy = f_val; // Assumed kWh
-                }
-                meter_state = METER_IDLE;
-                break;
-                
-            default:
-                meter_state = METER_IDLE;
-                break;
+        if (e->format == METER_FMT_FLOAT32)
+        {
+            uint32_t raw = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+            float f_val;
+            memcpy(&f_val, &raw, 4);
+            e->value[conn] = f_val * e->scale;
         }
-        #endif
-    }
-}
-
-
-static uint16_t Modbus_CRC16(uint8_t *buffer, uint16_t buffer_length)
-{
-    uint16_t crc = 0xFFFF;
-    for (uint16_t pos = 0; pos < buffer_length; pos++) {
-        crc ^= (uint16_t)buffer[pos];
-        for (int i = 8; i != 0; i--) {
-            if ((crc & 0x0001) != 0) {
-                crc >>= 1;
-                crc ^= 0xA001;
-            } else {
-                crc >>= 1;
-            }
+        else
+        {
+            e->value[conn] = (uint16_t)((p[0] << 8) | p[1]) * e->scale;
         }
     }
-    return crc;
 }
 
-float Meter_ReadVoltage(void) { return meter_voltage; }
-float Meter_ReadCurrent(void) { return meter_current; }
-float Meter_ReadPower(void)   { return meter_power; }
-float Meter_ReadEnergy(void)  { return meter_energy; }
-float Meter_ReadTemperature(void) { return meter_temp; }
-void Meter_Sim_SetCurrent(float amps) { sim_current_target = amps; }
+float Meter_ReadVoltage(uint8_t conn) { return (conn < EVSE_CONNECTOR_COUNT) ? meter_voltage[conn] : 0.0f; }
+float Meter_ReadCurrent(uint8_t conn) { return (conn < EVSE_CONNECTOR_COUNT) ? meter_current[conn] : 0.0f; }
+float Meter_ReadPower(uint8_t conn)   { return (conn < EVSE_CONNECTOR_COUNT) ? meter_power[conn] : 0.0f; }
+float Meter_ReadEnergy(uint8_t conn)  { return (conn < EVSE_CONNECTOR_COUNT) ? meter_energy[conn] : 0.0f; }
+float Meter_ReadTemperature(uint8_t conn) { return (conn < EVSE_CONNECTOR_COUNT) ? meter_temp[conn] : 0.0f; }
+void Meter_Sim_SetCurrent(uint8_t conn, float amps) { if (conn < EVSE_CONNECTOR_COUNT) sim_current_target[conn] = amps; }
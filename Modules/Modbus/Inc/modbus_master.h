@@ -0,0 +1,194 @@
+/**
+ * @file    modbus_master.h
+ * @brief   Modbus RTU Master (RS-485 on USART3)
+ *
+ * @note    Framing: the receiver runs HAL_UARTEx_ReceiveToIdle_DMA into a
+ *          buffer of MODBUS_ADU_MAX bytes, so a response of any length
+ *          ends at the line-idle event; the ISR only stores the length and
+ *          the time. The whole frame is checked in the task (CRC over every
+ *          byte before it with crc_service, slave, function or exception,
+ *          byte count). A frame whose bytes are split by a gap (idle
+ *          mid-frame) fails the check and is retried. Before every request the bus has been
+ *          silent for t3.5 (3.5 characters, 1750 us above 19200 baud).
+ *
+ * @note    RS-485: USART3 runs in driver-enable mode (HAL_RS485Ex_Init, DE on
+ *          PB14); the UART raises DE for exactly the transmission, no GPIO
+ *          toggling or TX-complete timing in software. The transceiver's RE
+ *          is tied to DE, so the master does not hear its own request.
+ *
+ * @note    Requests: registered polls (a period per Modbus_Rate_t) and
+ *          one-shot requests share one scheduler. Modbus_Process(), in the
+ *          control task, starts the highest-priority due request (FIFO
+ *          within a priority), checks the response and runs the request's
+ *          callback in the task, never in the ISR. A failed attempt is
+ *          retried up to its retry count before the callback sees the
+ *          error. Statistics (latency, errors) are kept per slave address.
+ *
+ * @note    Offline slaves: after MODBUS_OFFLINE_FAILS failed transactions
+ *          in a row a slave is offline. Its polls are then sent only every
+ *          MODBUS_OFFLINE_PROBE_MS as a probe, and no request to it is
+ *          retried. Each failed attempt costs roughly twice the timeout of
+ *          bus time, which the slaves that do answer need. The first answer
+ *          (a response or an exception) brings the slave back online.
+ */
+
+#ifndef MODULES_MODBUS_MODBUS_MASTER_H_
+#define MODULES_MODBUS_MODBUS_MASTER_H_
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Configuration ---
+#define MODBUS_ADU_MAX          256     // RTU frame limit (RX buffer)
+#define MODBUS_READ_MAX_REGS    125     // Read holding/input registers limit
+#define MODBUS_MAX_POLLS        16      // Registered polls
+#define MODBUS_QUEUE_LEN        8       // Pending one-shot requests
+#define MODBUS_MAX_SLAVES       8       // Slaves with statistics
+#define MODBUS_TIMEOUT_MS       100     // Default response timeout (after the request is on the wire)
+#define MODBUS_RETRIES          1       // Default retries of a failed attempt
+#define MODBUS_T35_MIN_US       1750U   // t3.5 above 19200 baud (Modbus over serial line 2.5.1.1)
+#define MODBUS_OFFLINE_FAILS    3       // Failed transactions in a row before a slave is offline
+#define MODBUS_OFFLINE_PROBE_MS 5000    // Poll period of an offline slave
+
+// Functions
+#define MODBUS_FC_READ_HOLDING  0x03
+#define MODBUS_FC_READ_INPUT    0x04
+#define MODBUS_FC_WRITE_SINGLE  0x06
+
+// Request Priority (lower value runs first)
+#define MODBUS_PRIO_HIGH        0       // Commands, safety-relevant reads
+#define MODBUS_PRIO_NORMAL      1       // Measurement polls
+#define MODBUS_PRIO_LOW         2       // Diagnostics, counters
+#define MODBUS_PRIO_COUNT       3
+
+// Poll rate class (the application picks it from the charger state)
+typedef enum
+{
+    MODBUS_RATE_IDLE = 0,    // No session: slow polls
+    MODBUS_RATE_ACTIVE,      // Pre-charge / charging: fast polls
+    MODBUS_RATE_COUNT
+} Modbus_Rate_t;
+
+typedef enum
+{
+    MODBUS_OK = 0,
+    MODBUS_ERR_TIMEOUT,      // No frame before the timeout
+    MODBUS_ERR_CRC,          // Frame with a bad CRC
+    MODBUS_ERR_FRAME,        // Wrong slave, function, length or byte count
+    MODBUS_ERR_EXCEPTION,    // Exception response (code in Modbus_Result_t)
+    MODBUS_ERR_COUNT
+} Modbus_Status_t;
+
+typedef struct
+{
+    Modbus_Status_t status;  // After the last attempt
+    uint8_t  slave;
+    uint8_t  function;
+    uint16_t reg;
+    uint16_t count;          // Registers requested
+    uint8_t  exception;      // Exception code (MODBUS_ERR_EXCEPTION)
+    const uint8_t *data;     // Register data, big endian (reads: 2 * count bytes)
+    uint16_t len;
+    uint32_t latency_us;     // Request start to response (OK)
+} Modbus_Result_t;
+
+// Runs in the task calling Modbus_Process(); data is valid during the call
+typedef void (*Modbus_Callback_t)(const Modbus_Result_t *result, uint32_t arg);
+
+typedef struct
+{
+    uint8_t  slave;          // 1..247
+    uint8_t  function;       // MODBUS_FC_*
+    uint16_t reg;
+    uint16_t count;          // Registers (reads) or the value (MODBUS_FC_WRITE_SINGLE)
+    uint8_t  prio;           // MODBUS_PRIO_*
+    uint8_t  retries;
+    uint16_t timeout_ms;     // 0 = MODBUS_TIMEOUT_MS
+    Modbus_Callback_t callback;
+    uint32_t arg;            // Passed to the callback
+} Modbus_Request_t;
+
+typedef struct
+{
+    uint8_t  slave;          // 0 = unused
+    uint32_t requests;       // Transactions (retries not counted)
+    uint32_t ok;
+    uint32_t failed;         // Transactions that ended in an error
+    uint32_t retries;
+    uint32_t errors[MODBUS_ERR_COUNT]; // Per attempt, by Modbus_Status_t
+    uint32_t latency_last_us;
+    uint32_t latency_max_us;
+    uint64_t latency_sum_us; // Over ok (average = sum / ok)
+    bool     offline;        // MODBUS_OFFLINE_FAILS in a row, probed slowly
+    uint32_t offline_events; // Times the slave went offline
+} Modbus_SlaveStats_t;
+
+typedef struct
+{
+    uint8_t  rate;           // Modbus_Rate_t
+    uint8_t  polls;          // Registered
+    uint8_t  queued;         // One-shot requests waiting
+    uint32_t late_polls;     // Polls started more than one period late
+    uint32_t queue_full;     // Rejected one-shot requests
+    uint32_t unsolicited;    // Frames without a request waiting
+} Modbus_MasterStatus_t;
+
+/**
+ * @brief Initialize the master (bus idle, no polls)
+ * @param huart UART in RS-485 driver-enable mode (huart3)
+ */
+void Modbus_Init(UART_HandleTypeDef *huart);
+
+/**
+ * @brief Register a periodic request
+ * @param req       Request (copied)
+ * @param period_ms Period per Modbus_Rate_t (0 = not polled in that class)
+ * @return Poll handle, -1 if the table is full or the request invalid
+ */
+int Modbus_AddPoll(const Modbus_Request_t *req, const uint16_t period_ms[MODBUS_RATE_COUNT]);
+
+/**
+ * @brief Queue a one-shot request (any task)
+ * @return false if the queue is full or the request invalid
+ */
+bool Modbus_Submit(const Modbus_Request_t *req);
+
+/**
+ * @brief Select the poll rate class
+ * @note  A faster class makes the polls due now instead of at the end of
+ *        the slow period.
+ */
+void Modbus_SetRate(Modbus_Rate_t rate);
+
+/**
+ * @brief Run the master: check a received frame or timeout, complete the
+ *        transaction (callback), start the next request
+ * @note  Call from the control task every loop.
+ */
+void Modbus_Process(void);
+
+/**
+ * @brief Line idle / receive complete (HAL_UARTEx_RxEventCallback)
+ * @param size Bytes in the receive buffer
+ */
+void Modbus_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size);
+
+/**
+ * @brief Statistics of a slave
+ * @param index 0 ~ MODBUS_MAX_SLAVES-1 (in first-use order)
+ * @return false if the slot is unused
+ */
+bool Modbus_GetSlaveStats(uint8_t index, Modbus_SlaveStats_t *stats);
+
+/**
+ * @brief Scheduler status
+ */
+void Modbus_GetStatus(Modbus_MasterStatus_t *status);
+
+/**
+ * @brief Name of a status
+ */
+const char *Modbus_StatusName(Modbus_Status_t status);
+
+#endif /* MODULES_MODBUS_MODBUS_MASTER_H_ */
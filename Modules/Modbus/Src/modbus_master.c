@@ -0,0 +1,484 @@
+/**
+ * @file    modbus_master.c
+ * @brief   Modbus RTU Master Implementation
+ *
+ * @details
+ * One transaction at a time. Modbus_Process() walks
+ *     IDLE -> (request picked) -> READY -> (t3.5 of silence) -> WAIT
+ *          -> (frame or timeout) -> READY (retry) or IDLE (callback)
+ * The ISR side is Modbus_RxEventCallback(): it latches the frame length
+ * and time for the task and records the frame. Polls are due at a fixed
+ * rate (due += period when started); one more than a period late is
+ * re-anchored to now and counted. The polls of an offline slave wait for
+ * its probe time instead and are re-anchored to it without being counted
+ * late; the first one due after it is the probe.
+ */
+
+#include "modbus_master.h"
+#include "timebase.h"
+#include "recorder.h"
+#include "crc_service.h"
+#include <stdio.h>
+#include <string.h>
+
+// --- Transaction ---
+typedef enum
+{
+    MB_IDLE = 0,
+    MB_READY,       // Request picked, waiting for t3.5 of bus silence
+    MB_WAIT,        // Request sent, waiting for the response
+} Modbus_Phase_t;
+
+typedef struct
+{
+    Modbus_Request_t req;
+    uint16_t period_ms[MODBUS_RATE_COUNT];
+    uint64_t due_us;
+} Modbus_Poll_t;
+
+typedef struct
+{
+    Modbus_Request_t req;
+    uint64_t queued_us;
+} Modbus_Queued_t;
+
+static UART_HandleTypeDef *mb_huart = NULL;
+static uint32_t mb_char_us = 0;     // One character (11 bits)
+static uint32_t mb_t35_us = 0;
+
+// Scheduler
+static Modbus_Poll_t mb_poll[MODBUS_MAX_POLLS];
+static uint8_t mb_poll_count = 0;
+static Modbus_Queued_t mb_queue[MODBUS_QUEUE_LEN];
+static uint8_t mb_queue_count = 0;
+static Modbus_Rate_t mb_rate = MODBUS_RATE_IDLE;
+static uint32_t mb_late_polls = 0;
+static uint32_t mb_queue_full = 0;
+static uint32_t mb_unsolicited = 0;
+
+// Transaction in progress
+static struct
+{
+    Modbus_Phase_t phase;
+    Modbus_Request_t req;
+    uint8_t  attempt;
+    uint16_t expect;         // Response length without errors
+    uint64_t start_us;       // First attempt sent
+    uint64_t deadline_us;
+} mb_cur;
+static uint64_t mb_bus_free_us = 0; // Earliest next request (t3.5 after the last frame)
+
+// Buffers (RX written by DMA, length latched by the ISR)
+static uint8_t mb_tx_buf[8];
+static uint8_t mb_rx_buf[MODBUS_ADU_MAX];
+static volatile uint16_t mb_rx_size = 0;
+static volatile uint64_t mb_rx_us = 0;
+static volatile bool mb_rx_ready = false;
+
+static Modbus_SlaveStats_t mb_stats[MODBUS_MAX_SLAVES];
+static uint8_t mb_fail_run[MODBUS_MAX_SLAVES];       // Failed transactions in a row
+static uint64_t mb_probe_due_us[MODBUS_MAX_SLAVES];  // Next poll of an offline slave
+
+static const char *const mb_status_names[MODBUS_ERR_COUNT] = {
+    "OK", "TIMEOUT", "CRC", "FRAME", "EXCEPTION",
+};
+
+static bool Modbus_Valid(const Modbus_Request_t *req);
+static Modbus_SlaveStats_t *Modbus_Stats(uint8_t slave);
+static bool Modbus_Pick(uint64_t now);
+static void Modbus_Send(uint64_t now);
+static Modbus_Status_t Modbus_Check(uint16_t size, Modbus_Result_t *res);
+static void Modbus_EndAttempt(Modbus_Status_t status, Modbus_Result_t *res, uint64_t at_us);
+
+void Modbus_Init(UART_HandleTypeDef *huart)
+{
+    mb_huart = huart;
+    memset(mb_poll, 0, sizeof(mb_poll));
+    memset(mb_queue, 0, sizeof(mb_queue));
+    memset(&mb_cur, 0, sizeof(mb_cur));
+    memset(mb_stats, 0, sizeof(mb_stats));
+    memset(mb_fail_run, 0, sizeof(mb_fail_run));
+    memset(mb_probe_due_us, 0, sizeof(mb_probe_due_us));
+    mb_poll_count = 0;
+    mb_queue_count = 0;
+    mb_rate = MODBUS_RATE_IDLE;
+    mb_late_polls = 0;
+    mb_queue_full = 0;
+    mb_unsolicited = 0;
+    mb_rx_ready = false;
+
+    // 11 bits per character (start, 8 data, parity or second stop, stop)
+    uint32_t baud = huart->Init.BaudRate;
+    mb_char_us = (baud > 0) ? (11U * 1000000U + baud - 1U) / baud : 1146U;
+    mb_t35_us = (baud > 19200U) ? MODBUS_T35_MIN_US : (mb_char_us * 7U + 1U) / 2U;
+    mb_bus_free_us = Timebase_GetMicros() + mb_t35_us;
+
+    printf("[Modbus] Initialized (%lu baud, t3.5 %lu us)\r\n", (unsigned long)baud, (unsigned long)mb_t35_us);
+}
+
+static bool Modbus_Valid(const Modbus_Request_t *req)
+{
+    if (req == NULL || req->slave < 1 || req->slave > 247 || req->prio >= MODBUS_PRIO_COUNT) return false;
+    if (req->function == MODBUS_FC_READ_HOLDING || req->function == MODBUS_FC_READ_INPUT)
+    {
+        return req->count >= 1 && req->count <= MODBUS_READ_MAX_REGS;
+    }
+    return req->function == MODBUS_FC_WRITE_SINGLE;
+}
+
+int Modbus_AddPoll(const Modbus_Request_t *req, const uint16_t period_ms[MODBUS_RATE_COUNT])
+{
+    if (!Modbus_Valid(req) || period_ms == NULL || mb_poll_count >= MODBUS_MAX_POLLS) return -1;
+
+    Modbus_Poll_t *p = &mb_poll[mb_poll_count];
+    p->req = *req;
+    memcpy(p->period_ms, period_ms, sizeof(p->period_ms));
+    p->due_us = Timebase_GetMicros();
+    Modbus_Stats(req->slave); // Statistics slots in registration order
+    return mb_poll_count++;
+}
+
+bool Modbus_Submit(const Modbus_Request_t *req)
+{
+    if (!Modbus_Valid(req)) return false;
+
+    uint64_t now = Timebase_GetMicros();
+    bool ok = false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (mb_queue_count < MODBUS_QUEUE_LEN)
+    {
+        mb_queue[mb_queue_count].req = *req;
+        mb_queue[mb_queue_count].queued_us = now;
+        mb_queue_count++;
+        ok = true;
+    }
+    else
+    {
+        mb_queue_full++;
+    }
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+void Modbus_SetRate(Modbus_Rate_t rate)
+{
+    if (rate >= MODBUS_RATE_COUNT || rate == mb_rate) return;
+
+    uint64_t now = Timebase_GetMicros();
+    for (uint8_t k = 0; k < mb_poll_count; k++)
+    {
+        Modbus_Poll_t *p = &mb_poll[k];
+        bool faster = p->period_ms[rate] != 0 &&
+                      (p->period_ms[mb_rate] == 0 || p->period_ms[rate] < p->period_ms[mb_rate]);
+        if (faster && p->due_us > now) p->due_us = now;
+    }
+    mb_rate = rate;
+}
+
+// Highest priority first; within a priority the one waiting longest
+static bool Modbus_Pick(uint64_t now)
+{
+    int best_poll = -1;
+    int best_queued = -1;
+    uint8_t best_prio = MODBUS_PRIO_COUNT;
+    uint64_t best_since = 0;
+
+    for (uint8_t k = 0; k < mb_poll_count; k++)
+    {
+        const Modbus_Poll_t *p = &mb_poll[k];
+        if (p->period_ms[mb_rate] == 0 || p->due_us > now) continue;
+        const Modbus_SlaveStats_t *st = Modbus_Stats(p->req.slave);
+        if (st != NULL && st->offline && mb_probe_due_us[st - mb_stats] > now) continue;
+        if (p->req.prio < best_prio || (p->req.prio == best_prio && p->due_us < best_since))
+        {
+            best_poll = k;
+            best_queued = -1;
+            best_prio = p->req.prio;
+            best_since = p->due_us;
+        }
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t k = 0; k < mb_queue_count; k++)
+    {
+        const Modbus_Queued_t *q = &mb_queue[k];
+        if (q->req.prio < best_prio || (q->req.prio == best_prio && q->queued_us < best_since))
+        {
+            best_poll = -1;
+            best_queued = k;
+            best_prio = q->req.prio;
+            best_since = q->queued_us;
+        }
+    }
+    if (best_queued >= 0)
+    {
+        mb_cur.req = mb_queue[best_queued].req;
+        mb_queue_count--;
+        memmove(&mb_queue[best_queued], &mb_queue[best_queued + 1],
+                (mb_queue_count - (uint8_t)best_queued) * sizeof(mb_queue[0]));
+    }
+    __set_PRIMASK(primask);
+
+    if (best_poll >= 0)
+    {
+        Modbus_Poll_t *p = &mb_poll[best_poll];
+        uint64_t period_us = (uint64_t)p->period_ms[mb_rate] * TIMEBASE_US_PER_MS;
+        Modbus_SlaveStats_t *st = Modbus_Stats(p->req.slave);
+        mb_cur.req = p->req;
+        p->due_us += period_us;
+        if (st != NULL && st->offline)
+        {
+            // Probe: the slave's next poll waits for the next probe time
+            mb_probe_due_us[st - mb_stats] = now + (uint64_t)MODBUS_OFFLINE_PROBE_MS * TIMEBASE_US_PER_MS;
+            if (p->due_us <= now) p->due_us = now + period_us;
+        }
+        else if (p->due_us <= now)
+        {
+            mb_late_polls++;
+            p->due_us = now + period_us;
+        }
+    }
+    if (best_poll < 0 && best_queued < 0) return false;
+
+    // No retries to a slave that is not answering anyway
+    const Modbus_SlaveStats_t *cur_st = Modbus_Stats(mb_cur.req.slave);
+    if (cur_st != NULL && cur_st->offline) mb_cur.req.retries = 0;
+
+    mb_cur.phase = MB_READY;
+    mb_cur.attempt = 0;
+    return true;
+}
+
+static void Modbus_Send(uint64_t now)
+{
+    const Modbus_Request_t *r = &mb_cur.req;
+    bool read = (r->function != MODBUS_FC_WRITE_SINGLE);
+
+    mb_tx_buf[0] = r->slave;
+    mb_tx_buf[1] = r->function;
+    mb_tx_buf[2] = (uint8_t)(r->reg >> 8);
+    mb_tx_buf[3] = (uint8_t)r->reg;
+    mb_tx_buf[4] = (uint8_t)(r->count >> 8);
+    mb_tx_buf[5] = (uint8_t)r->count;
+    uint16_t crc = (uint16_t)Crc_Compute(CRC_ALGO_MODBUS, mb_tx_buf, 6);
+    mb_tx_buf[6] = (uint8_t)crc;
+    mb_tx_buf[7] = (uint8_t)(crc >> 8);
+    mb_cur.expect = read ? (uint16_t)(5U + 2U * r->count) : 8U;
+
+    // Receive first (the reply may start right after the request); events
+    // only at line idle or a full buffer, not at half transfer
+    mb_rx_ready = false;
+    HAL_UARTEx_ReceiveToIdle_DMA(mb_huart, mb_rx_buf, sizeof(mb_rx_buf));
+    __HAL_DMA_DISABLE_IT(mb_huart->hdmarx, DMA_IT_HT);
+
+    Recorder_Write(REC_SRC_MODBUS, 0, REC_FLAG_TX, now, mb_tx_buf, sizeof(mb_tx_buf));
+    HAL_UART_Transmit_DMA(mb_huart, mb_tx_buf, sizeof(mb_tx_buf));
+
+    // Timeout counts from the end of the request and allows for the response on the wire
+    uint16_t timeout_ms = (r->timeout_ms != 0) ? r->timeout_ms : MODBUS_TIMEOUT_MS;
+    if (mb_cur.attempt == 0) mb_cur.start_us = now;
+    mb_cur.deadline_us = now + (uint64_t)(sizeof(mb_tx_buf) + mb_cur.expect) * mb_char_us +
+                         (uint64_t)timeout_ms * TIMEBASE_US_PER_MS;
+    mb_cur.phase = MB_WAIT;
+}
+
+static Modbus_Status_t Modbus_Check(uint16_t size, Modbus_Result_t *res)
+{
+    const Modbus_Request_t *r = &mb_cur.req;
+    const uint8_t *f = mb_rx_buf;
+
+    if (size < 5 || size > sizeof(mb_rx_buf)) return MODBUS_ERR_FRAME;
+    uint16_t crc = (uint16_t)(f[size - 2] | (f[size - 1] << 8));
+    if (Crc_Compute(CRC_ALGO_MODBUS, f, size - 2U) != crc) return MODBUS_ERR_CRC;
+    if (f[0] != r->slave) return MODBUS_ERR_FRAME;
+
+    if (f[1] == (r->function | 0x80U))
+    {
+        if (size != 5) return MODBUS_ERR_FRAME;
+        res->exception = f[2];
+        return MODBUS_ERR_EXCEPTION;
+    }
+    if (f[1] != r->function || size != mb_cur.expect) return MODBUS_ERR_FRAME;
+
+    if (r->function == MODBUS_FC_WRITE_SINGLE)
+    {
+        if (memcmp(f, mb_tx_buf, 6) != 0) return MODBUS_ERR_FRAME; // Echo of the request
+        res->data = &f[4];
+        res->len = 2;
+    }
+    else
+    {
+        if (f[2] != 2U * r->count) return MODBUS_ERR_FRAME;
+        res->data = &f[3];
+        res->len = f[2];
+    }
+    return MODBUS_OK;
+}
+
+// Offline after MODBUS_OFFLINE_FAILS failed transactions, online again at
+// the first answer (an exception is an answer too)
+static void Modbus_UpdateOnline(Modbus_SlaveStats_t *st, Modbus_Status_t status, uint64_t at_us)
+{
+    uint8_t k = (uint8_t)(st - mb_stats);
+
+    if (status == MODBUS_OK || status == MODBUS_ERR_EXCEPTION)
+    {
+        mb_fail_run[k] = 0;
+        if (st->offline)
+        {
+            st->offline = false;
+            printf("[Modbus] Slave %u Online\r\n", st->slave);
+        }
+        return;
+    }
+
+    if (mb_fail_run[k] < UINT8_MAX) mb_fail_run[k]++;
+    if (!st->offline && mb_fail_run[k] >= MODBUS_OFFLINE_FAILS)
+    {
+        st->offline = true;
+        st->offline_events++;
+        mb_probe_due_us[k] = at_us + (uint64_t)MODBUS_OFFLINE_PROBE_MS * TIMEBASE_US_PER_MS;
+        printf("[Modbus] Slave %u Offline (%u Failed in a Row), Probing every %u ms\r\n",
+               st->slave, mb_fail_run[k], MODBUS_OFFLINE_PROBE_MS);
+    }
+}
+
+// Retry or complete the transaction (statistics, callback)
+static void Modbus_EndAttempt(Modbus_Status_t status, Modbus_Result_t *res, uint64_t at_us)
+{
+    const Modbus_Request_t *r = &mb_cur.req;
+    Modbus_SlaveStats_t *st = Modbus_Stats(r->slave);
+
+    mb_bus_free_us = at_us + mb_t35_us;
+    if (status != MODBUS_OK && st != NULL) st->errors[status]++;
+
+    // An exception is the slave's answer: repeating the request changes nothing
+    if (status != MODBUS_OK && status != MODBUS_ERR_EXCEPTION && mb_cur.attempt < r->retries)
+    {
+        mb_cur.attempt++;
+        mb_cur.phase = MB_READY;
+        if (st != NULL) st->retries++;
+        return;
+    }
+
+    res->status = status;
+    res->slave = r->slave;
+    res->function = r->function;
+    res->reg = r->reg;
+    res->count = r->count;
+    res->latency_us = (status == MODBUS_OK) ? (uint32_t)(at_us - mb_cur.start_us) : 0U;
+    if (st != NULL)
+    {
+        st->requests++;
+        if (status == MODBUS_OK)
+        {
+            st->ok++;
+            st->latency_last_us = res->latency_us;
+            if (res->latency_us > st->latency_max_us) st->latency_max_us = res->latency_us;
+            st->latency_sum_us += res->latency_us;
+        }
+        else
+        {
+            st->failed++;
+        }
+        Modbus_UpdateOnline(st, status, at_us);
+    }
+
+    mb_cur.phase = MB_IDLE;
+    if (r->callback != NULL) r->callback(res, r->arg);
+}
+
+void Modbus_Process(void)
+{
+    if (mb_huart == NULL) return;
+    uint64_t now = Timebase_GetMicros();
+
+    // Frame latched by the ISR
+    if (mb_rx_ready)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint16_t size = mb_rx_size;
+        uint64_t rx_us = mb_rx_us;
+        mb_rx_ready = false;
+        __set_PRIMASK(primask);
+
+        if (mb_cur.phase == MB_WAIT)
+        {
+            Modbus_Result_t res;
+            memset(&res, 0, sizeof(res));
+            Modbus_Status_t status = Modbus_Check(size, &res);
+            Modbus_EndAttempt(status, &res, rx_us);
+        }
+        else
+        {
+            mb_unsolicited++;
+            mb_bus_free_us = rx_us + mb_t35_us;
+        }
+    }
+    else if (mb_cur.phase == MB_WAIT && now >= mb_cur.deadline_us)
+    {
+        HAL_UART_AbortReceive(mb_huart);
+        Modbus_Result_t res;
+        memset(&res, 0, sizeof(res));
+        Modbus_EndAttempt(MODBUS_ERR_TIMEOUT, &res, now);
+    }
+
+    // Next request (or the retry) once the bus has been silent for t3.5
+    if (mb_cur.phase == MB_IDLE) Modbus_Pick(now);
+    if (mb_cur.phase == MB_READY && now >= mb_bus_free_us) Modbus_Send(now);
+}
+
+// ISR Callback (Hooked from HAL_UARTEx_RxEventCallback in main.c)
+void Modbus_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size)
+{
+    if (huart != mb_huart) return;
+
+    uint64_t now = Timebase_GetMicros();
+    if (size > sizeof(mb_rx_buf)) size = sizeof(mb_rx_buf);
+    Recorder_Write(REC_SRC_MODBUS, 0, 0, now, mb_rx_buf, size);
+
+    // Reception has ended (idle line or full buffer); the task restarts it
+    mb_rx_size = size;
+    mb_rx_us = now;
+    mb_rx_ready = true;
+}
+
+static Modbus_SlaveStats_t *Modbus_Stats(uint8_t slave)
+{
+    for (uint8_t k = 0; k < MODBUS_MAX_SLAVES; k++)
+    {
+        if (mb_stats[k].slave == slave) return &mb_stats[k];
+        if (mb_stats[k].slave == 0)
+        {
+            mb_stats[k].slave = slave;
+            return &mb_stats[k];
+        }
+    }
+    return NULL;
+}
+
+bool Modbus_GetSlaveStats(uint8_t index, Modbus_SlaveStats_t *stats)
+{
+    if (index >= MODBUS_MAX_SLAVES || stats == NULL || mb_stats[index].slave == 0) return false;
+    *stats = mb_stats[index];
+    return true;
+}
+
+void Modbus_GetStatus(Modbus_MasterStatus_t *status)
+{
+    if (status == NULL) return;
+    status->rate = (uint8_t)mb_rate;
+    status->polls = mb_poll_count;
+    status->queued = mb_queue_count;
+    status->late_polls = mb_late_polls;
+    status->queue_full = mb_queue_full;
+    status->unsolicited = mb_unsolicited;
+}
+
+const char *Modbus_StatusName(Modbus_Status_t status)
+{
+    return (status < MODBUS_ERR_COUNT) ? mb_status_names[status] : "?";
+}
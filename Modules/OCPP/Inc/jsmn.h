@@ -139,6 +139,8 @@ JSMN_STATIC int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 			if (parser->toknext < num_tokens) {
 				token->type = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
 				token->start = parser->pos;
+				token->end = -1; /* Open until the closing bracket */
+				token->size = 0;
 				token->parent = parser->toksuper;
 			}
 			parser->toksuper = parser->toknext;
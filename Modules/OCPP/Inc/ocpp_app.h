@@ -1,12 +1,19 @@
 /**
  * @file    ocpp_app.h
  * @brief   OCPP 1.6J Client Application
+ *
+ * @note    Connectors: connectorId n is firmware connector n - 1. Each
+ *          connector runs at most one transaction, its transactionId is the
+ *          connectorId (the backend's RemoteStop names it).
  */
 
 #ifndef MODULES_OCPP_OCPP_APP_H_
 #define MODULES_OCPP_OCPP_APP_H_
 
 #include "main.h"
+#include "evse_connector.h"
+#include <stdbool.h>
+#include <stddef.h>
 
 typedef enum {
     OCPP_STATE_OFFLINE,
@@ -28,15 +35,31 @@ void OCPP_Init(void);
  */
 void OCPP_Process(void);
 
+/**
+ * @brief Handle a received OCPP message (CALL dispatch)
+ * @note  Called by OCPP_Process() for every frame read from TLS; also the
+ *        entry point for recorded traffic in Tools/replay.
+ * @param json Message text (not necessarily NUL terminated)
+ * @param len Message length
+ */
+void OCPP_HandleCallMessage(const char* json, size_t len);
+
 /**
  * @brief Send StartTransaction
+ * @param conn Connector index
+ */
+void OCPP_SendStartTransaction(uint8_t conn, const char* id_tag);
+
+/**
+ * @brief Send StopTransaction (if the connector has a transaction)
+ * @param conn Connector index
  */
-void OCPP_SendStartTransaction(const char* id_tag);
+void OCPP_SendStopTransaction(uint8_t conn);
 
 /**
- * @brief Send StopTransaction
+ * @brief Transaction running on a connector
  */
-void OCPP_SendStopTransaction(void);
+bool OCPP_IsTransactionActive(uint8_t conn);
 
 /**
  * @brief Send Status Notification
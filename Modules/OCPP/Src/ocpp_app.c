@@ -14,8 +14,10 @@
 #include "mbedtls/x509_crt.h"
 #include <stdio.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "config_manager.h" // For SystemConfig
+#include "recorder.h"
 
 // External Port Functions
 extern int mbedtls_net_send(void *ctx, const unsigned char *buf, size_t len);
@@ -43,13 +45,20 @@ const char *mbedtls_root_ca =
     "r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7r7\r\n"
     "-----END CERTIFICATE-----\r\n";
 
-static OCPP_State_t ocpp_state = OCPP_STATE_OFFLINE;
+static OCPP_State_t ocpp_state = OCPP_STATE_OFFLINE; // CHARGING while any connector transacts
+static bool ocpp_tx_active[EVSE_CONNECTOR_COUNT];
 static uint32_t ocpp_tick = 0;
 
 // Rx Handler Prototypes
 static void Handle_RemoteStartTransaction(jsmntok_t *tokens, int num_tokens, const char *json);
 static void Handle_RemoteStopTransaction(jsmntok_t *tokens, int num_tokens, const char *json);
-static void Handle_CallMessage(const char* json, size_t len);
+
+// TLS write, every outgoing message is recorded
+static void OCPP_Write(const char *buf, size_t len)
+{
+    Recorder_Write(REC_SRC_OCPP, 0, REC_FLAG_TX, Timebase_GetMicros(), (const uint8_t *)buf, (uint16_t)len);
+    mbedtls_ssl_write(&ssl, (const unsigned char *)buf, len);
+}
 
 void OCPP_Init(void)
 {
@@ -78,6 +87,7 @@ void OCPP_Init(void)
     mbedtls_ssl_setup(&ssl, &conf);
     
     ocpp_state = OCPP_STATE_OFFLINE;
+    memset(ocpp_tx_active, 0, sizeof(ocpp_tx_active));
     printf("[OCPP] Initialized (Real TLS with CA).\r\n");
 }
 
@@ -168,7 +178,7 @@ void OCPP_Process(void)
                      cfg->charge_box_id,
                      cfg->server_ip[0], cfg->server_ip[1], cfg->server_ip[2], cfg->server_ip[3], cfg->server_port);
                      
-            mbedtls_ssl_write(&ssl, (unsigned char*)ws_req, strlen(ws_req));
+            OCPP_Write(ws_req, strlen(ws_req));
             
             ocpp_state = OCPP_STATE_BOOTING;
             ocpp_tick = HAL_GetTick();
@@ -179,7 +189,7 @@ void OCPP_Process(void)
             {
                 printf("[OCPP] Sending BootNotification...\r\n");
                 char boot_json[] = "[2, \"1001\", \"BootNotification\", {\"vendor\": \"TestFw\"}]";
-                mbedtls_ssl_write(&ssl, (unsigned char*)boot_json, strlen(boot_json));
+                OCPP_Write(boot_json, strlen(boot_json));
                 
                 ocpp_state = OCPP_STATE_IDLE;
             }
@@ -192,12 +202,13 @@ void OCPP_Process(void)
             if (len > 0)
             {
                 buf[len] = 0; // Null terminate
+                Recorder_Write(REC_SRC_OCPP, 0, 0, Timebase_GetMicros(), buf, (uint16_t)len);
                 printf("[OCPP] RX: %s\r\n", buf);
                 
                 // Simple Check for JSON Array Start
                 if (buf[0] == '[')
                 {
-                    Handle_CallMessage((const char*)buf, (size_t)len);
+                    OCPP_HandleCallMessage((const char*)buf, (size_t)len);
                 }
             }
             else if (len != MBEDTLS_ERR_SSL_WANT_READ && len != MBEDTLS_ERR_SSL_WANT_WRITE && len != 0)
@@ -213,7 +224,7 @@ void OCPP_Process(void)
     }
 }
 
-static void Handle_CallMessage(const char* json, size_t len)
+void OCPP_HandleCallMessage(const char* json, size_t len)
 {
     // [MessageTypeId, "UniqueId", "Action", {Payload}]
     jsmn_parser p;
@@ -345,64 +356,95 @@ static void Handle_RemoteStartTransaction(jsmntok_t *tokens, int num_tokens, con
     strncpy(idTag, json + tokens[idTag_idx].start, len);
     idTag[len] = '\0';
     
-    // 2. Extract connectorId (Optional)
-    // int conn_idx = OCPP_GetJsonToken(tokens, num_tokens, json, 4, "connectorId");
+    // 2. Extract connectorId (Optional, connector 1 if absent)
+    int connector_id = 1;
+    int conn_idx = OCPP_GetJsonToken(tokens, num_tokens, json, 4, "connectorId");
+    if (conn_idx >= 0 && tokens[conn_idx].type == JSMN_PRIMITIVE)
+    {
+        connector_id = atoi(json + tokens[conn_idx].start);
+    }
     
     printf("[OCPP] Remote Request for ID: %s\r\n", idTag);
 
     // Call State Machine
     // We pass the extracted ID Tag instead of hardcoded "REMOTE_USER"
-    if (StateMachine_RemoteStart(idTag))
+    if (EVSE_CONNECTOR_VALID(connector_id) &&
+        StateMachine_RemoteStart(EVSE_CONNECTOR_INDEX(connector_id), idTag))
     {
         // Accepted
         char resp[] = "[3, \"100x\", {\"status\": \"Accepted\"}]"; // TODO: UniqueID sync
-        mbedtls_ssl_write(&ssl, (unsigned char*)resp, strlen(resp));
+        OCPP_Write(resp, strlen(resp));
     }
     else
     {
         char resp[] = "[3, \"100x\", {\"status\": \"Rejected\"}]";
-        mbedtls_ssl_write(&ssl, (unsigned char*)resp, strlen(resp));
+        OCPP_Write(resp, strlen(resp));
     }
 }
 
 static void Handle_RemoteStopTransaction(jsmntok_t *tokens, int num_tokens, const char *json)
 {
     printf("[OCPP] Handling Remote Stop...\r\n");
-    if (StateMachine_RemoteStop())
+
+    // transactionId = connectorId (connector 1 if absent)
+    int transaction_id = 1;
+    int tx_idx = (num_tokens > 4) ? OCPP_GetJsonToken(tokens, num_tokens, json, 4, "transactionId") : -1;
+    if (tx_idx >= 0 && tokens[tx_idx].type == JSMN_PRIMITIVE)
+    {
+        transaction_id = atoi(json + tokens[tx_idx].start);
+    }
+
+    if (EVSE_CONNECTOR_VALID(transaction_id) &&
+        StateMachine_RemoteStop(EVSE_CONNECTOR_INDEX(transaction_id)))
     {
          char resp[] = "[3, \"100x\", {\"status\": \"Accepted\"}]";
-         mbedtls_ssl_write(&ssl, (unsigned char*)resp, strlen(resp));
+         OCPP_Write(resp, strlen(resp));
     }
     else
     {
          char resp[] = "[3, \"100x\", {\"status\": \"Rejected\"}]";
-         mbedtls_ssl_write(&ssl, (unsigned char*)resp, strlen(resp));
+         OCPP_Write(resp, strlen(resp));
     }
 }
 
 
-void OCPP_SendStartTransaction(const char* id_tag)
+void OCPP_SendStartTransaction(uint8_t conn, const char* id_tag)
 {
     if (ocpp_state != OCPP_STATE_IDLE && ocpp_state != OCPP_STATE_CHARGING) return;
+    if (conn >= EVSE_CONNECTOR_COUNT) return;
     
     char buf[256];
-    snprintf(buf, sizeof(buf), "[2, \"1002\", \"StartTransaction\", {\"connectorId\": 1, \"idTag\": \"%s\", \"meterStart\": 0, \"timestamp\": \"2026-02-02T12:00:00Z\"}]", id_tag);
+    snprintf(buf, sizeof(buf), "[2, \"1002\", \"StartTransaction\", {\"connectorId\": %d, \"idTag\": \"%s\", \"meterStart\": 0, \"timestamp\": \"2026-02-02T12:00:00Z\"}]",
+             EVSE_CONNECTOR_ID(conn), id_tag);
     printf("[OCPP] Tx Start: %s\r\n", buf);
-    mbedtls_ssl_write(&ssl, (unsigned char*)buf, strlen(buf));
+    OCPP_Write(buf, strlen(buf));
     
+    ocpp_tx_active[conn] = true;
     ocpp_state = OCPP_STATE_CHARGING;
 }
 
-void OCPP_SendStopTransaction(void)
+void OCPP_SendStopTransaction(uint8_t conn)
 {
     if (ocpp_state != OCPP_STATE_CHARGING) return;
+    if (conn >= EVSE_CONNECTOR_COUNT || !ocpp_tx_active[conn]) return;
     
     char buf[256];
-    snprintf(buf, sizeof(buf), "[2, \"1003\", \"StopTransaction\", {\"idTag\": \"REMOTE_USER\", \"meterStop\": 100, \"timestamp\": \"2026-02-02T13:00:00Z\", \"transactionId\": 1}]");
+    snprintf(buf, sizeof(buf), "[2, \"1003\", \"StopTransaction\", {\"idTag\": \"REMOTE_USER\", \"meterStop\": 100, \"timestamp\": \"2026-02-02T13:00:00Z\", \"transactionId\": %d}]",
+             EVSE_CONNECTOR_ID(conn));
     printf("[OCPP] Tx Stop: %s\r\n", buf);
-    mbedtls_ssl_write(&ssl, (unsigned char*)buf, strlen(buf));
+    OCPP_Write(buf, strlen(buf));
     
-    ocpp_state = OCPP_STATE_IDLE;
+    ocpp_tx_active[conn] = false;
+
+    // Back to IDLE with the last transaction
+    bool any = false;
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++) any = any || ocpp_tx_active[c];
+    if (!any) ocpp_state = OCPP_STATE_IDLE;
+}
+
+bool OCPP_IsTransactionActive(uint8_t conn)
+{
+    return (conn < EVSE_CONNECTOR_COUNT) && ocpp_tx_active[conn];
 }
 
 void OCPP_SendStatusNotification(int connectorId, const char* status, const char* error_code)
@@ -412,17 +454,18 @@ void OCPP_SendStatusNotification(int connectorId, const char* status, const char
      char buf[256];
      snprintf(buf, sizeof(buf), "[2, \"1004\", \"StatusNotification\", {\"connectorId\": %d, \"errorCode\": \"%s\", \"status\": \"%s\"}]", connectorId, error_code, status);
      printf("[OCPP] Tx Status: %s\r\n", buf);
-     mbedtls_ssl_write(&ssl, (unsigned char*)buf, strlen(buf));
+     OCPP_Write(buf, strlen(buf));
 }
 
 void OCPP_SendMeterValues(int connectorId, float power_w, float energy_wh, int soc)
 {
      if (ocpp_state != OCPP_STATE_CHARGING) return;
+     if (!EVSE_CONNECTOR_VALID(connectorId) || !ocpp_tx_active[EVSE_CONNECTOR_INDEX(connectorId)]) return;
      
      char buf[512];
-     snprintf(buf, sizeof(buf), "[2, \"1005\", \"MeterValues\", {\"connectorId\": %d, \"transactionId\": 1, \"meterValue\": [{\"timestamp\": \"2026-02-02T12:30:00Z\", \"sampledValue\": [{\"value\": \"%.2f\", \"unit\": \"W\"}, {\"value\": \"%.2f\", \"unit\": \"Wh\"}, {\"value\": \"%d\", \"unit\": \"Percent\"}]}]}]", 
-              connectorId, power_w, energy_wh, soc);
+     snprintf(buf, sizeof(buf), "[2, \"1005\", \"MeterValues\", {\"connectorId\": %d, \"transactionId\": %d, \"meterValue\": [{\"timestamp\": \"2026-02-02T12:30:00Z\", \"sampledValue\": [{\"value\": \"%.2f\", \"unit\": \"W\"}, {\"value\": \"%.2f\", \"unit\": \"Wh\"}, {\"value\": \"%d\", \"unit\": \"Percent\"}]}]}]", 
+              connectorId, connectorId, power_w, energy_wh, soc);
               
     //  printf("[OCPP] Tx MeterValues\r\n"); // Verbose
-     mbedtls_ssl_write(&ssl, (unsigned char*)buf, strlen(buf));
+     OCPP_Write(buf, strlen(buf));
 }
@@ -11,28 +11,196 @@
  * @attention
  *          User requested sufficient comments for Power Module Control.
  *          This driver abstracts the CAN communication.
+ *
+ * @note    Status aggregation is incremental: the module table is kept as
+ *          struct-of-arrays with alive/on/fault bitmasks, each status frame
+ *          updates the sums in the CAN task and Infy_Process() times out
+ *          silent modules at a fixed rate. Infy_GetSystemStatus() only
+ *          copies the published aggregate (seqlock, O(1)). Readers must not
+ *          run above the CAN task, which is the only writer.
+ *
+ * @note    Discovery and staging: module n answers on status ID base + n
+ *          (n = 0..INFY_MAX_MODULES-1, one extended filter) and is
+ *          discovered by its first status frame; its Infy_Info frame (rated
+ *          power, efficiency sweet spot) replaces the defaults below.
+ *          Modules are staged in groups of INFY_GROUP_SIZE (group = n / 8):
+ *          Infy_Process() runs just enough groups that the demanded power
+ *          sits near their sweet spot, and broadcasts the group mask in the
+ *          Infy_Stage frame. The per-module current is split across the
+ *          alive, fault-free modules of the staged groups only.
+ *
+ * @note    Current sharing: the broadcast carries the equal share, each
+ *          module gets a unicast Infy_Trim on top. Infy_Process() steps a
+ *          module's trim towards the mean of the measured currents on every
+ *          new status frame (trims sum to zero, so the total is unchanged)
+ *          until all modules are within INFY_SHARE_TOL_PCT. A module that
+ *          times out or faults leaves the share at the next Infy_Process():
+ *          the broadcast share is recomputed for the rest and its trim is
+ *          spread over them in the same call.
+ *
+ * @note    Fast path: Infy_SetOutputFast() (SECC demand, from the urgent
+ *          RX ISR) rebuilds the setpoint and queues the control frame at
+ *          once instead of waiting for the control loop and the scheduler
+ *          tick. The RX SOF to control frame SOF latency is measured with
+ *          the CAN driver's TX probe (Infy_GetFastStats()). The regulator
+ *          only takes it for demand cuts (PowerReg_SetTargetFast()): a
+ *          higher demand waits for the next PowerReg_Tick() and its ramp,
+ *          up to PREG_PERIOD_MS plus the scheduler slot, so the
+ *          INFY_FAST_BUDGET_US bound holds for reductions only.
+ *
+ * @note    Output ranges: a module runs its two output stages in parallel
+ *          (LOW, up to INFY_RANGE_LOW_V_MAX at the full module current) or
+ *          in series (HIGH, up to INFY_RANGE_HIGH_V_MAX at
+ *          INFY_RANGE_HIGH_CURRENT_PCT of it), always capped at its rated
+ *          power. The Infy_Range frame commands the range per group and a
+ *          module only switches while its output is off. Infy_Process()
+ *          stages only groups whose command matches the requested range and
+ *          whose alive modules all report it; a group in the other range is
+ *          taken out of the staging, its command changes once it is off (not
+ *          staged or output disabled), so a group never runs in a mixed or
+ *          unconfirmed range. The state machine picks the range
+ *          from the EV voltage at the start of the pre-charge
+ *          (Infy_SelectRange / Infy_SetRange): LOW gives 400 V vehicles the
+ *          full current, HIGH gives 800 V vehicles the full power.
+ *
+ * @note    Extended status: temperatures, AC input, the full fault word and
+ *          the derating state are not in the status frame. Infy_Process()
+ *          polls them with unicast Infy_Query frames, one module per query,
+ *          each item at its own period (INFY_POLL_*_MS per module). Queries
+ *          and their replies are charged to a wire-time budget of
+ *          INFY_POLL_LOAD_PERMILLE of the bus, so with more modules than the
+ *          budget covers the rounds stretch instead of the bus load growing.
+ *
+ * @note    Outlets: with several connectors (EVSE_CONNECTOR_COUNT) every
+ *          connector has its own output bus, fed by the groups the
+ *          allocation matrix (power_alloc) switched onto it. Each outlet
+ *          keeps its own demand, range, staging, current split, sharing
+ *          loop and control frame; the control frame's group_mask names the
+ *          groups that take it. Infy_AssignGroup() moves a group between
+ *          outlets (only once it is off, the matrix contactor is switched
+ *          by the caller). A single-outlet build owns every group and sends
+ *          group_mask 0 (all groups), as before the matrix.
  */
 
 #ifndef MODULES_POWER_INFY_POWER_H_
 #define MODULES_POWER_INFY_POWER_H_
 
 #include "main.h"
+#include "can_driver.h"
+#include "can_sched.h"
+#include "can_db_power.h" // Generated from Tools/dbc/power.dbc
+#include "evse_connector.h"
 #include <stdbool.h>
 
-// --- Configuration ---
 // --- Configuration ---
 #define INFY_USE_SIMULATION  0       // 1=Simulate Response, 0=Real CAN
-#define INFY_MAX_MODULES     10      // Max modules for 350kW+ (40kW * 10 = 400kW)
+#ifndef INFY_MAX_MODULES
+#define INFY_MAX_MODULES     64      // Module addresses 0..MAX-1 (40kW * 10 = 400kW cabinet), up to 64
+#endif
+#define INFY_GROUP_SIZE      8       // Modules per staging group (Group g = modules 8g..8g+7)
+#define INFY_GROUP_COUNT     (INFY_MAX_MODULES / INFY_GROUP_SIZE) // Up to 8 (Stage frame mask)
+#define INFY_SIM_MODULES     10      // Modules answering in simulation
+#define INFY_COMM_TIMEOUT_US (1 * TIMEBASE_US_PER_SEC) // Status frame timeout (wire time)
+#define INFY_OUTLETS         EVSE_CONNECTOR_COUNT // Output buses (one per connector)
+#define INFY_OUTLET_NONE     0xFFU   // Group switched to no outlet
+
+// Module Ratings (Until the module's Infy_Info frame arrives)
+#define INFY_MODULE_RATED_KW       40.0f
+#define INFY_MODULE_MAX_CURRENT_A  100.0f  // LOW range
+#define INFY_MODULE_SWEET_PCT      60      // Load at peak efficiency (% of rated power)
+
+// Output Ranges (LOW: stages in parallel, HIGH: in series)
+#define INFY_RANGE_LOW_V_MIN        150.0f
+#define INFY_RANGE_LOW_V_MAX        500.0f
+#define INFY_RANGE_HIGH_V_MIN       300.0f
+#define INFY_RANGE_HIGH_V_MAX       1000.0f
+#define INFY_RANGE_HIGH_CURRENT_PCT 50      // HIGH current limit (% of the module max current)
+#define INFY_RANGE_MARGIN_V         20.0f   // LOW only if the EV stays this far below LOW_V_MAX
+#define INFY_RANGE_DEFAULT          INFY_RANGE_LOW // Until the first Infy_SetRange()
+
+// Staging Policy (Power demand vs. the staged groups)
+#define INFY_STAGING_ENABLE   1       // 0 = Always run every group
+#define INFY_STAGE_UP_PCT     120     // Add a group above this % of the staged sweet-spot power
+#define INFY_STAGE_MAX_PCT    90      // ... or above this % of the staged rated power
+#define INFY_STAGE_DOWN_PCT   80      // Drop a group if demand stays below this % of the rest's sweet spot
+#define INFY_STAGE_DWELL_MS   5000    // Min time after a change before dropping a group
+
+// Current Sharing (Closed loop on the measured module currents)
+#define INFY_SHARE_ENABLE          1       // 0 = Equal broadcast share only
+#define INFY_SHARE_GAIN_PCT        50      // Trim step per status frame (% of the deviation)
+#define INFY_SHARE_TRIM_MAX_A      10.0f   // Trim limit per module
+#define INFY_SHARE_TRIM_STEP_A     0.2f    // Min trim change worth a unicast frame
+#define INFY_SHARE_MIN_CURRENT_A   2.0f    // Below this mean current the trims are released
+#define INFY_SHARE_TOL_PCT         5       // Converged: all within this % of the mean ...
+#define INFY_SHARE_TOL_MIN_A       0.5f    // ... or within this many A
+#define INFY_TRIM_FRAMES_PER_CALL  2       // Unicast trims per Infy_Process() (bus load)
+
+// Extended Status Polling (Infy_Query per module, round robin within a bus budget)
+#define INFY_POLL_ENABLE           1       // 0 = Status and info frames only
+#define INFY_POLL_TEMPS_MS         1000    // Period per module and item (0 = not polled)
+#define INFY_POLL_AC_MS            5000
+#define INFY_POLL_FAULTS_MS        1000
+#define INFY_POLL_DERATE_MS        2000
+#define INFY_POLL_LOAD_PERMILLE    100     // Bus share for queries + replies (periods stretch above it)
+#define INFY_POLL_BURST            4       // Query + reply pairs the unused budget may save up
+#define INFY_POLL_QUERIES_PER_CALL 4       // Queries per Infy_Process() (TX queue)
+#define INFY_POLL_MAX_LAG_MS       1000    // Backlog an overloaded item may keep
+
+// Control Frame Scheduling (125 kbps bus: ~1ms per frame)
+#define INFY_CONTROL_PERIOD_MS        100 // Keep-alive repeat of the setpoint
+#define INFY_CONTROL_OFFSET_MS        5   // Clear of the 10ms grid the state machine runs on
+#define INFY_CONTROL_STRIDE_MS        10  // Offset between the outlets' control frames
+#define INFY_CONTROL_MIN_INTERVAL_MS  10  // Minimum gap between change-triggered sends
+#define INFY_STAGE_PERIOD_MS          100 // Keep-alive repeat of the group mask
+#define INFY_STAGE_OFFSET_MS          55  // Half a period after the control frame
+#define INFY_RANGE_PERIOD_MS          100 // Keep-alive repeat of the range mask
+#define INFY_RANGE_OFFSET_MS          30  // Between the control and the stage frame
+#define INFY_FAST_BUDGET_US           1000 // Demand SOF -> control frame SOF target (cuts)
 
 // --- CAN Identifiers (Assumed) ---
 // Control: PGN 0xFF00, Priority 6 -> 0x18FF00xx
-#define INFY_CAN_ID_CONTROL_BASE  0x18005000 // Broadcast to all modules
-#define INFY_CAN_ID_STATUS_BASE   0x18005001 // Base Response ID (0x..01 ~ 0x..0A)
+#define INFY_CAN_ID_CONTROL_BASE  INFY_CONTROL_ID // 0x18005000 Broadcast to all modules
+#define INFY_CAN_ID_STAGE         INFY_STAGE_ID   // 0x18005100 Broadcast group mask
+#define INFY_CAN_ID_STATUS_BASE   INFY_STATUS_ID  // 0x18005001 Base Response ID (0x..01 ~ 0x..40)
+#define INFY_CAN_ID_STATUS_LAST   (INFY_CAN_ID_STATUS_BASE + INFY_MAX_MODULES - 1)
+#define INFY_CAN_ID_INFO_BASE     INFY_INFO_ID    // 0x18005201 Module rating (0x..01 ~ 0x..40)
+#define INFY_CAN_ID_INFO_LAST     (INFY_CAN_ID_INFO_BASE + INFY_MAX_MODULES - 1)
+#define INFY_CAN_ID_TRIM_BASE     INFY_TRIM_ID    // 0x18005301 Unicast current trim (0x..01 ~ 0x..40)
+#define INFY_CAN_ID_RANGE         INFY_RANGE_ID   // 0x18005400 Broadcast range mask
+#define INFY_CAN_ID_QUERY_BASE    INFY_QUERY_ID   // 0x18005501 Unicast extended status request (0x..01 ~ 0x..40)
+#define INFY_CAN_ID_POLL_FIRST    INFY_TEMPS_ID   // 0x18005601 Replies: Temps, AcInput, Faults, Derate ...
+#define INFY_CAN_ID_POLL_LAST     (INFY_DERATE_ID + INFY_MAX_MODULES - 1) // ... 0x18005940 (one filter)
 
 // --- Data Structures ---
 
 /**
- * @brief Power Module Status Structure (Individual)
+ * @brief Module Output Range
+ */
+typedef enum {
+    INFY_RANGE_LOW = 0,      // INFY_RANGE_LOW_V_MIN..LOW_V_MAX, full current
+    INFY_RANGE_HIGH = 1,     // INFY_RANGE_HIGH_V_MIN..HIGH_V_MAX, reduced current
+} Infy_OutputRange_t;
+
+/**
+ * @brief Extended Status Items (Infy_Query item = value + 1)
+ */
+typedef enum {
+    INFY_POLL_TEMPS = 0,     // Infy_Temps
+    INFY_POLL_AC,            // Infy_AcInput
+    INFY_POLL_FAULTS,        // Infy_Faults
+    INFY_POLL_DERATE,        // Infy_Derate
+    INFY_POLL_ITEMS
+} Infy_PollItem_t;
+
+// Module Bitmask (Bit n = module index n)
+#if INFY_MAX_MODULES <= 32
+typedef uint32_t Infy_Mask_t;
+#else
+typedef uint64_t Infy_Mask_t;
+#endif
+
+/**
+ * @brief Power Module Status Structure (Individual, copy of the table row)
  */
 typedef struct {
     float output_voltage;    // Measured Output Voltage (V)
@@ -42,19 +210,124 @@ typedef struct {
     bool  fault_uv;          // Under Voltage
     bool  fault_ot;          // Over Temp
     bool  comm_timeout;      // Communication Lost
-    uint32_t last_rx_tick;   // For timeout logic
+    bool  discovered;        // Reported at least once since boot
+    bool  range_high;        // Reports the HIGH range
+    float rated_kw;          // Rated Power (Infy_Info or default)
+    float max_current;       // Current Limit (A)
+    uint8_t sweet_pct;       // Load at peak efficiency (% of rated)
+    float current_trim;      // Sharing trim on top of the broadcast current (A)
+    uint64_t last_rx_us;     // SOF of last status frame (Timebase)
+    // Extended status (polled, valid per item once answered, see polled)
+    uint8_t polled;          // Bit i = item i answered since the module came alive
+    int8_t temp_inlet;       // degC
+    int8_t temp_pfc;
+    int8_t temp_dcdc;
+    float ac_voltage[3];     // Line voltages AB, BC, CA (V)
+    uint32_t fault_word;     // Vendor fault bits (0 = none)
+    uint8_t derate_pct;      // Available power (% of rated, 100 = not derated)
+    uint8_t derate_reason;   // Bit 0 = temperature, 1 = AC input, 2 = output voltage
 } Infy_ModuleStatus_t;
 
 /**
  * @brief System Status Structure (Aggregated)
  */
 typedef struct {
-    float total_voltage;     // System Voltage (Max or Avg)
-    float total_current;     // System Total Current (Sum)
+    float total_voltage;     // System Voltage (Max of alive modules)
+    float total_current;     // System Total Current (Sum of alive modules)
     int   active_modules;    // Count of healthy modules
     bool  system_fault;      // Any module fault
+    Infy_Mask_t alive_mask;  // Status frame within INFY_COMM_TIMEOUT_US
+    Infy_Mask_t on_mask;     // Alive and output on
+    Infy_Mask_t fault_mask;  // Alive and reporting a fault
+    Infy_Mask_t discovered_mask; // Reported at least once since boot
+    uint8_t stage_mask;      // Groups commanded to run, all outlets (Bit g = group g)
+    int   running_modules;   // Alive, fault-free modules of the staged groups (current split)
+    uint8_t range_high_mask; // Groups commanded to the HIGH range
+    uint8_t range_ready_mask;// Groups whose alive modules all report their commanded range
 } Infy_SystemStatus_t;
 
+/**
+ * @brief Outlet Status (Groups switched onto one connector's output bus)
+ */
+typedef struct {
+    float voltage;           // Max of its alive modules (V)
+    float current;           // Sum of its alive modules (A)
+    uint8_t groups;          // Assigned groups (Bit g = group g)
+    uint8_t stage_mask;      // Staged groups (subset of groups)
+    Infy_Mask_t modules;     // Module bits of its groups
+    Infy_Mask_t on_mask;     // Its alive modules with the output on
+    int   alive_modules;     // Alive modules of its groups
+    int   usable_modules;    // Alive, fault-free modules of its groups
+    int   running_modules;   // ... of the staged groups (current split)
+    float rated_kw;          // Alive, fault-free modules of its groups
+    bool  enable;            // Demand (Infy_SetOutput)
+    float demand_volts;
+    float demand_amps;
+    Infy_OutputRange_t range; // Requested range (Infy_SetRange)
+} Infy_OutletStatus_t;
+
+/**
+ * @brief Current Sharing Status (Imbalance metrics)
+ */
+typedef struct {
+    bool  active;            // Loop trimming (output on, >= 2 modules, mean above the minimum)
+    bool  converged;         // All sharing modules within tolerance
+    int   modules;           // Modules sharing the current (running)
+    float mean_current;      // Measured mean per module (A)
+    float max_deviation;     // Worst |measured - mean| (A)
+    float imbalance_pct;     // max_deviation / mean_current * 100
+    int   worst_module;      // Module with the worst deviation (-1 = none)
+    uint32_t trim_frames;    // Unicast trims sent
+    uint32_t trim_drops;     // Trims the TX queue rejected (retried)
+    uint32_t failovers;      // Modules that left the share (timeout, fault) while on
+} Infy_ShareStatus_t;
+
+/**
+ * @brief Fast Path Statistics (Demand frame -> control frame)
+ * @note  Demand cuts only; rises are counted in PowerReg_Status_t fast_rises.
+ */
+typedef struct {
+    uint32_t triggers;       // Infy_SetOutputFast() calls (demand cuts)
+    uint32_t sent;           // Control frames queued at once
+    uint32_t unchanged;      // Same setpoint, nothing to send
+    uint32_t rejected;       // Output off or TX queue full (the loop / scheduler sends)
+    uint32_t queue_last_us;  // Demand SOF -> control frame queued
+    uint32_t queue_max_us;
+    uint32_t wire_last_us;   // Demand SOF -> control frame SOF on the power bus
+    uint32_t wire_max_us;
+    uint32_t over_budget;    // wire latency above INFY_FAST_BUDGET_US
+} Infy_FastStats_t;
+
+/**
+ * @brief Extended Status Polling Statistics
+ */
+typedef struct {
+    uint32_t queries;        // Infy_Query frames sent
+    uint32_t replies;        // Item frames received
+    uint32_t budget_holds;   // Calls that left a due query to the next one (bus budget)
+    uint32_t tx_drops;       // Queries the TX queue rejected (retried)
+    uint32_t budget_ns_per_s; // Wire time the budget allows (queries + replies)
+    uint32_t used_ns_per_s;  // Wire time spent, last second
+    uint32_t round_ms[INFY_POLL_ITEMS]; // Last full round of an item over the alive modules
+} Infy_PollStatus_t;
+
+/**
+ * @brief Staging Group Status
+ */
+typedef struct {
+    uint8_t discovered;      // Modules discovered
+    uint8_t alive;           // Modules alive
+    uint8_t usable;          // Modules alive and fault-free
+    uint8_t on;              // Modules alive with the output on
+    uint8_t outlet;          // Outlet it is switched to (INFY_OUTLET_NONE = none)
+    bool  staged;            // Commanded to run
+    bool  range_high;        // Commanded to the HIGH range
+    bool  range_ready;       // All alive modules report it (may be staged)
+    float voltage;           // Highest output voltage its alive modules report (V)
+    float rated_kw;          // Alive modules
+    float sweet_kw;          // Alive modules, power at their sweet spot
+} Infy_GroupStatus_t;
+
 /**
  * @brief Initialize Power Module Driver
  * @param hfdcan Ptr to CAN handle
@@ -62,28 +335,125 @@ typedef struct {
 void Infy_Init(FDCAN_HandleTypeDef *hfdcan);
 
 /**
- * @brief Send Control Command to Power Module
- * @note  Call this periodically (e.g. 50ms or 100ms).
- *        Modules usually timeout if command is missing for >1s.
+ * @brief Set Control Command for the Power Modules of an Outlet
+ * @note  Only stores the setpoint; calling it every control cycle is cheap.
+ *        The demand (V * A) drives the staging in Infy_Process(), the
+ *        current is split across the alive modules of the outlet's staged
+ *        groups.
+ *        The scheduler sends it when it changes (at most every
+ *        INFY_CONTROL_MIN_INTERVAL_MS) and every INFY_CONTROL_PERIOD_MS as
+ *        keep-alive (modules usually timeout if command is missing for >1s).
  *
- * @param target_volts  Target Voltage (V). Range: 150-1000V
- * @param target_amps   Target Current (A). Range: 0-100A
+ * @param outlet        Outlet (connector index)
+ * @param target_volts  Target Voltage (V), clamped to the requested range
+ * @param target_amps   Target Current (A, total), per module up to Infy_RangeCurrentLimit()
  * @param enable        Output Enable (True=ON, False=OFF/Safe)
  */
-void Infy_SetOutput(float target_volts, float target_amps, bool enable);
+void Infy_SetOutput(uint8_t outlet, float target_volts, float target_amps, bool enable);
+
+/**
+ * @brief Apply a new demand and send the control frame now (task or ISR)
+ * @note  Only while the output is enabled (Infy_SetOutput(..., true) owns
+ *        the enable); the caller clamps to the EV and charger limits.
+ *        The regulator calls it for demand cuts only, a rise goes out with
+ *        the next tick (see the fast path note above).
+ *        An unchanged setpoint sends nothing. The latency probe matches
+ *        the control frame ID and the outlet's group mask, so another
+ *        outlet's frame on the shared ID is not measured.
+ * @param outlet       Outlet (connector index)
+ * @param target_volts Target Voltage (V)
+ * @param target_amps  Target Current (A, total)
+ * @param trigger_us   SOF of the frame that carried the demand (latency)
+ * @return false if the output is off or the TX queue was full
+ */
+bool Infy_SetOutputFast(uint8_t outlet, float target_volts, float target_amps, uint64_t trigger_us);
+
+/**
+ * @brief Get Fast Path Statistics (Latency of Infy_SetOutputFast)
+ */
+void Infy_GetFastStats(Infy_FastStats_t *stats);
+
+/**
+ * @brief Get Extended Status Polling Statistics
+ */
+void Infy_GetPollStatus(Infy_PollStatus_t *status);
+
+/**
+ * @brief Range for an EV voltage (LOW if it stays INFY_RANGE_MARGIN_V below
+ *        INFY_RANGE_LOW_V_MAX)
+ * @param ev_volts Highest voltage the EV may ask for (max or target voltage)
+ */
+Infy_OutputRange_t Infy_SelectRange(float ev_volts);
+
+/**
+ * @brief Request an output range for the groups of an outlet (any task)
+ * @note  Call while the output is off (before the pre-charge): groups in
+ *        the other range are unstaged and switched, and staged again once
+ *        their modules confirm; the output stays at 0 A until then. Groups
+ *        switched onto the outlet later follow the same request.
+ */
+void Infy_SetRange(uint8_t outlet, Infy_OutputRange_t range);
+
+/**
+ * @brief Switch a group to an outlet, or to none (CAN task)
+ * @note  The group leaves its previous outlet's staging, sums and sharing
+ *        at once; the new outlet stages it (range permitting) from the next
+ *        Infy_Process(). Move only groups whose modules are off, with the
+ *        matrix contactor opened in between (power_alloc does both).
+ * @param group  Group Index (0 ~ INFY_GROUP_COUNT-1)
+ * @param outlet Outlet, INFY_OUTLET_NONE = unassigned (held off)
+ * @return false if an index is out of range
+ */
+bool Infy_AssignGroup(uint8_t group, uint8_t outlet);
+
+/**
+ * @brief Get Outlet Status (Its groups, measured output and demand)
+ * @return false if outlet is out of range
+ */
+bool Infy_GetOutletStatus(uint8_t outlet, Infy_OutletStatus_t *status);
+
+/**
+ * @brief Per-module current limit at a voltage (range current, rated power)
+ */
+float Infy_RangeCurrentLimit(Infy_OutputRange_t range, float volts);
 
 /**
  * @brief Get Latest System Status (Aggregated)
- * @return Information about Total V/I
+ * @note  O(1) consistent snapshot, the aggregate is maintained on RX.
+ * @param status Output: Total V/I, module counts and masks
  */
-const Infy_SystemStatus_t* Infy_GetSystemStatus(void);
+void Infy_GetSystemStatus(Infy_SystemStatus_t *status);
 
 /**
  * @brief Get Individual Module Status
  * @param index Module Index (0 ~ MAX-1)
- * @return Pointer to module status
+ * @param status Output: copy of the module's row
+ * @return false if index is out of range
+ */
+bool Infy_GetModuleStatus(uint8_t index, Infy_ModuleStatus_t *status);
+
+/**
+ * @brief Get Current Sharing Status of an Outlet (Imbalance metrics)
+ * @note  Updated by every Infy_Process().
+ */
+void Infy_GetShareStatus(uint8_t outlet, Infy_ShareStatus_t *status);
+
+/**
+ * @brief Get Staging Group Status
+ * @param group Group Index (0 ~ INFY_GROUP_COUNT-1)
+ * @param status Output: module counts and power of the group
+ * @return false if group is out of range
+ */
+bool Infy_GetGroupStatus(uint8_t group, Infy_GroupStatus_t *status);
+
+/**
+ * @brief Time out silent modules, report discoveries, stage groups, trim
+ *        the current shares (CAN task)
+ * @note  Call at a fixed rate, every CAN_HEALTH_PERIOD_MS with the health
+ *        processing. Cost is one age check per alive module plus a few
+ *        per-group sums.
  */
-const Infy_ModuleStatus_t* Infy_GetModuleStatus(uint8_t index);
+void Infy_Process(void);
 
 /**
  * @brief Check if Power System is Healthy
@@ -92,11 +462,9 @@ const Infy_ModuleStatus_t* Infy_GetModuleStatus(uint8_t index);
 bool Infy_IsHealthy(void);
 
 /**
- * @brief Handle Incoming CAN Messages
- * @param id CAN ID
- * @param data Payload
- * @param len Length
+ * @brief Handle Incoming CAN Messages (Called from CAN task via route table)
+ * @param msg Received frame (29-bit status or info ID)
  */
-void Infy_RxHandler(uint32_t id, uint8_t *data, uint8_t len);
+void Infy_RxHandler(const CAN_Message_t *msg);
 
 #endif /* MODULES_POWER_INFY_POWER_H_ */
@@ -0,0 +1,109 @@
+/**
+ * @file    power_alloc.h
+ * @brief   Power Module Allocation Matrix (Module Groups -> Connectors)
+ *
+ * @note    With more than one connector the Infy module groups are a shared
+ *          pool: each group's matrix contactor (Relay_SetMatrix) puts it on
+ *          one connector's output bus, and Infy_AssignGroup() gives it that
+ *          outlet's setpoint. PowerAlloc_Process() sizes every connector to
+ *          its present need (the regulator's current target, derated) and
+ *          moves groups as the needs change: a tapering car gives groups up
+ *          to one that is ramping, so the cabinet's modules follow the
+ *          demand instead of sitting idle behind a fixed split.
+ *
+ * @note    Policy, every PALLOC_PERIOD_MS:
+ *          - A connector whose regulator is disabled releases its groups.
+ *          - An enabled one wants enough groups to carry its need plus
+ *            PALLOC_HEADROOM_PCT, at least one (pre-charge).
+ *          - Free groups go to the connector with the largest shortfall.
+ *          - Without free groups, the wants are cut to a fair share (one
+ *            group each, the rest by shortfall) and the connector with the
+ *            largest surplus gives one group up, no sooner than
+ *            PALLOC_DWELL_MS after its last change. A connector that has
+ *            what it wants keeps it while no one else is short: a move
+ *            costs contactor cycles and a ramp.
+ *
+ * @note    A move is break-before-make, one group at a time per step:
+ *          unassign (the outlet unstages it, the modules switch off), wait
+ *          until none of its modules reports its output on (at least
+ *          PALLOC_OFF_MIN_MS), open the contactor, wait PALLOC_CONTACTOR_MS,
+ *          close it onto the new connector, wait again, assign. The
+ *          contactors never switch load current and two output buses are
+ *          never tied together (the relay driver interlocks that as well).
+ *
+ * @note    A group is only closed onto a connector (a move or a free group)
+ *          with its output discharged (PALLOC_DISCHARGED_V) or within
+ *          PALLOC_MATCH_V of the connector's bus: the highest voltage of
+ *          the connector's modules, or of its meter with the main relay
+ *          closed (the EV battery). A move waits up to
+ *          PALLOC_CLOSE_TIMEOUT_MS for the output capacitors to bleed down,
+ *          then leaves the group free.
+ *
+ * @note    A single-connector build has no matrix: the one outlet owns every
+ *          group and PowerAlloc_Process() does nothing.
+ */
+
+#ifndef MODULES_POWER_POWER_ALLOC_H_
+#define MODULES_POWER_POWER_ALLOC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "evse_connector.h"
+#include "infy_power.h"
+
+// --- Configuration ---
+#define PALLOC_PERIOD_MS        100     // Evaluation period (CAN task)
+#define PALLOC_HEADROOM_PCT     110     // Capacity wanted (% of the connector's need)
+#define PALLOC_DWELL_MS         5000    // A connector gives up a group no sooner after its last change
+#define PALLOC_OFF_MIN_MS       200     // Released group: off for at least this long (status frame delay)
+#define PALLOC_OFF_TIMEOUT_MS   2000    // ... logged if a module still reports its output on after this
+#define PALLOC_CONTACTOR_MS     50      // Matrix contactor operate + bounce time
+#define PALLOC_DISCHARGED_V     60.0f   // Group output at or below: closed onto any bus
+#define PALLOC_MATCH_V          20.0f   // ... or at most this far from the connector's bus
+#define PALLOC_CLOSE_TIMEOUT_MS 10000   // A move waiting for either gives the group up after this
+#define PALLOC_MIN_VOLTS        200.0f  // Group capacity taken at this voltage below it (pre-charge)
+
+typedef enum
+{
+    PALLOC_GROUP_IDLE = 0,   // On its connector (or free, contactors open)
+    PALLOC_GROUP_DRAIN,      // Unassigned, waiting for its modules to switch off
+    PALLOC_GROUP_OPEN,       // Contactor opened, waiting
+    PALLOC_GROUP_CLOSE,      // Contactor closed onto the new connector, waiting
+} PowerAlloc_Phase_t;
+
+typedef struct
+{
+    uint8_t  owner[INFY_GROUP_COUNT];      // Connector whose contactor is closed (INFY_OUTLET_NONE = free)
+    uint8_t  dest[INFY_GROUP_COUNT];       // Connector of a move in progress (INFY_OUTLET_NONE = release)
+    uint8_t  phase[INFY_GROUP_COUNT];      // PowerAlloc_Phase_t
+    bool     active[EVSE_CONNECTOR_COUNT]; // Regulator enabled
+    float    need_a[EVSE_CONNECTOR_COUNT]; // Current target, derated (A)
+    float    group_a[EVSE_CONNECTOR_COUNT];// Capacity of an average group at its voltage and range (A)
+    uint8_t  held[EVSE_CONNECTOR_COUNT];   // Usable groups on it or on their way
+    uint8_t  target[EVSE_CONNECTOR_COUNT]; // Groups it should have
+    uint32_t moves;                        // Groups switched onto a connector
+    uint32_t off_timeouts;                 // Releases that exceeded PALLOC_OFF_TIMEOUT_MS
+    uint32_t close_holds;                  // Closes held back: group voltage against the bus
+    uint32_t evaluations;
+} PowerAlloc_Status_t;
+
+/**
+ * @brief Reset the matrix (all contactors open, no group assigned)
+ * @note  Call after Infy_Init and Relay_Init. Single connector: the
+ *        outlet keeps every group.
+ */
+void PowerAlloc_Init(void);
+
+/**
+ * @brief Re-balance the groups and step the moves in progress
+ * @note  Call from the CAN task before Infy_Process() (Infy_AssignGroup
+ *        runs in the module table's task); evaluates every PALLOC_PERIOD_MS.
+ */
+void PowerAlloc_Process(void);
+
+/**
+ * @brief Get Allocation Status
+ */
+void PowerAlloc_GetStatus(PowerAlloc_Status_t *status);
+
+#endif /* MODULES_POWER_POWER_ALLOC_H_ */
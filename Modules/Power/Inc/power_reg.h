@@ -0,0 +1,111 @@
+/**
+ * @file    power_reg.h
+ * @brief   DC Output Regulator (Slew-Rate Limited V/I References + PI Trim)
+ *
+ * @note    The state machine (and the SECC demand ISR) set targets; the
+ *          regulator owns Infy_SetOutput(). PowerReg_Tick() runs in the CAN
+ *          task every PREG_PERIOD_MS (100 Hz, the module status and meter
+ *          feedback are not faster than that) next to Infy_Process(), so it
+ *          reads the module aggregate from the writer's own task.
+ *
+ * @note    References rise at the configured ramp rates (SystemConfig_t
+ *          reg_ramp_*, 0 = step) and fall to a lower target at once, so the
+ *          output never runs above what the EV asked for. After an enable
+ *          the voltage ramp starts at the module output voltage and the
+ *          current ramp at 0 A. The current target is clamped to the
+ *          thermal derating limit (Thermal_GetCurrentLimit) every tick.
+ *          One regulator per connector, driving the Infy outlet of the
+ *          same index.
+ *
+ * @note    Once a reference has settled, a PI trim on top of it removes the
+ *          offset between command and feedback (module calibration, cable
+ *          drop): the voltage loop while the output is at its voltage
+ *          reference (CV), the current loop while it is current limited
+ *          (CC) and current flows. The other integrator holds, and nothing
+ *          integrates during a ramp or without feedback, so the trim cannot
+ *          wind up and overshoot when the ramp ends.
+ */
+
+#ifndef MODULES_POWER_POWER_REG_H_
+#define MODULES_POWER_POWER_REG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "evse_connector.h"
+
+// --- Configuration ---
+#define PREG_PERIOD_MS        10      // Tick (CAN task)
+#define PREG_DT_MAX_S         0.1f    // Longest step a late tick may ramp
+#define PREG_METER_MIN_V      20.0f   // Below: voltage feedback from the modules (also with the main relay open)
+#define PREG_CV_BAND_V        5.0f    // Output this close to the voltage reference = CV
+#define PREG_MIN_CURRENT_A    5.0f    // Current loop idle below (reference or feedback)
+
+// PI Trim (per loop, output in V / A on top of the reference)
+#define PREG_KP_V             0.3f
+#define PREG_KI_V             1.0f    // 1/s
+#define PREG_TRIM_MAX_V       10.0f
+#define PREG_KP_I             0.3f
+#define PREG_KI_I             1.0f    // 1/s
+#define PREG_TRIM_MAX_A       10.0f
+
+typedef struct
+{
+    bool     enabled;
+    bool     cv_mode;            // Voltage loop active
+    float    target_voltage;     // Requested (V)
+    float    target_current;     // Requested (A)
+    float    ref_voltage;        // Slew-limited reference (V)
+    float    ref_current;        // Slew-limited reference (A)
+    float    trim_voltage;       // PI trim (V)
+    float    trim_current;       // PI trim (A)
+    float    cmd_voltage;        // Sent to the modules (V)
+    float    cmd_current;        // Sent to the modules (A)
+    float    meas_voltage;       // Feedback (V)
+    float    meas_current;       // Feedback (A, module sum)
+    float    limit_current;      // Thermal derating limit (A, THERMAL_NO_LIMIT_A = none)
+    bool     thermal_limited;    // Current target clamped to it
+    uint32_t ticks;
+    uint32_t period_max_us;      // Longest gap between two ticks
+    uint32_t fast_cuts;          // Target drops applied from the SECC ISR
+    uint32_t fast_rises;         // Target rises from the SECC ISR, left to the tick
+} PowerReg_Status_t;
+
+/**
+ * @brief Reset the regulator (output disabled)
+ * @note  Call after Infy_Init and Config_Init.
+ */
+void PowerReg_Init(void);
+
+/**
+ * @brief Set the output target of a connector (any task)
+ * @param conn   Connector index
+ * @param volts  Target Voltage (V), clamped by the caller
+ * @param amps   Current Limit (A), clamped by the caller
+ * @param enable false disables the modules at once
+ * @note  A lower target cuts the references at once (the scheduler sends
+ *        the change), a higher one is ramped by the next ticks.
+ */
+void PowerReg_SetTarget(uint8_t conn, float volts, float amps, bool enable);
+
+/**
+ * @brief Set the output target from the SECC demand ISR
+ * @param rx_us SOF of the demand frame (Infy_SetOutputFast latency)
+ * @return true if the target cut the command and it was queued at once
+ * @note  Only while enabled. Rises wait for the next tick and its ramp
+ *        (up to PREG_PERIOD_MS, counted in fast_rises): the fast path and
+ *        INFY_FAST_BUDGET_US cover demand reductions only.
+ */
+bool PowerReg_SetTargetFast(uint8_t conn, float volts, float amps, uint64_t rx_us);
+
+/**
+ * @brief Regulator step of every connector: ramp, PI trim, Infy_SetOutput()
+ * @note  Call every PREG_PERIOD_MS from the CAN task, after Infy_Process().
+ */
+void PowerReg_Tick(void);
+
+/**
+ * @brief Get Regulator Status of a connector
+ */
+void PowerReg_GetStatus(uint8_t conn, PowerReg_Status_t *status);
+
+#endif /* MODULES_POWER_POWER_REG_H_ */
@@ -5,201 +5,1494 @@
  * @details
  * This module handles the CAN communication with multiple Rectifier modules.
  * It implements load sharing (Current Distribution) and status aggregation.
+ *
+ * Status aggregation: the table keeps raw values per field (struct of
+ * arrays) and bitmasks per state, so the aggregate is updated in place:
+ * the current sum is adjusted by the module's delta (integer 0.1A, no float
+ * drift), the max voltage only needs a rescan of the alive voltages when
+ * the module holding it drops. Every change republishes the snapshot under
+ * a sequence counter (odd while writing); readers retry if it moved.
+ *
+ * Staging: the table also keeps the rated and sweet-spot power of the alive
+ * modules per group. Infy_Process() compares the demanded power (set by
+ * Infy_SetOutput) with the staged groups: above INFY_STAGE_UP_PCT of their
+ * sweet-spot power (or INFY_STAGE_MAX_PCT of their rating) the available
+ * group with the most sweet-spot power is added at once; a group is only
+ * dropped after INFY_STAGE_DWELL_MS, the smallest one first, when the rest
+ * would still run below INFY_STAGE_DOWN_PCT of its sweet spot. The gap
+ * between the thresholds keeps the staging from toggling at a boundary.
+ * Both payloads (control and stage) are rebuilt under PRIMASK whenever the
+ * demand, the stage mask or the number of running modules changes.
+ *
+ * Current sharing: a module's trim is stepped by INFY_SHARE_GAIN_PCT of its
+ * deviation from the mean, once per new status frame (stepping on a stale
+ * measurement would wind the trim up), then all trims are shifted so they
+ * sum to zero. The loop stops stepping while every module is within
+ * tolerance. Trims go out as unicast frames, changed ones only and at most
+ * INFY_TRIM_FRAMES_PER_CALL per call, round robin; a module leaving the
+ * share gets trim 0 (resent when it rejoins), all trims reset with the
+ * output enable like the modules do.
+ *
+ * Output ranges: Infy_Process() moves the command of every group that is
+ * off to the requested range (Infy_Range frame, rebuilt with the stage
+ * payload) and recomputes which groups are ready: commanded to the request
+ * and all alive modules report it. Only ready groups are available to the
+ * staging, so a group that still has to switch (or a module that came up
+ * in the other range) is held off instead of running at the wrong limits.
+ *
+ * Extended status polling: every item keeps its own round over the alive
+ * modules, spaced period / alive modules apart, and the item whose next
+ * query is the oldest goes first. A query is only sent while the budget
+ * (INFY_POLL_LOAD_PERMILLE of the elapsed time, at most INFY_POLL_BURST
+ * pairs saved up) covers its own and its reply's wire time. Beyond the
+ * budget every item falls behind by the same time, so the rounds stretch in
+ * proportion to their periods; the backlog is capped at
+ * INFY_POLL_MAX_LAG_MS (all items behind move up together), so the polls
+ * do not burst once the load drops.
+ *
+ * Outlets: a group belongs to at most one outlet (infy_tab.outlet). The
+ * outlet sums (current, max voltage) are kept incrementally like the
+ * system ones and rescanned when a group moves. Staging, range, split and
+ * sharing run per outlet over its own groups; the stage and range frames
+ * stay single broadcasts (union of the outlets' masks), the control frame
+ * is declared once per outlet and carries its group mask. An outlet
+ * without groups sends no control frame, since group_mask 0 addresses all.
  */
 
 #include "infy_power.h"
-#include "can_driver.h"
+#include "can_health.h"
 #include <stdio.h>
 #include <stdlib.h> 
 #include <string.h>
 
+_Static_assert(INFY_MAX_MODULES <= 64, "Module masks are 64 bits wide");
+_Static_assert((INFY_MAX_MODULES % INFY_GROUP_SIZE) == 0, "Groups must cover all modules");
+_Static_assert(INFY_GROUP_COUNT >= 1 && INFY_GROUP_COUNT <= 8, "Stage frame carries an 8-bit group mask");
+
+// Fault Bits (Per module)
+#define INFY_FAULT_OV   0x01U
+#define INFY_FAULT_UV   0x02U
+#define INFY_FAULT_OT   0x04U
+
+#define INFY_BIT(idx)      ((Infy_Mask_t)1U << (idx))
+#define INFY_GROUP_BITS    (INFY_BIT(INFY_GROUP_SIZE) - 1U)
+#define INFY_GROUP_ALL     ((uint8_t)((1U << INFY_GROUP_COUNT) - 1U))
+
+#define INFY_TRIM_UNSENT   INT16_MIN // Module must be told its trim (again)
+#define INFY_DA(amps)      ((int32_t)((amps) * 10.0f))
+
+#define INFY_CONTROL_GROUP_BYTE 5U // Infy_Control group_mask (bit 40): tells the outlets' frames apart
+_Static_assert(INFY_CONTROL_GROUP_BYTE < INFY_CONTROL_LEN, "Group mask outside of the control frame");
+
 static FDCAN_HandleTypeDef *infy_hfdcan = NULL;
 
-// Individual Module Status
-static Infy_ModuleStatus_t modules[INFY_MAX_MODULES];
+// Module Table (Struct of Arrays, written by the CAN task only)
+static struct {
+    uint16_t voltage_dv[INFY_MAX_MODULES];  // 0.1 V
+    uint16_t current_da[INFY_MAX_MODULES];  // 0.1 A
+    uint8_t  faults[INFY_MAX_MODULES];      // INFY_FAULT_x
+    uint64_t last_rx_us[INFY_MAX_MODULES];  // SOF of last status frame
+    uint16_t rated_hw[INFY_MAX_MODULES];    // 0.1 kW (Infy_Info or default)
+    uint16_t max_current_da[INFY_MAX_MODULES]; // 0.1 A
+    uint8_t  sweet_pct[INFY_MAX_MODULES];   // % of rated power
+    int16_t  trim_da[INFY_MAX_MODULES];     // Sharing trim, 0.1 A
+    int16_t  trim_sent_da[INFY_MAX_MODULES];// Last trim sent (INFY_TRIM_UNSENT)
+    uint64_t trim_rx_us[INFY_MAX_MODULES];  // Status frame of the last trim step
+    Infy_Mask_t alive;
+    Infy_Mask_t on;
+    Infy_Mask_t fault;
+    Infy_Mask_t discovered;
+    uint32_t sum_current_da;                // Alive modules
+    uint16_t max_voltage_dv;                // Alive modules
+    uint32_t group_rated_w[INFY_GROUP_COUNT]; // Alive, fault-free modules
+    uint32_t group_sweet_w[INFY_GROUP_COUNT]; // Alive, fault-free modules, at the sweet spot
+    uint8_t  stage_mask;                    // Staged groups (all outlets)
+    Infy_Mask_t range_high;                 // Modules reporting the HIGH range
+    uint8_t  range_cmd;                     // Groups commanded to the HIGH range
+    uint8_t  range_ready;                   // Groups in the requested range, confirmed by their alive modules
+    uint8_t  running;                       // All outlets
+    uint8_t  outlet[INFY_GROUP_COUNT];      // Outlet of the group (INFY_OUTLET_NONE)
+    uint8_t  groups[INFY_OUTLETS];          // Groups of the outlet
+    Infy_Mask_t out_mods[INFY_OUTLETS];     // Module bits of those groups
+    uint8_t  out_stage[INFY_OUTLETS];       // Staged groups of the outlet
+    uint32_t out_current_da[INFY_OUTLETS];  // Alive modules of the outlet
+    uint16_t out_voltage_dv[INFY_OUTLETS];  // Alive modules of the outlet
+    Infy_Mask_t running_mask[INFY_OUTLETS]; // Alive, fault-free modules of its staged groups
+    uint8_t  out_running[INFY_OUTLETS];
+    int8_t   temp_c[INFY_MAX_MODULES][3];   // Inlet, PFC, DC/DC (Infy_Temps)
+    uint16_t ac_dv[INFY_MAX_MODULES][3];    // Line voltages AB, BC, CA, 0.1 V (Infy_AcInput)
+    uint32_t fault_word[INFY_MAX_MODULES];  // Infy_Faults
+    uint8_t  derate_pct[INFY_MAX_MODULES];  // Infy_Derate (100 until answered)
+    uint8_t  derate_reason[INFY_MAX_MODULES];
+    Infy_Mask_t polled[INFY_POLL_ITEMS];    // Answered since the module came alive
+} infy_tab;
 
-// System Aggregated Status
+// Published Aggregate (Seqlock: odd while the CAN task rewrites it)
+static volatile uint32_t infy_seq = 0;
 static Infy_SystemStatus_t system_status = {0};
+static Infy_OutletStatus_t outlet_status[INFY_OUTLETS];
+static Infy_ShareStatus_t share_status[INFY_OUTLETS];
+static Infy_PollStatus_t poll_status = {0};
+
+// Staging State (CAN task)
+static Infy_Mask_t infy_reported = 0;       // Discoveries already logged
+static uint32_t infy_stage_tick[INFY_OUTLETS]; // HAL tick of the last stage change
+static bool infy_stage_blind[INFY_OUTLETS]; // All groups staged for lack of modules
+
+// Current Sharing State (CAN task)
+static struct {
+    Infy_ShareStatus_t status;
+    Infy_Mask_t members;                    // Running set of the last call
+    bool enabled;                           // Output enable of the last call
+} infy_share[INFY_OUTLETS];
+static uint8_t infy_trim_next = 0;          // Round robin start for trim frames
+
+// Extended Status Polling State (CAN task)
+static struct {
+    Infy_PollStatus_t status;
+    uint64_t next_us[INFY_POLL_ITEMS];      // Next query of the item due
+    uint64_t round_us[INFY_POLL_ITEMS];     // Start of the item's round
+    uint8_t  cursor[INFY_POLL_ITEMS];       // Next module of the round (INFY_MAX_MODULES = done)
+    uint64_t last_us;                       // Budget accrued up to
+    uint64_t credit_ns;                     // Unused budget
+    uint64_t window_us;                     // Start of the used_ns_per_s window
+    uint32_t window_ns;
+} infy_poll;
+
+static const struct {
+    uint32_t period_ms;                     // Per module, 0 = not polled
+    uint8_t  reply_len;
+} infy_poll_items[INFY_POLL_ITEMS] = {
+    [INFY_POLL_TEMPS]  = { INFY_POLL_TEMPS_MS,  INFY_TEMPS_LEN },
+    [INFY_POLL_AC]     = { INFY_POLL_AC_MS,     INFY_ACINPUT_LEN },
+    [INFY_POLL_FAULTS] = { INFY_POLL_FAULTS_MS, INFY_FAULTS_LEN },
+    [INFY_POLL_DERATE] = { INFY_POLL_DERATE_MS, INFY_DERATE_LEN },
+};
 
 // Simulation State (for Multi-Module)
 static struct {
     float sim_volt;
     float sim_curr;
-} sim_modules[INFY_MAX_MODULES];
+} sim_modules[INFY_SIM_MODULES];
+
+// Demand and Payloads per Outlet (State machine / CAN task write under PRIMASK, scheduler sends)
+static struct {
+    float volts;
+    float amps;
+    bool  enable;
+    Infy_OutputRange_t range;               // Requested (Infy_SetRange)
+    uint8_t split;                          // Running modules the setpoint was split for
+    uint8_t setpoint[8];
+    bool setpoint_valid;
+    int control_handle;
+} infy_out[INFY_OUTLETS];
+static uint8_t infy_stage_payload[INFY_STAGE_LEN];
+static uint8_t infy_range_payload[INFY_RANGE_LEN];
+
+// Fast Path (Any context, PRIMASK)
+static Infy_FastStats_t infy_fast;
+static bool infy_fast_probing = false;      // Waiting for the probed control frame
+static uint64_t infy_fast_trigger_us = 0;
+
+static uint8_t Infy_PackControl(uint8_t *data, uint8_t outlet);
+static uint8_t Infy_PackStage(uint8_t *data, uint8_t arg);
+static uint8_t Infy_PackRange(uint8_t *data, uint8_t arg);
+static Infy_Mask_t Infy_GroupModules(uint8_t groups);
 
 
 void Infy_Init(FDCAN_HandleTypeDef *hfdcan)
 {
     infy_hfdcan = hfdcan;
     
-    // Clear Status
-    memset(modules, 0, sizeof(modules));
+    // Clear Status (All modules timed out, default ratings until Infy_Info)
+    memset(&infy_tab, 0, sizeof(infy_tab));
+    for (int i = 0; i < INFY_MAX_MODULES; i++)
+    {
+        infy_tab.rated_hw[i] = (uint16_t)(INFY_MODULE_RATED_KW * 10.0f);
+        infy_tab.max_current_da[i] = (uint16_t)(INFY_MODULE_MAX_CURRENT_A * 10.0f);
+        infy_tab.sweet_pct[i] = INFY_MODULE_SWEET_PCT;
+        infy_tab.derate_pct[i] = 100;
+    }
+    // One outlet owns every group; with more the matrix switches them in on demand
+    memset(infy_tab.outlet, (INFY_OUTLETS == 1) ? 0 : INFY_OUTLET_NONE, sizeof(infy_tab.outlet));
+    if (INFY_OUTLETS == 1)
+    {
+        infy_tab.groups[0] = INFY_GROUP_ALL;
+        infy_tab.out_mods[0] = Infy_GroupModules(INFY_GROUP_ALL);
+        infy_tab.out_stage[0] = INFY_GROUP_ALL; // Nothing discovered yet
+    }
+    infy_tab.stage_mask = infy_tab.out_stage[0];
+    infy_tab.range_cmd = (INFY_RANGE_DEFAULT == INFY_RANGE_HIGH) ? INFY_GROUP_ALL : 0U;
+    infy_tab.range_ready = INFY_GROUP_ALL; // No module alive to disagree
     memset(&system_status, 0, sizeof(system_status));
+    system_status.stage_mask = infy_tab.stage_mask;
+    system_status.range_high_mask = infy_tab.range_cmd;
+    system_status.range_ready_mask = infy_tab.range_ready;
+    memset(infy_share, 0, sizeof(infy_share));
+    memset(&infy_poll, 0, sizeof(infy_poll));
+    infy_poll.status.budget_ns_per_s = INFY_POLL_LOAD_PERMILLE * 1000000U;
+    poll_status = infy_poll.status;
+    memset(outlet_status, 0, sizeof(outlet_status));
+    for (int o = 0; o < INFY_OUTLETS; o++)
+    {
+        infy_share[o].status.worst_module = -1;
+        share_status[o] = infy_share[o].status;
+        outlet_status[o].groups = infy_tab.groups[o];
+        outlet_status[o].stage_mask = infy_tab.out_stage[o];
+        outlet_status[o].modules = infy_tab.out_mods[o];
+        infy_stage_tick[o] = HAL_GetTick();
+        infy_stage_blind[o] = true;
+    }
+    infy_trim_next = 0;
+    infy_seq = 0;
+    infy_reported = 0;
     
     // Init Simulation
-    for(int i=0; i<INFY_MAX_MODULES; i++) {
-        modules[i].comm_timeout = true; 
+    for(int i=0; i<INFY_SIM_MODULES; i++) {
         sim_modules[i].sim_volt = 0.0f;
     }
 
-    printf("[Infy] Multi-Module Driver Initialized (%d Modules).\r\n", INFY_MAX_MODULES);
+    memset(infy_out, 0, sizeof(infy_out));
+    for (int o = 0; o < INFY_OUTLETS; o++)
+    {
+        infy_out[o].range = INFY_RANGE_DEFAULT;
+        infy_out[o].control_handle = -1;
+    }
+    memset(&infy_fast, 0, sizeof(infy_fast));
+    infy_fast_probing = false;
+
+    // Route Module Status, Info and Poll Replies (29-bit, one extended filter element each)
+    CAN_RegisterRxRange(hfdcan, CAN_ID_EXT, INFY_CAN_ID_STATUS_BASE, INFY_CAN_ID_STATUS_LAST, Infy_RxHandler);
+    CAN_RegisterRxRange(hfdcan, CAN_ID_EXT, INFY_CAN_ID_INFO_BASE, INFY_CAN_ID_INFO_LAST, Infy_RxHandler);
+    CAN_RegisterRxRange(hfdcan, CAN_ID_EXT, INFY_CAN_ID_POLL_FIRST, INFY_CAN_ID_POLL_LAST, Infy_RxHandler);
+
+    // Declare Control (one per outlet) and Stage Frames: on change (rate limited) plus keep-alive
+    for (int o = 0; o < INFY_OUTLETS; o++)
+    {
+        const CAN_SchedMsg_t control = {
+            .hfdcan = hfdcan, .id = INFY_CAN_ID_CONTROL_BASE,
+            .period_ms = INFY_CONTROL_PERIOD_MS, .offset_ms = INFY_CONTROL_OFFSET_MS + o * INFY_CONTROL_STRIDE_MS,
+            .min_interval_ms = INFY_CONTROL_MIN_INTERVAL_MS, .flags = CAN_SCHED_ON_CHANGE,
+            .prio = CAN_TX_PRIO_CRITICAL, .pack = Infy_PackControl, .arg = (uint8_t)o,
+        };
+        infy_out[o].control_handle = CAN_Sched_Register(&control);
+    }
+
+    const CAN_SchedMsg_t stage = {
+        .hfdcan = hfdcan, .id = INFY_CAN_ID_STAGE,
+        .period_ms = INFY_STAGE_PERIOD_MS, .offset_ms = INFY_STAGE_OFFSET_MS,
+        .min_interval_ms = INFY_CONTROL_MIN_INTERVAL_MS, .flags = CAN_SCHED_ON_CHANGE,
+        .prio = CAN_TX_PRIO_CRITICAL, .pack = Infy_PackStage,
+    };
+    CAN_Sched_Register(&stage);
+
+    const CAN_SchedMsg_t range = {
+        .hfdcan = hfdcan, .id = INFY_CAN_ID_RANGE,
+        .period_ms = INFY_RANGE_PERIOD_MS, .offset_ms = INFY_RANGE_OFFSET_MS,
+        .min_interval_ms = INFY_CONTROL_MIN_INTERVAL_MS, .flags = CAN_SCHED_ON_CHANGE,
+        .prio = CAN_TX_PRIO_CRITICAL, .pack = Infy_PackRange,
+    };
+    CAN_Sched_Register(&range);
+
+    printf("[Infy] Multi-Module Driver Initialized (%d Modules, %d Groups, %d Outlets).\r\n",
+           INFY_MAX_MODULES, INFY_GROUP_COUNT, INFY_OUTLETS);
+}
+
+static uint8_t Infy_MaskCount(Infy_Mask_t mask)
+{
+#if INFY_MAX_MODULES <= 32
+    return (uint8_t)__builtin_popcount(mask);
+#else
+    return (uint8_t)__builtin_popcountll(mask);
+#endif
+}
+
+// Module bits of a group mask
+static Infy_Mask_t Infy_GroupModules(uint8_t groups)
+{
+    Infy_Mask_t mods = 0;
+    for (int g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        if (groups & (1U << g)) mods |= INFY_GROUP_BITS << (g * INFY_GROUP_SIZE);
+    }
+    return mods;
+}
+
+// Max voltage of the alive modules in mods (Only when the holder dropped)
+static uint16_t Infy_ScanMaxVoltage(Infy_Mask_t mods)
+{
+    uint16_t max_v = 0;
+    for (int i = 0; i < INFY_MAX_MODULES; i++)
+    {
+        if ((infy_tab.alive & mods & INFY_BIT(i)) && infy_tab.voltage_dv[i] > max_v) max_v = infy_tab.voltage_dv[i];
+    }
+    return max_v;
+}
+
+// Outlet sums from scratch (Its groups changed)
+static void Infy_ScanOutlet(uint8_t o)
+{
+    uint32_t sum_da = 0;
+    for (Infy_Mask_t m = infy_tab.alive & infy_tab.out_mods[o]; m != 0; m &= m - 1)
+    {
+        sum_da += infy_tab.current_da[__builtin_ctzll(m)];
+    }
+    infy_tab.out_current_da[o] = sum_da;
+    infy_tab.out_voltage_dv[o] = Infy_ScanMaxVoltage(infy_tab.out_mods[o]);
+}
+
+// Power sums of a group (When a module joins, drops, faults or reports its rating)
+static void Infy_UpdateGroup(int g)
+{
+    uint32_t rated_w = 0;
+    uint32_t sweet_w = 0;
+    Infy_Mask_t usable = infy_tab.alive & ~infy_tab.fault;
+    for (int i = g * INFY_GROUP_SIZE; i < (g + 1) * INFY_GROUP_SIZE; i++)
+    {
+        if (!(usable & INFY_BIT(i))) continue;
+        rated_w += infy_tab.rated_hw[i] * 100U;
+        sweet_w += (uint32_t)infy_tab.rated_hw[i] * infy_tab.sweet_pct[i]; // 100 W * % / 100
+    }
+    infy_tab.group_rated_w[g] = rated_w;
+    infy_tab.group_sweet_w[g] = sweet_w;
+}
+
+static uint32_t Infy_GroupSum(const uint32_t *sum_w, uint8_t groups)
+{
+    uint32_t total = 0;
+    for (int g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        if (groups & (1U << g)) total += sum_w[g];
+    }
+    return total;
+}
+
+// Rewrite the snapshot from the table aggregates
+static void Infy_Publish(void)
+{
+    infy_seq++;
+    __DMB();
+
+    system_status.total_voltage = infy_tab.max_voltage_dv * 0.1f; // Use Max voltage for safety
+    system_status.total_current = infy_tab.sum_current_da * 0.1f;
+    system_status.active_modules = Infy_MaskCount(infy_tab.alive);
+    system_status.alive_mask = infy_tab.alive;
+    system_status.on_mask = infy_tab.on & infy_tab.alive;
+    system_status.fault_mask = infy_tab.fault & infy_tab.alive;
+    system_status.system_fault = (system_status.fault_mask != 0);
+    system_status.discovered_mask = infy_tab.discovered;
+    system_status.stage_mask = infy_tab.stage_mask;
+    system_status.running_modules = infy_tab.running;
+    system_status.range_high_mask = infy_tab.range_cmd;
+    system_status.range_ready_mask = infy_tab.range_ready;
+    for (int o = 0; o < INFY_OUTLETS; o++)
+    {
+        Infy_OutletStatus_t *out = &outlet_status[o];
+        Infy_Mask_t mods = infy_tab.out_mods[o];
+        out->voltage = infy_tab.out_voltage_dv[o] * 0.1f;
+        out->current = infy_tab.out_current_da[o] * 0.1f;
+        out->groups = infy_tab.groups[o];
+        out->stage_mask = infy_tab.out_stage[o];
+        out->modules = mods;
+        out->on_mask = infy_tab.on & infy_tab.alive & mods;
+        out->alive_modules = Infy_MaskCount(infy_tab.alive & mods);
+        out->usable_modules = Infy_MaskCount(infy_tab.alive & ~infy_tab.fault & mods);
+        out->running_modules = infy_tab.out_running[o];
+        out->rated_kw = Infy_GroupSum(infy_tab.group_rated_w, infy_tab.groups[o]) * 0.001f;
+        share_status[o] = infy_share[o].status;
+    }
+    poll_status = infy_poll.status;
+
+    __DMB();
+    infy_seq++;
+}
+
+static void Infy_UpdateModule(int idx, uint16_t voltage_dv, uint16_t current_da, bool on,
+                              uint8_t faults, bool range_high, uint64_t timestamp_us)
+{
+    Infy_Mask_t bit = INFY_BIT(idx);
+    bool was_alive = (infy_tab.alive & bit) != 0;
+    bool was_fault = (infy_tab.fault & bit) != 0;
+    uint16_t old_v = infy_tab.voltage_dv[idx];
+    uint16_t old_i = infy_tab.current_da[idx];
+
+    if (was_alive) infy_tab.sum_current_da -= infy_tab.current_da[idx];
+    infy_tab.sum_current_da += current_da;
+
+    infy_tab.voltage_dv[idx] = voltage_dv;
+    infy_tab.current_da[idx] = current_da;
+    infy_tab.faults[idx] = faults;
+    infy_tab.last_rx_us[idx] = timestamp_us;
+
+    infy_tab.alive |= bit;
+    infy_tab.discovered |= bit;
+    if (on) infy_tab.on |= bit; else infy_tab.on &= ~bit;
+    if (faults) infy_tab.fault |= bit; else infy_tab.fault &= ~bit;
+    if (range_high) infy_tab.range_high |= bit; else infy_tab.range_high &= ~bit;
+
+    if (voltage_dv >= infy_tab.max_voltage_dv) infy_tab.max_voltage_dv = voltage_dv;
+    else if (was_alive && old_v == infy_tab.max_voltage_dv) infy_tab.max_voltage_dv = Infy_ScanMaxVoltage(~(Infy_Mask_t)0);
+
+    // Same for its outlet (current already stored: subtract the old value)
+    uint8_t o = infy_tab.outlet[idx / INFY_GROUP_SIZE];
+    if (o < INFY_OUTLETS)
+    {
+        if (was_alive) infy_tab.out_current_da[o] -= old_i;
+        infy_tab.out_current_da[o] += current_da;
+        if (voltage_dv >= infy_tab.out_voltage_dv[o]) infy_tab.out_voltage_dv[o] = voltage_dv;
+        else if (was_alive && old_v == infy_tab.out_voltage_dv[o]) infy_tab.out_voltage_dv[o] = Infy_ScanMaxVoltage(infy_tab.out_mods[o]);
+    }
+
+    // Joined or fault changed: group power (running set and split follow in Infy_Process)
+    if (!was_alive || was_fault != (faults != 0)) Infy_UpdateGroup(idx / INFY_GROUP_SIZE);
+
+    Infy_Publish();
+}
+
+static void Infy_UpdateInfo(int idx, const Infy_Info_t *info)
+{
+    // Implausible rating: keep the defaults
+    if (info->rated_power == 0 || info->sweet_spot == 0 || info->sweet_spot > 100) return;
+
+    infy_tab.rated_hw[idx] = info->rated_power;
+    infy_tab.sweet_pct[idx] = info->sweet_spot;
+    if (info->max_current != 0) infy_tab.max_current_da[idx] = info->max_current;
+
+    if (infy_tab.alive & INFY_BIT(idx)) Infy_UpdateGroup(idx / INFY_GROUP_SIZE);
+
+    Infy_Publish();
+}
+
+// Extended status reply (Frame base + module index)
+static void Infy_UpdatePolled(const CAN_Message_t *msg)
+{
+    int idx = (int)(msg->id & 0xFFU) - 1; // 0x..01 = module 0
+    if (idx < 0 || idx >= INFY_MAX_MODULES) return;
+    if (!(infy_tab.alive & INFY_BIT(idx))) return; // Kept from its next status frame on
+
+    Infy_PollItem_t item;
+    switch (msg->id - (uint32_t)idx)
+    {
+        case INFY_TEMPS_ID:
+        {
+            if (msg->len < INFY_TEMPS_MIN_LEN) return;
+            Infy_Temps_t t;
+            Infy_Temps_Unpack(msg->data, &t);
+            infy_tab.temp_c[idx][0] = t.temp_inlet;
+            infy_tab.temp_c[idx][1] = t.temp_pfc;
+            infy_tab.temp_c[idx][2] = t.temp_dcdc;
+            item = INFY_POLL_TEMPS;
+            break;
+        }
+        case INFY_ACINPUT_ID:
+        {
+            if (msg->len < INFY_ACINPUT_MIN_LEN) return;
+            Infy_AcInput_t ac;
+            Infy_AcInput_Unpack(msg->data, &ac);
+            infy_tab.ac_dv[idx][0] = ac.v_ab;
+            infy_tab.ac_dv[idx][1] = ac.v_bc;
+            infy_tab.ac_dv[idx][2] = ac.v_ca;
+            item = INFY_POLL_AC;
+            break;
+        }
+        case INFY_FAULTS_ID:
+        {
+            if (msg->len < INFY_FAULTS_MIN_LEN) return;
+            Infy_Faults_t f;
+            Infy_Faults_Unpack(msg->data, &f);
+            infy_tab.fault_word[idx] = f.fault_word;
+            item = INFY_POLL_FAULTS;
+            break;
+        }
+        case INFY_DERATE_ID:
+        {
+            if (msg->len < INFY_DERATE_MIN_LEN) return;
+            Infy_Derate_t d;
+            Infy_Derate_Unpack(msg->data, &d);
+            infy_tab.derate_pct[idx] = (d.power_limit > 100) ? 100 : d.power_limit;
+            infy_tab.derate_reason[idx] = d.reason;
+            item = INFY_POLL_DERATE;
+            break;
+        }
+        default:
+            return; // Gap between the reply bases
+    }
+
+    infy_tab.polled[item] |= INFY_BIT(idx);
+    infy_poll.status.replies++;
+    Infy_Publish();
 }
 
-void Infy_RxHandler(uint32_t id, uint8_t *data, uint8_t len)
+void Infy_RxHandler(const CAN_Message_t *msg)
 {
-    // ID Range Check: 0x18005001 ~ 0x1800500A (Assuming base + 1..10)
+    // Extended Status Replies: 0x18005601 ~ 0x18005940 (Item base + module index)
+    if (msg->id >= INFY_CAN_ID_POLL_FIRST && msg->id <= INFY_CAN_ID_POLL_LAST)
+    {
+        Infy_UpdatePolled(msg);
+        return;
+    }
+
+    // Module Rating: 0x18005201 ~ 0x18005240 (Module index 0..MAX-1)
+    if (msg->id >= INFY_CAN_ID_INFO_BASE && msg->id <= INFY_CAN_ID_INFO_LAST)
+    {
+        if (msg->len < INFY_INFO_MIN_LEN) return;
+
+        Infy_Info_t info;
+        Infy_Info_Unpack(msg->data, &info);
+        Infy_UpdateInfo((int)(msg->id - INFY_CAN_ID_INFO_BASE), &info);
+        return;
+    }
+
+    // ID Range Check: 0x18005001 ~ 0x18005040 (Module index 0..MAX-1)
     // Note: Adjust depending on actual Module ID configuration
-    if (id <= INFY_CAN_ID_STATUS_BASE || id > (INFY_CAN_ID_STATUS_BASE + INFY_MAX_MODULES))
+    if (msg->id < INFY_CAN_ID_STATUS_BASE || msg->id > INFY_CAN_ID_STATUS_LAST)
     {
         return;
     }
 
-    int idx = id - INFY_CAN_ID_STATUS_BASE - 1; 
+    int idx = msg->id - INFY_CAN_ID_STATUS_BASE;
     if (idx < 0 || idx >= INFY_MAX_MODULES) return;
+    if (msg->len < INFY_STATUS_MIN_LEN) return; // V(2) + I(2) + State(1)
 
-    // Parse Data (Assumed Format: V(2), I(2), State(1)...)
-    // Byte 0-1: Voltage (0.1V)
-    uint16_t v_raw = (data[0] << 8) | data[1];
-    modules[idx].output_voltage = v_raw * 0.1f;
-
-    // Byte 2-3: Current (0.1A)
-    uint16_t i_raw = (data[2] << 8) | data[3];
-    modules[idx].output_current = i_raw * 0.1f;
+    // Layout in Tools/dbc/power.dbc (Assumed Format, Big Endian)
+    Infy_Status_t st;
+    Infy_Status_Unpack(msg->data, &st);
 
-    // Byte 4: State/Faults
-    modules[idx].is_on = (data[4] & 0x01) ? true : false;
-    modules[idx].fault_ov = (data[4] & 0x02) ? true : false;
+    uint8_t faults = st.fault_ov ? INFY_FAULT_OV : 0U;
     // ... decode other faults
 
-    modules[idx].last_rx_tick = HAL_GetTick();
-    modules[idx].comm_timeout = false;
+    Infy_UpdateModule(idx, st.voltage, st.current, st.is_on != 0, faults, st.range_high != 0,
+                      msg->timestamp_us); // 0.1V, 0.1A
+}
+
+// Group with the most (or least) sweet-spot power
+static uint8_t Infy_PickGroup(uint8_t groups, bool largest)
+{
+    uint8_t pick = 0;
+    for (int g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        if (!(groups & (1U << g))) continue;
+        if (pick == 0) { pick = (uint8_t)(1U << g); continue; }
+
+        uint32_t best = infy_tab.group_sweet_w[__builtin_ctz(pick)];
+        if (largest ? (infy_tab.group_sweet_w[g] > best) : (infy_tab.group_sweet_w[g] < best))
+        {
+            pick = (uint8_t)(1U << g);
+        }
+    }
+    return pick;
+}
+
+static float Infy_RangeMaxVoltage(Infy_OutputRange_t range)
+{
+    return (range == INFY_RANGE_HIGH) ? INFY_RANGE_HIGH_V_MAX : INFY_RANGE_LOW_V_MAX;
 }
 
+// Move the groups that are off to their outlet's requested range, refresh the ready set
+static bool Infy_UpdateRange(void)
+{
+    uint8_t want = 0;
+    uint8_t enabled = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (int o = 0; o < INFY_OUTLETS; o++)
+    {
+        if (infy_out[o].range == INFY_RANGE_HIGH) want |= infy_tab.groups[o];
+        if (infy_out[o].enable) enabled |= infy_tab.groups[o];
+    }
+    __set_PRIMASK(primask);
+
+    // Unassigned groups keep their command, a staged group keeps its range while the output is enabled
+    uint8_t assigned = 0;
+    for (int o = 0; o < INFY_OUTLETS; o++) assigned |= infy_tab.groups[o];
+    want |= infy_tab.range_cmd & (uint8_t)~assigned;
+    uint8_t off = (uint8_t)~(infy_tab.stage_mask & enabled);
+    uint8_t cmd = (uint8_t)((infy_tab.range_cmd & ~off) | (want & off));
+
+    bool changed = false;
+    if (cmd != infy_tab.range_cmd)
+    {
+        infy_tab.range_cmd = cmd;
+        printf("[Infy] Range: Groups 0x%02X HIGH\r\n", cmd);
+        changed = true;
+    }
+
+    // Ready: commanded to the request and every alive module reports it
+    uint8_t ready = 0;
+    for (int g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        if ((cmd ^ want) & (1U << g)) continue; // Unstaged below, switched next call
+        Infy_Mask_t bits = infy_tab.alive & (INFY_GROUP_BITS << (g * INFY_GROUP_SIZE));
+        Infy_Mask_t high = (cmd & (1U << g)) ? bits : 0;
+        if ((infy_tab.range_high & bits) == high) ready |= (uint8_t)(1U << g);
+    }
+    if (ready != infy_tab.range_ready)
+    {
+        infy_tab.range_ready = ready;
+        changed = true;
+    }
+    return changed;
+}
+
+// Groups of an outlet to run for its demand
+static uint8_t Infy_StagePolicy(uint8_t o)
+{
+    uint8_t groups = infy_tab.groups[o];
+#if INFY_STAGING_ENABLE
+    uint8_t avail = 0;
+    for (int g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        if ((groups & (1U << g)) && infy_tab.group_rated_w[g] > 0) avail |= (uint8_t)(1U << g);
+    }
+    // Nothing alive (startup, bus down): let every module answer the setpoint
+    if (avail == 0)
+    {
+        infy_stage_blind[o] = true;
+        return groups & infy_tab.range_ready;
+    }
+
+    // Groups still switching their range wait (the output stays at 0 A meanwhile)
+    avail &= infy_tab.range_ready;
+    if (avail == 0)
+    {
+        infy_stage_blind[o] = false;
+        return 0;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t demand_w = infy_out[o].enable ? (uint64_t)(infy_out[o].volts * infy_out[o].amps) : 0U;
+    __set_PRIMASK(primask);
+
+    // Modules showed up: stage up from nothing instead of trimming all groups
+    uint8_t prev = infy_stage_blind[o] ? 0U : (infy_tab.out_stage[o] & avail);
+    uint8_t mask = prev;
+    infy_stage_blind[o] = false;
+
+    // Stage up at once: at least one group, more while the staged ones run past their sweet spot
+    while (mask != avail)
+    {
+        if (mask != 0 &&
+            demand_w * 100U <= (uint64_t)Infy_GroupSum(infy_tab.group_sweet_w, mask) * INFY_STAGE_UP_PCT &&
+            demand_w * 100U <= (uint64_t)Infy_GroupSum(infy_tab.group_rated_w, mask) * INFY_STAGE_MAX_PCT)
+        {
+            break;
+        }
+        mask |= Infy_PickGroup(avail & ~mask, true);
+    }
+
+    // Stage down after the dwell, smallest group first, if the rest still runs below its sweet spot
+    if (mask == prev && __builtin_popcount(mask) > 1 && (HAL_GetTick() - infy_stage_tick[o]) >= INFY_STAGE_DWELL_MS)
+    {
+        uint8_t rest = mask & (uint8_t)~Infy_PickGroup(mask, false);
+        if (demand_w * 100U < (uint64_t)Infy_GroupSum(infy_tab.group_sweet_w, rest) * INFY_STAGE_DOWN_PCT &&
+            demand_w * 100U <= (uint64_t)Infy_GroupSum(infy_tab.group_rated_w, rest) * INFY_STAGE_MAX_PCT)
+        {
+            mask = rest;
+        }
+    }
+
+    return mask;
+#else
+    return groups & infy_tab.range_ready;
+#endif
+}
+
+// Control payload of an outlet from its demand, stage and range payloads (PRIMASK held)
+static void Infy_BuildSetpoint(uint8_t o)
+{
+    infy_out[o].split = infy_tab.out_running[o];
+
+    // Fail-safe: nothing alive in the staged groups yet (startup), split
+    // across every module slot of the outlet so the total can only undershoot
+    int slots = Infy_MaskCount(infy_tab.out_mods[o]);
+    int share = (infy_out[o].split > 0) ? infy_out[o].split : ((slots > 0) ? slots : INFY_MAX_MODULES);
+    float current_per_module = infy_out[o].amps / share;
+
+    // Clamp per module (LOW if any staged group runs in it)
+    float volts = infy_out[o].volts;
+    Infy_OutputRange_t range = (infy_tab.out_stage[o] & (uint8_t)~infy_tab.range_cmd) ? INFY_RANGE_LOW : INFY_RANGE_HIGH;
+    float limit = Infy_RangeCurrentLimit(range, volts);
+    if (current_per_module > limit) current_per_module = limit;
+
+    if (!infy_out[o].enable) {
+        volts = 0.0f;
+        current_per_module = 0.0f;
+    }
+
+    // CAN Tx Payloads (Broadcast, layout in Tools/dbc/power.dbc)
+    Infy_Control_t ctl = {
+        .voltage = (uint16_t)(volts * 10.0f),
+        .current = (uint16_t)(current_per_module * 10.0f), // Send Shared Current!
+        .enable = infy_out[o].enable ? 1 : 0,
+        .group_mask = (INFY_OUTLETS > 1) ? infy_tab.groups[o] : 0U, // 0 = all (single output bus)
+    };
+    Infy_Control_Pack(&ctl, infy_out[o].setpoint);
+
+    Infy_Stage_t stage = { .group_mask = infy_tab.stage_mask };
+    Infy_Stage_Pack(&stage, infy_stage_payload);
+
+    Infy_Range_t rng = { .high_mask = infy_tab.range_cmd };
+    Infy_Range_Pack(&rng, infy_range_payload);
+
+    // Simulated modules read the payload directly, nothing goes on the bus
+    infy_out[o].setpoint_valid = (INFY_USE_SIMULATION == 0) && (infy_hfdcan != NULL);
+}
+
+// An outlet without groups has nobody to address (group_mask 0 = all)
+static bool Infy_OutletLive(uint8_t o)
+{
+    return (INFY_OUTLETS == 1) || (infy_tab.groups[o] != 0);
+}
+
+static void Infy_ClampTrim(int idx, int32_t trim_da)
+{
+    if (trim_da > INFY_DA(INFY_SHARE_TRIM_MAX_A)) trim_da = INFY_DA(INFY_SHARE_TRIM_MAX_A);
+    if (trim_da < -INFY_DA(INFY_SHARE_TRIM_MAX_A)) trim_da = -INFY_DA(INFY_SHARE_TRIM_MAX_A);
+    infy_tab.trim_da[idx] = (int16_t)trim_da;
+}
+
+// Sharing metrics and trim steps over the running modules of an outlet
+static void Infy_Share(uint8_t o, bool enable)
+{
+    Infy_ShareStatus_t *st = &infy_share[o].status;
+    Infy_Mask_t members = infy_tab.running_mask[o];
+
+    // Modules that left hand their trim back (re-centered below) and are
+    // told trim 0 when they rejoin; the broadcast share already grew
+    Infy_Mask_t gone = infy_share[o].members & ~members;
+    Infy_Mask_t failed = gone & ~(infy_tab.alive & ~infy_tab.fault); // Not just unstaged
+    if (failed != 0 && enable && infy_share[o].enabled) st->failovers += Infy_MaskCount(failed);
+    for (Infy_Mask_t m = gone; m != 0; m &= m - 1)
+    {
+        int i = __builtin_ctzll(m);
+        infy_tab.trim_da[i] = 0;
+        infy_tab.trim_sent_da[i] = INFY_TRIM_UNSENT;
+    }
+    // Joined: first step on its next status frame
+    for (Infy_Mask_t m = members & ~infy_share[o].members; m != 0; m &= m - 1)
+    {
+        int i = __builtin_ctzll(m);
+        infy_tab.trim_rx_us[i] = infy_tab.last_rx_us[i];
+    }
+    infy_share[o].members = members;
+
+    // Output off: the outlet's modules drop their trims, so do we
+    if (!enable && infy_share[o].enabled)
+    {
+        for (Infy_Mask_t m = infy_tab.out_mods[o]; m != 0; m &= m - 1)
+        {
+            int i = __builtin_ctzll(m);
+            infy_tab.trim_da[i] = 0;
+            infy_tab.trim_sent_da[i] = 0;
+        }
+    }
+    infy_share[o].enabled = enable;
+
+    st->modules = Infy_MaskCount(members);
+    st->active = false;
+    st->converged = false;
+    st->mean_current = 0.0f;
+    st->max_deviation = 0.0f;
+    st->imbalance_pct = 0.0f;
+    st->worst_module = -1;
+    if (!enable || members == 0) return;
+
+    // Metrics: deviation from the mean (0.1 A)
+    uint32_t sum_da = 0;
+    for (Infy_Mask_t m = members; m != 0; m &= m - 1) sum_da += infy_tab.current_da[__builtin_ctzll(m)];
+    int32_t mean_da = (int32_t)(sum_da / st->modules);
+
+    int32_t worst_da = 0;
+    for (Infy_Mask_t m = members; m != 0; m &= m - 1)
+    {
+        int i = __builtin_ctzll(m);
+        int32_t dev = abs((int32_t)infy_tab.current_da[i] - mean_da);
+        if (dev > worst_da || st->worst_module < 0)
+        {
+            worst_da = dev;
+            st->worst_module = i;
+        }
+    }
+    int32_t tol_da = (mean_da * INFY_SHARE_TOL_PCT) / 100;
+    if (tol_da < INFY_DA(INFY_SHARE_TOL_MIN_A)) tol_da = INFY_DA(INFY_SHARE_TOL_MIN_A);
+
+    st->mean_current = mean_da * 0.1f;
+    st->max_deviation = worst_da * 0.1f;
+    st->imbalance_pct = (mean_da > 0) ? (worst_da * 100.0f) / mean_da : 0.0f;
+    st->converged = (worst_da <= tol_da);
+    st->active = INFY_SHARE_ENABLE && st->modules >= 2 && mean_da >= INFY_DA(INFY_SHARE_MIN_CURRENT_A);
+    if (!st->active)
+    {
+        // Near idle a trim could exceed the share itself: release them
+        for (Infy_Mask_t m = members; m != 0; m &= m - 1) infy_tab.trim_da[__builtin_ctzll(m)] = 0;
+        return;
+    }
+
+    // Step towards the mean on fresh measurements only (no step inside the tolerance)
+    int32_t trim_sum = 0;
+    for (Infy_Mask_t m = members; m != 0; m &= m - 1)
+    {
+        int i = __builtin_ctzll(m);
+        if (!st->converged && infy_tab.trim_rx_us[i] != infy_tab.last_rx_us[i])
+        {
+            infy_tab.trim_rx_us[i] = infy_tab.last_rx_us[i];
+            Infy_ClampTrim(i, infy_tab.trim_da[i] + ((mean_da - infy_tab.current_da[i]) * INFY_SHARE_GAIN_PCT) / 100);
+        }
+        trim_sum += infy_tab.trim_da[i];
+    }
+
+    // Re-center: trims sum to zero, the total stays at the setpoint
+    int32_t offset = trim_sum / st->modules;
+    if (offset == 0) return;
+    for (Infy_Mask_t m = members; m != 0; m &= m - 1)
+    {
+        int i = __builtin_ctzll(m);
+        Infy_ClampTrim(i, infy_tab.trim_da[i] - offset);
+    }
+}
+
+static bool Infy_TrimDue(int idx)
+{
+    int32_t sent = infy_tab.trim_sent_da[idx];
+    int32_t trim = infy_tab.trim_da[idx];
+    if (sent == INFY_TRIM_UNSENT) return true;
+    if (trim == 0) return sent != 0;
+    return abs(trim - sent) >= INFY_DA(INFY_SHARE_TRIM_STEP_A);
+}
+
+// Extended status queries: oldest due item first, within the wire-time budget
+static void Infy_Poll(uint64_t now)
+{
+#if INFY_POLL_ENABLE
+    if (INFY_USE_SIMULATION || infy_hfdcan == NULL) return;
+
+    int bus = CAN_GetBusIndex(infy_hfdcan);
+    uint32_t query_ns = CAN_Health_FrameNs(bus, true, INFY_QUERY_LEN, false, false);
+    uint64_t burst_ns = (uint64_t)INFY_POLL_BURST * (query_ns + CAN_Health_FrameNs(bus, true, 8, false, false));
+
+    // Budget: INFY_POLL_LOAD_PERMILLE of the elapsed time (1 us = 1000 ns)
+    uint64_t credit_ns = infy_poll.credit_ns + (now - infy_poll.last_us) * INFY_POLL_LOAD_PERMILLE;
+    if (credit_ns > burst_ns) credit_ns = burst_ns;
+    infy_poll.last_us = now;
+
+    if (now - infy_poll.window_us >= TIMEBASE_US_PER_SEC)
+    {
+        infy_poll.status.used_ns_per_s = infy_poll.window_ns;
+        infy_poll.window_ns = 0;
+        infy_poll.window_us = now;
+    }
+
+    // Backlog cap: the items behind move up together, so their order (and
+    // with it the share of each item) is kept
+    uint64_t lag_us = (uint64_t)INFY_POLL_MAX_LAG_MS * 1000U;
+    uint64_t oldest_us = UINT64_MAX;
+    for (int k = 0; k < INFY_POLL_ITEMS; k++)
+    {
+        if (infy_poll_items[k].period_ms != 0 && infy_poll.next_us[k] < oldest_us) oldest_us = infy_poll.next_us[k];
+    }
+    if (now > lag_us && oldest_us < now - lag_us)
+    {
+        uint64_t shift_us = now - lag_us - oldest_us;
+        for (int k = 0; k < INFY_POLL_ITEMS; k++)
+        {
+            if (infy_poll.next_us[k] >= now) continue;
+            infy_poll.next_us[k] += shift_us;
+            if (infy_poll.next_us[k] > now) infy_poll.next_us[k] = now;
+        }
+    }
+
+    Infy_Mask_t targets = infy_tab.alive;
+    int count = Infy_MaskCount(targets);
+    for (int q = 0; q < INFY_POLL_QUERIES_PER_CALL && count > 0; q++)
+    {
+        int item = -1;
+        for (int k = 0; k < INFY_POLL_ITEMS; k++)
+        {
+            if (infy_poll_items[k].period_ms == 0) continue;
+            if (infy_poll.next_us[k] > now) continue;
+            if (item < 0 || infy_poll.next_us[k] < infy_poll.next_us[item]) item = k;
+        }
+        if (item < 0) break;
+
+        uint32_t cost_ns = query_ns + CAN_Health_FrameNs(bus, true, infy_poll_items[item].reply_len, false, false);
+        if (credit_ns < cost_ns)
+        {
+            infy_poll.status.budget_holds++;
+            break;
+        }
+
+        // Next alive module of the item's round
+        uint8_t cur = infy_poll.cursor[item];
+        if (cur == 0) infy_poll.round_us[item] = now; // First round
+        Infy_Mask_t ahead = (cur < INFY_MAX_MODULES) ? (targets & ~(INFY_BIT(cur) - 1U)) : 0;
+        if (ahead == 0)
+        {
+            infy_poll.status.round_ms[item] = (uint32_t)((now - infy_poll.round_us[item]) / 1000U);
+            infy_poll.round_us[item] = now;
+            ahead = targets;
+        }
+        int i = __builtin_ctzll(ahead);
+
+        uint8_t data[INFY_QUERY_LEN];
+        Infy_Query_t query = { .item = (uint8_t)(item + 1) };
+        Infy_Query_Pack(&query, data);
+        if (!CAN_Transmit(infy_hfdcan, INFY_CAN_ID_QUERY_BASE + i, data, INFY_QUERY_LEN, CAN_TX_PRIO_DIAG))
+        {
+            infy_poll.status.tx_drops++;
+            break;
+        }
+        credit_ns -= cost_ns;
+        infy_poll.window_ns += cost_ns;
+        infy_poll.status.queries++;
+        infy_poll.cursor[item] = (uint8_t)(i + 1);
+        infy_poll.next_us[item] += (uint64_t)infy_poll_items[item].period_ms * 1000U / count;
+    }
+    infy_poll.credit_ns = credit_ns;
+#else
+    (void)now;
+#endif
+}
+
+// Unicast trims of the running modules, changed ones only (round robin)
+static void Infy_SendTrims(void)
+{
+    // Not in simulation, nor before an outlet's first setpoint
+    Infy_Mask_t members = 0;
+    for (int o = 0; o < INFY_OUTLETS; o++)
+    {
+        if (infy_out[o].setpoint_valid) members |= infy_share[o].members;
+    }
+    if (members == 0) return;
+
+    int budget = INFY_TRIM_FRAMES_PER_CALL;
+    for (int k = 0; k < INFY_MAX_MODULES && budget > 0; k++)
+    {
+        int i = (infy_trim_next + k) % INFY_MAX_MODULES;
+        if (!(members & INFY_BIT(i)) || !Infy_TrimDue(i)) continue;
+
+        uint8_t data[INFY_TRIM_LEN];
+        Infy_Trim_t trim = { .current_trim = infy_tab.trim_da[i] };
+        Infy_Trim_Pack(&trim, data);
+        if (!CAN_Transmit(infy_hfdcan, INFY_CAN_ID_TRIM_BASE + i, data, INFY_TRIM_LEN, CAN_TX_PRIO_CRITICAL))
+        {
+            infy_share[infy_tab.outlet[i / INFY_GROUP_SIZE]].status.trim_drops++;
+            break;
+        }
+        infy_tab.trim_sent_da[i] = infy_tab.trim_da[i];
+        infy_share[infy_tab.outlet[i / INFY_GROUP_SIZE]].status.trim_frames++;
+        infy_trim_next = (uint8_t)((i + 1) % INFY_MAX_MODULES);
+        budget--;
+    }
+}
+
+void Infy_Process(void)
+{
+    Infy_Mask_t lost = 0;
+    uint64_t now = Timebase_GetMicros();
+
+    // Check Timeout (1s since the last frame was on the wire)
+    for (Infy_Mask_t m = infy_tab.alive; m != 0; m &= m - 1)
+    {
+        int i = __builtin_ctzll(m);
+        if (now > infy_tab.last_rx_us[i] && (now - infy_tab.last_rx_us[i]) > INFY_COMM_TIMEOUT_US)
+        {
+            lost |= INFY_BIT(i);
+            infy_tab.sum_current_da -= infy_tab.current_da[i];
+            uint8_t o = infy_tab.outlet[i / INFY_GROUP_SIZE];
+            if (o < INFY_OUTLETS) infy_tab.out_current_da[o] -= infy_tab.current_da[i];
+        }
+    }
+
+    bool changed = false;
+    if (lost != 0)
+    {
+        infy_tab.alive &= ~lost;
+        infy_tab.max_voltage_dv = Infy_ScanMaxVoltage(~(Infy_Mask_t)0);
+        for (int o = 0; o < INFY_OUTLETS; o++)
+        {
+            if (lost & infy_tab.out_mods[o]) infy_tab.out_voltage_dv[o] = Infy_ScanMaxVoltage(infy_tab.out_mods[o]);
+        }
+        for (int k = 0; k < INFY_POLL_ITEMS; k++) infy_tab.polled[k] &= ~lost;
+        for (int g = 0; g < INFY_GROUP_COUNT; g++)
+        {
+            if (lost & (INFY_GROUP_BITS << (g * INFY_GROUP_SIZE))) Infy_UpdateGroup(g);
+        }
+        printf("[Infy] %d Module(s) Lost, %d Alive\r\n", Infy_MaskCount(lost), Infy_MaskCount(infy_tab.alive));
+        changed = true;
+    }
+
+    // Discovery: logged here (once per sweep), not per status frame
+    Infy_Mask_t found = infy_tab.discovered & ~infy_reported;
+    if (found != 0)
+    {
+        infy_reported |= found;
+        printf("[Infy] %d Module(s) Discovered, %d Total\r\n", Infy_MaskCount(found), Infy_MaskCount(infy_tab.discovered));
+    }
+
+    if (Infy_UpdateRange()) changed = true;
+
+    // Per outlet: staging, running set (a timed-out or faulted module leaves it in this call), sharing
+    uint8_t stage_all = 0;
+    uint8_t running_all = 0;
+    bool out_changed[INFY_OUTLETS];
+    for (int o = 0; o < INFY_OUTLETS; o++)
+    {
+        out_changed[o] = false;
+        uint8_t stage = Infy_StagePolicy((uint8_t)o);
+        if (stage != infy_tab.out_stage[o])
+        {
+            infy_tab.out_stage[o] = stage;
+            infy_stage_tick[o] = HAL_GetTick();
+            printf("[Infy] Staging: Outlet %d Groups 0x%02X\r\n", o + 1, stage);
+            out_changed[o] = true;
+        }
+        stage_all |= stage;
+
+        Infy_Mask_t running = infy_tab.alive & ~infy_tab.fault & Infy_GroupModules(stage);
+        if (running != infy_tab.running_mask[o])
+        {
+            infy_tab.running_mask[o] = running;
+            infy_tab.out_running[o] = Infy_MaskCount(running);
+            out_changed[o] = true;
+        }
+        running_all += infy_tab.out_running[o];
+
+        Infy_Share((uint8_t)o, infy_out[o].enable);
+    }
+    // The stage frame is shared by all outlets
+    if (stage_all != infy_tab.stage_mask) changed = true;
+    infy_tab.stage_mask = stage_all;
+    infy_tab.running = running_all;
+    Infy_Publish();
+
+    // Fast path: wire latency once the probed control frame was sent
+    uint64_t sof_us;
+    if (infy_fast_probing && CAN_TxProbeRead(infy_hfdcan, &sof_us))
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint32_t wire_us = (uint32_t)(sof_us - infy_fast_trigger_us);
+        infy_fast.wire_last_us = wire_us;
+        if (wire_us > infy_fast.wire_max_us) infy_fast.wire_max_us = wire_us;
+        if (wire_us > INFY_FAST_BUDGET_US) infy_fast.over_budget++;
+        infy_fast_probing = false;
+        __set_PRIMASK(primask);
+    }
+
+    // Re-split the current when the running modules, the stage or the range
+    // masks changed (nothing to send before the outlet's first Infy_SetOutput)
+    for (int o = 0; o < INFY_OUTLETS; o++)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (infy_out[o].setpoint_valid && (changed || out_changed[o] || infy_tab.out_running[o] != infy_out[o].split))
+        {
+            Infy_BuildSetpoint((uint8_t)o);
+        }
+        __set_PRIMASK(primask);
+    }
+
+    Infy_SendTrims();
+    Infy_Poll(now);
+}
+
+
+// Any outlet got its first setpoint (PRIMASK held)
+static bool Infy_AnyValid(void)
+{
+    for (int o = 0; o < INFY_OUTLETS; o++)
+    {
+        if (infy_out[o].setpoint_valid) return true;
+    }
+    return false;
+}
+
+// Scheduler pack callbacks (timer task)
+static uint8_t Infy_PackControl(uint8_t *data, uint8_t outlet)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool valid = infy_out[outlet].setpoint_valid && Infy_OutletLive(outlet);
+    memcpy(data, infy_out[outlet].setpoint, sizeof(infy_out[outlet].setpoint));
+    __set_PRIMASK(primask);
+
+    return valid ? sizeof(infy_out[outlet].setpoint) : 0;
+}
+
+static uint8_t Infy_PackStage(uint8_t *data, uint8_t arg)
+{
+    (void)arg;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool valid = Infy_AnyValid();
+    memcpy(data, infy_stage_payload, sizeof(infy_stage_payload));
+    __set_PRIMASK(primask);
+
+    return valid ? sizeof(infy_stage_payload) : 0;
+}
+
+static uint8_t Infy_PackRange(uint8_t *data, uint8_t arg)
+{
+    (void)arg;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool valid = Infy_AnyValid();
+    memcpy(data, infy_range_payload, sizeof(infy_range_payload));
+    __set_PRIMASK(primask);
+
+    return valid ? sizeof(infy_range_payload) : 0;
+}
 
 /**
- * @brief  Build and Send CAN Control Frame
+ * @brief  Store the demand and build the CAN Control Frame (Sent by the TX scheduler)
  * @detail Packet Format (Assumed):
  *         Byte 0-1: Voltage (0.1V/bit)
- *         Byte 2-3: Current (0.1A/bit) - PER MODULE
+ *         Byte 2-3: Current (0.1A/bit) - PER MODULE (staged modules only)
  *         Byte 4:   Control (0x01=ON, 0x00=OFF)
+ *         Byte 5:   Group mask of the outlet (0 = all, single outlet)
  */
-void Infy_SetOutput(float target_volts, float target_amps, bool enable)
+void Infy_SetOutput(uint8_t outlet, float target_volts, float target_amps, bool enable)
 {
-    // --- 1. System Limits & Load Sharing ---
-    float max_system_current = INFY_MAX_MODULES * 100.0f; // 100A per module
-    if (target_amps > max_system_current) target_amps = max_system_current;
-    if (target_volts > 1000.0f) target_volts = 1000.0f;
-
-    // Count Active Modules for Distribution
-    int active_count = 0;
-    for(int i=0; i<INFY_MAX_MODULES; i++) {
-        // Consider a module active if it's not timed out or we are just starting
-        // For robustness, maybe assume all configured are active initially?
-        // Simple logic: If enabled, assume we try to drive all.
-        // Or better: Count healthy ones.
-        if (!modules[i].comm_timeout) active_count++;
-    }
-    
-    // Fail-safe: If no modules seen yet, assume all are available (at startup)
-    if (active_count == 0 && enable) active_count = INFY_MAX_MODULES;
-    if (active_count == 0) active_count = 1; // Avoid div by zero
+    if (outlet >= INFY_OUTLETS) return;
 
-    float current_per_module = target_amps / active_count;
-    
-    // Clamp per module
-    if (current_per_module > 100.0f) current_per_module = 100.0f;
+    // --- 1. System Limits ---
+    float max_system_current = INFY_MAX_MODULES * INFY_MODULE_MAX_CURRENT_A;
+    if (target_amps > max_system_current) target_amps = max_system_current;
+    float max_volts = Infy_RangeMaxVoltage(infy_out[outlet].range);
+    if (target_volts > max_volts) target_volts = max_volts;
 
-    if (!enable) {
-        target_volts = 0.0f;
-        current_per_module = 0.0f;
-    }
+    // --- 2. Load Sharing ---
+    // Publish only: the scheduler sends a changed setpoint at once (rate
+    // limited) and repeats it as keep-alive, not on every control cycle.
+    // Infy_Process() restages from this demand and re-splits the current.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    infy_out[outlet].volts = target_volts;
+    infy_out[outlet].amps = target_amps;
+    infy_out[outlet].enable = enable;
+    Infy_BuildSetpoint(outlet);
+#if INFY_USE_SIMULATION
+    Infy_Control_t ctl;
+    Infy_Control_Unpack(infy_out[outlet].setpoint, &ctl);
+#endif
+    __set_PRIMASK(primask);
 
 #if INFY_USE_SIMULATION
-    for(int i=0; i<INFY_MAX_MODULES; i++)
+    // Simulated modules answer through the RX path (the CAN task stays the table's only writer)
+    Infy_Mask_t staged = Infy_GroupModules(infy_tab.out_stage[outlet]);
+    for(int i=0; i<INFY_SIM_MODULES && i<INFY_MAX_MODULES && infy_hfdcan != NULL; i++)
     {
-        if (enable) {
+        if (!(infy_tab.out_mods[outlet] & INFY_BIT(i))) continue;
+        bool run = enable && (staged & INFY_BIT(i));
+        if (run) {
              // Sim Ramp
              if (sim_modules[i].sim_volt < target_volts) sim_modules[i].sim_volt += 20.0f;
              else if (sim_modules[i].sim_volt > target_volts) sim_modules[i].sim_volt -= 20.0f;
              
              // Sim Load
-             if (sim_modules[i].sim_volt > 300.0f) sim_modules[i].sim_curr = current_per_module;
+             if (sim_modules[i].sim_volt > 300.0f) sim_modules[i].sim_curr = ctl.current * 0.1f;
              else sim_modules[i].sim_curr = 0.0f;
-             
-             modules[i].is_on = true;
         } else {
              sim_modules[i].sim_volt *= 0.9f;
              sim_modules[i].sim_curr = 0.0f;
-             modules[i].is_on = false;
         }
-        
-        modules[i].output_voltage = sim_modules[i].sim_volt;
-        modules[i].output_current = sim_modules[i].sim_curr;
-        modules[i].comm_timeout = false;
-        modules[i].last_rx_tick = HAL_GetTick(); // Keep alive
+
+        Infy_Status_t st = {
+            .voltage = (uint16_t)(sim_modules[i].sim_volt * 10.0f),
+            .current = (uint16_t)(sim_modules[i].sim_curr * 10.0f),
+            .is_on = run ? 1 : 0,
+            .range_high = (infy_tab.range_cmd >> (i / INFY_GROUP_SIZE)) & 1U,
+        };
+        CAN_Message_t msg = {
+            .timestamp_us = Timebase_GetMicros(), // Keep alive
+            .id = INFY_CAN_ID_STATUS_BASE + i,
+            .len = INFY_STATUS_LEN,
+            .bus = (uint8_t)CAN_GetBusIndex(infy_hfdcan),
+            .id_type = CAN_ID_EXT,
+        };
+        Infy_Status_Pack(&st, msg.data);
+        CAN_InjectRx(&msg);
     }
-    return;
 #endif
+}
+
+bool Infy_SetOutputFast(uint8_t outlet, float target_volts, float target_amps, uint64_t trigger_us)
+{
+    if (outlet >= INFY_OUTLETS) return false;
 
-    if (infy_hfdcan == NULL) return;
+    float max_system_current = INFY_MAX_MODULES * INFY_MODULE_MAX_CURRENT_A;
+    if (target_amps > max_system_current) target_amps = max_system_current;
+    float max_volts = Infy_RangeMaxVoltage(infy_out[outlet].range);
+    if (target_volts > max_volts) target_volts = max_volts;
 
-    // CAN Tx Logic (Broadcast)
-    uint8_t data[8] = {0};
-    uint16_t v_set = (uint16_t)(target_volts * 10.0f);
-    uint16_t c_set = (uint16_t)(current_per_module * 10.0f); // Send Shared Current!
-    
-    data[0] = (uint8_t)(v_set >> 8);
-    data[1] = (uint8_t)(v_set & 0xFF);
-    data[2] = (uint8_t)(c_set >> 8);
-    data[3] = (uint8_t)(c_set & 0xFF);
-    data[4] = enable ? 0x01 : 0x00; 
-    
-    // Broadcast ID
-    CAN_Transmit(infy_hfdcan, INFY_CAN_ID_CONTROL_BASE, data, 8);
+    uint8_t data[sizeof(infy_out[outlet].setpoint)];
+    uint8_t prev[sizeof(infy_out[outlet].setpoint)];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    infy_fast.triggers++;
+    if (!infy_out[outlet].enable || !infy_out[outlet].setpoint_valid || !Infy_OutletLive(outlet))
+    {
+        infy_fast.rejected++;
+        __set_PRIMASK(primask);
+        return false;
+    }
+    infy_out[outlet].volts = target_volts;
+    infy_out[outlet].amps = target_amps;
+    memcpy(prev, infy_out[outlet].setpoint, sizeof(prev));
+    Infy_BuildSetpoint(outlet);
+    memcpy(data, infy_out[outlet].setpoint, sizeof(data));
+    bool changed = (memcmp(prev, data, sizeof(data)) != 0);
+    if (!changed) infy_fast.unchanged++;
+    __set_PRIMASK(primask);
+
+    if (!changed) return true;
+
+    // Probe first: the frame may be on the wire before CAN_Transmit returns.
+    // All outlets share the control ID, so the group mask picks this one.
+    CAN_TxProbeArm(infy_hfdcan, INFY_CAN_ID_CONTROL_BASE, INFY_CONTROL_GROUP_BYTE, data[INFY_CONTROL_GROUP_BYTE]);
+    bool queued = CAN_Transmit(infy_hfdcan, INFY_CAN_ID_CONTROL_BASE, data, sizeof(data), CAN_TX_PRIO_CRITICAL);
+    if (queued) CAN_Sched_MarkSent(infy_out[outlet].control_handle, data, sizeof(data));
+
+    uint32_t queue_us = (uint32_t)(Timebase_GetMicros() - trigger_us);
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (queued)
+    {
+        infy_fast.sent++;
+        infy_fast.queue_last_us = queue_us;
+        if (queue_us > infy_fast.queue_max_us) infy_fast.queue_max_us = queue_us;
+        infy_fast_trigger_us = trigger_us;
+        infy_fast_probing = true;
+    }
+    else
+    {
+        infy_fast.rejected++; // Scheduler sends the changed setpoint
+    }
+    __set_PRIMASK(primask);
+
+    return queued;
+}
+
+Infy_OutputRange_t Infy_SelectRange(float ev_volts)
+{
+    // LOW up to its limit less the margin (CV end point and the ramp's overshoot)
+    return (ev_volts <= INFY_RANGE_LOW_V_MAX - INFY_RANGE_MARGIN_V) ? INFY_RANGE_LOW : INFY_RANGE_HIGH;
 }
 
-const Infy_SystemStatus_t* Infy_GetSystemStatus(void)
+void Infy_SetRange(uint8_t outlet, Infy_OutputRange_t range)
 {
-    float max_v = 0.0f;
-    float total_i = 0.0f;
-    int valid_cnt = 0;
-    bool any_fault = false;
+    if (outlet >= INFY_OUTLETS) return;
 
-    for (int i=0; i<INFY_MAX_MODULES; i++)
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool changed = (range != infy_out[outlet].range);
+    infy_out[outlet].range = range;
+    __set_PRIMASK(primask);
+
+    if (changed) printf("[Infy] Outlet %d Range Requested: %s\r\n", outlet + 1, (range == INFY_RANGE_HIGH) ? "HIGH" : "LOW");
+}
+
+bool Infy_AssignGroup(uint8_t group, uint8_t outlet)
+{
+    if (group >= INFY_GROUP_COUNT || (outlet >= INFY_OUTLETS && outlet != INFY_OUTLET_NONE)) return false;
+
+    uint8_t from = infy_tab.outlet[group];
+    if (from == outlet) return true;
+
+    uint8_t bit = (uint8_t)(1U << group);
+    Infy_Mask_t mods = INFY_GROUP_BITS << (group * INFY_GROUP_SIZE);
+
+    // Out of the old outlet at once: unstaged, out of its running set and sums
+    if (from < INFY_OUTLETS)
     {
-        // Check Timeout (1s)
-        if (HAL_GetTick() - modules[i].last_rx_tick > 1000) modules[i].comm_timeout = true;
+        infy_tab.groups[from] &= (uint8_t)~bit;
+        infy_tab.out_mods[from] &= ~mods;
+        infy_tab.out_stage[from] &= (uint8_t)~bit;
+        infy_tab.running_mask[from] &= ~mods;
+        infy_tab.out_running[from] = Infy_MaskCount(infy_tab.running_mask[from]);
+        Infy_ScanOutlet(from);
+    }
+    infy_tab.stage_mask &= (uint8_t)~bit;
+    infy_tab.running = 0;
+    for (int o = 0; o < INFY_OUTLETS; o++) infy_tab.running += infy_tab.out_running[o];
+
+    // Into the new one: staged by its next Infy_Process() (range permitting)
+    infy_tab.outlet[group] = outlet;
+    if (outlet < INFY_OUTLETS)
+    {
+        infy_tab.groups[outlet] |= bit;
+        infy_tab.out_mods[outlet] |= mods;
+        Infy_ScanOutlet(outlet);
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (from < INFY_OUTLETS && infy_out[from].setpoint_valid) Infy_BuildSetpoint(from);
+    if (outlet < INFY_OUTLETS && infy_out[outlet].setpoint_valid) Infy_BuildSetpoint(outlet);
+    __set_PRIMASK(primask);
+
+    Infy_Publish();
 
-        if (!modules[i].comm_timeout)
+    if (outlet < INFY_OUTLETS) printf("[Infy] Group %d -> Outlet %d\r\n", group, outlet + 1);
+    else printf("[Infy] Group %d Released (Outlet %d)\r\n", group, from + 1);
+    return true;
+}
+
+bool Infy_GetOutletStatus(uint8_t outlet, Infy_OutletStatus_t *status)
+{
+    if (outlet >= INFY_OUTLETS) return false;
+
+    uint32_t seq;
+    do {
+        seq = infy_seq;
+        __DMB();
+        *status = outlet_status[outlet];
+        __DMB();
+    } while ((seq & 1U) || seq != infy_seq);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    status->enable = infy_out[outlet].enable;
+    status->demand_volts = infy_out[outlet].volts;
+    status->demand_amps = infy_out[outlet].amps;
+    status->range = infy_out[outlet].range;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+float Infy_RangeCurrentLimit(Infy_OutputRange_t range, float volts)
+{
+    float amps = INFY_MODULE_MAX_CURRENT_A;
+    if (range == INFY_RANGE_HIGH) amps = amps * INFY_RANGE_HIGH_CURRENT_PCT / 100.0f;
+
+    // Power limit (the LOW range reaches it from 400 V on, HIGH from 800 V)
+    if (volts > 0.0f)
+    {
+        float power_amps = INFY_MODULE_RATED_KW * 1000.0f / volts;
+        if (power_amps < amps) amps = power_amps;
+    }
+    return amps;
+}
+
+void Infy_GetFastStats(Infy_FastStats_t *stats)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = infy_fast;
+    __set_PRIMASK(primask);
+}
+
+void Infy_GetSystemStatus(Infy_SystemStatus_t *status)
+{
+    uint32_t seq;
+    do {
+        seq = infy_seq;
+        __DMB();
+        *status = system_status;
+        __DMB();
+    } while ((seq & 1U) || seq != infy_seq);
+}
+
+bool Infy_GetModuleStatus(uint8_t index, Infy_ModuleStatus_t *status)
+{
+    if (index >= INFY_MAX_MODULES) return false;
+
+    Infy_Mask_t bit = INFY_BIT(index);
+    uint32_t seq;
+    do {
+        seq = infy_seq;
+        __DMB();
+        status->output_voltage = infy_tab.voltage_dv[index] * 0.1f;
+        status->output_current = infy_tab.current_da[index] * 0.1f;
+        status->is_on = (infy_tab.on & bit) != 0;
+        status->fault_ov = (infy_tab.faults[index] & INFY_FAULT_OV) != 0;
+        status->fault_uv = (infy_tab.faults[index] & INFY_FAULT_UV) != 0;
+        status->fault_ot = (infy_tab.faults[index] & INFY_FAULT_OT) != 0;
+        status->comm_timeout = (infy_tab.alive & bit) == 0;
+        status->range_high = (infy_tab.range_high & bit) != 0;
+        status->discovered = (infy_tab.discovered & bit) != 0;
+        status->rated_kw = infy_tab.rated_hw[index] * 0.1f;
+        status->max_current = infy_tab.max_current_da[index] * 0.1f;
+        status->sweet_pct = infy_tab.sweet_pct[index];
+        status->current_trim = infy_tab.trim_da[index] * 0.1f;
+        status->last_rx_us = infy_tab.last_rx_us[index];
+        status->polled = 0;
+        for (int k = 0; k < INFY_POLL_ITEMS; k++)
         {
-            if (modules[i].output_voltage > max_v) max_v = modules[i].output_voltage;
-            total_i += modules[i].output_current;
-            valid_cnt++;
-            
-            if (modules[i].fault_ot || modules[i].fault_ov || modules[i].fault_uv) any_fault = true;
+            if (infy_tab.polled[k] & bit) status->polled |= (uint8_t)(1U << k);
         }
-    }
-    
-    system_status.active_modules = valid_cnt;
-    system_status.total_voltage = max_v; // Use Max voltage for safety
-    system_status.total_current = total_i;
-    system_status.system_fault = any_fault;
+        status->temp_inlet = infy_tab.temp_c[index][0];
+        status->temp_pfc = infy_tab.temp_c[index][1];
+        status->temp_dcdc = infy_tab.temp_c[index][2];
+        for (int p = 0; p < 3; p++) status->ac_voltage[p] = infy_tab.ac_dv[index][p] * 0.1f;
+        status->fault_word = infy_tab.fault_word[index];
+        status->derate_pct = infy_tab.derate_pct[index];
+        status->derate_reason = infy_tab.derate_reason[index];
+        __DMB();
+    } while ((seq & 1U) || seq != infy_seq);
+
+    return true;
+}
+
+void Infy_GetShareStatus(uint8_t outlet, Infy_ShareStatus_t *status)
+{
+    if (outlet >= INFY_OUTLETS) outlet = 0;
 
-    return &system_status;
+    uint32_t seq;
+    do {
+        seq = infy_seq;
+        __DMB();
+        *status = share_status[outlet];
+        __DMB();
+    } while ((seq & 1U) || seq != infy_seq);
 }
 
-const Infy_ModuleStatus_t* Infy_GetModuleStatus(uint8_t index)
+void Infy_GetPollStatus(Infy_PollStatus_t *status)
 {
-    if (index >= INFY_MAX_MODULES) return NULL;
-    return &modules[index];
+    uint32_t seq;
+    do {
+        seq = infy_seq;
+        __DMB();
+        *status = poll_status;
+        __DMB();
+    } while ((seq & 1U) || seq != infy_seq);
+}
+
+bool Infy_GetGroupStatus(uint8_t group, Infy_GroupStatus_t *status)
+{
+    if (group >= INFY_GROUP_COUNT) return false;
+
+    Infy_Mask_t bits = INFY_GROUP_BITS << (group * INFY_GROUP_SIZE);
+    uint32_t seq;
+    do {
+        seq = infy_seq;
+        __DMB();
+        status->discovered = Infy_MaskCount(infy_tab.discovered & bits);
+        status->alive = Infy_MaskCount(infy_tab.alive & bits);
+        status->usable = Infy_MaskCount(infy_tab.alive & ~infy_tab.fault & bits);
+        status->on = Infy_MaskCount(infy_tab.alive & infy_tab.on & bits);
+        status->outlet = infy_tab.outlet[group];
+        status->staged = (infy_tab.stage_mask & (1U << group)) != 0;
+        status->rated_kw = infy_tab.group_rated_w[group] * 0.001f;
+        status->sweet_kw = infy_tab.group_sweet_w[group] * 0.001f;
+        status->range_high = (infy_tab.range_cmd & (1U << group)) != 0;
+        status->range_ready = (infy_tab.range_ready & (1U << group)) != 0;
+        status->voltage = Infy_ScanMaxVoltage(bits) * 0.1f;
+        __DMB();
+    } while ((seq & 1U) || seq != infy_seq);
+
+    return true;
 }
 
 bool Infy_IsHealthy(void)
 {
-    const Infy_SystemStatus_t *s = Infy_GetSystemStatus();
+    Infy_SystemStatus_t s;
+    Infy_GetSystemStatus(&s);
     // Logic: At least 1 module active and no Global Fault?
     // Or need minimum N modules? For now, simple check.
-    if (s->system_fault) return false;
-    if (s->active_modules == 0) return false; // No power available
+    if (s.system_fault) return false;
+    if (s.active_modules == 0) return false; // No power available
     return true;
 }
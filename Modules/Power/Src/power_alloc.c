@@ -0,0 +1,379 @@
+/**
+ * @file    power_alloc.c
+ * @brief   Power Module Allocation Matrix Implementation
+ *
+ * @details
+ * A connector's need is its regulator's current target, clamped to its
+ * thermal limit. A group's capacity is counted as an average group (usable
+ * modules of the pool / usable groups) at the connector's voltage and
+ * range, so one evaluation is a handful of multiplications per connector;
+ * what a move does to the real sums shows in the next evaluation.
+ *
+ * The matrix state (owner, move phase) is only written here, in the CAN
+ * task, where Infy_AssignGroup() and the regulator tick run as well. The
+ * status copy for the CLI is taken under PRIMASK.
+ */
+
+#include "power_alloc.h"
+#include "power_reg.h"
+#include "relay_driver.h"
+#include "meter_driver.h"
+#include "main.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+_Static_assert(EVSE_CONNECTOR_COUNT == 1 || INFY_GROUP_COUNT <= RELAY_MATRIX_GROUPS,
+               "Module group without a matrix contactor");
+
+static struct
+{
+    bool     started;
+    uint32_t last_ms;                        // Previous evaluation
+    uint32_t phase_ms[INFY_GROUP_COUNT];     // Move phase entered
+    bool     late[INFY_GROUP_COUNT];         // Off timeout logged
+    uint32_t change_ms[EVSE_CONNECTOR_COUNT];// Last group switched on or off the connector
+    uint8_t  want[EVSE_CONNECTOR_COUNT];     // Groups its need asks for (before the fair share)
+    PowerAlloc_Status_t st;                  // Working copy
+} palloc;
+
+static PowerAlloc_Status_t palloc_status; // PRIMASK
+
+static void PowerAlloc_Publish(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    palloc_status = palloc.st;
+    __set_PRIMASK(primask);
+}
+
+void PowerAlloc_Init(void)
+{
+    memset(&palloc, 0, sizeof(palloc));
+    for (uint8_t g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        // Infy_Init starts the same way: one outlet owns all, several own none
+        palloc.st.owner[g] = (EVSE_CONNECTOR_COUNT > 1) ? INFY_OUTLET_NONE : 0U;
+        palloc.st.dest[g] = INFY_OUTLET_NONE;
+        palloc.st.phase[g] = PALLOC_GROUP_IDLE;
+    }
+    PowerAlloc_Publish();
+
+    printf("[Alloc] Initialized (%d Connector(s), %d Groups%s)\r\n", EVSE_CONNECTOR_COUNT, INFY_GROUP_COUNT,
+           (EVSE_CONNECTOR_COUNT > 1) ? ", Matrix" : "");
+}
+
+#if EVSE_CONNECTOR_COUNT > 1
+
+static void PowerAlloc_Enter(uint8_t g, PowerAlloc_Phase_t phase, uint32_t now)
+{
+    palloc.st.phase[g] = (uint8_t)phase;
+    palloc.phase_ms[g] = now;
+    palloc.late[g] = false;
+}
+
+// Take a group off its connector's setpoint; dest gets it once it is off
+static void PowerAlloc_Release(uint8_t g, uint8_t dest, uint32_t now)
+{
+    uint8_t from = palloc.st.owner[g];
+    Infy_AssignGroup(g, INFY_OUTLET_NONE);
+    palloc.st.dest[g] = dest;
+    palloc.change_ms[from] = now;
+    PowerAlloc_Enter(g, PALLOC_GROUP_DRAIN, now);
+
+    if (dest == INFY_OUTLET_NONE) printf("[Alloc] Group %d: Connector %d -> Free\r\n", g, from + 1);
+    else printf("[Alloc] Group %d: Connector %d -> %d\r\n", g, from + 1, dest + 1);
+}
+
+// A group's output may meet the connector's bus: discharged, or matched to
+// the bus (its modules; the EV battery through a closed main relay)
+static bool PowerAlloc_CloseReady(uint8_t g, uint8_t conn)
+{
+    Infy_GroupStatus_t gs;
+    Infy_GetGroupStatus(g, &gs);
+    Infy_OutletStatus_t out;
+    Infy_GetOutletStatus(conn, &out);
+
+    float bus_v = out.voltage;
+    float meter_v = Meter_ReadVoltage(conn);
+    if ((Relay_GetState(conn) & 0x01) && meter_v > bus_v) bus_v = meter_v;
+
+    if (gs.voltage <= PALLOC_DISCHARGED_V || fabsf(gs.voltage - bus_v) <= PALLOC_MATCH_V) return true;
+    palloc.st.close_holds++;
+    return false;
+}
+
+// Close a free group onto a connector (assigned once the contactor settled)
+static bool PowerAlloc_Connect(uint8_t g, uint8_t conn, uint32_t now)
+{
+    if (!PowerAlloc_CloseReady(g, conn)) return false;
+    if (!Relay_SetMatrix(conn, g, true)) return false; // Interlock (logged by the driver)
+    palloc.st.owner[g] = conn;
+    palloc.st.dest[g] = conn;
+    PowerAlloc_Enter(g, PALLOC_GROUP_CLOSE, now);
+    return true;
+}
+
+// Advance a move: drain -> open -> close -> assign
+static void PowerAlloc_Step(uint8_t g, uint32_t now)
+{
+    PowerAlloc_Status_t *s = &palloc.st;
+    uint32_t age = now - palloc.phase_ms[g];
+
+    switch (s->phase[g])
+    {
+        case PALLOC_GROUP_DRAIN:
+        {
+            Infy_GroupStatus_t gs;
+            Infy_GetGroupStatus(g, &gs);
+            if (gs.on != 0)
+            {
+                // Never open under load: wait for the modules (or their timeout)
+                if (age >= PALLOC_OFF_TIMEOUT_MS && !palloc.late[g])
+                {
+                    palloc.late[g] = true;
+                    s->off_timeouts++;
+                    printf("[Alloc] Group %d: %d Module(s) Still On, Contactor Held\r\n", g, gs.on);
+                }
+                break;
+            }
+            if (age < PALLOC_OFF_MIN_MS) break;
+
+            Relay_SetMatrix(s->owner[g], g, false);
+            s->owner[g] = INFY_OUTLET_NONE;
+            PowerAlloc_Enter(g, PALLOC_GROUP_OPEN, now);
+            break;
+        }
+        case PALLOC_GROUP_OPEN:
+            if (age < PALLOC_CONTACTOR_MS) break;
+            if (s->dest[g] != INFY_OUTLET_NONE && !PowerAlloc_Connect(g, s->dest[g], now))
+            {
+                // Output capacitors still charged against the bus: let them bleed down
+                if (age < PALLOC_CLOSE_TIMEOUT_MS) break;
+                printf("[Alloc] Group %d: Not Closed onto Connector %d (Voltage / Interlock), Left Free\r\n",
+                       g, s->dest[g] + 1);
+                s->dest[g] = INFY_OUTLET_NONE;
+            }
+            if (s->dest[g] == INFY_OUTLET_NONE)
+            {
+                PowerAlloc_Enter(g, PALLOC_GROUP_IDLE, now); // Free
+            }
+            break;
+        case PALLOC_GROUP_CLOSE:
+            if (age < PALLOC_CONTACTOR_MS) break;
+            Infy_AssignGroup(g, s->owner[g]);
+            palloc.change_ms[s->owner[g]] = now;
+            s->dest[g] = INFY_OUTLET_NONE;
+            s->moves++;
+            PowerAlloc_Enter(g, PALLOC_GROUP_IDLE, now);
+            break;
+        default:
+            break;
+    }
+}
+
+// Connector short of its target with the largest shortfall (A), NONE if none
+static uint8_t PowerAlloc_Neediest(void)
+{
+    const PowerAlloc_Status_t *s = &palloc.st;
+    uint8_t best = INFY_OUTLET_NONE;
+    float best_gap = 0.0f;
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        if (s->held[c] >= s->target[c]) continue;
+        float gap = s->need_a[c] - s->held[c] * s->group_a[c];
+        if (best == INFY_OUTLET_NONE || gap > best_gap)
+        {
+            best = c;
+            best_gap = gap;
+        }
+    }
+    return best;
+}
+
+// Wants from the needs, cut to a fair share when the pool is short
+static void PowerAlloc_Targets(uint8_t usable_groups)
+{
+    PowerAlloc_Status_t *s = &palloc.st;
+    unsigned sum = 0;
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        uint8_t want = 0;
+        if (s->active[c])
+        {
+            want = 1; // Pre-charge, or a car asking for 0 A
+            if (s->group_a[c] > 0.0f)
+            {
+                float k = s->need_a[c] * PALLOC_HEADROOM_PCT / 100.0f / s->group_a[c];
+                if (k > (float)usable_groups) k = (float)usable_groups;
+                uint8_t n = (uint8_t)k;
+                if ((float)n < k) n++;
+                if (n > want) want = n;
+            }
+            if (want > usable_groups) want = usable_groups;
+        }
+        palloc.want[c] = want;
+        s->target[c] = want;
+        sum += want;
+    }
+    if (sum <= usable_groups) return;
+
+    // Fair share: one group each, the rest one by one to the largest shortfall
+    uint8_t left = usable_groups;
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        s->target[c] = (palloc.want[c] > 0 && left > 0) ? 1U : 0U;
+        left -= s->target[c];
+    }
+    while (left > 0)
+    {
+        uint8_t best = INFY_OUTLET_NONE;
+        float best_gap = 0.0f;
+        for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+        {
+            if (s->target[c] >= palloc.want[c]) continue;
+            float gap = s->need_a[c] - s->target[c] * s->group_a[c];
+            if (best == INFY_OUTLET_NONE || gap > best_gap)
+            {
+                best = c;
+                best_gap = gap;
+            }
+        }
+        if (best == INFY_OUTLET_NONE) break;
+        s->target[best]++;
+        left--;
+    }
+}
+
+static void PowerAlloc_Balance(uint32_t now)
+{
+    PowerAlloc_Status_t *s = &palloc.st;
+
+    // Pool: usable groups, average group size
+    uint8_t usable[INFY_GROUP_COUNT];
+    bool staged[INFY_GROUP_COUNT];
+    uint8_t usable_groups = 0;
+    unsigned usable_mods = 0;
+    for (uint8_t g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        Infy_GroupStatus_t gs;
+        Infy_GetGroupStatus(g, &gs);
+        usable[g] = gs.usable;
+        staged[g] = gs.staged;
+        if (gs.usable > 0)
+        {
+            usable_groups++;
+            usable_mods += gs.usable;
+        }
+    }
+    float avg_mods = (usable_groups > 0) ? (float)usable_mods / usable_groups : 0.0f;
+
+    // Needs
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        PowerReg_Status_t reg;
+        PowerReg_GetStatus(c, &reg);
+        Infy_OutletStatus_t out;
+        Infy_GetOutletStatus(c, &out);
+
+        float need = (reg.limit_current < reg.target_current) ? reg.limit_current : reg.target_current;
+        float volts = (reg.target_voltage > PALLOC_MIN_VOLTS) ? reg.target_voltage : PALLOC_MIN_VOLTS;
+        s->active[c] = reg.enabled;
+        s->need_a[c] = (reg.enabled && need > 0.0f) ? need : 0.0f;
+        s->group_a[c] = avg_mods * Infy_RangeCurrentLimit(out.range, volts);
+        s->held[c] = 0;
+    }
+
+    // Held: on the connector, or on the way to it
+    for (uint8_t g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        if (usable[g] == 0) continue;
+        uint8_t c = (s->phase[g] == PALLOC_GROUP_IDLE) ? s->owner[g] : s->dest[g];
+        if (c < EVSE_CONNECTOR_COUNT) s->held[c]++;
+    }
+
+    PowerAlloc_Targets(usable_groups);
+
+    // 1. Idle connectors free their groups (their output is already off)
+    for (uint8_t g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        uint8_t c = s->owner[g];
+        if (s->phase[g] != PALLOC_GROUP_IDLE || c >= EVSE_CONNECTOR_COUNT || s->active[c]) continue;
+        PowerAlloc_Release(g, INFY_OUTLET_NONE, now);
+        if (usable[g] > 0) s->held[c]--;
+    }
+
+    // 2. Free groups to the largest shortfall
+    bool free_left = false;
+    for (uint8_t g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        if (s->phase[g] != PALLOC_GROUP_IDLE || s->owner[g] != INFY_OUTLET_NONE || usable[g] == 0) continue;
+        uint8_t c = PowerAlloc_Neediest();
+        if (c == INFY_OUTLET_NONE)
+        {
+            free_left = true;
+            break;
+        }
+        if (PowerAlloc_Connect(g, c, now)) s->held[c]++;
+    }
+
+    // 3. Pool used up and a connector still short: the largest surplus gives
+    //    one group up (one move in flight at a time, the donor's dwell elapsed)
+    uint8_t taker = PowerAlloc_Neediest();
+    if (free_left || taker == INFY_OUTLET_NONE) return;
+    for (uint8_t g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        if (s->phase[g] != PALLOC_GROUP_IDLE) return;
+    }
+
+    uint8_t donor = INFY_OUTLET_NONE;
+    int best_surplus = 0;
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        int surplus = (int)s->held[c] - (int)s->target[c];
+        if (surplus > best_surplus && (now - palloc.change_ms[c]) >= PALLOC_DWELL_MS)
+        {
+            donor = c;
+            best_surplus = surplus;
+        }
+    }
+    if (donor == INFY_OUTLET_NONE) return;
+
+    // Its least loaded group: an unstaged one first, else the highest
+    uint8_t pick = INFY_OUTLET_NONE;
+    for (uint8_t g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        if (s->owner[g] != donor || usable[g] == 0) continue;
+        if (pick == INFY_OUTLET_NONE || !staged[g] || staged[pick]) pick = g;
+    }
+    if (pick != INFY_OUTLET_NONE) PowerAlloc_Release(pick, taker, now);
+}
+
+#endif /* EVSE_CONNECTOR_COUNT > 1 */
+
+void PowerAlloc_Process(void)
+{
+#if EVSE_CONNECTOR_COUNT > 1
+    uint32_t now = HAL_GetTick();
+    if (palloc.started && (now - palloc.last_ms) < PALLOC_PERIOD_MS) return;
+    palloc.started = true;
+    palloc.last_ms = now;
+
+    for (uint8_t g = 0; g < INFY_GROUP_COUNT; g++)
+    {
+        PowerAlloc_Step(g, now);
+    }
+    PowerAlloc_Balance(now);
+
+    palloc.st.evaluations++;
+    PowerAlloc_Publish();
+#endif
+}
+
+void PowerAlloc_GetStatus(PowerAlloc_Status_t *status)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = palloc_status;
+    __set_PRIMASK(primask);
+}
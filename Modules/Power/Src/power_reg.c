@@ -0,0 +1,282 @@
+/**
+ * @file    power_reg.c
+ * @brief   DC Output Regulator Implementation
+ *
+ * @details
+ * State is shared by the control task (targets), the SECC RX ISR (fast
+ * target drops) and the CAN task (tick), so every update runs under
+ * PRIMASK, including the Infy_SetOutput() that applies it: a tick cannot
+ * overwrite a drop the ISR has just sent with an older, higher command.
+ * The feedback is read before that section (the aggregate is a seqlock
+ * read and the meter value a plain float).
+ *
+ * The current target is clamped to the thermal derating limit here, once
+ * per tick: it falls at once like a lower target and comes back with the
+ * ramp. The target itself keeps what the EV asked for.
+ *
+ * One regulator per connector, each driving its own Infy outlet from the
+ * feedback of that outlet (its modules, its meter, its main relay).
+ *
+ * The step uses the measured time since the last tick, so the ramps keep
+ * their rate when the CAN task is late; a gap above PREG_DT_MAX_S is
+ * treated as PREG_DT_MAX_S. The trims are computed on the error against
+ * the reference, not the target, and only the P part of the active loop
+ * reacts at once; the integrators are clamped to the trim range.
+ */
+
+#include "power_reg.h"
+#include "infy_power.h"
+#include "thermal_derate.h"
+#include "meter_driver.h"
+#include "relay_driver.h"
+#include "config_manager.h"
+#include "timebase.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct
+{
+    bool     running;      // References initialised since the enable
+    float    integ_v;      // Integrator (V)
+    float    integ_i;      // Integrator (A)
+    uint64_t last_us;      // Previous tick
+} PowerReg_State_t;
+
+static PowerReg_State_t preg[EVSE_CONNECTOR_COUNT];          // PRIMASK
+static PowerReg_Status_t preg_status[EVSE_CONNECTOR_COUNT];  // PRIMASK
+
+static float PowerReg_Clamp(float x, float limit)
+{
+    if (x > limit) return limit;
+    if (x < -limit) return -limit;
+    return x;
+}
+
+// Rise by at most step, fall at once
+static float PowerReg_Slew(float ref, float target, float step)
+{
+    if (target <= ref || step <= 0.0f) return target;
+    return (target - ref > step) ? ref + step : target;
+}
+
+// PRIMASK held
+static void PowerReg_Command(PowerReg_Status_t *st)
+{
+    float v = st->ref_voltage + st->trim_voltage;
+    float i = st->ref_current + st->trim_current;
+    st->cmd_voltage = (v > 0.0f) ? v : 0.0f;
+    st->cmd_current = (i > 0.0f) ? i : 0.0f;
+}
+
+// PRIMASK held: drop the references to a lower target, true if the command fell
+static bool PowerReg_Cut(uint8_t conn)
+{
+    PowerReg_State_t *pr = &preg[conn];
+    PowerReg_Status_t *st = &preg_status[conn];
+
+    if (!pr->running) return false;
+
+    bool cut = false;
+    if (st->ref_voltage > st->target_voltage)
+    {
+        st->ref_voltage = st->target_voltage;
+        cut = true;
+    }
+    if (st->ref_current > st->target_current)
+    {
+        st->ref_current = st->target_current;
+        cut = true;
+    }
+    if (cut) PowerReg_Command(st);
+    return cut;
+}
+
+void PowerReg_Init(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(preg, 0, sizeof(preg));
+    memset(preg_status, 0, sizeof(preg_status));
+    uint64_t now = Timebase_GetMicros();
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++) preg[c].last_us = now;
+    __set_PRIMASK(primask);
+
+    const SystemConfig_t *cfg = Config_Get();
+    printf("[PowerReg] Initialized (%d Hz, Ramp %u V/s %u A/s)\r\n",
+           1000 / PREG_PERIOD_MS, cfg->reg_ramp_v_s, cfg->reg_ramp_a_s);
+}
+
+void PowerReg_SetTarget(uint8_t conn, float volts, float amps, bool enable)
+{
+    if (conn >= EVSE_CONNECTOR_COUNT) return;
+    PowerReg_State_t *pr = &preg[conn];
+    PowerReg_Status_t *st = &preg_status[conn];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (!enable)
+    {
+        pr->running = false;
+        pr->integ_v = 0.0f;
+        pr->integ_i = 0.0f;
+        st->enabled = false;
+        st->cv_mode = false;
+        st->target_voltage = 0.0f;
+        st->target_current = 0.0f;
+        st->ref_voltage = 0.0f;
+        st->ref_current = 0.0f;
+        st->trim_voltage = 0.0f;
+        st->trim_current = 0.0f;
+        st->cmd_voltage = 0.0f;
+        st->cmd_current = 0.0f;
+        __set_PRIMASK(primask);
+
+        // Outside PRIMASK: the simulation answers through the RX path
+        Infy_SetOutput(conn, 0.0f, 0.0f, false);
+        return;
+    }
+
+    st->enabled = true;
+    st->target_voltage = volts;
+    st->target_current = amps;
+    if (PowerReg_Cut(conn)) Infy_SetOutput(conn, st->cmd_voltage, st->cmd_current, true);
+
+    __set_PRIMASK(primask);
+}
+
+bool PowerReg_SetTargetFast(uint8_t conn, float volts, float amps, uint64_t rx_us)
+{
+    if (conn >= EVSE_CONNECTOR_COUNT) return false;
+    PowerReg_Status_t *st = &preg_status[conn];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (!st->enabled)
+    {
+        __set_PRIMASK(primask);
+        return false;
+    }
+    st->target_voltage = volts;
+    st->target_current = amps;
+    bool cut = PowerReg_Cut(conn);
+    float cmd_v = st->cmd_voltage;
+    float cmd_i = st->cmd_current;
+    if (cut) st->fast_cuts++;
+    else if (st->target_voltage > st->ref_voltage || st->target_current > st->ref_current) st->fast_rises++;
+
+    __set_PRIMASK(primask);
+
+    return cut && Infy_SetOutputFast(conn, cmd_v, cmd_i, rx_us);
+}
+
+static void PowerReg_TickConnector(uint8_t conn, const Infy_SystemStatus_t *pwr)
+{
+    PowerReg_State_t *pr = &preg[conn];
+    PowerReg_Status_t *st = &preg_status[conn];
+
+    // Feedback: meter at the output once the main relay connects it, the outlet's modules before
+    Infy_OutletStatus_t out;
+    Infy_GetOutletStatus(conn, &out);
+    float meas_v = out.voltage;
+    float meter_v = Meter_ReadVoltage(conn);
+    if ((Relay_GetState(conn) & 0x01) && meter_v >= PREG_METER_MIN_V) meas_v = meter_v;
+    float meas_i = out.current;
+    bool feedback = ((pwr->alive_mask & out.modules) != 0);
+    float limit_i = Thermal_GetCurrentLimit(conn);
+
+    const SystemConfig_t *cfg = Config_Get();
+    float ramp_v = (float)cfg->reg_ramp_v_s;
+    float ramp_i = (float)cfg->reg_ramp_a_s;
+
+    uint64_t now = Timebase_GetMicros();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t period_us = (uint32_t)(now - pr->last_us);
+    pr->last_us = now;
+    float dt = period_us * 1e-6f;
+    if (dt > PREG_DT_MAX_S) dt = PREG_DT_MAX_S;
+
+    st->ticks++;
+    if (period_us > st->period_max_us) st->period_max_us = period_us;
+    st->meas_voltage = meas_v;
+    st->meas_current = meas_i;
+    st->limit_current = limit_i;
+
+    if (!st->enabled)
+    {
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    // Bumpless start: voltage from where the modules are, current from 0 A
+    if (!pr->running)
+    {
+        float mod_v = out.voltage;
+        pr->running = true;
+        st->ref_voltage = (mod_v < st->target_voltage) ? mod_v : st->target_voltage;
+        st->ref_current = 0.0f;
+    }
+
+    float tgt_v = st->target_voltage;
+    float tgt_i = st->target_current;
+    st->thermal_limited = (limit_i < tgt_i);
+    if (st->thermal_limited) tgt_i = limit_i;
+    st->ref_voltage = PowerReg_Slew(st->ref_voltage, tgt_v, (ramp_v > 0.0f) ? ramp_v * dt : 0.0f);
+    st->ref_current = PowerReg_Slew(st->ref_current, tgt_i, (ramp_i > 0.0f) ? ramp_i * dt : 0.0f);
+
+    float err_v = st->ref_voltage - meas_v;
+    float err_i = st->ref_current - meas_i;
+    bool cv = (err_v <= PREG_CV_BAND_V);
+    // Current loop only while current flows: before the EV takes current the
+    // error is the whole reference and would wind the trim up
+    bool cc_loop = !cv && (st->ref_current >= PREG_MIN_CURRENT_A) && (meas_i >= PREG_MIN_CURRENT_A);
+    st->cv_mode = cv;
+
+    float trim_v = pr->integ_v;
+    float trim_i = pr->integ_i;
+    if (feedback)
+    {
+        if (cv && st->ref_voltage == tgt_v)
+        {
+            pr->integ_v = PowerReg_Clamp(pr->integ_v + PREG_KI_V * err_v * dt, PREG_TRIM_MAX_V);
+            trim_v = pr->integ_v + PREG_KP_V * err_v;
+        }
+        else if (cc_loop && st->ref_current == tgt_i)
+        {
+            pr->integ_i = PowerReg_Clamp(pr->integ_i + PREG_KI_I * err_i * dt, PREG_TRIM_MAX_A);
+            trim_i = pr->integ_i + PREG_KP_I * err_i;
+        }
+    }
+    st->trim_voltage = PowerReg_Clamp(trim_v, PREG_TRIM_MAX_V);
+    st->trim_current = PowerReg_Clamp(trim_i, PREG_TRIM_MAX_A);
+
+    PowerReg_Command(st);
+    Infy_SetOutput(conn, st->cmd_voltage, st->cmd_current, true);
+
+    __set_PRIMASK(primask);
+}
+
+void PowerReg_Tick(void)
+{
+    Infy_SystemStatus_t pwr;
+    Infy_GetSystemStatus(&pwr);
+
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        PowerReg_TickConnector(c, &pwr);
+    }
+}
+
+void PowerReg_GetStatus(uint8_t conn, PowerReg_Status_t *status)
+{
+    if (conn >= EVSE_CONNECTOR_COUNT) conn = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = preg_status[conn];
+    __set_PRIMASK(primask);
+}
@@ -3,14 +3,36 @@
  * @brief   High Voltage Relay Control Driver
  * @author  Antigravity
  * @date    2026-01-31
+ *
+ * @note    One contactor set (main P/N, pre-charge) per connector. With more
+ *          than one connector the power module groups reach the outlets
+ *          through the allocation matrix: one contactor per group and
+ *          connector. The package has too few free pins for them, so they
+ *          hang off a chain of RELAY_MATRIX_CHAIN TPIC6B595 power shift
+ *          registers (output conn * RELAY_MATRIX_GROUPS + group), shifted
+ *          in on three GPIOs (main.h Matrix_*); /G holds every output off
+ *          until Relay_Init() has latched an all-open pattern.
+ *          A group is closed onto at most one connector at a time, the
+ *          driver refuses a second (it would tie two output buses together).
  */
 
 #ifndef MODULES_RELAY_RELAY_DRIVER_H_
 #define MODULES_RELAY_RELAY_DRIVER_H_
 
 #include "main.h"
+#include "evse_connector.h"
 #include <stdbool.h>
 
+#ifndef RELAY_MATRIX_GROUPS
+#define RELAY_MATRIX_GROUPS   8   // Matrix columns per connector (module groups)
+#endif
+
+#define RELAY_MATRIX_CHAIN    4   // TPIC6B595 fitted (8 outputs each)
+#define RELAY_MATRIX_OUTPUTS  (RELAY_MATRIX_CHAIN * 8)
+
+_Static_assert(EVSE_CONNECTOR_COUNT == 1 || EVSE_CONNECTOR_COUNT * RELAY_MATRIX_GROUPS <= RELAY_MATRIX_OUTPUTS,
+               "Matrix contactors exceed the shift register chain");
+
 /**
  * @brief Initialize Relay GPIOs to Safe State (Open)
  */
@@ -18,20 +40,41 @@ void Relay_Init(void);
 
 /**
  * @brief Control Main Contactor (Positive & Negative)
+ * @param conn Connector index
  * @param closed true=Close (Power ON), false=Open (Safe)
  */
-void Relay_SetMain(bool closed);
+void Relay_SetMain(uint8_t conn, bool closed);
 
 /**
  * @brief Control Precharge Relay
+ * @param conn Connector index
  * @param closed true=Close (Resistor Active), false=Open
  */
-void Relay_SetPrecharge(bool closed);
+void Relay_SetPrecharge(uint8_t conn, bool closed);
 
 /**
  * @brief Get Relay Status
+ * @param conn Connector index
  * @return Bit0: Main, Bit1: Precharge
  */
-uint8_t Relay_GetState(void);
+uint8_t Relay_GetState(uint8_t conn);
+
+/**
+ * @brief Switch a module group's matrix contactor to a connector
+ * @note  No-op on a single-connector build (groups hard-wired to the outlet).
+ *        Open the group's output first: the contactor is not rated to break
+ *        load current.
+ * @param conn   Connector index
+ * @param group  Module group (0 ~ RELAY_MATRIX_GROUPS-1)
+ * @param closed true=Close onto conn
+ * @return false if out of range or the group is closed onto another connector
+ */
+bool Relay_SetMatrix(uint8_t conn, uint8_t group, bool closed);
+
+/**
+ * @brief Groups whose matrix contactor is closed onto a connector
+ * @return Bit g = group g (single connector: all)
+ */
+uint8_t Relay_GetMatrix(uint8_t conn);
 
 #endif /* MODULES_RELAY_RELAY_DRIVER_H_ */
@@ -10,54 +10,194 @@
 #define RELAY_ACTIVE_STATE GPIO_PIN_SET
 #define RELAY_SAFE_STATE   GPIO_PIN_RESET
 
+typedef struct
+{
+    GPIO_TypeDef *main_p_port;
+    uint16_t      main_p_pin;
+    GPIO_TypeDef *main_n_port;
+    uint16_t      main_n_pin;
+    GPIO_TypeDef *precharge_port;
+    uint16_t      precharge_pin;
+} Relay_Pins_t;
+
+// Connector 1 is set up by CubeMX (gpio.c), the others by Relay_Init
+static const Relay_Pins_t relay_pins[EVSE_CONNECTOR_MAX] = {
+    { Relay_Main_P_GPIO_Port, Relay_Main_P_Pin, Relay_Main_N_GPIO_Port, Relay_Main_N_Pin,
+      Relay_Precharge_GPIO_Port, Relay_Precharge_Pin },
+    { Relay2_Main_P_GPIO_Port, Relay2_Main_P_Pin, Relay2_Main_N_GPIO_Port, Relay2_Main_N_Pin,
+      Relay2_Precharge_GPIO_Port, Relay2_Precharge_Pin },
+    { Relay3_Main_P_GPIO_Port, Relay3_Main_P_Pin, Relay3_Main_N_GPIO_Port, Relay3_Main_N_Pin,
+      Relay3_Precharge_GPIO_Port, Relay3_Precharge_Pin },
+    { Relay4_Main_P_GPIO_Port, Relay4_Main_P_Pin, Relay4_Main_N_GPIO_Port, Relay4_Main_N_Pin,
+      Relay4_Precharge_GPIO_Port, Relay4_Precharge_Pin },
+};
+
+#if EVSE_CONNECTOR_COUNT > 1
+#define RELAY_MATRIX_BIT(conn, group)  (1UL << ((conn) * RELAY_MATRIX_GROUPS + (group)))
+
+static uint32_t relay_matrix = 0; // Latched outputs (the chain cannot be read back)
+
+// Shift the pattern into the chain (last output first) and latch it.
+// Caller holds the critical section: one writer at a time.
+static void Relay_MatrixWrite(uint32_t outputs)
+{
+    for (int8_t i = RELAY_MATRIX_OUTPUTS - 1; i >= 0; i--)
+    {
+        HAL_GPIO_WritePin(Matrix_SER_GPIO_Port, Matrix_SER_Pin, (outputs >> i) & 1U ? GPIO_PIN_SET : GPIO_PIN_RESET);
+        HAL_GPIO_WritePin(Matrix_SRCK_GPIO_Port, Matrix_SRCK_Pin, GPIO_PIN_SET);
+        HAL_GPIO_WritePin(Matrix_SRCK_GPIO_Port, Matrix_SRCK_Pin, GPIO_PIN_RESET);
+    }
+    HAL_GPIO_WritePin(Matrix_RCK_GPIO_Port, Matrix_RCK_Pin, GPIO_PIN_SET);
+    HAL_GPIO_WritePin(Matrix_RCK_GPIO_Port, Matrix_RCK_Pin, GPIO_PIN_RESET);
+    relay_matrix = outputs;
+}
+
+static void Relay_InitPins(void)
+{
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Mode = GPIO_MODE_OUTPUT_PP;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_LOW;
+
+    for (uint8_t c = 1; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        const Relay_Pins_t *p = &relay_pins[c];
+        HAL_GPIO_WritePin(p->main_p_port, p->main_p_pin, RELAY_SAFE_STATE);
+        HAL_GPIO_WritePin(p->main_n_port, p->main_n_pin, RELAY_SAFE_STATE);
+        HAL_GPIO_WritePin(p->precharge_port, p->precharge_pin, RELAY_SAFE_STATE);
+        gpio.Pin = p->main_p_pin;
+        HAL_GPIO_Init(p->main_p_port, &gpio);
+        gpio.Pin = p->main_n_pin;
+        HAL_GPIO_Init(p->main_n_port, &gpio);
+        gpio.Pin = p->precharge_pin;
+        HAL_GPIO_Init(p->precharge_port, &gpio);
+    }
+
+    // Matrix: outputs disabled (/G high), latch every group open, enable
+    __HAL_RCC_GPIOD_CLK_ENABLE();
+    HAL_GPIO_WritePin(Matrix_OE_GPIO_Port, Matrix_OE_Pin, GPIO_PIN_SET);
+    gpio.Pin = Matrix_OE_Pin;
+    HAL_GPIO_Init(Matrix_OE_GPIO_Port, &gpio);
+    HAL_GPIO_WritePin(Matrix_SER_GPIO_Port, Matrix_SER_Pin, GPIO_PIN_RESET);
+    gpio.Pin = Matrix_SER_Pin;
+    HAL_GPIO_Init(Matrix_SER_GPIO_Port, &gpio);
+    HAL_GPIO_WritePin(Matrix_SRCK_GPIO_Port, Matrix_SRCK_Pin, GPIO_PIN_RESET);
+    gpio.Pin = Matrix_SRCK_Pin;
+    HAL_GPIO_Init(Matrix_SRCK_GPIO_Port, &gpio);
+    HAL_GPIO_WritePin(Matrix_RCK_GPIO_Port, Matrix_RCK_Pin, GPIO_PIN_RESET);
+    gpio.Pin = Matrix_RCK_Pin;
+    HAL_GPIO_Init(Matrix_RCK_GPIO_Port, &gpio);
+
+    Relay_MatrixWrite(0);
+    HAL_GPIO_WritePin(Matrix_OE_GPIO_Port, Matrix_OE_Pin, GPIO_PIN_RESET);
+}
+#endif
+
 void Relay_Init(void)
 {
+#if EVSE_CONNECTOR_COUNT > 1
+    Relay_InitPins();
+#endif
+
     // Ensure all relays are Open on init
-    Relay_SetMain(false);
-    Relay_SetPrecharge(false);
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        Relay_SetMain(c, false);
+        Relay_SetPrecharge(c, false);
+    }
     
     printf("[Relay] Initialized (Safe State: Open)\r\n");
 }
 
-void Relay_SetMain(bool closed)
+void Relay_SetMain(uint8_t conn, bool closed)
 {
+    if (conn >= EVSE_CONNECTOR_COUNT) return;
+
+    const Relay_Pins_t *p = &relay_pins[conn];
     GPIO_PinState state = closed ? RELAY_ACTIVE_STATE : RELAY_SAFE_STATE;
     
     // Control both P and N contactors simultaneously
-    HAL_GPIO_WritePin(Relay_Main_P_GPIO_Port, Relay_Main_P_Pin, state);
-    HAL_GPIO_WritePin(Relay_Main_N_GPIO_Port, Relay_Main_N_Pin, state);
+    HAL_GPIO_WritePin(p->main_p_port, p->main_p_pin, state);
+    HAL_GPIO_WritePin(p->main_n_port, p->main_n_pin, state);
     
     // printf/Log can be added here if needed, but might spam if called frequently
 }
 
-void Relay_SetPrecharge(bool closed)
+void Relay_SetPrecharge(uint8_t conn, bool closed)
 {
+    if (conn >= EVSE_CONNECTOR_COUNT) return;
+
     // [Hardware Config] No Physical Pre-charge Relay exists.
     // Logic is handled by Power Module Soft-Start (Voltage Matching).
     // Just log the intent for debugging.
     if (closed)
     {
-        printf("[Relay] Pre-charge Virtual State: CLOSED (Soft-Start Logic Active)\r\n");
+        printf("[Relay] Connector %d Pre-charge Virtual State: CLOSED (Soft-Start Logic Active)\r\n", conn + 1);
     }
     else
     {
-        printf("[Relay] Pre-charge Virtual State: OPEN\r\n");
+        printf("[Relay] Connector %d Pre-charge Virtual State: OPEN\r\n", conn + 1);
     }
     
     // GPIO_PinState state = closed ? RELAY_ACTIVE_STATE : RELAY_SAFE_STATE;
-    // HAL_GPIO_WritePin(Relay_Precharge_GPIO_Port, Relay_Precharge_Pin, state);
+    // HAL_GPIO_WritePin(relay_pins[conn].precharge_port, relay_pins[conn].precharge_pin, state);
 }
 
-uint8_t Relay_GetState(void)
+uint8_t Relay_GetState(uint8_t conn)
 {
+    if (conn >= EVSE_CONNECTOR_COUNT) return 0;
+
+    const Relay_Pins_t *p = &relay_pins[conn];
     uint8_t state = 0;
-    if (HAL_GPIO_ReadPin(Relay_Main_P_GPIO_Port, Relay_Main_P_Pin) == RELAY_ACTIVE_STATE)
+    if (HAL_GPIO_ReadPin(p->main_p_port, p->main_p_pin) == RELAY_ACTIVE_STATE)
     {
         state |= 0x01;
     }
-    if (HAL_GPIO_ReadPin(Relay_Precharge_GPIO_Port, Relay_Precharge_Pin) == RELAY_ACTIVE_STATE)
+    if (HAL_GPIO_ReadPin(p->precharge_port, p->precharge_pin) == RELAY_ACTIVE_STATE)
     {
         state |= 0x02;
     }
     return state;
 }
+
+bool Relay_SetMatrix(uint8_t conn, uint8_t group, bool closed)
+{
+    if (conn >= EVSE_CONNECTOR_COUNT || group >= RELAY_MATRIX_GROUPS) return false;
+#if EVSE_CONNECTOR_COUNT > 1
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // Interlock: a group feeds one output bus at a time
+    if (closed)
+    {
+        for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+        {
+            if (c != conn && (relay_matrix & RELAY_MATRIX_BIT(c, group)))
+            {
+                __set_PRIMASK(primask);
+                printf("[Relay] Matrix Interlock: Group %d Closed on Connector %d\r\n", group, c + 1);
+                return false;
+            }
+        }
+    }
+    uint32_t outputs = closed ? (relay_matrix | RELAY_MATRIX_BIT(conn, group))
+                              : (relay_matrix & ~RELAY_MATRIX_BIT(conn, group));
+    if (outputs != relay_matrix) Relay_MatrixWrite(outputs);
+
+    __set_PRIMASK(primask);
+#else
+    (void)closed; // Hard-wired
+#endif
+    return true;
+}
+
+uint8_t Relay_GetMatrix(uint8_t conn)
+{
+    if (conn >= EVSE_CONNECTOR_COUNT) return 0;
+#if EVSE_CONNECTOR_COUNT > 1
+    uint32_t outputs = relay_matrix; // Single word read
+    return (uint8_t)((outputs >> (conn * RELAY_MATRIX_GROUPS)) & ((1UL << RELAY_MATRIX_GROUPS) - 1U));
+#else
+    return (uint8_t)((1U << RELAY_MATRIX_GROUPS) - 1U);
+#endif
+}
@@ -3,60 +3,149 @@
  * @brief   SECC Communication Driver (EVerest-like BSP Protocol)
  * @author  Antigravity
  * @date    2026-01-31
+ *
+ * @note    Link Mode: starts in Classic CAN (0x600 status 50ms, 0x602 meter 200ms).
+ *          When the SECC sends its command frame (0x610) as CAN FD, the link
+ *          switches to one combined FD frame (0x601) every 10ms. It falls
+ *          back to Classic when the SECC heartbeat times out, so an older
+ *          SECC is never exposed to FD frames it would flag as errors.
+ *
+ * @note    All three frames are declared to the CAN TX scheduler; the App
+ *          only publishes a snapshot with SECC_SetTxData(). A frame of the
+ *          inactive link mode packs nothing, so its slot stays empty.
+ *
+ * @note    DC demand (0x611) and EV limits (0x612) share the urgent route of
+ *          the command frame. They are decoded in the line 1 ISR and passed
+ *          to the demand handler (SECC_SetDemandHandler) right there, so a
+ *          new setpoint does not wait for the next control loop pass.
+ *
+ * @note    Connector temperatures (0x613) take the normal route: they are
+ *          decoded in the CAN task, which is also their only reader
+ *          (thermal_derate.c).
+ *
+ * @note    Connectors: every connector has its own SECC on the same bus,
+ *          using the same frames shifted by SECC_CAN_ID_STRIDE per connector
+ *          (connector 2: 0x620..0x622 / 0x630..0x633). Link mode, TX
+ *          snapshot and control data are kept per connector.
  */
 
 #ifndef MODULES_SECC_DRIVER_H_
 #define MODULES_SECC_DRIVER_H_
 
 #include "main.h"
+#include "can_driver.h"
+#include "can_sched.h"
+#include "can_db_secc.h" // Generated from Tools/dbc/secc.dbc
+#include "evse_connector.h"
 #include <stdbool.h>
 
-// CAN IDs
-#define SECC_CAN_ID_TX_STATUS   0x600 // CCU -> SECC
-#define SECC_CAN_ID_TX_METER    0x602 // CCU -> SECC (Meter Values)
-#define SECC_CAN_ID_RX_CMD      0x610 // SECC -> CCU
+// CAN IDs (Layouts in Tools/dbc/secc.dbc)
+#define SECC_CAN_ID_TX_STATUS   CCU_STATUS_ID   // 0x600 CCU -> SECC
+#define SECC_CAN_ID_TX_METER    CCU_METER_ID    // 0x602 CCU -> SECC (Meter Values)
+#define SECC_CAN_ID_TX_COMBINED CCU_COMBINED_ID // 0x601 CCU -> SECC (FD: Status + Meter + Power Stage)
+#define SECC_CAN_ID_RX_CMD      SECC_COMMAND_ID // 0x610 SECC -> CCU
+#define SECC_CAN_ID_RX_DEMAND   SECC_DCDEMAND_ID // 0x611 SECC -> CCU (DC target V/I, SoC)
+#define SECC_CAN_ID_RX_LIMITS   SECC_DCLIMITS_ID // 0x612 SECC -> CCU (EV max V/I)
+#define SECC_CAN_ID_RX_TEMPS    SECC_TEMPS_ID    // 0x613 SECC -> CCU (Connector / cable NTCs)
+
+#define SECC_TEMP_INVALID_RAW   INT16_MIN        // SECC_Temps: sensor open or shorted
+
+// Connector n uses the IDs above + n * SECC_CAN_ID_STRIDE
+#define SECC_CAN_ID_STRIDE      0x20U
+#define SECC_CAN_ID(base, conn) ((uint32_t)(base) + (uint32_t)(conn) * SECC_CAN_ID_STRIDE)
+
+// Tx Refresh Period / Phase (Scheduler slots, ms)
+#define SECC_TX_PERIOD_FD_MS        10  // Combined FD frame
+#define SECC_TX_PERIOD_CLASSIC_MS   50  // Status frame
+#define SECC_TX_PERIOD_METER_MS     200 // Meter frame (Classic)
+#define SECC_TX_OFFSET_COMBINED_MS  0
+#define SECC_TX_OFFSET_STATUS_MS    0
+#define SECC_TX_OFFSET_METER_MS     25  // Between two status frames
+
+#define SECC_COMM_TIMEOUT_US    (3 * TIMEBASE_US_PER_SEC) // Heartbeat timeout (wire time)
 
 // Control Data Structure
 typedef struct {
     uint8_t target_pwm_duty; // 0-100% (Legacy AC)
     float   ev_target_voltage; // DC Target Voltage (V)
-    float   ev_max_current;    // DC Max Current (A)
+    float   ev_target_current; // DC Target Current (A)
+    float   ev_max_voltage;    // EV Max Voltage (V, 0 = not received)
+    float   ev_max_current;    // EV Max Current (A, 0 = not received)
+    uint8_t ev_soc;          // State of Charge (%)
     uint8_t allow_power;     // 0=Open, 1=Close
     uint8_t reset_fault;     // 1=Trigger Reset
     bool    valid;           // True if fresh data received
-    uint32_t last_rx_tick;   // For timeout
+    bool    demand_valid;    // DC demand received since boot
+    volatile uint64_t last_rx_us; // SOF of last command (Timebase)
+    volatile uint64_t demand_rx_us; // SOF of last DC demand
+    // Connector Temperatures (CAN task, SECC_Temps)
+    float   temp_dc_plus;      // DC+ pin (degC)
+    float   temp_dc_minus;     // DC- pin (degC)
+    float   temp_cable;        // Cable (degC)
+    uint8_t temps_ok;          // Bit 0/1/2 = DC+/DC-/cable reading valid
+    uint64_t temps_rx_us;      // SOF of last SECC_Temps (0 = never)
 } SECC_Control_t;
 
-extern SECC_Control_t secc_control;
+/**
+ * @brief DC demand handler (runs in the FDCAN1 line 1 ISR)
+ * @param conn  Connector whose SECC sent the frame
+ * @param rx_us SOF of the demand or limits frame
+ * @note  Same rules as an urgent route handler: short, no blocking, no printf.
+ */
+typedef void (*SECC_DemandHandler_t)(uint8_t conn, uint64_t rx_us);
+
+extern SECC_Control_t secc_control[EVSE_CONNECTOR_COUNT];
+
+// Tx Snapshot (Published by App every control loop iteration)
+typedef struct {
+    float   cp_volts;        // Control Pilot Voltage (V)
+    uint8_t pwm_duty;        // PWM Duty (%)
+    uint8_t relay_state;     // Relay Bitmask
+    uint8_t err_code;        // Error Code
+    float   ac_volts;        // Meter Voltage (V)
+    float   ac_amps;         // Meter Current (A)
+    float   temp_c;          // Temperature (C)
+    float   dc_volts;        // Power Stage Output Voltage (V)
+    float   dc_amps;         // Power Stage Output Current (A)
+    uint8_t active_modules;  // Healthy Power Modules
+    bool    power_fault;     // Any Power Module Fault
+} SECC_TxData_t;
 
 /**
- * @brief Initialize SECC Driver (Register CAN Callback)
+ * @brief Initialize SECC Driver (Registers the 0x610 routes of every connector on the SECC bus)
  * @param hfdcan Ptr to CAN handle
  */
 void SECC_Init(FDCAN_HandleTypeDef *hfdcan);
 
 /**
- * @brief Send Status Packet to SECC (Call every 50ms)
- * ...
+ * @brief Publish the values sent to the SECC (Call from the control loop)
+ * @note  Also drops back to the Classic link when the heartbeat timed out.
+ *        The scheduler packs 0x600/0x602 or 0x601 from the last snapshot.
+ * @param conn Connector index
+ * @param tx Snapshot of status/meter/power-stage values
+ */
+void SECC_SetTxData(uint8_t conn, const SECC_TxData_t *tx);
+
+/**
+ * @brief Set the handler called on every DC demand / limits frame
+ * @param handler NULL to detach
  */
-void SECC_TxStatus(float cp_volts_v, uint8_t pwm_duty, uint8_t relay_state, uint8_t err_code);
+void SECC_SetDemandHandler(SECC_DemandHandler_t handler);
 
 /**
- * @brief Send Meter Values (Call every 100-200ms)
- * @param ac_volts AC Voltage (V)
- * @param ac_amps AC Current (A)
- * @param temp_c Temperature (C)
+ * @brief Check if the SECC link of a connector runs CAN FD
  */
-void SECC_TxMeter(float ac_volts, float ac_amps, float temp_c);
+bool SECC_IsFdActive(uint8_t conn);
 
 /**
- * @brief Handle CAN Rx Message (Called from CAN ISR/Callback)
+ * @brief Handle CAN Rx Message (Urgent route: called from the FDCAN1 line 1 ISR;
+ *        SECC_Temps from the CAN task)
  */
-void SECC_RxHandler(uint32_t id, uint8_t *data, uint8_t len);
+void SECC_RxHandler(const CAN_Message_t *msg);
 
 /**
- * @brief Check if SECC is connected (Heartbeat timeout)
+ * @brief Check if the SECC of a connector is connected (Heartbeat timeout)
  */
-bool SECC_IsConnected(void);
+bool SECC_IsConnected(uint8_t conn);
 
 #endif /* MODULES_SECC_DRIVER_H_ */
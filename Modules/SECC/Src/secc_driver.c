@@ -4,98 +4,256 @@
  */
 
 #include "secc_driver.h"
-#include "can_driver.h"
+#include "safety_monitor.h"
 #include <stdio.h>
 #include <string.h>
 
 static FDCAN_HandleTypeDef *secc_hfdcan = NULL;
-SECC_Control_t secc_control = {0};
+SECC_Control_t secc_control[EVSE_CONNECTOR_COUNT];
+
+// Per Connector Link
+static struct
+{
+    volatile bool fd_active;   // Set by the RX ISR on FD command, cleared by Tx on timeout
+    bool fd_reported;          // Link change logged (control task)
+    uint8_t tx_seq;
+    SECC_TxData_t tx_data;     // Tx Snapshot (Control task writes, scheduler packs)
+    bool tx_valid;
+} secc_link[EVSE_CONNECTOR_COUNT];
+
+static volatile SECC_DemandHandler_t secc_demand_handler = NULL;
+
+static bool SECC_GetTxData(uint8_t conn, SECC_TxData_t *tx);
+static uint8_t SECC_PackStatus(uint8_t *data, uint8_t conn);
+static uint8_t SECC_PackMeter(uint8_t *data, uint8_t conn);
+static uint8_t SECC_PackCombined(uint8_t *data, uint8_t conn);
 
 void SECC_Init(FDCAN_HandleTypeDef *hfdcan)
 {
     secc_hfdcan = hfdcan;
-    secc_control.valid = false;
-    secc_control.last_rx_tick = 0;
+    memset(secc_control, 0, sizeof(secc_control));
+    memset(secc_link, 0, sizeof(secc_link));
+
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        // Route SECC Command, Demand and Limits Frames (RX FIFO1: a stop or a new
+        // setpoint must not queue behind bulk traffic)
+        CAN_RegisterRxRangeUrgent(hfdcan, CAN_ID_STD, SECC_CAN_ID(SECC_CAN_ID_RX_CMD, c),
+                                  SECC_CAN_ID(SECC_CAN_ID_RX_LIMITS, c), SECC_RxHandler);
+
+        // Route SECC Temperatures (RX FIFO0: read by the thermal derating in the CAN task)
+        CAN_RegisterRxRange(hfdcan, CAN_ID_STD, SECC_CAN_ID(SECC_CAN_ID_RX_TEMPS, c),
+                            SECC_CAN_ID(SECC_CAN_ID_RX_TEMPS, c), SECC_RxHandler);
+
+        // Declare Tx Frames (Classic pair and FD frame skip while the other link mode is active)
+        const CAN_SchedMsg_t status = {
+            .hfdcan = hfdcan, .id = SECC_CAN_ID(SECC_CAN_ID_TX_STATUS, c),
+            .period_ms = SECC_TX_PERIOD_CLASSIC_MS, .offset_ms = SECC_TX_OFFSET_STATUS_MS,
+            .prio = CAN_TX_PRIO_STATUS, .pack = SECC_PackStatus, .arg = c,
+        };
+        const CAN_SchedMsg_t meter = {
+            .hfdcan = hfdcan, .id = SECC_CAN_ID(SECC_CAN_ID_TX_METER, c),
+            .period_ms = SECC_TX_PERIOD_METER_MS, .offset_ms = SECC_TX_OFFSET_METER_MS,
+            .prio = CAN_TX_PRIO_STATUS, .pack = SECC_PackMeter, .arg = c,
+        };
+        const CAN_SchedMsg_t combined = {
+            .hfdcan = hfdcan, .id = SECC_CAN_ID(SECC_CAN_ID_TX_COMBINED, c),
+            .period_ms = SECC_TX_PERIOD_FD_MS, .offset_ms = SECC_TX_OFFSET_COMBINED_MS,
+            .flags = CAN_SCHED_FD, .prio = CAN_TX_PRIO_STATUS, .pack = SECC_PackCombined, .arg = c,
+        };
+        CAN_Sched_Register(&status);
+        CAN_Sched_Register(&meter);
+        CAN_Sched_Register(&combined);
+    }
     
-    printf("[SECC] Initialized. Waiting for 0x610...\r\n");
+    printf("[SECC] Initialized (%d Connector(s)). Waiting for 0x610...\r\n", EVSE_CONNECTOR_COUNT);
 }
 
-void SECC_TxStatus(float cp_volts_v, uint8_t pwm_duty, uint8_t relay_state, uint8_t err_code)
+// Status (0x600, Classic link)
+static uint8_t SECC_PackStatus(uint8_t *data, uint8_t conn)
 {
-    if (secc_hfdcan == NULL) return;
+    SECC_TxData_t tx;
+    if (secc_link[conn].fd_active || !SECC_GetTxData(conn, &tx)) return 0;
 
-    uint8_t data[8] = {0};
-    
-    // Byte 0-1: CP Voltage (mV)
-    uint16_t cp_mv = (uint16_t)(cp_volts_v * 1000.0f);
-    data[0] = cp_mv & 0xFF;
-    data[1] = (cp_mv >> 8) & 0xFF;
-    
-    // Byte 2-3: PP Voltage (mV) - Placeholder 0
-    data[2] = 0;
-    data[3] = 0;
-    
-    // Byte 4: PWM Duty
-    data[4] = pwm_duty;
-    
-    // Byte 5: Relay State
-    data[5] = relay_state;
-    
-    // Byte 6: Error Code
-    data[6] = err_code;
-    
-    // Byte 7: Reserved
-    data[7] = 0;
-    
-    CAN_Transmit(secc_hfdcan, SECC_CAN_ID_TX_STATUS, data, 8);
+    CCU_Status_t m = {
+        .cp_voltage = (uint16_t)(tx.cp_volts * 1000.0f), // mV
+        .pp_voltage = 0,                                 // Placeholder
+        .pwm_duty = tx.pwm_duty,
+        .relay_state = tx.relay_state,
+        .err_code = tx.err_code,
+    };
+    CCU_Status_Pack(&m, data);
+    return CCU_STATUS_LEN;
 }
 
-void SECC_TxMeter(float ac_volts, float ac_amps, float temp_c)
+// Meter Values (0x602, Classic link)
+static uint8_t SECC_PackMeter(uint8_t *data, uint8_t conn)
 {
-    if (secc_hfdcan == NULL) return;
+    SECC_TxData_t tx;
+    if (secc_link[conn].fd_active || !SECC_GetTxData(conn, &tx)) return 0;
 
-    uint8_t data[8] = {0};
-    
-    // V (10x)
-    uint16_t v_scale = (uint16_t)(ac_volts * 10.0f);
-    data[0] = v_scale & 0xFF;
-    data[1] = (v_scale >> 8) & 0xFF;
-    
-    // I (10x)
-    uint16_t i_scale = (uint16_t)(ac_amps * 10.0f);
-    data[2] = i_scale & 0xFF;
-    data[3] = (i_scale >> 8) & 0xFF;
-    
-    // Temp (1x, offset?) Assuming -40 to 215. int8
-    data[4] = (int8_t)temp_c;
-    
-    // Checksum simulation? No.
-    
-    CAN_Transmit(secc_hfdcan, SECC_CAN_ID_TX_METER, data, 8);
+    CCU_Meter_t m = {
+        .ac_voltage = (uint16_t)(tx.ac_volts * 10.0f),
+        .ac_current = (uint16_t)(tx.ac_amps * 10.0f),
+        .temperature = (int8_t)tx.temp_c,
+    };
+    CCU_Meter_Pack(&m, data);
+    return CCU_METER_LEN;
 }
 
-void SECC_RxHandler(uint32_t id, uint8_t *data, uint8_t len)
+// Status + Meter + Power Stage (0x601, FD link)
+static uint8_t SECC_PackCombined(uint8_t *data, uint8_t conn)
 {
-    if (id == SECC_CAN_ID_RX_CMD && len >= 3)
+    SECC_TxData_t tx;
+    if (!secc_link[conn].fd_active || !SECC_GetTxData(conn, &tx)) return 0;
+
+    // Same scaling as 0x600 / 0x602, plus power stage and rolling counter
+    CCU_Combined_t m = {
+        .cp_voltage = (uint16_t)(tx.cp_volts * 1000.0f),
+        .pwm_duty = tx.pwm_duty,
+        .relay_state = tx.relay_state,
+        .err_code = tx.err_code,
+        .ac_voltage = (uint16_t)(tx.ac_volts * 10.0f),
+        .ac_current = (uint16_t)(tx.ac_amps * 10.0f),
+        .temperature = (int8_t)tx.temp_c,
+        .dc_voltage = (uint16_t)(tx.dc_volts * 10.0f),
+        .dc_current = (uint16_t)(tx.dc_amps * 10.0f),
+        .active_modules = tx.active_modules,
+        .power_fault = tx.power_fault ? 1 : 0,
+        .counter = secc_link[conn].tx_seq++, // SECC can detect lost 10ms frames
+    };
+    CCU_Combined_Pack(&m, data);
+    return CCU_COMBINED_LEN;
+}
+
+void SECC_SetTxData(uint8_t conn, const SECC_TxData_t *tx)
+{
+    if (tx == NULL || conn >= EVSE_CONNECTOR_COUNT) return;
+
+    // Heartbeat lost: SECC may have been replaced, return to Classic
+    if (secc_link[conn].fd_active && !SECC_IsConnected(conn))
     {
-        secc_control.target_pwm_duty = data[0];
-        secc_control.allow_power = data[1];
-        secc_control.reset_fault = data[2];
+        secc_link[conn].fd_active = false;
+        secc_link[conn].fd_reported = false;
+        printf("[SECC] Connector %d Link Timeout. Fallback to Classic CAN\r\n", conn + 1);
+    }
+    else if (secc_link[conn].fd_active && !secc_link[conn].fd_reported)
+    {
+        secc_link[conn].fd_reported = true; // Detected in the ISR, which cannot print
+        printf("[SECC] Connector %d CAN FD Link Detected (10ms Refresh)\r\n", conn + 1);
+    }
+
+    // Scheduler reads it from the timer task
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    secc_link[conn].tx_data = *tx;
+    secc_link[conn].tx_valid = true;
+    __set_PRIMASK(primask);
+}
+
+static bool SECC_GetTxData(uint8_t conn, SECC_TxData_t *tx)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool valid = secc_link[conn].tx_valid;
+    *tx = secc_link[conn].tx_data;
+    __set_PRIMASK(primask);
+    return valid;
+}
+
+void SECC_SetDemandHandler(SECC_DemandHandler_t handler)
+{
+    secc_demand_handler = handler;
+}
+
+bool SECC_IsFdActive(uint8_t conn)
+{
+    return (conn < EVSE_CONNECTOR_COUNT) && secc_link[conn].fd_active;
+}
+
+void SECC_RxHandler(const CAN_Message_t *msg)
+{
+    // Connector from the ID block (0x610.. + n * stride)
+    if (msg->id < SECC_CAN_ID_RX_CMD) return;
+    uint32_t conn = (msg->id - SECC_CAN_ID_RX_CMD) / SECC_CAN_ID_STRIDE;
+    if (conn >= EVSE_CONNECTOR_COUNT) return;
+    uint32_t id = msg->id - conn * SECC_CAN_ID_STRIDE;
+    SECC_Control_t *ctl = &secc_control[conn];
+
+    if (id == SECC_CAN_ID_RX_CMD && msg->len >= SECC_COMMAND_MIN_LEN)
+    {
+        SECC_Command_t cmd;
+        SECC_Command_Unpack(msg->data, &cmd);
+
+        bool stop = ctl->allow_power && !cmd.allow_power;
+
+        ctl->target_pwm_duty = cmd.target_pwm_duty;
+        ctl->allow_power = cmd.allow_power;
+        ctl->reset_fault = cmd.reset_fault;
         
-        secc_control.last_rx_tick = HAL_GetTick();
-        secc_control.valid = true;
+        ctl->last_rx_us = msg->timestamp_us;
+        ctl->valid = true;
+
+        // FD-capable SECC announces itself by sending the command as FD
+        if (msg->fd) secc_link[conn].fd_active = true;
+
+        // Stop: state machine opens the contactors now, not next cycle
+        if (stop) Safety_Notify();
         
         // Debug Log (Throttled?)
-        // printf("[SECC] Rx Cmd: PWM=%d Allow=%d Res=%d\r\n", data[0], data[1], data[2]);
+        // printf("[SECC] Rx Cmd: PWM=%d Allow=%d Res=%d\r\n", cmd.target_pwm_duty, cmd.allow_power, cmd.reset_fault);
+    }
+    else if (id == SECC_CAN_ID_RX_DEMAND && msg->len >= SECC_DCDEMAND_MIN_LEN)
+    {
+        SECC_DcDemand_t dem;
+        SECC_DcDemand_Unpack(msg->data, &dem);
+
+        ctl->ev_target_voltage = dem.target_voltage * 0.1f;
+        ctl->ev_target_current = dem.target_current * 0.1f;
+        ctl->ev_soc = dem.soc;
+        ctl->demand_rx_us = msg->timestamp_us;
+        ctl->demand_valid = true;
+
+        SECC_DemandHandler_t handler = secc_demand_handler;
+        if (handler != NULL) handler((uint8_t)conn, msg->timestamp_us);
+    }
+    else if (id == SECC_CAN_ID_RX_LIMITS && msg->len >= SECC_DCLIMITS_MIN_LEN)
+    {
+        SECC_DcLimits_t lim;
+        SECC_DcLimits_Unpack(msg->data, &lim);
+
+        ctl->ev_max_voltage = lim.ev_max_voltage * 0.1f;
+        ctl->ev_max_current = lim.ev_max_current * 0.1f;
+
+        // Lower limits clamp the running setpoint at once
+        SECC_DemandHandler_t handler = secc_demand_handler;
+        if (handler != NULL) handler((uint8_t)conn, msg->timestamp_us);
+    }
+    else if (id == SECC_CAN_ID_RX_TEMPS && msg->len >= SECC_TEMPS_MIN_LEN)
+    {
+        SECC_Temps_t t;
+        SECC_Temps_Unpack(msg->data, &t);
+
+        const int16_t raw[3] = { t.temp_dc_plus, t.temp_dc_minus, t.temp_cable };
+        uint8_t ok = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            if (raw[k] != SECC_TEMP_INVALID_RAW) ok |= (uint8_t)(1U << k);
+        }
+        ctl->temp_dc_plus = t.temp_dc_plus * 0.1f;
+        ctl->temp_dc_minus = t.temp_dc_minus * 0.1f;
+        ctl->temp_cable = t.temp_cable * 0.1f;
+        ctl->temps_ok = ok;
+        ctl->temps_rx_us = msg->timestamp_us;
     }
 }
 
-bool SECC_IsConnected(void)
+bool SECC_IsConnected(uint8_t conn)
 {
-    if (!secc_control.valid) return false;
+    if (conn >= EVSE_CONNECTOR_COUNT || !secc_control[conn].valid) return false;
     
-    // 3 Second Timeout
-    if ((HAL_GetTick() - secc_control.last_rx_tick) > 3000)
+    // 3 Second Timeout (since the last command was on the wire)
+    if (Timebase_GetAge(&secc_control[conn].last_rx_us) > SECC_COMM_TIMEOUT_US)
     {
         return false;
     }
@@ -9,18 +9,22 @@
 #define MODULES_IMD_DRIVER_H_
 
 #include "main.h"
+#include "can_driver.h"
+#include "can_db_imd.h" // Generated from Tools/dbc/imd.dbc
 #include <stdbool.h>
 
 // CAN IDs (Bender Default - Adjustable)
 #define IMD_CAN_ID_TX_RESPONSE  0x23 // Example ID from IMD
-#define IMD_CAN_ID_TX_INFO      0x24 // Periodic Info
+#define IMD_CAN_ID_TX_INFO      IMD_INFO_ID // 0x24 Periodic Info
+
+#define IMD_COMM_TIMEOUT_US     (1 * TIMEBASE_US_PER_SEC) // Info frame timeout (wire time)
 
 typedef struct {
     float    insulation_resistance_kohm; // Measured R_iso
     bool     valid;             // Data validity
     bool     warning;           // Warning Threshold Reached
     bool     fault;             // Fault Threshold Reached
-    uint32_t last_rx_tick;      // Timeout check
+    volatile uint64_t last_rx_us; // SOF of last info frame (Timebase)
 } IMD_Status_t;
 
 /**
@@ -30,9 +34,9 @@ typedef struct {
 void IMD_Init(FDCAN_HandleTypeDef *hfdcan);
 
 /**
- * @brief Handle CAN Rx for IMD
+ * @brief Handle CAN Rx for IMD (Urgent route: called from the FDCAN3 line 1 ISR)
  */
-void IMD_RxHandler(uint32_t id, uint8_t *data, uint8_t len);
+void IMD_RxHandler(const CAN_Message_t *msg);
 
 /**
  * @brief Get latest IMD Status
@@ -9,15 +9,20 @@
 #define MODULES_SAFETY_MONITOR_H_
 
 #include "main.h"
+#include "cmsis_os.h"
 #include <stdbool.h>
 
+#define SAFETY_IMD_MIN_KOHM   100.0f   // Insulation fault threshold
+#define SAFETY_THREAD_FLAG    0x0001U  // Wakes the control task for Safety_Check()
+
 typedef enum
 {
     SAFETY_OK = 0,
     SAFETY_FAULT_ESTOP,
     SAFETY_FAULT_IMD,
     SAFETY_FAULT_OVERTEMP,
-    SAFETY_FAULT_WELDING
+    SAFETY_FAULT_WELDING,
+    SAFETY_FAULT_CAN_BUS
 } Safety_Status_t;
 
 
@@ -27,9 +32,22 @@ typedef enum
 void Safety_Init(void);
 
 /**
- * @brief Check all safety conditions
+ * @brief Check all safety conditions of a connector
+ * @note  E-Stop, IMD and CAN bus are cabinet-wide; over-temperature is
+ *        the connector's own gun and outlet modules.
  * @return SAFETY_OK if safe, otherwise Error Code
  */
-Safety_Status_t Safety_Check(void);
+Safety_Status_t Safety_Check(uint8_t conn);
+
+/**
+ * @brief Register the task that runs Safety_Check() / the state machine
+ */
+void Safety_SetNotifyThread(osThreadId_t thread_id);
+
+/**
+ * @brief Wake that task now instead of at its next cycle (ISR safe)
+ * @note  Used by the urgent CAN handlers (IMD fault, SECC stop).
+ */
+void Safety_Notify(void);
 
 #endif /* MODULES_SAFETY_MONITOR_H_ */
@@ -0,0 +1,149 @@
+/**
+ * @file    thermal_derate.h
+ * @brief   Thermal Derating (Connector / Cable / Power Module Current Limit)
+ *
+ * @note    Sensors: the DC+/DC- pin and cable NTCs of the gun (SECC_Temps,
+ *          measured by the SECC board), the hottest PFC/DC-DC stage of the
+ *          alive power modules (Infy polled status) and, as ambient, the
+ *          coolest module air inlet. Each channel is filtered and turned into
+ *          a current limit; the lowest one, together with what the modules
+ *          still offer after their own derating, is the output current limit.
+ *          PowerReg_Tick() clamps its current target with it every tick.
+ *          One limit per connector: its gun and the modules of its outlet.
+ *
+ * @note    Curve: 100 % of the channel's reference current up to
+ *          THERMAL_*_START_C, falling linearly to 0 A at THERMAL_*_END_C.
+ *          It is not evaluated on the measured temperature but on a
+ *          prediction THERMAL_*_HORIZON_S ahead, from a first-order model
+ *              dT/dt = (T_amb + RISE * (I / I_ref)^2 - T) / TAU
+ *          started at the measured temperature. The limit is the current at
+ *          which the prediction lands on the curve, so a hot spot that is
+ *          still heating is cut back before it gets there, and a cooling one
+ *          gets its current back early. The model is re-anchored to the
+ *          measurement every period: RISE and TAU only shape the look-ahead.
+ *
+ * @note    A sensor that was never seen does not limit (gun or SECC board
+ *          without NTCs). One that reported and went silent or open/short
+ *          limits to THERMAL_FALLBACK_PCT. The trip temperatures
+ *          (THERMAL_*_TRIP_C, Safety_Check) lie above the end of the curve:
+ *          only a sensor that keeps heating at 0 A reaches them.
+ */
+
+#ifndef MODULES_SAFETY_THERMAL_DERATE_H_
+#define MODULES_SAFETY_THERMAL_DERATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <float.h>
+#include "timebase.h"
+#include "evse_connector.h"
+
+// --- Configuration ---
+#define THERMAL_PERIOD_MS          100     // Evaluation period (CAN task)
+#define THERMAL_FILTER_S           2.0f    // Measurement filter time constant
+#define THERMAL_SENSOR_TIMEOUT_US  (5 * TIMEBASE_US_PER_SEC) // Reading older = stale
+#define THERMAL_FALLBACK_PCT       50      // Limit of a stale / failed sensor (% of reference)
+#define THERMAL_AMBIENT_DEFAULT_C  40.0f   // Model ambient without module inlet readings
+#define THERMAL_NO_LIMIT_A         FLT_MAX // Limit while nothing derates
+#define THERMAL_CAP_MIN_V          50.0f   // Module power derating turned into A from this output voltage on
+
+// Connector Pins (Reference: rated current of the gun)
+#define THERMAL_PIN_RATED_A        400.0f
+#define THERMAL_PIN_START_C        70.0f
+#define THERMAL_PIN_END_C          85.0f
+#define THERMAL_PIN_TRIP_C         90.0f
+#define THERMAL_PIN_RISE_C         40.0f   // Steady-state rise at the rated current
+#define THERMAL_PIN_TAU_S          600.0f
+#define THERMAL_PIN_HORIZON_S      120.0f
+
+// Cable (Reference: rated current of the gun)
+#define THERMAL_CABLE_START_C      60.0f
+#define THERMAL_CABLE_END_C        75.0f
+#define THERMAL_CABLE_TRIP_C       80.0f
+#define THERMAL_CABLE_RISE_C       30.0f
+#define THERMAL_CABLE_TAU_S        900.0f
+#define THERMAL_CABLE_HORIZON_S    180.0f
+
+// Power Modules (Reference: rated current of the alive modules, load shared evenly)
+#define THERMAL_MODULE_START_C     80.0f
+#define THERMAL_MODULE_END_C       95.0f
+#define THERMAL_MODULE_TRIP_C      105.0f
+#define THERMAL_MODULE_RISE_C      40.0f   // Hot spot rise at full load
+#define THERMAL_MODULE_TAU_S       300.0f
+#define THERMAL_MODULE_HORIZON_S   60.0f
+
+typedef enum
+{
+    THERMAL_CH_DC_PLUS = 0,
+    THERMAL_CH_DC_MINUS,
+    THERMAL_CH_CABLE,
+    THERMAL_CH_MODULE,
+    THERMAL_CH_COUNT
+} Thermal_Channel_Id_t;
+
+typedef struct
+{
+    bool  valid;             // Fresh reading
+    bool  stale;             // Reported before, now silent or failed (fallback limit)
+    float temp_c;            // Filtered (degC)
+    float predict_c;         // Predicted at the horizon with the present current (degC)
+    float limit_pct;         // Curve result (% of the reference current)
+    float limit_a;           // (A, THERMAL_NO_LIMIT_A = none)
+} Thermal_Channel_t;
+
+typedef struct
+{
+    Thermal_Channel_t ch[THERMAL_CH_COUNT];
+    float ambient_c;         // Coolest module inlet (THERMAL_AMBIENT_DEFAULT_C without)
+    bool  ambient_valid;
+    bool  module_derated;    // A module reports less than 100 % power
+    float module_cap_kw;     // Alive modules after their own derating (kW)
+    float module_cap_a;      // Same at the output voltage (A, THERMAL_NO_LIMIT_A while not derated)
+    float limit_a;           // Output current limit (A, THERMAL_NO_LIMIT_A = none)
+    int8_t limiting;         // Channel setting limit_a (-1 = none, THERMAL_CH_COUNT = module derating)
+    uint32_t evaluations;
+    uint32_t derating_ms;    // Time spent below 100 % (any channel)
+} Thermal_Status_t;
+
+/**
+ * @brief Reset the channels (no limit until the first reading)
+ */
+void Thermal_Init(void);
+
+/**
+ * @brief Read the sensors and update the current limit
+ * @note  Call from the CAN task before PowerReg_Tick() (the SECC and module
+ *        temperatures are decoded there); evaluates every THERMAL_PERIOD_MS.
+ */
+void Thermal_Process(void);
+
+/**
+ * @brief Output current limit of a connector (A, THERMAL_NO_LIMIT_A = none)
+ */
+float Thermal_GetCurrentLimit(uint8_t conn);
+
+/**
+ * @brief Reported temperature of a connector (degC, any task)
+ * @return Hottest fresh channel (filtered), the module inlet ambient
+ *         without any, THERMAL_AMBIENT_DEFAULT_C without that either
+ */
+float Thermal_GetTemperature(uint8_t conn);
+
+/**
+ * @brief Channel of a connector above its trip temperature (any task)
+ * @param temp_c Output: its filtered temperature (may be NULL)
+ * @return Channel (Thermal_Channel_Id_t), -1 if none
+ */
+int Thermal_GetOverTemp(uint8_t conn, float *temp_c);
+
+/**
+ * @brief Channel name for logs ("DC+", "DC-", "Cable", "Module")
+ */
+const char *Thermal_ChannelName(int ch);
+
+/**
+ * @brief Get Derating Status of a connector
+ */
+void Thermal_GetStatus(uint8_t conn, Thermal_Status_t *status);
+
+#endif /* MODULES_SAFETY_THERMAL_DERATE_H_ */
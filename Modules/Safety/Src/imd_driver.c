@@ -4,6 +4,7 @@
  */
 
 #include "imd_driver.h"
+#include "safety_monitor.h"
 #include <stdio.h>
 
 static FDCAN_HandleTypeDef *imd_hfdcan = NULL;
@@ -16,34 +17,42 @@ void IMD_Init(FDCAN_HandleTypeDef *hfdcan)
     imd_status.valid = false;
     imd_status.warning = false;
     imd_status.fault = false;
+
+    // Route Periodic Info Frame (RX FIFO1: decoded in the ISR, bus load independent)
+    CAN_RegisterRxRangeUrgent(hfdcan, CAN_ID_STD, IMD_CAN_ID_TX_INFO, IMD_CAN_ID_TX_INFO, IMD_RxHandler);
     
     printf("[IMD] Initialized (CAN Mode).\r\n");
 }
 
-void IMD_RxHandler(uint32_t id, uint8_t *data, uint8_t len)
+void IMD_RxHandler(const CAN_Message_t *msg)
 {
-    // Simplified parsing for Bender-like protocol
+    // Simplified parsing for Bender-like protocol (Tools/dbc/imd.dbc)
     // Usually standard format: Byte 0-1 = Resistance, Byte 2 = Flags
     
-    if (id == IMD_CAN_ID_TX_INFO && len >= 4)
+    if (msg->id == IMD_CAN_ID_TX_INFO && msg->len >= IMD_INFO_MIN_LEN)
     {
-        // Example Mapping (Big Endian)
-        uint16_t r_iso_raw = (data[0] << 8) | data[1];
-        imd_status.insulation_resistance_kohm = (float)r_iso_raw; // 1 kOhm/bit or similar
-        
-        uint8_t flags = data[2];
-        imd_status.warning = (flags & 0x01) ? true : false;
-        imd_status.fault   = (flags & 0x02) ? true : false;
+        IMD_Info_t info;
+        IMD_Info_Unpack(msg->data, &info);
+
+        imd_status.insulation_resistance_kohm = (float)info.r_iso; // 1 kOhm/bit or similar
+        imd_status.warning = info.warning;
+        imd_status.fault   = info.fault;
         
-        imd_status.last_rx_tick = HAL_GetTick();
+        imd_status.last_rx_us = msg->timestamp_us;
         imd_status.valid = true;
+
+        // Do not wait for the next control cycle to see it
+        if (info.fault || imd_status.insulation_resistance_kohm < SAFETY_IMD_MIN_KOHM)
+        {
+            Safety_Notify();
+        }
     }
 }
 
 const IMD_Status_t* IMD_GetStatus(void)
 {
-    // Check timeout (e.g. 500ms)
-    if (HAL_GetTick() - imd_status.last_rx_tick > 1000)
+    // Check timeout (1s since the last frame was on the wire)
+    if (Timebase_GetAge(&imd_status.last_rx_us) > IMD_COMM_TIMEOUT_US)
     {
         imd_status.valid = false;
     }
@@ -5,17 +5,20 @@
 
 #include "safety_monitor.h"
 #include "imd_driver.h"
-#include "meter_driver.h"
+#include "thermal_derate.h"
+#include "can_health.h"
 #include <stdio.h>
 
+static osThreadId_t safety_thread = NULL;
+
 void Safety_Init(void)
 {
-    printf("[Safety] Monitor Initialized (E-Stop, IMD, Temp).\r\n");
+    printf("[Safety] Monitor Initialized (E-Stop, IMD, Temp, CAN).\r\n");
     // Initial Check
-    Safety_Check();
+    Safety_Check(0);
 }
 
-Safety_Status_t Safety_Check(void)
+Safety_Status_t Safety_Check(uint8_t conn)
 {
     // 1. E-Stop Check (Hardwired)
     GPIO_PinState estop_state = HAL_GPIO_ReadPin(Emergency_Stop_GPIO_Port, Emergency_Stop_Pin);
@@ -28,7 +31,7 @@ Safety_Status_t Safety_Check(void)
     const IMD_Status_t *imd = IMD_GetStatus();
     if (imd->valid)
     {
-        if (imd->fault || imd->insulation_resistance_kohm < 100.0f) // Threshold: 100 kOhm
+        if (imd->fault || imd->insulation_resistance_kohm < SAFETY_IMD_MIN_KOHM)
         {
             printf("[Safety] IMD Fault! R_iso: %.1f kOhm\r\n", imd->insulation_resistance_kohm);
             return SAFETY_FAULT_IMD;
@@ -40,13 +43,34 @@ Safety_Status_t Safety_Check(void)
         // return SAFETY_FAULT_IMD; // Strict Safety
     }
 
-    // 3. Over-Temperature Check
-    float temp = Meter_ReadTemperature();
-    if (temp > 85.0f)
+    // 3. Over-Temperature Check (Backstop: the derating keeps the sensors below their trip)
+    float temp;
+    int hot = Thermal_GetOverTemp(conn, &temp);
+    if (hot >= 0)
     {
-        printf("[Safety] Over Temperature! %.1f C\r\n", temp);
+        printf("[Safety] Connector %d Over Temperature! %s %.1f C\r\n", conn + 1, Thermal_ChannelName(hot), temp);
         return SAFETY_FAULT_OVERTEMP;
     }
 
+    // 4. CAN Bus Health (Power Modules / IMD unreachable)
+    if (CAN_Health_IsFaulted())
+    {
+        printf("[Safety] CAN Bus Fault (Bus-Off)!\r\n");
+        return SAFETY_FAULT_CAN_BUS;
+    }
+
     return SAFETY_OK;
 }
+
+void Safety_SetNotifyThread(osThreadId_t thread_id)
+{
+    safety_thread = thread_id;
+}
+
+void Safety_Notify(void)
+{
+    if (safety_thread != NULL)
+    {
+        osThreadFlagsSet(safety_thread, SAFETY_THREAD_FLAG);
+    }
+}
@@ -0,0 +1,324 @@
+/**
+ * @file    thermal_derate.c
+ * @brief   Thermal Derating Implementation
+ *
+ * @details
+ * Per channel, with e = exp(-H / TAU) for the horizon H, the model predicts
+ *     T(H) = A + B * i^2,   A = T_amb + (T - T_amb) * e,   B = RISE * (1 - e)
+ * for a current of i times the reference, and the curve allows
+ *     i = (END - T(H)) / (END - START)
+ * Solving both for i gives B i^2 + D i - (END - A) = 0 with D = END - START,
+ * whose positive root is the channel limit (clamped to 0..1). Only a square
+ * root per channel and period: e is fixed by the configuration.
+ *
+ * Each connector has its own set of channels: its gun's NTCs and the
+ * modules of the groups switched onto its outlet; the ambient (coolest
+ * inlet of all alive modules) is common. Everything runs in the CAN task,
+ * next to the SECC and module decoders it reads from and the regulator
+ * that applies the limit; the status copy for the other tasks
+ * (Safety_Check, CLI, UDS) is taken under PRIMASK.
+ */
+
+#include "thermal_derate.h"
+#include "main.h"
+#include "infy_power.h"
+#include "secc_driver.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct
+{
+    const char *name;
+    float start_c;
+    float end_c;
+    float trip_c;
+    float rise_c;
+    float tau_s;
+    float horizon_s;
+} Thermal_Curve_t;
+
+static const Thermal_Curve_t thermal_curves[THERMAL_CH_COUNT] = {
+    [THERMAL_CH_DC_PLUS]  = { "DC+", THERMAL_PIN_START_C, THERMAL_PIN_END_C, THERMAL_PIN_TRIP_C,
+                              THERMAL_PIN_RISE_C, THERMAL_PIN_TAU_S, THERMAL_PIN_HORIZON_S },
+    [THERMAL_CH_DC_MINUS] = { "DC-", THERMAL_PIN_START_C, THERMAL_PIN_END_C, THERMAL_PIN_TRIP_C,
+                              THERMAL_PIN_RISE_C, THERMAL_PIN_TAU_S, THERMAL_PIN_HORIZON_S },
+    [THERMAL_CH_CABLE]    = { "Cable", THERMAL_CABLE_START_C, THERMAL_CABLE_END_C, THERMAL_CABLE_TRIP_C,
+                              THERMAL_CABLE_RISE_C, THERMAL_CABLE_TAU_S, THERMAL_CABLE_HORIZON_S },
+    [THERMAL_CH_MODULE]   = { "Module", THERMAL_MODULE_START_C, THERMAL_MODULE_END_C, THERMAL_MODULE_TRIP_C,
+                              THERMAL_MODULE_RISE_C, THERMAL_MODULE_TAU_S, THERMAL_MODULE_HORIZON_S },
+};
+
+static struct
+{
+    bool     started;
+    uint64_t last_us;                  // Previous evaluation
+    float    decay[THERMAL_CH_COUNT];  // exp(-horizon / tau)
+    struct
+    {
+        bool     seen[THERMAL_CH_COUNT];   // Reported at least once
+        uint64_t ok_us[THERMAL_CH_COUNT];  // Last valid reading
+        Thermal_Status_t st;               // Working copy
+    } conn[EVSE_CONNECTOR_COUNT];
+} thermal;
+
+static volatile float thermal_limit_a[EVSE_CONNECTOR_COUNT]; // CAN task
+static Thermal_Status_t thermal_status[EVSE_CONNECTOR_COUNT]; // PRIMASK
+
+void Thermal_Init(void)
+{
+    memset(&thermal, 0, sizeof(thermal));
+    for (int ch = 0; ch < THERMAL_CH_COUNT; ch++)
+    {
+        thermal.decay[ch] = expf(-thermal_curves[ch].horizon_s / thermal_curves[ch].tau_s);
+    }
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        Thermal_Status_t *st = &thermal.conn[c].st;
+        for (int ch = 0; ch < THERMAL_CH_COUNT; ch++)
+        {
+            st->ch[ch].limit_pct = 100.0f;
+            st->ch[ch].limit_a = THERMAL_NO_LIMIT_A;
+        }
+        st->ambient_c = THERMAL_AMBIENT_DEFAULT_C;
+        st->module_cap_a = THERMAL_NO_LIMIT_A;
+        st->limit_a = THERMAL_NO_LIMIT_A;
+        st->limiting = -1;
+        thermal_limit_a[c] = THERMAL_NO_LIMIT_A;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++) thermal_status[c] = thermal.conn[c].st;
+    __set_PRIMASK(primask);
+
+    printf("[Thermal] Derating Initialized (Pins %.0f-%.0f C, Cable %.0f-%.0f C, Modules %.0f-%.0f C)\r\n",
+           THERMAL_PIN_START_C, THERMAL_PIN_END_C, THERMAL_CABLE_START_C, THERMAL_CABLE_END_C,
+           THERMAL_MODULE_START_C, THERMAL_MODULE_END_C);
+}
+
+// Filter the reading, run the model, set limit_pct / limit_a (ref_a: current at i = 1)
+static void Thermal_Channel(uint8_t conn, int ch, bool ok, float temp_c, float load, float ref_a, float dt, uint64_t now)
+{
+    const Thermal_Curve_t *c = &thermal_curves[ch];
+    Thermal_Channel_t *out = &thermal.conn[conn].st.ch[ch];
+
+    if (ok)
+    {
+        // First reading (or the first after a loss) is taken as it is
+        if (!out->valid) out->temp_c = temp_c;
+        else out->temp_c += (temp_c - out->temp_c) * dt / (THERMAL_FILTER_S + dt);
+        out->valid = true;
+        out->stale = false;
+        thermal.conn[conn].seen[ch] = true;
+        thermal.conn[conn].ok_us[ch] = now;
+    }
+    else if (thermal.conn[conn].seen[ch] && (now - thermal.conn[conn].ok_us[ch]) > THERMAL_SENSOR_TIMEOUT_US)
+    {
+        out->valid = false;
+        out->stale = true;
+    }
+
+    float f = 1.0f;
+    if (out->valid)
+    {
+        float amb = thermal.conn[conn].st.ambient_c;
+        float e = thermal.decay[ch];
+        float a = amb + (out->temp_c - amb) * e;
+        float b = c->rise_c * (1.0f - e);
+        float d = c->end_c - c->start_c;
+        float head = c->end_c - a;
+
+        out->predict_c = a + b * load * load;
+        if (head <= 0.0f) f = 0.0f;
+        else if (b <= 0.0f) f = head / d;
+        else f = (sqrtf(d * d + 4.0f * b * head) - d) / (2.0f * b);
+        if (f > 1.0f) f = 1.0f;
+    }
+    else if (out->stale)
+    {
+        f = THERMAL_FALLBACK_PCT / 100.0f;
+    }
+
+    out->limit_pct = f * 100.0f;
+    out->limit_a = (f < 1.0f && ref_a > 0.0f) ? f * ref_a : THERMAL_NO_LIMIT_A;
+}
+
+// Ambient: coolest inlet of all alive modules (they share the cabinet air)
+static bool Thermal_Ambient(const Infy_SystemStatus_t *pwr, float *inlet)
+{
+    bool ok = false;
+    *inlet = 127.0f;
+    for (uint8_t m = 0; m < INFY_MAX_MODULES; m++)
+    {
+        if (!((pwr->alive_mask >> m) & 1U) || ((pwr->fault_mask >> m) & 1U)) continue;
+        Infy_ModuleStatus_t st;
+        if (!Infy_GetModuleStatus(m, &st) || !(st.polled & (1U << INFY_POLL_TEMPS))) continue;
+        if (st.temp_inlet < *inlet) *inlet = st.temp_inlet;
+        ok = true;
+    }
+    return ok;
+}
+
+static void Thermal_Connector(uint8_t conn, const Infy_SystemStatus_t *pwr, bool amb_ok, float amb_c,
+                              float dt, uint64_t now)
+{
+    Infy_OutletStatus_t out;
+    Infy_GetOutletStatus(conn, &out);
+    float out_a = (out.current > 0.0f) ? out.current : 0.0f;
+
+    // Modules of the outlet: hottest stage, capacity (alive / running / after their own derating)
+    bool mod_ok = false;
+    float mod_hot = -128.0f;
+    float cap_a = 0.0f;
+    float run_a = 0.0f;
+    float cap_kw = 0.0f;
+    bool derated = false;
+    for (uint8_t m = 0; m < INFY_MAX_MODULES; m++)
+    {
+        if (!((out.modules >> m) & 1U)) continue;
+        if (!((pwr->alive_mask >> m) & 1U) || ((pwr->fault_mask >> m) & 1U)) continue;
+        Infy_ModuleStatus_t st;
+        if (!Infy_GetModuleStatus(m, &st)) continue;
+
+        cap_a += st.max_current;
+        if ((pwr->on_mask >> m) & 1U) run_a += st.max_current;
+        if (st.polled & (1U << INFY_POLL_TEMPS))
+        {
+            float hot = (st.temp_pfc > st.temp_dcdc) ? st.temp_pfc : st.temp_dcdc;
+            if (hot > mod_hot) mod_hot = hot;
+            mod_ok = true;
+        }
+        uint8_t pct = (st.polled & (1U << INFY_POLL_DERATE)) ? st.derate_pct : 100U;
+        if (pct < 100U) derated = true;
+        cap_kw += st.rated_kw * pct / 100.0f;
+    }
+
+    Thermal_Status_t *s = &thermal.conn[conn].st;
+    s->ambient_valid = amb_ok;
+    s->ambient_c = amb_ok ? amb_c : THERMAL_AMBIENT_DEFAULT_C;
+    s->module_derated = derated;
+    s->module_cap_kw = cap_kw;
+    s->module_cap_a = (derated && out.voltage >= THERMAL_CAP_MIN_V) ? cap_kw * 1000.0f / out.voltage : THERMAL_NO_LIMIT_A;
+
+    // Gun (SECC): never received = no NTCs fitted
+    const SECC_Control_t *secc = &secc_control[conn];
+    bool gun = (secc->temps_rx_us != 0) &&
+               (Timebase_GetAge(&secc->temps_rx_us) <= THERMAL_SENSOR_TIMEOUT_US);
+    uint8_t gun_ok = gun ? secc->temps_ok : 0U;
+    float pin_load = out_a / THERMAL_PIN_RATED_A;
+    Thermal_Channel(conn, THERMAL_CH_DC_PLUS, (gun_ok & 0x01U) != 0, secc->temp_dc_plus, pin_load, THERMAL_PIN_RATED_A, dt, now);
+    Thermal_Channel(conn, THERMAL_CH_DC_MINUS, (gun_ok & 0x02U) != 0, secc->temp_dc_minus, pin_load, THERMAL_PIN_RATED_A, dt, now);
+    Thermal_Channel(conn, THERMAL_CH_CABLE, (gun_ok & 0x04U) != 0, secc->temp_cable, pin_load, THERMAL_PIN_RATED_A, dt, now);
+    Thermal_Channel(conn, THERMAL_CH_MODULE, mod_ok, mod_hot, (run_a > 0.0f) ? out_a / run_a : 0.0f, cap_a, dt, now);
+
+    // Lowest limit wins
+    float limit = s->module_cap_a;
+    int8_t limiting = (limit < THERMAL_NO_LIMIT_A) ? THERMAL_CH_COUNT : -1;
+    bool below = derated;
+    for (int ch = 0; ch < THERMAL_CH_COUNT; ch++)
+    {
+        if (s->ch[ch].limit_pct < 100.0f) below = true;
+        if (s->ch[ch].limit_a < limit)
+        {
+            limit = s->ch[ch].limit_a;
+            limiting = (int8_t)ch;
+        }
+    }
+
+    if (limiting != s->limiting)
+    {
+        if (limiting < 0) printf("[Thermal] Connector %d Derating Ended\r\n", conn + 1);
+        else if (limiting == THERMAL_CH_COUNT) printf("[Thermal] Connector %d Derating: Modules at %.1f kW -> %.0f A\r\n",
+                                                      conn + 1, cap_kw, limit);
+        else printf("[Thermal] Connector %d Derating: %s %.1f C (%.1f C Predicted) -> %.0f A\r\n", conn + 1,
+                    thermal_curves[limiting].name, s->ch[limiting].temp_c, s->ch[limiting].predict_c, limit);
+    }
+
+    s->limit_a = limit;
+    s->limiting = limiting;
+    s->evaluations++;
+    if (below) s->derating_ms += (uint32_t)(dt * 1000.0f + 0.5f);
+    thermal_limit_a[conn] = limit;
+}
+
+void Thermal_Process(void)
+{
+    uint64_t now = Timebase_GetMicros();
+    if (thermal.started && (now - thermal.last_us) < (uint64_t)THERMAL_PERIOD_MS * 1000U) return;
+
+    float dt = thermal.started ? (now - thermal.last_us) * 1e-6f : 0.0f;
+    if (dt > 1.0f) dt = 1.0f;
+    thermal.started = true;
+    thermal.last_us = now;
+
+    Infy_SystemStatus_t pwr;
+    Infy_GetSystemStatus(&pwr);
+    float inlet;
+    bool amb_ok = Thermal_Ambient(&pwr, &inlet);
+
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        Thermal_Connector(c, &pwr, amb_ok, inlet, dt, now);
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++) thermal_status[c] = thermal.conn[c].st;
+    __set_PRIMASK(primask);
+}
+
+float Thermal_GetCurrentLimit(uint8_t conn)
+{
+    return (conn < EVSE_CONNECTOR_COUNT) ? thermal_limit_a[conn] : 0.0f;
+}
+
+float Thermal_GetTemperature(uint8_t conn)
+{
+    Thermal_Status_t st;
+    Thermal_GetStatus(conn, &st);
+
+    bool found = false;
+    float hottest = st.ambient_c;
+    for (int ch = 0; ch < THERMAL_CH_COUNT; ch++)
+    {
+        if (st.ch[ch].valid && (!found || st.ch[ch].temp_c > hottest))
+        {
+            hottest = st.ch[ch].temp_c;
+            found = true;
+        }
+    }
+    return hottest;
+}
+
+int Thermal_GetOverTemp(uint8_t conn, float *temp_c)
+{
+    Thermal_Status_t st;
+    Thermal_GetStatus(conn, &st);
+
+    for (int ch = 0; ch < THERMAL_CH_COUNT; ch++)
+    {
+        if (st.ch[ch].valid && st.ch[ch].temp_c > thermal_curves[ch].trip_c)
+        {
+            if (temp_c != NULL) *temp_c = st.ch[ch].temp_c;
+            return ch;
+        }
+    }
+    return -1;
+}
+
+const char *Thermal_ChannelName(int ch)
+{
+    if (ch < 0 || ch >= THERMAL_CH_COUNT) return "?";
+    return thermal_curves[ch].name;
+}
+
+void Thermal_GetStatus(uint8_t conn, Thermal_Status_t *status)
+{
+    if (conn >= EVSE_CONNECTOR_COUNT) conn = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = thermal_status[conn];
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,155 @@
+/**
+ * @file    crc_bench.c
+ * @brief   Host Benchmark of the CRC Service
+ *
+ * @note    Times, per algorithm, over a Modbus-sized frame and a UDS
+ *          transfer block:
+ *          - the bit-by-bit loop the CRC service replaced (Modbus_CRC16,
+ *            UDS_Crc32, copied below)
+ *          - Crc_ComputeBitwise(), the service's generic bit-serial form
+ *          - Crc_Compute(), tables on the host (the target uses the CRC
+ *            unit: "crc_bench" in the CLI)
+ *          Every result is checked against the replaced loop, including
+ *          Crc_Update() over the buffer in uneven pieces; the exit code is
+ *          1 on a mismatch.
+ */
+
+#include "host_hal.h"
+#include "crc_service.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_BYTES        (256U * 1024U)  // Per measurement
+#define BENCH_SIZES        2
+#define BENCH_CHECK_MAX    4096U           // Longest buffer of the result check
+
+static const uint32_t bench_sizes[BENCH_SIZES] = { 8U, 2050U }; // Modbus request, UDS block
+
+static uint8_t bench_buf[BENCH_CHECK_MAX + 64U]; // Timed calls start at a varying offset
+static uint32_t bench_rng = 12345U;
+static volatile uint32_t bench_sink;
+
+static uint32_t Bench_Rand(void)
+{
+    bench_rng = bench_rng * 1103515245U + 12345U;
+    return bench_rng >> 8;
+}
+
+static double Bench_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Previous implementation: Modbus master (bit loop)
+static uint32_t Bench_OldModbus(const uint8_t *buffer, uint32_t buffer_length)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint32_t pos = 0; pos < buffer_length; pos++) {
+        crc ^= (uint16_t)buffer[pos];
+        for (int i = 8; i != 0; i--) {
+            if ((crc & 0x0001) != 0) {
+                crc >>= 1;
+                crc ^= 0xA001;
+            } else {
+                crc >>= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+// Previous implementation: UDS download (bit loop)
+static uint32_t Bench_OldCrc32(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = ~0U;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+typedef uint32_t (*Bench_Fn_t)(Crc_Algo_t algo, const uint8_t *data, uint32_t len);
+
+static uint32_t Bench_Old(Crc_Algo_t algo, const uint8_t *data, uint32_t len)
+{
+    return (algo == CRC_ALGO_MODBUS) ? Bench_OldModbus(data, len) : Bench_OldCrc32(data, len);
+}
+
+static uint32_t Bench_Bitwise(Crc_Algo_t algo, const uint8_t *data, uint32_t len)
+{
+    return Crc_ComputeBitwise(algo, data, len);
+}
+
+static uint32_t Bench_Service(Crc_Algo_t algo, const uint8_t *data, uint32_t len)
+{
+    return Crc_Compute(algo, data, len);
+}
+
+// ns per byte
+static double Bench_Time(Bench_Fn_t fn, Crc_Algo_t algo, uint32_t len)
+{
+    uint32_t calls = BENCH_BYTES / len;
+    uint32_t acc = 0;
+    double t0 = Bench_Now();
+    for (uint32_t i = 0; i < calls; i++) acc += fn(algo, &bench_buf[i & 63U], len);
+    double t1 = Bench_Now();
+    bench_sink = acc;
+    return (t1 - t0) / ((double)calls * len);
+}
+
+static bool Bench_Check(Crc_Algo_t algo)
+{
+    bool ok = true;
+    for (uint32_t len = 0; len <= BENCH_CHECK_MAX; len += 1U + len / 3U)
+    {
+        uint32_t ref = Bench_Old(algo, bench_buf, len);
+        uint32_t crc = Crc_Compute(algo, NULL, 0);
+        for (uint32_t pos = 0; pos < len; )
+        {
+            uint32_t n = 1U + Bench_Rand() % 97U;
+            if (n > len - pos) n = len - pos;
+            crc = Crc_Update(algo, crc, &bench_buf[pos], n);
+            pos += n;
+        }
+        if (Crc_Compute(algo, bench_buf, len) != ref || Crc_ComputeBitwise(algo, bench_buf, len) != ref || crc != ref)
+        {
+            printf("  MISMATCH %s, %u bytes: ref 0x%08X\n", Crc_GetParams(algo)->name, len, ref);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(void)
+{
+    for (uint32_t i = 0; i < sizeof(bench_buf); i++) bench_buf[i] = (uint8_t)Bench_Rand();
+
+    bool ok = Crc_Init();
+
+    printf("CRC benchmark, %u KiB per measurement (ns/byte)\n", BENCH_BYTES / 1024U);
+    printf("  %-14s %6s %10s %10s %10s %8s\n", "Algorithm", "Bytes", "Old loop", "Bitwise", "Service", "Speedup");
+    for (int a = 0; a < CRC_ALGO_COUNT; a++)
+    {
+        for (int s = 0; s < BENCH_SIZES; s++)
+        {
+            double t_old = Bench_Time(Bench_Old, (Crc_Algo_t)a, bench_sizes[s]);
+            double t_bit = Bench_Time(Bench_Bitwise, (Crc_Algo_t)a, bench_sizes[s]);
+            double t_svc = Bench_Time(Bench_Service, (Crc_Algo_t)a, bench_sizes[s]);
+            printf("  %-14s %6u %10.2f %10.2f %10.2f %7.1fx\n", Crc_GetParams((Crc_Algo_t)a)->name,
+                   bench_sizes[s], t_old, t_bit, t_svc, t_old / t_svc);
+        }
+        if (!Bench_Check((Crc_Algo_t)a)) ok = false;
+    }
+
+    printf("CRC check: %s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
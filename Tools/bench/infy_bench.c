@@ -0,0 +1,176 @@
+/**
+ * @file    infy_bench.c
+ * @brief   Host Benchmark of the Power Module Status Aggregation
+ *
+ * @note    Built with INFY_MAX_MODULES=64 (see Makefile). Feeds status
+ *          frames for all modules through Infy_RxHandler(), lets a quarter
+ *          of them go silent for the timeout sweep and times:
+ *          - Infy_RxHandler() per frame (incremental aggregate update)
+ *          - Infy_Process() per sweep
+ *          - Infy_GetSystemStatus() per call
+ *          - a full walk of all modules with a timeout check per module,
+ *            the per-call work Infy_GetSystemStatus() used to do (here
+ *            with a row copy per module on top, so it reads a bit high).
+ *          Every published aggregate is checked against a full recompute
+ *          from Infy_GetModuleStatus(); the exit code is 1 on a mismatch.
+ */
+
+#include "host_hal.h"
+#include "infy_power.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROUNDS       2000   // Status frames per module
+#define BENCH_CALLS        1000000
+#define BENCH_FRAME_US     100    // Wire time between status frames
+
+static uint32_t bench_rng = 12345U;
+
+static uint32_t Bench_Rand(void)
+{
+    bench_rng = bench_rng * 1103515245U + 12345U;
+    return bench_rng >> 8;
+}
+
+static double Bench_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void Bench_Frame(int idx, uint64_t t_us, CAN_Message_t *msg)
+{
+    Infy_Status_t st = {
+        .voltage = (uint16_t)(3000U + Bench_Rand() % 7000U),
+        .current = (uint16_t)(Bench_Rand() % 1000U),
+        .is_on = (uint8_t)(Bench_Rand() & 1U),
+        .fault_ov = (uint8_t)((Bench_Rand() % 64U) == 0),
+    };
+
+    memset(msg, 0, sizeof(*msg));
+    msg->timestamp_us = t_us;
+    msg->id = INFY_CAN_ID_STATUS_BASE + (uint32_t)idx;
+    msg->id_type = CAN_ID_EXT;
+    msg->bus = CAN_BUS_POWER;
+    msg->len = INFY_STATUS_LEN;
+    Infy_Status_Pack(&st, msg->data);
+}
+
+// Previous implementation: walk all modules, timeout check per module
+static void Bench_FullWalk(Infy_SystemStatus_t *out)
+{
+    float max_v = 0.0f;
+    float total_i = 0.0f;
+    int valid_cnt = 0;
+    bool any_fault = false;
+
+    for (uint8_t i = 0; i < INFY_MAX_MODULES; i++)
+    {
+        Infy_ModuleStatus_t m;
+        Infy_GetModuleStatus(i, &m);
+        if (m.comm_timeout || (Timebase_GetMicros() - m.last_rx_us) > INFY_COMM_TIMEOUT_US) continue;
+
+        if (m.output_voltage > max_v) max_v = m.output_voltage;
+        total_i += m.output_current;
+        valid_cnt++;
+        if (m.fault_ot || m.fault_ov || m.fault_uv) any_fault = true;
+    }
+
+    out->total_voltage = max_v;
+    out->total_current = total_i;
+    out->active_modules = valid_cnt;
+    out->system_fault = any_fault;
+}
+
+static int Bench_Check(const char *when)
+{
+    Infy_SystemStatus_t fast, ref;
+    Infy_GetSystemStatus(&fast);
+    Bench_FullWalk(&ref);
+
+    // Sum differs from the float walk by rounding only
+    float di = fast.total_current - ref.total_current;
+    if (fast.active_modules != ref.active_modules || fast.system_fault != ref.system_fault ||
+        fast.total_voltage != ref.total_voltage || di > 0.5f || di < -0.5f)
+    {
+        printf("MISMATCH %s: %.1f V %.1f A %d %d vs %.1f V %.1f A %d %d\n", when,
+               fast.total_voltage, fast.total_current, fast.active_modules, fast.system_fault,
+               ref.total_voltage, ref.total_current, ref.active_modules, ref.system_fault);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    CAN_Message_t msg;
+    Infy_SystemStatus_t st;
+    volatile float sink = 0.0f;
+    int errors = 0;
+    uint64_t t_us = 1000;
+
+    Host_Init();
+    CAN_Driver_Init(&hfdcan2);
+    Infy_Init(&hfdcan2);
+
+    // RX: every module reports, modules 48..63 go silent after half the
+    // rounds; the sweep runs once per round (~6 ms) like the CAN task's
+    double rx_ns = 0.0;
+    double sweep_ns = 0.0;
+    uint32_t rx_frames = 0;
+    uint32_t sweeps = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        for (int i = 0; i < INFY_MAX_MODULES; i++)
+        {
+            t_us += BENCH_FRAME_US;
+            Host_SetMicros(t_us);
+            if (r >= BENCH_ROUNDS / 2 && i >= (INFY_MAX_MODULES * 3) / 4) continue;
+
+            Bench_Frame(i, t_us, &msg);
+
+            double t0 = Bench_Now();
+            Infy_RxHandler(&msg);
+            rx_ns += Bench_Now() - t0;
+            rx_frames++;
+        }
+
+        double t0 = Bench_Now();
+        Infy_Process();
+        sweep_ns += Bench_Now() - t0;
+        sweeps++;
+
+        if ((r % 16) == 0) errors += Bench_Check("rx");
+    }
+    errors += Bench_Check("end");
+
+    double t0 = Bench_Now();
+    for (int k = 0; k < BENCH_CALLS; k++)
+    {
+        Infy_GetSystemStatus(&st);
+        sink += st.total_current;
+    }
+    double get_ns = Bench_Now() - t0;
+
+    t0 = Bench_Now();
+    for (int k = 0; k < BENCH_CALLS; k++)
+    {
+        Bench_FullWalk(&st);
+        sink += st.total_current;
+    }
+    double walk_ns = Bench_Now() - t0;
+
+    Infy_GetSystemStatus(&st);
+    printf("Modules: %d, alive at the end: %d (mask 0x%016llX)\n", INFY_MAX_MODULES, st.active_modules,
+           (unsigned long long)st.alive_mask);
+    printf("Infy_RxHandler        %8.1f ns/frame (%lu frames)\n", rx_ns / rx_frames, (unsigned long)rx_frames);
+    printf("Infy_Process          %8.1f ns/sweep\n", sweep_ns / sweeps);
+    printf("Infy_GetSystemStatus  %8.1f ns/call\n", get_ns / BENCH_CALLS);
+    printf("Full walk (reference) %8.1f ns/call\n", walk_ns / BENCH_CALLS);
+    printf("Aggregate check: %s\n", errors ? "FAILED" : "OK");
+
+    return errors ? 1 : 0;
+}
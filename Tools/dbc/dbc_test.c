@@ -0,0 +1,214 @@
+/**
+ * @file    dbc_test.c
+ * @brief   Host Test of the Generated CAN Signal Code (can_db_*.h)
+ *
+ * @note    Every message of the DBC files has reference frames written out
+ *          by hand from the DBC layout (byte order, sign, bit position), not
+ *          from dbcgen.py. Per vector:
+ *          - <Msg>_Pack() of the raw values gives the reference bytes,
+ *            writes exactly <MSG>_LEN bytes and clears the unused bits
+ *          - <Msg>_Unpack() of the reference bytes gives the raw values
+ *            back, signed fields sign-extended (SECC_TEMP_INVALID_RAW,
+ *            negative temperatures and trims)
+ *          - <Msg>_Unpack() sets every field: Pack of a struct unpacked
+ *            over garbage gives the reference bytes again
+ *          The exit code is 1 on a mismatch.
+ */
+
+#include "can_db_secc.h"
+#include "can_db_power.h"
+#include "can_db_imd.h"
+#include "secc_driver.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DBC_FRAME_MAX   64U     // CAN FD
+#define DBC_FILL        0xEEU   // Frame bytes before Pack
+#define DBC_GARBAGE     0x5A    // Struct bytes before Unpack
+
+static uint32_t dbc_vectors;
+static uint32_t dbc_failed;
+
+static void Dbc_Dump(const char *what, const uint8_t *data, uint32_t len)
+{
+    printf("    %-6s", what);
+    for (uint32_t i = 0; i < len; i++) printf(" %02X", data[i]);
+    printf("\n");
+}
+
+static void Dbc_Check(const char *name, uint32_t len, const uint8_t *ref, uint32_t ref_len,
+                      const uint8_t *packed, const uint8_t *repacked, bool fields_ok)
+{
+    bool ok = (ref_len == len) && fields_ok;
+
+    if (ref_len == len)
+    {
+        if (memcmp(packed, ref, len) != 0 || memcmp(repacked, ref, len) != 0) ok = false;
+    }
+    for (uint32_t i = len; i < DBC_FRAME_MAX; i++)
+    {
+        if (packed[i] != DBC_FILL) ok = false; // Written past <MSG>_LEN
+    }
+
+    dbc_vectors++;
+    if (ok) return;
+
+    dbc_failed++;
+    printf("  MISMATCH %s (vector %u bytes, %u expected)%s\n", name, ref_len, len,
+           fields_ok ? "" : ", unpacked fields differ");
+    Dbc_Dump("ref", ref, ref_len);
+    Dbc_Dump("pack", packed, len);
+    Dbc_Dump("repack", repacked, len);
+}
+
+// value: raw signal values as a parenthesized compound literal, then the frame bytes
+#define DBC_VECTOR(Msg, LEN, value, ...)                                    \
+    do {                                                                    \
+        static const uint8_t ref[] = { __VA_ARGS__ };                       \
+        Msg##_t in = value, out, back;                                      \
+        uint8_t packed[DBC_FRAME_MAX], repacked[DBC_FRAME_MAX];             \
+        memset(packed, DBC_FILL, sizeof(packed));                           \
+        memset(repacked, DBC_FILL, sizeof(repacked));                       \
+        Msg##_Pack(&in, packed);                                            \
+        memset(&out, DBC_GARBAGE, sizeof(out));                             \
+        Msg##_Unpack(ref, &out);                                            \
+        Msg##_Pack(&out, repacked);                                         \
+        memcpy(&back, &in, sizeof(back)); /* same padding as in */          \
+        Msg##_Unpack(ref, &back);                                           \
+        Dbc_Check(#Msg, LEN, ref, sizeof(ref), packed, repacked,            \
+                  memcmp(&back, &in, sizeof(in)) == 0);                     \
+    } while (0)
+
+// secc.dbc: Intel byte order
+static void Dbc_TestSecc(void)
+{
+    DBC_VECTOR(CCU_Status, CCU_STATUS_LEN,
+               ((CCU_Status_t){ .cp_voltage = 9012, .pp_voltage = 0, .pwm_duty = 53,
+                                .relay_state = 0x03, .err_code = 0x81 }),
+               0x34, 0x23, 0x00, 0x00, 0x35, 0x03, 0x81, 0x00);
+
+    DBC_VECTOR(CCU_Combined, CCU_COMBINED_LEN,
+               ((CCU_Combined_t){ .cp_voltage = 6012, .pp_voltage = 1234, .pwm_duty = 5,
+                                  .relay_state = 1, .err_code = 0, .ac_voltage = 2301,
+                                  .ac_current = 325, .temperature = -40, .dc_voltage = 4005,
+                                  .dc_current = 1250, .active_modules = 12, .power_fault = 1,
+                                  .counter = 255 }),
+               0x7C, 0x17, 0xD2, 0x04, 0x05, 0x01, 0x00, 0x00,
+               0xFD, 0x08, 0x45, 0x01, 0xD8, 0x00, 0x00, 0x00,
+               0xA5, 0x0F, 0xE2, 0x04, 0x0C, 0x01, 0xFF, 0x00);
+
+    DBC_VECTOR(CCU_Meter, CCU_METER_LEN,
+               ((CCU_Meter_t){ .ac_voltage = 65535, .ac_current = 0, .temperature = -128 }),
+               0xFF, 0xFF, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00);
+    DBC_VECTOR(CCU_Meter, CCU_METER_LEN,
+               ((CCU_Meter_t){ .ac_voltage = 2300, .ac_current = 160, .temperature = 127 }),
+               0xFC, 0x08, 0xA0, 0x00, 0x7F, 0x00, 0x00, 0x00);
+
+    DBC_VECTOR(SECC_Command, SECC_COMMAND_LEN,
+               ((SECC_Command_t){ .target_pwm_duty = 100, .allow_power = 1, .reset_fault = 0 }),
+               0x64, 0x01, 0x00);
+
+    DBC_VECTOR(SECC_DcDemand, SECC_DCDEMAND_LEN,
+               ((SECC_DcDemand_t){ .target_voltage = 4000, .target_current = 1250, .soc = 87 }),
+               0xA0, 0x0F, 0xE2, 0x04, 0x57);
+
+    DBC_VECTOR(SECC_DcLimits, SECC_DCLIMITS_LEN,
+               ((SECC_DcLimits_t){ .ev_max_voltage = 9200, .ev_max_current = 2000 }),
+               0xF0, 0x23, 0xD0, 0x07);
+
+    DBC_VECTOR(SECC_Temps, SECC_TEMPS_LEN,
+               ((SECC_Temps_t){ .temp_dc_plus = SECC_TEMP_INVALID_RAW, .temp_dc_minus = -253,
+                                .temp_cable = 654 }),
+               0x00, 0x80, 0x03, 0xFF, 0x8E, 0x02);
+    DBC_VECTOR(SECC_Temps, SECC_TEMPS_LEN,
+               ((SECC_Temps_t){ .temp_dc_plus = 32767, .temp_dc_minus = -1, .temp_cable = 0 }),
+               0xFF, 0x7F, 0xFF, 0xFF, 0x00, 0x00);
+    DBC_VECTOR(SECC_Temps, SECC_TEMPS_LEN,
+               ((SECC_Temps_t){ .temp_dc_plus = SECC_TEMP_INVALID_RAW,
+                                .temp_dc_minus = SECC_TEMP_INVALID_RAW,
+                                .temp_cable = SECC_TEMP_INVALID_RAW }),
+               0x00, 0x80, 0x00, 0x80, 0x00, 0x80);
+}
+
+// power.dbc: 16/32-bit values Motorola (big endian), flags Intel
+static void Dbc_TestPower(void)
+{
+    DBC_VECTOR(Infy_Control, INFY_CONTROL_LEN,
+               ((Infy_Control_t){ .voltage = 7500, .current = 305, .enable = 1, .group_mask = 0xA5 }),
+               0x1D, 0x4C, 0x01, 0x31, 0x01, 0xA5, 0x00, 0x00);
+
+    DBC_VECTOR(Infy_Stage, INFY_STAGE_LEN,
+               ((Infy_Stage_t){ .group_mask = 0x0F }),
+               0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+
+    DBC_VECTOR(Infy_Trim, INFY_TRIM_LEN,
+               ((Infy_Trim_t){ .current_trim = -15 }),
+               0xFF, 0xF1);
+    DBC_VECTOR(Infy_Trim, INFY_TRIM_LEN,
+               ((Infy_Trim_t){ .current_trim = INT16_MIN }),
+               0x80, 0x00);
+    DBC_VECTOR(Infy_Trim, INFY_TRIM_LEN,
+               ((Infy_Trim_t){ .current_trim = 32767 }),
+               0x7F, 0xFF);
+
+    DBC_VECTOR(Infy_Range, INFY_RANGE_LEN,
+               ((Infy_Range_t){ .high_mask = 0x81 }),
+               0x81, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+
+    DBC_VECTOR(Infy_Query, INFY_QUERY_LEN,
+               ((Infy_Query_t){ .item = 3 }),
+               0x03);
+
+    DBC_VECTOR(Infy_Status, INFY_STATUS_LEN,
+               ((Infy_Status_t){ .voltage = 7498, .current = 2999, .is_on = 1, .fault_ov = 0,
+                                 .range_high = 1 }),
+               0x1D, 0x4A, 0x0B, 0xB7, 0x05);
+    DBC_VECTOR(Infy_Status, INFY_STATUS_LEN,
+               ((Infy_Status_t){ .voltage = 0, .current = 0, .is_on = 0, .fault_ov = 1,
+                                 .range_high = 0 }),
+               0x00, 0x00, 0x00, 0x00, 0x02);
+
+    DBC_VECTOR(Infy_Info, INFY_INFO_LEN,
+               ((Infy_Info_t){ .rated_power = 300, .max_current = 1000, .sweet_spot = 60 }),
+               0x01, 0x2C, 0x03, 0xE8, 0x3C);
+
+    DBC_VECTOR(Infy_Temps, INFY_TEMPS_LEN,
+               ((Infy_Temps_t){ .temp_inlet = -40, .temp_pfc = 0, .temp_dcdc = 127 }),
+               0xD8, 0x00, 0x7F);
+    DBC_VECTOR(Infy_Temps, INFY_TEMPS_LEN,
+               ((Infy_Temps_t){ .temp_inlet = -128, .temp_pfc = -1, .temp_dcdc = 85 }),
+               0x80, 0xFF, 0x55);
+
+    DBC_VECTOR(Infy_AcInput, INFY_ACINPUT_LEN,
+               ((Infy_AcInput_t){ .v_ab = 4000, .v_bc = 4012, .v_ca = 3998 }),
+               0x0F, 0xA0, 0x0F, 0xAC, 0x0F, 0x9E);
+
+    DBC_VECTOR(Infy_Faults, INFY_FAULTS_LEN,
+               ((Infy_Faults_t){ .fault_word = 0x80000105U }),
+               0x80, 0x00, 0x01, 0x05);
+
+    DBC_VECTOR(Infy_Derate, INFY_DERATE_LEN,
+               ((Infy_Derate_t){ .power_limit = 75, .reason = 0x05 }),
+               0x4B, 0x05);
+}
+
+// imd.dbc
+static void Dbc_TestImd(void)
+{
+    DBC_VECTOR(IMD_Info, IMD_INFO_LEN,
+               ((IMD_Info_t){ .r_iso = 500, .warning = 0, .fault = 1 }),
+               0x01, 0xF4, 0x02, 0x00);
+    DBC_VECTOR(IMD_Info, IMD_INFO_LEN,
+               ((IMD_Info_t){ .r_iso = 65535, .warning = 1, .fault = 0 }),
+               0xFF, 0xFF, 0x01, 0x00);
+}
+
+int main(void)
+{
+    Dbc_TestSecc();
+    Dbc_TestPower();
+    Dbc_TestImd();
+
+    printf("DBC check: %u vectors, %s\n", dbc_vectors, dbc_failed ? "FAILED" : "OK");
+    return dbc_failed ? 1 : 0;
+}
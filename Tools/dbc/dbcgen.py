@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+"""
+DBC -> C header generator for the CAN signal pack/unpack code.
+
+    python3 dbcgen.py secc.dbc ../../Modules/CAN/Inc/can_db_secc.h
+
+Per message the header gets ID/length/format defines, a struct of raw
+(integer, unscaled) signal values and two static inline functions:
+
+    <Msg>_Pack(const <Msg>_t *m, uint8_t *data)    writes all <MSG>_LEN bytes
+    <Msg>_Unpack(const uint8_t *data, <Msg>_t *m)  reads <MSG>_MIN_LEN bytes
+
+Both are straight-line shift/mask code (no branches, no float): scaling
+is left to the caller and documented per field. Intel (@1) and Motorola
+(@0, DBC start bit = MSB) byte orders and signed signals are supported.
+Multiplexing and float signals are not (none of our buses use them).
+
+Only the standard library is used, so the firmware checkout needs no
+extra Python packages.
+"""
+
+import os
+import re
+import sys
+
+RE_BO = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)')
+RE_SG = re.compile(r'^SG_\s+(\w+)\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+                   r'\(([^,]+),([^)]+)\)\s*\[([^|]*)\|([^\]]*)\]\s*"([^"]*)"')
+RE_CM_BO = re.compile(r'^CM_\s+BO_\s+(\d+)\s+"([^"]*)"\s*;')
+RE_CM_SG = re.compile(r'^CM_\s+SG_\s+(\d+)\s+(\w+)\s+"([^"]*)"\s*;')
+RE_BA_FMT = re.compile(r'^BA_\s+"VFrameFormat"\s+BO_\s+(\d+)\s+(\d+)\s*;')
+
+CAN_EXT_FLAG = 0x80000000
+FD_LENGTHS = (0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64)
+
+
+class Signal:
+    def __init__(self, name, start, length, motorola, signed, factor, offset, unit):
+        self.name = name
+        self.start = start
+        self.length = length
+        self.motorola = motorola
+        self.signed = signed
+        self.factor = factor
+        self.offset = offset
+        self.unit = unit
+        self.comment = ''
+
+    def bit_positions(self):
+        """Frame bit (byte * 8 + bit) of each value bit, index = value bit."""
+        if not self.motorola:
+            return [self.start + i for i in range(self.length)]
+        pos = [0] * self.length
+        p = self.start
+        for k in range(self.length):
+            pos[self.length - 1 - k] = p   # MSB first
+            p = p + 15 if p % 8 == 0 else p - 1
+        return pos
+
+    def segments(self):
+        """(byte, bit in byte, value bit, width) runs, one per touched byte."""
+        runs = {}
+        for vbit, fbit in enumerate(self.bit_positions()):
+            byte, bit = divmod(fbit, 8)
+            if byte not in runs:
+                runs[byte] = [bit, vbit, 0]
+            runs[byte][0] = min(runs[byte][0], bit)
+            runs[byte][1] = min(runs[byte][1], vbit)
+            runs[byte][2] += 1
+        return sorted((b, r[0], r[1], r[2]) for b, r in runs.items())
+
+    def c_type(self):
+        for bits in (8, 16, 32, 64):
+            if self.length <= bits:
+                return ('int%d_t' if self.signed else 'uint%d_t') % bits
+        raise ValueError('signal %s longer than 64 bits' % self.name)
+
+    def raw_type(self):
+        return 'uint64_t' if self.length > 32 else 'uint32_t'
+
+
+class Message:
+    def __init__(self, frame_id, name, dlc, sender):
+        self.ext = bool(frame_id & CAN_EXT_FLAG)
+        self.id = frame_id & ~CAN_EXT_FLAG
+        self.name = name
+        self.dlc = dlc
+        self.sender = sender
+        self.fd = False
+        self.comment = ''
+        self.signals = []
+
+    def min_len(self):
+        last = -1
+        for s in self.signals:
+            last = max([last] + [b for b, _, _, _ in s.segments()])
+        return last + 1
+
+
+def parse(path):
+    msgs = {}
+    current = None
+    with open(path) as f:
+        for raw in f:
+            line = raw.strip()
+            m = RE_BO.match(line)
+            if m:
+                current = Message(int(m.group(1)), m.group(2), int(m.group(3)), m.group(4))
+                msgs[int(m.group(1))] = current
+                continue
+            m = RE_SG.match(line)
+            if m and current is not None:
+                current.signals.append(Signal(
+                    m.group(1), int(m.group(2)), int(m.group(3)), m.group(4) == '0',
+                    m.group(5) == '-', m.group(6).strip(), m.group(7).strip(), m.group(10)))
+                continue
+            if not line.startswith('SG_'):
+                current = None
+            m = RE_CM_BO.match(line)
+            if m and int(m.group(1)) in msgs:
+                msgs[int(m.group(1))].comment = m.group(2)
+                continue
+            m = RE_CM_SG.match(line)
+            if m and int(m.group(1)) in msgs:
+                for s in msgs[int(m.group(1))].signals:
+                    if s.name == m.group(2):
+                        s.comment = m.group(3)
+                continue
+            m = RE_BA_FMT.match(line)
+            if m and int(m.group(1)) in msgs:
+                msgs[int(m.group(1))].fd = int(m.group(2)) >= 14
+    return list(msgs.values())
+
+
+def check(msg):
+    if msg.fd and msg.dlc not in FD_LENGTHS:
+        raise ValueError('%s: %d is not a CAN FD length' % (msg.name, msg.dlc))
+    if not msg.fd and msg.dlc > 8:
+        raise ValueError('%s: classic frame longer than 8 bytes' % msg.name)
+    used = {}
+    for s in msg.signals:
+        for fbit in s.bit_positions():
+            if fbit < 0 or fbit >= msg.dlc * 8:
+                raise ValueError('%s.%s: outside of the frame' % (msg.name, s.name))
+            if fbit in used:
+                raise ValueError('%s.%s overlaps %s' % (msg.name, s.name, used[fbit]))
+            used[fbit] = s.name
+
+
+def scale_text(s):
+    text = '%s %s/bit' % (s.factor, s.unit) if s.unit else 'x' + s.factor
+    if s.offset not in ('0', '0.0'):
+        text += ', offset ' + s.offset
+    if s.comment:
+        text += ' (' + s.comment + ')'
+    return text
+
+
+def emit_message(msg, out):
+    upper = msg.name.upper()
+    mask = lambda w: '0x%XU' % ((1 << w) - 1)
+
+    out.append('// 0x%X %s%s' % (msg.id, msg.name, (': ' + msg.comment) if msg.comment else ''))
+    out.append('#define %-28s 0x%XU' % (upper + '_ID', msg.id))
+    out.append('#define %-28s %s' % (upper + '_ID_TYPE', 'CAN_ID_EXT' if msg.ext else 'CAN_ID_STD'))
+    out.append('#define %-28s %d' % (upper + '_FD', 1 if msg.fd else 0))
+    out.append('#define %-28s %dU' % (upper + '_LEN', msg.dlc))
+    out.append('#define %-28s %dU // Bytes carrying signals' % (upper + '_MIN_LEN', msg.min_len()))
+    out.append('')
+    out.append('typedef struct')
+    out.append('{')
+    width = max([len(s.c_type()) for s in msg.signals] + [1])
+    for s in msg.signals:
+        decl = '%-*s %s;' % (width, s.c_type(), s.name)
+        out.append('    %-32s // %s' % (decl, scale_text(s)))
+    out.append('} %s_t;' % msg.name)
+    out.append('')
+
+    # Pack: every byte assigned once, unused bits 0
+    per_byte = {b: [] for b in range(msg.dlc)}
+    for s in msg.signals:
+        for byte, bit, vbit, w in s.segments():
+            src = '(%s)m->%s' % (s.raw_type(), s.name) if s.signed else 'm->%s' % s.name
+            expr = '(%s >> %d)' % (src, vbit) if vbit else src
+            term = '((%s & %s) << %d)' % (expr, mask(w), bit) if bit else '(%s & %s)' % (expr, mask(w))
+            per_byte[byte].append(term)
+    out.append('static inline void %s_Pack(const %s_t *m, uint8_t *data)' % (msg.name, msg.name))
+    out.append('{')
+    for b in range(msg.dlc):
+        terms = per_byte[b]
+        if not terms:
+            out.append('    data[%d] = 0;' % b)
+        elif len(terms) == 1:
+            out.append('    data[%d] = (uint8_t)%s;' % (b, terms[0]))
+        else:
+            out.append('    data[%d] = (uint8_t)(%s);' % (b, ' | '.join(terms)))
+    out.append('}')
+    out.append('')
+
+    # Unpack: integer only, sign extension by xor/subtract
+    out.append('static inline void %s_Unpack(const uint8_t *data, %s_t *m)' % (msg.name, msg.name))
+    out.append('{')
+    for s in msg.signals:
+        terms = []
+        segs = s.segments()
+        for byte, bit, vbit, w in segs:
+            t = '(data[%d] >> %d)' % (byte, bit) if bit else 'data[%d]' % byte
+            if w != 8 or bit:
+                t = '(%s & %s)' % (t, mask(w))
+            if vbit:
+                t = '((%s)%s << %d)' % (s.raw_type(), t, vbit)
+            elif len(segs) > 1 or s.signed:
+                t = '(%s)%s' % (s.raw_type(), t)
+            terms.append(t)
+        raw = ' | '.join(terms) if len(terms) > 1 else terms[0]
+        if s.signed:
+            sign = '0x%XU' % (1 << (s.length - 1))
+            if s.length > 32:
+                sign += 'LL'
+            out.append('    m->%s = (%s)(((%s) ^ %s) - %s);' % (s.name, s.c_type(), raw, sign, sign))
+        else:
+            out.append('    m->%s = (%s)%s;' % (s.name, s.c_type(), raw if len(terms) == 1 else '(' + raw + ')'))
+    out.append('}')
+    out.append('')
+
+
+def generate(dbc_path, out_path):
+    msgs = parse(dbc_path)
+    for msg in msgs:
+        check(msg)
+
+    base = os.path.basename(out_path)
+    guard = 'MODULES_CAN_' + re.sub(r'\W', '_', base).upper() + '_'
+    dbc_name = os.path.basename(dbc_path)
+
+    out = ['/**',
+           ' * @file    %s' % base,
+           ' * @brief   CAN Signal Pack/Unpack (%s)' % dbc_name,
+           ' *',
+           ' * @note    Generated by Tools/dbc/dbcgen.py from Tools/dbc/%s.' % dbc_name,
+           ' *          Do not edit: change the DBC and run make in Tools/dbc.',
+           ' *          Struct fields are raw signal values; scale is in the comment.',
+           ' */',
+           '',
+           '#ifndef %s' % guard,
+           '#define %s' % guard,
+           '',
+           '#include "can_driver.h"',
+           '#include <stdint.h>',
+           '']
+    for msg in msgs:
+        emit_message(msg, out)
+    out.append('#endif /* %s */' % guard)
+
+    text = '\n'.join(out) + '\n'
+    with open(out_path, 'w', newline='\n') as f:
+        f.write(text)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.stderr.write('Usage: %s input.dbc output.h\n' % sys.argv[0])
+        sys.exit(2)
+    try:
+        generate(sys.argv[1], sys.argv[2])
+    except ValueError as e:
+        sys.stderr.write('%s: %s\n' % (sys.argv[1], e))
+        sys.exit(1)
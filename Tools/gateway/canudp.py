@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""
+Listener for the CAN-over-UDP gateway (Modules/CAN/Inc/can_gateway.h).
+
+    python3 canudp.py                          print frames, ports 20000-20002
+    python3 canudp.py --port 20000 --bus 1     power bus only
+    python3 canudp.py --vcan vcan0,vcan1,vcan2 also write to SocketCAN
+
+Datagrams are cannelloni v2, one UDP port per bus (base port + bus index).
+Output follows candump -L ("(time) canN ID#DATA", FD frames "ID##<flags>DATA")
+with the host receive time, so it can be fed to the usual can-utils tools.
+
+For --vcan the interfaces must exist and be up (FD capable for FD frames):
+
+    ip link add dev vcan1 type vcan && ip link set vcan1 mtu 72 up
+
+A single bus can also be bridged with cannelloni itself:
+
+    cannelloni -I vcan1 -R <controller ip> -r 20001 -l 20001
+
+Only the standard library is used.
+"""
+
+import argparse
+import select
+import socket
+import struct
+import sys
+import time
+
+PROTO_VERSION = 2
+OP_DATA = 0
+ID_EFF = 0x80000000
+LEN_FD = 0x80
+FD_BRS = 0x01
+BUS_COUNT = 3
+
+
+def parse_datagram(data):
+    """Yield (can_id, fd, flags, payload); raises ValueError on a bad datagram."""
+    if len(data) < 5:
+        raise ValueError('short header')
+    version, op, _seq, count = struct.unpack_from('>BBBH', data, 0)
+    if version != PROTO_VERSION or op != OP_DATA:
+        raise ValueError('version %d op %d' % (version, op))
+    pos = 5
+    for _ in range(count):
+        if pos + 5 > len(data):
+            raise ValueError('truncated frame header')
+        can_id, length = struct.unpack_from('>IB', data, pos)
+        pos += 5
+        fd = bool(length & LEN_FD)
+        length &= ~LEN_FD
+        flags = 0
+        if fd:
+            flags = data[pos]
+            pos += 1
+        if length > 64 or pos + length > len(data):
+            raise ValueError('truncated frame data')
+        yield can_id, fd, flags, data[pos:pos + length]
+        pos += length
+
+
+def candump_line(stamp, bus, can_id, fd, flags, payload):
+    if can_id & ID_EFF:
+        ident = '%08X' % (can_id & 0x1FFFFFFF)
+    else:
+        ident = '%03X' % (can_id & 0x7FF)
+    sep = '##%X' % flags if fd else '#'
+    return '(%.6f) can%d %s%s%s' % (stamp, bus, ident, sep, payload.hex().upper())
+
+
+class VcanWriter:
+    def __init__(self, names):
+        self.socks = []
+        for name in names:
+            s = socket.socket(socket.AF_CAN, socket.SOCK_RAW, socket.CAN_RAW)
+            s.setsockopt(socket.SOL_CAN_RAW, socket.CAN_RAW_FD_FRAMES, 1)
+            s.bind((name,))
+            self.socks.append(s)
+
+    def send(self, bus, can_id, fd, flags, payload):
+        if bus >= len(self.socks):
+            return
+        if fd:
+            frame = struct.pack('=IBBxx64s', can_id, len(payload), flags, payload)
+        else:
+            frame = struct.pack('=IBxxx8s', can_id, len(payload), payload)
+        self.socks[bus].send(frame)
+
+
+def main():
+    ap = argparse.ArgumentParser(description='CAN-over-UDP gateway listener')
+    ap.add_argument('--port', type=int, default=20000, help='base port (gw_port)')
+    ap.add_argument('--bus', type=int, action='append', help='bus index to listen for (repeatable)')
+    ap.add_argument('--vcan', help='comma separated SocketCAN interfaces, one per bus')
+    ap.add_argument('--quiet', action='store_true', help='do not print frames')
+    args = ap.parse_args()
+
+    buses = args.bus if args.bus else list(range(BUS_COUNT))
+    writer = VcanWriter(args.vcan.split(',')) if args.vcan else None
+
+    socks = {}
+    for bus in buses:
+        s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        s.bind(('', args.port + bus))
+        socks[s] = bus
+
+    last_seq = {}
+    while True:
+        ready, _, _ = select.select(list(socks), [], [])
+        for s in ready:
+            data, _addr = s.recvfrom(2048)
+            bus = socks[s]
+            stamp = time.time()
+            if len(data) >= 3:
+                seq = data[2]
+                if bus in last_seq and seq != (last_seq[bus] + 1) & 0xFF:
+                    sys.stderr.write('can%d: %d datagram(s) lost\n' % (bus, (seq - last_seq[bus] - 1) & 0xFF))
+                last_seq[bus] = seq
+            try:
+                for can_id, fd, flags, payload in parse_datagram(data):
+                    if writer:
+                        writer.send(bus, can_id, fd, flags, payload)
+                    if not args.quiet:
+                        print(candump_line(stamp, bus, can_id, fd, flags, payload), flush=True)
+            except ValueError as e:
+                sys.stderr.write('can%d: bad datagram (%s)\n' % (bus, e))
+
+
+if __name__ == '__main__':
+    try:
+        main()
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,49 @@
+/**
+ * @file    cmsis_os.h
+ * @brief   Host (Linux) Stand-in for CMSIS-RTOS2
+ *
+ * @note    The host tools run every task body from one loop, so thread
+ *          flags only have to be accepted, never waited on, and timers are
+ *          never started: the tool calls their callbacks itself.
+ */
+
+#ifndef TOOLS_HOST_CMSIS_OS_H_
+#define TOOLS_HOST_CMSIS_OS_H_
+
+#include <stdint.h>
+
+typedef void *osThreadId_t;
+typedef void *osTimerId_t;
+typedef void (*osTimerFunc_t)(void *argument);
+
+typedef enum
+{
+    osOK = 0,
+    osError = -1,
+    osErrorResource = -3,
+} osStatus_t;
+
+typedef enum
+{
+    osTimerOnce = 0,
+    osTimerPeriodic = 1,
+} osTimerType_t;
+
+typedef struct
+{
+    const char *name;
+    uint32_t attr_bits;
+    void *cb_mem;
+    uint32_t cb_size;
+} osTimerAttr_t;
+
+typedef struct { void *pad[11]; } StaticTimer_t; // FreeRTOS control block stand-in
+
+#define osFlagsWaitAny  0x00000000U
+#define osWaitForever   0xFFFFFFFFU
+
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags);
+osTimerId_t osTimerNew(osTimerFunc_t func, osTimerType_t type, void *argument, const osTimerAttr_t *attr);
+osStatus_t osTimerStart(osTimerId_t timer_id, uint32_t ticks);
+
+#endif /* TOOLS_HOST_CMSIS_OS_H_ */
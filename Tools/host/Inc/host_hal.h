@@ -0,0 +1,66 @@
+/**
+ * @file    host_hal.h
+ * @brief   Host (Linux) Harness for Firmware Modules
+ *
+ * @note    Provides a virtual clock behind HAL_GetTick() and the Timebase,
+ *          GPIO state, peripheral handles and stand-ins for the modules that
+ *          need real hardware (Control Pilot ADC, W5500, TLS, CAN health).
+ *          Everything is single-threaded: the tool calls the task bodies
+ *          and "ISR" callbacks itself, in virtual-time order.
+ */
+
+#ifndef TOOLS_HOST_HOST_HAL_H_
+#define TOOLS_HOST_HOST_HAL_H_
+
+#include "main.h"
+#include "fdcan.h"
+#include "usart.h"
+#include "tim.h"
+#include <stdbool.h>
+
+// Output observers (NULL = ignored)
+typedef void (*Host_UartTxHook_t)(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len);
+typedef void (*Host_OcppTxHook_t)(const uint8_t *data, size_t len);
+
+extern Host_UartTxHook_t host_uart_tx_hook;
+extern Host_OcppTxHook_t host_ocpp_tx_hook;
+
+/**
+ * @brief Reset peripherals, GPIO (E-Stop released) and the clock to 0
+ * @note  FDCAN1 is set up FD BRS, FDCAN2/3 classic, as in Core/Src/fdcan.c.
+ */
+void Host_Init(void);
+
+/**
+ * @brief Set the virtual clock (must not go backwards)
+ */
+void Host_SetMicros(uint64_t now_us);
+
+/**
+ * @brief Get the virtual clock
+ */
+uint64_t Host_GetMicros(void);
+
+/**
+ * @brief Buffer and length of the last HAL_UART_Receive_DMA() on a UART
+ * @param len Output, expected length (may be NULL)
+ * @return Destination buffer, NULL if no receive is pending
+ */
+uint8_t *Host_GetUartRxBuffer(UART_HandleTypeDef *huart, uint16_t *len);
+
+/**
+ * @brief Complete the pending UART receive (clears it)
+ */
+void Host_ClearUartRx(UART_HandleTypeDef *huart);
+
+/**
+ * @brief Control Pilot voltage returned by CP_ReadVoltage() for a connector
+ */
+void Host_SetCpVoltage(uint8_t conn, float volts);
+
+/**
+ * @brief Last duty set by CP_SetPWM() for a connector
+ */
+float Host_GetCpDuty(uint8_t conn);
+
+#endif /* TOOLS_HOST_HOST_HAL_H_ */
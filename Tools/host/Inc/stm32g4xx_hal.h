@@ -0,0 +1,309 @@
+/**
+ * @file    stm32g4xx_hal.h
+ * @brief   Host (Linux) Stand-in for the STM32G4 HAL
+ *
+ * @note    Only what the host-compiled firmware modules use. Placed ahead of
+ *          the real HAL on the include path, so Core/Inc/main.h, fdcan.h,
+ *          usart.h and tim.h resolve to these types. Peripheral instances
+ *          are plain host structs; register fields are the few the drivers
+ *          read directly.
+ */
+
+#ifndef TOOLS_HOST_STM32G4XX_HAL_H_
+#define TOOLS_HOST_STM32G4XX_HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __IO volatile
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum { RESET = 0U, SET = !RESET } FlagStatus, ITStatus;
+
+#define SET_BIT(REG, BIT)     ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)   ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)    ((REG) & (BIT))
+
+// --- Core Intrinsics (Single-threaded host: PRIMASK is a plain flag) ---
+extern uint32_t host_primask;
+
+static inline uint32_t __get_PRIMASK(void) { return host_primask; }
+static inline void __set_PRIMASK(uint32_t primask) { host_primask = primask; }
+static inline void __disable_irq(void) { host_primask = 1U; }
+static inline void __enable_irq(void) { host_primask = 0U; }
+static inline void __DMB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline void __NOP(void) { }
+
+// --- Tick ---
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay_ms);
+void HAL_NVIC_SystemReset(void);
+
+// --- NVIC ---
+typedef enum
+{
+    FDCAN1_IT1_IRQn = 22,
+    FDCAN2_IT1_IRQn = 87,
+    FDCAN3_IT1_IRQn = 89,
+} IRQn_Type;
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn);
+
+// --- GPIO ---
+typedef struct
+{
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef enum { GPIO_PIN_RESET = 0U, GPIO_PIN_SET } GPIO_PinState;
+
+extern GPIO_TypeDef host_gpio[6];
+#define GPIOA  (&host_gpio[0])
+#define GPIOB  (&host_gpio[1])
+#define GPIOC  (&host_gpio[2])
+#define GPIOD  (&host_gpio[3])
+#define GPIOE  (&host_gpio[4])
+#define GPIOF  (&host_gpio[5])
+
+#define GPIO_PIN_0   ((uint16_t)0x0001)
+#define GPIO_PIN_1   ((uint16_t)0x0002)
+#define GPIO_PIN_2   ((uint16_t)0x0004)
+#define GPIO_PIN_3   ((uint16_t)0x0008)
+#define GPIO_PIN_4   ((uint16_t)0x0010)
+#define GPIO_PIN_5   ((uint16_t)0x0020)
+#define GPIO_PIN_6   ((uint16_t)0x0040)
+#define GPIO_PIN_7   ((uint16_t)0x0080)
+#define GPIO_PIN_8   ((uint16_t)0x0100)
+#define GPIO_PIN_9   ((uint16_t)0x0200)
+#define GPIO_PIN_10  ((uint16_t)0x0400)
+#define GPIO_PIN_11  ((uint16_t)0x0800)
+#define GPIO_PIN_12  ((uint16_t)0x1000)
+#define GPIO_PIN_13  ((uint16_t)0x2000)
+#define GPIO_PIN_14  ((uint16_t)0x4000)
+#define GPIO_PIN_15  ((uint16_t)0x8000)
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_MODE_OUTPUT_PP  0x01U
+#define GPIO_NOPULL          0x00U
+#define GPIO_SPEED_FREQ_LOW  0x00U
+#define __HAL_RCC_GPIOD_CLK_ENABLE()  do { } while (0)
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+// --- TIM ---
+typedef struct { uint32_t CNT; } TIM_TypeDef;
+typedef struct { TIM_TypeDef *Instance; } TIM_HandleTypeDef;
+
+extern TIM_TypeDef host_tim[4];
+#define TIM1  (&host_tim[0])
+#define TIM3  (&host_tim[1])
+#define TIM6  (&host_tim[2])
+
+// --- UART ---
+typedef struct { uint32_t ISR; } USART_TypeDef;
+typedef struct { uint32_t BaudRate; } UART_InitTypeDef;
+typedef struct { uint32_t Instance; } DMA_HandleTypeDef;
+typedef struct { USART_TypeDef *Instance; UART_InitTypeDef Init; DMA_HandleTypeDef *hdmarx; } UART_HandleTypeDef;
+
+#define DMA_IT_HT                          0x00000004U
+#define __HAL_DMA_DISABLE_IT(__HANDLE__, __INTERRUPT__)  ((void)(__HANDLE__), (void)(__INTERRUPT__))
+
+extern USART_TypeDef host_usart[3];
+#define USART1  (&host_usart[0])
+#define USART2  (&host_usart[1])
+#define USART3  (&host_usart[2])
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+
+// --- FDCAN ---
+typedef struct
+{
+    __IO uint32_t CCCR;
+    __IO uint32_t IR;
+    __IO uint32_t TXEFS;
+} FDCAN_GlobalTypeDef;
+
+extern FDCAN_GlobalTypeDef host_fdcan[3];
+#define FDCAN1  (&host_fdcan[0])
+#define FDCAN2  (&host_fdcan[1])
+#define FDCAN3  (&host_fdcan[2])
+
+#define FDCAN_CCCR_INIT   0x00000001U
+#define FDCAN_CCCR_FDOE   0x00000100U
+#define FDCAN_CCCR_BRSE   0x00000200U
+#define FDCAN_TXEFS_EFFL  0x00000007U
+
+typedef struct
+{
+    uint32_t FrameFormat;
+    uint32_t Mode;
+    uint32_t AutoRetransmission;
+    uint32_t NominalPrescaler;
+    uint32_t NominalSyncJumpWidth;
+    uint32_t NominalTimeSeg1;
+    uint32_t NominalTimeSeg2;
+    uint32_t DataPrescaler;
+    uint32_t DataSyncJumpWidth;
+    uint32_t DataTimeSeg1;
+    uint32_t DataTimeSeg2;
+    uint32_t StdFiltersNbr;
+    uint32_t ExtFiltersNbr;
+    uint32_t TxFifoQueueMode;
+} FDCAN_InitTypeDef;
+
+typedef struct
+{
+    FDCAN_GlobalTypeDef *Instance;
+    FDCAN_InitTypeDef    Init;
+    uint32_t             ErrorCode;
+} FDCAN_HandleTypeDef;
+
+typedef struct
+{
+    uint32_t IdType;
+    uint32_t FilterIndex;
+    uint32_t FilterType;
+    uint32_t FilterConfig;
+    uint32_t FilterID1;
+    uint32_t FilterID2;
+} FDCAN_FilterTypeDef;
+
+typedef struct
+{
+    uint32_t Identifier;
+    uint32_t IdType;
+    uint32_t TxFrameType;
+    uint32_t DataLength;
+    uint32_t ErrorStateIndicator;
+    uint32_t BitRateSwitch;
+    uint32_t FDFormat;
+    uint32_t TxEventFifoControl;
+    uint32_t MessageMarker;
+} FDCAN_TxHeaderTypeDef;
+
+typedef struct
+{
+    uint32_t Identifier;
+    uint32_t IdType;
+    uint32_t RxFrameType;
+    uint32_t DataLength;
+    uint32_t ErrorStateIndicator;
+    uint32_t BitRateSwitch;
+    uint32_t FDFormat;
+    uint32_t RxTimestamp;
+    uint32_t FilterIndex;
+    uint32_t IsFilterMatchingFrame;
+} FDCAN_RxHeaderTypeDef;
+
+typedef struct
+{
+    uint32_t Identifier;
+    uint32_t IdType;
+    uint32_t TxFrameType;
+    uint32_t DataLength;
+    uint32_t ErrorStateIndicator;
+    uint32_t BitRateSwitch;
+    uint32_t FDFormat;
+    uint32_t TxTimestamp;
+    uint32_t MessageMarker;
+    uint32_t EventType;
+} FDCAN_TxEventFifoTypeDef;
+
+#define FDCAN_FRAME_CLASSIC        0x00000000U
+#define FDCAN_FRAME_FD_NO_BRS      FDCAN_CCCR_FDOE
+#define FDCAN_FRAME_FD_BRS         (FDCAN_CCCR_FDOE | FDCAN_CCCR_BRSE)
+
+#define FDCAN_STANDARD_ID          0x00000000U
+#define FDCAN_EXTENDED_ID          0x40000000U
+#define FDCAN_DATA_FRAME           0x00000000U
+#define FDCAN_ESI_ACTIVE           0x00000000U
+#define FDCAN_BRS_OFF              0x00000000U
+#define FDCAN_BRS_ON               0x00100000U
+#define FDCAN_CLASSIC_CAN          0x00000000U
+#define FDCAN_FD_CAN               0x00200000U
+#define FDCAN_NO_TX_EVENTS         0x00000000U
+#define FDCAN_STORE_TX_EVENTS      0x00800000U
+
+#define FDCAN_FILTER_RANGE         0x00000000U
+#define FDCAN_FILTER_DUAL          0x00000001U
+#define FDCAN_FILTER_MASK          0x00000002U
+#define FDCAN_FILTER_TO_RXFIFO0    0x00000001U
+#define FDCAN_FILTER_TO_RXFIFO1    0x00000002U
+#define FDCAN_REJECT               0x00000002U
+#define FDCAN_REJECT_REMOTE        0x00000001U
+
+#define FDCAN_RX_FIFO0             0x00000040U
+#define FDCAN_RX_FIFO1             0x00000041U
+
+#define FDCAN_TIMESTAMP_PRESC_1    0x00000000U
+#define FDCAN_TIMESTAMP_INTERNAL   0x00000001U
+#define FDCAN_TIMESTAMP_EXTERNAL   0x00000002U
+
+#define FDCAN_TX_BUFFER0           0x00000001U
+#define FDCAN_TX_BUFFER1           0x00000002U
+#define FDCAN_TX_BUFFER2           0x00000004U
+
+#define FDCAN_IT_RX_FIFO0_NEW_MESSAGE   0x00000001U
+#define FDCAN_IT_RX_FIFO0_FULL          0x00000002U
+#define FDCAN_IT_RX_FIFO0_MESSAGE_LOST  0x00000004U
+#define FDCAN_IT_RX_FIFO1_NEW_MESSAGE   0x00000008U
+#define FDCAN_IT_RX_FIFO1_FULL          0x00000010U
+#define FDCAN_IT_RX_FIFO1_MESSAGE_LOST  0x00000020U
+#define FDCAN_IT_TX_COMPLETE            0x00000200U
+#define FDCAN_IT_TX_EVT_FIFO_NEW_DATA   0x00001000U
+#define FDCAN_IT_TX_EVT_FIFO_ELT_LOST   0x00008000U
+#define FDCAN_IT_ERROR_WARNING          0x01000000U
+#define FDCAN_IT_ERROR_PASSIVE          0x00800000U
+#define FDCAN_IT_BUS_OFF                0x02000000U
+
+#define FDCAN_FLAG_RX_FIFO1_NEW_MESSAGE   FDCAN_IT_RX_FIFO1_NEW_MESSAGE
+#define FDCAN_FLAG_RX_FIFO1_MESSAGE_LOST  FDCAN_IT_RX_FIFO1_MESSAGE_LOST
+#define __HAL_FDCAN_CLEAR_FLAG(__HANDLE__, __FLAG__)  ((__HANDLE__)->Instance->IR = (__FLAG__))
+
+#define FDCAN_IT_GROUP_RX_FIFO1         0x00000002U
+#define FDCAN_INTERRUPT_LINE1           0x00000001U
+
+HAL_StatusTypeDef HAL_FDCAN_ConfigFilter(FDCAN_HandleTypeDef *hfdcan, const FDCAN_FilterTypeDef *sFilterConfig);
+HAL_StatusTypeDef HAL_FDCAN_ConfigGlobalFilter(FDCAN_HandleTypeDef *hfdcan, uint32_t NonMatchingStd,
+                                               uint32_t NonMatchingExt, uint32_t RejectRemoteStd,
+                                               uint32_t RejectRemoteExt);
+HAL_StatusTypeDef HAL_FDCAN_ConfigTimestampCounter(FDCAN_HandleTypeDef *hfdcan, uint32_t TimestampPrescaler);
+HAL_StatusTypeDef HAL_FDCAN_EnableTimestampCounter(FDCAN_HandleTypeDef *hfdcan, uint32_t TimestampOperation);
+HAL_StatusTypeDef HAL_FDCAN_ConfigInterruptLines(FDCAN_HandleTypeDef *hfdcan, uint32_t ITList, uint32_t InterruptLine);
+HAL_StatusTypeDef HAL_FDCAN_Start(FDCAN_HandleTypeDef *hfdcan);
+HAL_StatusTypeDef HAL_FDCAN_ActivateNotification(FDCAN_HandleTypeDef *hfdcan, uint32_t ActiveITs,
+                                                 uint32_t BufferIndexes);
+HAL_StatusTypeDef HAL_FDCAN_AddMessageToTxFifoQ(FDCAN_HandleTypeDef *hfdcan, const FDCAN_TxHeaderTypeDef *pTxHeader,
+                                                const uint8_t *pTxData);
+uint32_t HAL_FDCAN_GetTxFifoFreeLevel(const FDCAN_HandleTypeDef *hfdcan);
+uint32_t HAL_FDCAN_GetRxFifoFillLevel(const FDCAN_HandleTypeDef *hfdcan, uint32_t RxFifo);
+HAL_StatusTypeDef HAL_FDCAN_GetRxMessage(FDCAN_HandleTypeDef *hfdcan, uint32_t RxLocation,
+                                         FDCAN_RxHeaderTypeDef *pRxHeader, uint8_t *pRxData);
+HAL_StatusTypeDef HAL_FDCAN_GetTxEvent(FDCAN_HandleTypeDef *hfdcan, FDCAN_TxEventFifoTypeDef *pTxEvent);
+
+#endif /* TOOLS_HOST_STM32G4XX_HAL_H_ */
@@ -0,0 +1,395 @@
+/**
+ * @file    host_hal.c
+ * @brief   Host (Linux) Harness Implementation
+ *
+ * @details
+ * Firmware modules are compiled unchanged against Tools/host/Inc. The HAL
+ * calls they make land here: time comes from the virtual clock, GPIO
+ * writes land in host_gpio[], FDCAN always has a free TX slot (frames are
+ * observed through the CAN driver taps), UART DMA requests are remembered
+ * so the tool can complete them. Modules that need real hardware and are
+ * not compiled on the host (timebase, can_health, control_pilot, w5500,
+ * mbedtls) are replaced by minimal stand-ins.
+ */
+
+#include "host_hal.h"
+#include "can_health.h"
+#include "control_pilot.h"
+#include "w5500_driver.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+#include <string.h>
+
+#define HOST_UART_COUNT  3
+
+typedef struct
+{
+    uint8_t *buf;
+    uint16_t len;
+} Host_UartRx_t;
+
+uint32_t host_primask = 0;
+GPIO_TypeDef host_gpio[6];
+TIM_TypeDef host_tim[4];
+USART_TypeDef host_usart[HOST_UART_COUNT];
+FDCAN_GlobalTypeDef host_fdcan[3];
+
+FDCAN_HandleTypeDef hfdcan1;
+FDCAN_HandleTypeDef hfdcan2;
+FDCAN_HandleTypeDef hfdcan3;
+UART_HandleTypeDef huart1;
+UART_HandleTypeDef huart2;
+UART_HandleTypeDef huart3;
+TIM_HandleTypeDef htim1;
+TIM_HandleTypeDef htim3;
+
+Host_UartTxHook_t host_uart_tx_hook = NULL;
+Host_OcppTxHook_t host_ocpp_tx_hook = NULL;
+
+static uint64_t host_now_us = 0;
+static Host_UartRx_t host_uart_rx[HOST_UART_COUNT];
+static float host_cp_volts[EVSE_CONNECTOR_MAX] = { 12.0f, 12.0f, 12.0f, 12.0f };
+static float host_cp_duty[EVSE_CONNECTOR_MAX] = { 100.0f, 100.0f, 100.0f, 100.0f };
+
+static int Host_UartIndex(const UART_HandleTypeDef *huart)
+{
+    if (huart == NULL) return -1;
+    if (huart->Instance == USART1) return 0;
+    if (huart->Instance == USART2) return 1;
+    if (huart->Instance == USART3) return 2;
+    return -1;
+}
+
+void Host_Init(void)
+{
+    memset(host_gpio, 0, sizeof(host_gpio));
+    memset(host_fdcan, 0, sizeof(host_fdcan));
+    memset(host_uart_rx, 0, sizeof(host_uart_rx));
+    host_now_us = 0;
+    host_primask = 0;
+
+    // E-Stop input is active low
+    host_gpio[2].IDR |= Emergency_Stop_Pin;
+
+    memset(&hfdcan1, 0, sizeof(hfdcan1));
+    memset(&hfdcan2, 0, sizeof(hfdcan2));
+    memset(&hfdcan3, 0, sizeof(hfdcan3));
+    hfdcan1.Instance = FDCAN1;
+    hfdcan1.Init.FrameFormat = FDCAN_FRAME_FD_BRS;
+    hfdcan2.Instance = FDCAN2;
+    hfdcan2.Init.FrameFormat = FDCAN_FRAME_CLASSIC;
+    hfdcan3.Instance = FDCAN3;
+    hfdcan3.Init.FrameFormat = FDCAN_FRAME_CLASSIC;
+
+    huart1.Instance = USART1;
+    huart2.Instance = USART2;
+    huart3.Instance = USART3;
+    huart3.Init.BaudRate = 9600; // Modbus (Core/Src/usart.c)
+    htim1.Instance = TIM1;
+    htim3.Instance = TIM3;
+}
+
+void Host_SetMicros(uint64_t now_us)
+{
+    if (now_us > host_now_us) host_now_us = now_us;
+}
+
+uint64_t Host_GetMicros(void)
+{
+    return host_now_us;
+}
+
+uint8_t *Host_GetUartRxBuffer(UART_HandleTypeDef *huart, uint16_t *len)
+{
+    int idx = Host_UartIndex(huart);
+    if (idx < 0) return NULL;
+    if (len != NULL) *len = host_uart_rx[idx].len;
+    return host_uart_rx[idx].buf;
+}
+
+void Host_ClearUartRx(UART_HandleTypeDef *huart)
+{
+    int idx = Host_UartIndex(huart);
+    if (idx < 0) return;
+    host_uart_rx[idx].buf = NULL;
+    host_uart_rx[idx].len = 0;
+}
+
+void Host_SetCpVoltage(uint8_t conn, float volts) { if (conn < EVSE_CONNECTOR_MAX) host_cp_volts[conn] = volts; }
+float Host_GetCpDuty(uint8_t conn) { return (conn < EVSE_CONNECTOR_MAX) ? host_cp_duty[conn] : 0.0f; }
+
+// --- HAL: Tick / System ---
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(host_now_us / TIMEBASE_US_PER_MS);
+}
+
+void HAL_Delay(uint32_t delay_ms)
+{
+    host_now_us += (uint64_t)delay_ms * TIMEBASE_US_PER_MS;
+}
+
+void HAL_NVIC_SystemReset(void) { }
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority) { }
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) { }
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn) { } // Urgent frames are injected, never pended
+void Error_Handler(void) { }
+
+// --- HAL: GPIO (Outputs in ODR, inputs in IDR) ---
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) { }
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return ((GPIOx->IDR | GPIOx->ODR) & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if (PinState == GPIO_PIN_SET) GPIOx->ODR |= GPIO_Pin;
+    else GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    GPIOx->ODR ^= GPIO_Pin;
+}
+
+// --- HAL: UART ---
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    if (host_uart_tx_hook != NULL) host_uart_tx_hook(huart, pData, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    int idx = Host_UartIndex(huart);
+    if (idx < 0) return HAL_ERROR;
+    host_uart_rx[idx].buf = pData;
+    host_uart_rx[idx].len = Size;
+    return HAL_OK;
+}
+
+// Completed by the tool (Host_GetUartRxBuffer, then the RX event callback)
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    return HAL_UART_Receive_DMA(huart, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart)
+{
+    Host_ClearUartRx(huart);
+    return HAL_OK;
+}
+
+// --- HAL: FDCAN (TX always accepted, RX only via CAN_InjectRx) ---
+HAL_StatusTypeDef HAL_FDCAN_ConfigFilter(FDCAN_HandleTypeDef *hfdcan, const FDCAN_FilterTypeDef *sFilterConfig)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_ConfigGlobalFilter(FDCAN_HandleTypeDef *hfdcan, uint32_t NonMatchingStd,
+                                               uint32_t NonMatchingExt, uint32_t RejectRemoteStd,
+                                               uint32_t RejectRemoteExt)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_ConfigTimestampCounter(FDCAN_HandleTypeDef *hfdcan, uint32_t TimestampPrescaler)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_EnableTimestampCounter(FDCAN_HandleTypeDef *hfdcan, uint32_t TimestampOperation)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_ConfigInterruptLines(FDCAN_HandleTypeDef *hfdcan, uint32_t ITList, uint32_t InterruptLine)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_Start(FDCAN_HandleTypeDef *hfdcan)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_ActivateNotification(FDCAN_HandleTypeDef *hfdcan, uint32_t ActiveITs,
+                                                 uint32_t BufferIndexes)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_AddMessageToTxFifoQ(FDCAN_HandleTypeDef *hfdcan, const FDCAN_TxHeaderTypeDef *pTxHeader,
+                                                const uint8_t *pTxData)
+{
+    return HAL_OK;
+}
+
+uint32_t HAL_FDCAN_GetTxFifoFreeLevel(const FDCAN_HandleTypeDef *hfdcan)
+{
+    return 3U;
+}
+
+uint32_t HAL_FDCAN_GetRxFifoFillLevel(const FDCAN_HandleTypeDef *hfdcan, uint32_t RxFifo)
+{
+    return 0U;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_GetRxMessage(FDCAN_HandleTypeDef *hfdcan, uint32_t RxLocation,
+                                         FDCAN_RxHeaderTypeDef *pRxHeader, uint8_t *pRxData)
+{
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_GetTxEvent(FDCAN_HandleTypeDef *hfdcan, FDCAN_TxEventFifoTypeDef *pTxEvent)
+{
+    return HAL_ERROR;
+}
+
+// --- RTOS ---
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags)
+{
+    return flags;
+}
+
+osTimerId_t osTimerNew(osTimerFunc_t func, osTimerType_t type, void *argument, const osTimerAttr_t *attr)
+{
+    return NULL;
+}
+
+osStatus_t osTimerStart(osTimerId_t timer_id, uint32_t ticks)
+{
+    return osErrorResource;
+}
+
+// --- Timebase (Virtual clock) ---
+void Timebase_Init(TIM_HandleTypeDef *htim) { }
+
+uint64_t Timebase_GetMicros(void)
+{
+    return host_now_us;
+}
+
+uint64_t Timebase_Extend16(uint16_t capture)
+{
+    uint16_t age = (uint16_t)((uint16_t)host_now_us - capture);
+    return host_now_us - age;
+}
+
+uint64_t Timebase_GetAge(const volatile uint64_t *stamp_us)
+{
+    uint64_t stamp = *stamp_us;
+    return (host_now_us > stamp) ? (host_now_us - stamp) : 0U;
+}
+
+void Timebase_OverflowCallback(void) { }
+
+// --- CAN Health (Bus is always error-active on the host) ---
+void CAN_Health_Init(FDCAN_HandleTypeDef *hfdcan) { }
+void CAN_Health_Process(void) { }
+void CAN_Health_OnFrame(int bus, bool ext, uint8_t len, bool fd, bool brs) { }
+void CAN_Health_OnRxLost(int bus) { }
+
+uint32_t CAN_Health_FrameNs(int bus, bool ext, uint8_t len, bool fd, bool brs)
+{
+    // Classic frame at the Core/Src/fdcan.c nominal rates (power 125 kbps, others 500 kbps)
+    uint32_t stuffed = (ext ? 54U : 34U) + 8U * len;
+    uint32_t bits = stuffed + stuffed / 10U + 13U;
+    return bits * ((bus == CAN_BUS_POWER) ? 8000U : 2000U);
+}
+
+bool CAN_Health_GetStatus(CAN_Bus_t bus, CAN_HealthStatus_t *status)
+{
+    if (status == NULL) return false;
+    memset(status, 0, sizeof(CAN_HealthStatus_t));
+    return true;
+}
+
+bool CAN_Health_IsFaulted(void)
+{
+    return false;
+}
+
+// --- Control Pilot ---
+void CP_Init(void) { }
+void CP_SetPWM(uint8_t conn, float duty_percent) { if (conn < EVSE_CONNECTOR_MAX) host_cp_duty[conn] = duty_percent; }
+float CP_ReadVoltage(uint8_t conn) { return (conn < EVSE_CONNECTOR_MAX) ? host_cp_volts[conn] : 0.0f; }
+
+CP_State_t CP_GetStateFromVoltage(float voltage_v)
+{
+    if (voltage_v > 10.5f) return CP_STATE_A;
+    if (voltage_v > 7.5f) return CP_STATE_B;
+    if (voltage_v > 4.5f) return CP_STATE_C;
+    if (voltage_v > 1.5f) return CP_STATE_D;
+    return CP_STATE_E;
+}
+
+// --- W5500 (Connects at once so OCPP reaches IDLE; no traffic below TLS) ---
+void W5500_Init(void) { }
+bool W5500_Socket(uint8_t sn, uint8_t protocol, uint16_t port) { return true; }
+bool W5500_Connect_Start(uint8_t sn, uint8_t *addr, uint16_t port) { return true; }
+uint8_t W5500_Connect_Poll(uint8_t sn) { return SOCK_ESTABLISHED; }
+void W5500_Close(uint8_t sn) { }
+
+// --- mbedtls (Plaintext pass-through of application data) ---
+int mbedtls_net_send(void *ctx, const unsigned char *buf, size_t len) { return (int)len; }
+int mbedtls_net_recv(void *ctx, unsigned char *buf, size_t len) { return MBEDTLS_ERR_SSL_WANT_READ; }
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    memset(output, 0, len);
+    *olen = len;
+    return 0;
+}
+
+void mbedtls_ssl_init(mbedtls_ssl_context *ssl) { }
+void mbedtls_ssl_config_init(mbedtls_ssl_config *conf) { }
+void mbedtls_ctr_drbg_init(mbedtls_ctr_drbg_context *ctx) { }
+void mbedtls_entropy_init(mbedtls_entropy_context *ctx) { }
+void mbedtls_x509_crt_init(mbedtls_x509_crt *crt) { }
+
+int mbedtls_ctr_drbg_seed(mbedtls_ctr_drbg_context *ctx, int (*f_entropy)(void *, unsigned char *, size_t),
+                          void *p_entropy, const unsigned char *custom, size_t len)
+{
+    return 0;
+}
+
+int mbedtls_ctr_drbg_random(void *p_rng, unsigned char *output, size_t output_len)
+{
+    memset(output, 0, output_len);
+    return 0;
+}
+
+int mbedtls_entropy_func(void *data, unsigned char *output, size_t len)
+{
+    memset(output, 0, len);
+    return 0;
+}
+
+int mbedtls_x509_crt_parse(mbedtls_x509_crt *chain, const unsigned char *buf, size_t buflen) { return 0; }
+int mbedtls_ssl_config_defaults(mbedtls_ssl_config *conf, int endpoint, int transport, int preset) { return 0; }
+void mbedtls_ssl_conf_rng(mbedtls_ssl_config *conf, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng) { }
+void mbedtls_ssl_conf_ca_chain(mbedtls_ssl_config *conf, mbedtls_x509_crt *ca_chain, mbedtls_x509_crl *ca_crl) { }
+void mbedtls_ssl_conf_authmode(mbedtls_ssl_config *conf, int authmode) { }
+int mbedtls_ssl_setup(mbedtls_ssl_context *ssl, const mbedtls_ssl_config *conf) { return 0; }
+
+void mbedtls_ssl_set_bio(mbedtls_ssl_context *ssl, void *p_bio, mbedtls_ssl_send_t *f_send,
+                         mbedtls_ssl_recv_t *f_recv, mbedtls_ssl_recv_timeout_t *f_recv_timeout)
+{
+}
+
+int mbedtls_ssl_handshake(mbedtls_ssl_context *ssl) { return 0; }
+
+int mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t len)
+{
+    if (host_ocpp_tx_hook != NULL) host_ocpp_tx_hook(buf, len);
+    return (int)len;
+}
+
+int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+{
+    return MBEDTLS_ERR_SSL_WANT_READ;
+}
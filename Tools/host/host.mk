@@ -0,0 +1,35 @@
+# Host (Linux) build of the firmware modules, shared by the tools under Tools/.
+# Include from a tool Makefile after setting ROOT to the repository root.
+
+HOST_DIR := $(ROOT)/Tools/host
+
+# Host HAL first: shadows Drivers/ and Middlewares/ headers of the same name
+HOST_INC := -I$(HOST_DIR)/Inc \
+            -I$(ROOT)/Core/Inc \
+            -I$(ROOT)/App/Inc \
+            $(patsubst %,-I%,$(wildcard $(ROOT)/Modules/*/Inc)) \
+            -I$(ROOT)/Middlewares/Third_Party/mbedtls/include
+
+# Firmware sources that run unchanged on the host
+HOST_FW_SRC := $(ROOT)/App/Src/app_state.c \
+               $(ROOT)/Modules/CAN/Src/can_driver.c \
+               $(ROOT)/Modules/CAN/Src/can_sched.c \
+               $(ROOT)/Modules/Common/Src/config_manager.c \
+               $(ROOT)/Modules/Common/Src/crc_service.c \
+               $(ROOT)/Modules/Common/Src/recorder.c \
+               $(ROOT)/Modules/Meter/Src/meter_driver.c \
+               $(ROOT)/Modules/Modbus/Src/modbus_master.c \
+               $(ROOT)/Modules/OCPP/Src/ocpp_app.c \
+               $(ROOT)/Modules/Power/Src/infy_power.c \
+               $(ROOT)/Modules/Power/Src/power_alloc.c \
+               $(ROOT)/Modules/Power/Src/power_reg.c \
+               $(ROOT)/Modules/Relay/Src/relay_driver.c \
+               $(ROOT)/Modules/SECC/Src/secc_driver.c \
+               $(ROOT)/Modules/Safety/Src/imd_driver.c \
+               $(ROOT)/Modules/Safety/Src/safety_monitor.c \
+               $(ROOT)/Modules/Safety/Src/thermal_derate.c
+
+HOST_SRC := $(HOST_DIR)/Src/host_hal.c $(HOST_FW_SRC)
+
+HOST_CFLAGS := -std=gnu11 -O2 -g -Wall -Wno-unused-parameter -Wno-format $(HOST_INC)
+HOST_LDLIBS := -lm
@@ -0,0 +1,572 @@
+/**
+ * @file    replay.c
+ * @brief   Deterministic Host Replay of a Traffic Recording
+ *
+ * @details
+ * Reads the JSONL dump of the traffic recorder (CLI: rec_jsonl) and feeds
+ * every received record back into the unchanged firmware modules on a
+ * virtual clock:
+ *   - CAN RX     -> CAN_InjectRx() + CAN_ProcessRx() (route table, handlers)
+ *   - Modbus RX  -> pending USART3 DMA buffer + Modbus_RxEventCallback()
+ *   - OCPP RX    -> OCPP_HandleCallMessage()
+ * Between inputs the CAN TX scheduler ticks every 1 ms and the control loop
+ * body runs every 10 ms of virtual time, the way the timer task and
+ * App_ControlLoop() / App_OCPPLoop() do on the target.
+ *
+ * Everything the firmware emits (CAN TX, Modbus TX, OCPP TX, relay outputs,
+ * state changes) is printed with its virtual time and the reaction time
+ * since the last input. Emitted frames are compared with the TX records of
+ * the recording (same source and ID, in order): identical payloads count as
+ * matched, with the time offset to the original.
+ *
+ * Usage: replay [-v | -q] [-w warmup_ms] [-t tail_ms] recording.jsonl
+ */
+
+#include "host_hal.h"
+#include "can_driver.h"
+#include "can_sched.h"
+#include "recorder.h"
+#include "app_state.h"
+#include "relay_driver.h"
+#include "safety_monitor.h"
+#include "secc_driver.h"
+#include "crc_service.h"
+#include "modbus_master.h"
+#include "meter_driver.h"
+#include "infy_power.h"
+#include "power_reg.h"
+#include "power_alloc.h"
+#include "thermal_derate.h"
+#include "imd_driver.h"
+#include "ocpp_app.h"
+#include "config_manager.h"
+#include "control_pilot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define REPLAY_TICK_US          (CAN_SCHED_TICK_MS * 1000U) // CAN TX scheduler timer
+#define REPLAY_LOOP_PERIOD_US   10000U  // App_ControlLoop / App_OCPPLoop osDelay(10)
+#define REPLAY_LINE_MAX         (2 * REC_MAX_PAYLOAD + 256)
+
+typedef struct
+{
+    uint64_t t_us;
+    uint32_t id;
+    uint8_t  src;     // Rec_Source_t
+    uint8_t  tx;
+    uint8_t  ext;
+    uint8_t  fd;
+    uint8_t  brs;
+    uint8_t  matched; // TX record already paired with an output
+    uint16_t len;
+    uint8_t *data;
+    uint32_t seq;     // File order (stable sort)
+} Replay_Event_t;
+
+typedef struct
+{
+    uint32_t inputs;
+    uint32_t outputs;
+    uint32_t matched;
+    uint32_t diff;
+    uint32_t extra;
+    uint32_t missing;
+    uint32_t unrouted;
+    uint32_t modbus_unsolicited;
+    int64_t  offset_max_us;   // Largest |output time - recorded time| of matched frames
+} Replay_Stats_t;
+
+static const char *const src_names[REC_SRC_COUNT] = {"can0", "can1", "can2", "modbus", "ocpp"};
+
+static Replay_Event_t *events = NULL;
+static size_t event_count = 0;
+static Replay_Stats_t stats;
+static FILE *report = NULL;
+static bool quiet = false;               // Only differences and state / relay changes
+static uint64_t t_origin = 0;           // Printed times are relative to the first record
+static uint64_t last_input_us = 0;
+static const Replay_Event_t *last_input = NULL;
+
+// --- Recording Parser ---
+static const char *Json_Find(const char *line, const char *key)
+{
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(line, pattern);
+    return (p != NULL) ? p + strlen(pattern) : NULL;
+}
+
+static uint64_t Json_GetU64(const char *line, const char *key, uint64_t def)
+{
+    const char *p = Json_Find(line, key);
+    return (p != NULL) ? strtoull(p, NULL, 10) : def;
+}
+
+static bool Json_GetStr(const char *line, const char *key, char *out, size_t size)
+{
+    const char *p = Json_Find(line, key);
+    if (p == NULL || *p != '"') return false;
+    p++;
+
+    size_t n = 0;
+    while (*p != '\0' && *p != '"' && n + 1 < size) out[n++] = *p++;
+    out[n] = '\0';
+    return true;
+}
+
+static int Hex_Nibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool Replay_ParseLine(const char *line, Replay_Event_t *ev)
+{
+    char src[16], dir[8];
+    static char hex[REPLAY_LINE_MAX];
+
+    if (!Json_GetStr(line, "src", src, sizeof(src)) || !Json_GetStr(line, "dir", dir, sizeof(dir))) return false;
+
+    memset(ev, 0, sizeof(Replay_Event_t));
+    ev->src = REC_SRC_COUNT;
+    for (int i = 0; i < REC_SRC_COUNT; i++)
+    {
+        if (strcmp(src, src_names[i]) == 0) ev->src = (uint8_t)i;
+    }
+    if (ev->src >= REC_SRC_COUNT) return false;
+
+    ev->t_us = Json_GetU64(line, "t_us", 0);
+    ev->tx = (strcmp(dir, "tx") == 0);
+    ev->id = (uint32_t)Json_GetU64(line, "id", 0);
+    ev->ext = (uint8_t)Json_GetU64(line, "ext", 0);
+    ev->fd = (uint8_t)Json_GetU64(line, "fd", 0);
+    ev->brs = (uint8_t)Json_GetU64(line, "brs", 0);
+
+    if (!Json_GetStr(line, "data", hex, sizeof(hex))) hex[0] = '\0';
+    size_t len = strlen(hex) / 2;
+    ev->data = malloc(len + 1);
+    if (ev->data == NULL) return false;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        int hi = Hex_Nibble(hex[2 * i]);
+        int lo = Hex_Nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        ev->data[i] = (uint8_t)((hi << 4) | lo);
+    }
+    ev->data[len] = 0; // OCPP text is handed over as a string too
+    ev->len = (uint16_t)len;
+    return true;
+}
+
+static int Replay_CompareEvents(const void *a, const void *b)
+{
+    const Replay_Event_t *ea = a;
+    const Replay_Event_t *eb = b;
+    if (ea->t_us != eb->t_us) return (ea->t_us < eb->t_us) ? -1 : 1;
+    return (ea->seq < eb->seq) ? -1 : (ea->seq > eb->seq);
+}
+
+static bool Replay_Load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    static char line[REPLAY_LINE_MAX];
+    size_t capacity = 0;
+    uint32_t line_no = 0;
+
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        line_no++;
+        if (line[0] != '{') continue; // CLI echo, prompts
+
+        if (event_count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 256;
+            events = realloc(events, capacity * sizeof(Replay_Event_t));
+            if (events == NULL) return false;
+        }
+
+        Replay_Event_t *ev = &events[event_count];
+        if (!Replay_ParseLine(line, ev))
+        {
+            fprintf(stderr, "%s:%u: skipped (not a recorder record)\n", path, line_no);
+            continue;
+        }
+        ev->seq = (uint32_t)event_count;
+        event_count++;
+    }
+    fclose(f);
+
+    // CAN records carry the SOF time, the others the driver time
+    qsort(events, event_count, sizeof(Replay_Event_t), Replay_CompareEvents);
+    return true;
+}
+
+// --- Output Observation ---
+static void Replay_PrintTime(uint64_t t_us)
+{
+    int64_t rel = (int64_t)(t_us - t_origin);
+    const char *sign = (rel < 0) ? "-" : " ";
+    if (rel < 0) rel = -rel;
+    fprintf(report, "[%s%6lld.%06lld] ", sign, (long long)(rel / 1000000), (long long)(rel % 1000000));
+}
+
+static void Replay_PrintData(const uint8_t *data, uint16_t len, bool text)
+{
+    if (text)
+    {
+        for (uint16_t i = 0; i < len; i++)
+        {
+            if (data[i] == '\r') fputs("\\r", report);
+            else if (data[i] == '\n') fputs("\\n", report);
+            else if (data[i] < 0x20 || data[i] >= 0x7F) fprintf(report, "\\x%02X", data[i]);
+            else fputc(data[i], report);
+        }
+        return;
+    }
+    for (uint16_t i = 0; i < len; i++) fprintf(report, "%02X", data[i]);
+}
+
+static void Replay_PrintReaction(uint64_t now)
+{
+    if (last_input == NULL) return;
+    fprintf(report, " (react %llu us after %s %s",
+            (unsigned long long)(now - last_input_us), src_names[last_input->src],
+            last_input->src <= REC_SRC_CAN2 ? "" : "rx");
+    if (last_input->src <= REC_SRC_CAN2) fprintf(report, "0x%lX", (unsigned long)last_input->id);
+    fprintf(report, ")");
+}
+
+// Pair an emitted frame with the next unmatched TX record of the same source and ID
+static void Replay_Output(Rec_Source_t src, uint32_t id, const uint8_t *data, uint16_t len)
+{
+    uint64_t now = Host_GetMicros();
+    Replay_Event_t *expected = NULL;
+
+    for (size_t i = 0; i < event_count; i++)
+    {
+        Replay_Event_t *ev = &events[i];
+        if (ev->tx && !ev->matched && ev->src == src && ev->id == id)
+        {
+            expected = ev;
+            break;
+        }
+    }
+
+    stats.outputs++;
+    bool same = (expected != NULL) && expected->len == len && memcmp(expected->data, data, len) == 0;
+    int64_t offset = (expected != NULL) ? (int64_t)(now - expected->t_us) : 0;
+
+    if (expected == NULL) stats.extra++;
+    else if (same)
+    {
+        stats.matched++;
+        if (llabs(offset) > stats.offset_max_us) stats.offset_max_us = llabs(offset);
+    }
+    else stats.diff++;
+    if (expected != NULL) expected->matched = 1;
+
+    if (quiet && (expected == NULL || same)) return;
+
+    Replay_PrintTime(now);
+    fprintf(report, "OUT %-6s ", src_names[src]);
+    if (src <= REC_SRC_CAN2) fprintf(report, "0x%03lX [%u] ", (unsigned long)id, len);
+    Replay_PrintData(data, len, src == REC_SRC_OCPP);
+
+    if (expected == NULL) fprintf(report, "  EXTRA");
+    else if (same) fprintf(report, "  match (%+lld us)", (long long)offset);
+    else
+    {
+        fprintf(report, "  DIFF (recorded ");
+        Replay_PrintData(expected->data, expected->len, src == REC_SRC_OCPP);
+        fprintf(report, ")");
+    }
+
+    Replay_PrintReaction(now);
+    fprintf(report, "\n");
+}
+
+static void Replay_CanTap(const CAN_Message_t *msg, bool tx)
+{
+    if (tx) Replay_Output((Rec_Source_t)(REC_SRC_CAN0 + msg->bus), msg->id, msg->data, msg->len);
+}
+
+static void Replay_UartTx(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len)
+{
+    if (huart->Instance == USART3) Replay_Output(REC_SRC_MODBUS, 0, data, len);
+}
+
+static void Replay_OcppTx(const uint8_t *data, size_t len)
+{
+    Replay_Output(REC_SRC_OCPP, 0, data, (uint16_t)len);
+}
+
+// Relay outputs and state are polled after every step
+static void Replay_CheckOutputs(void)
+{
+    static int last_state = -1;
+    static int last_relay = -1;
+    uint64_t now = Host_GetMicros();
+
+    int state = (int)StateMachine_GetState(0);
+    if (state != last_state)
+    {
+        Replay_PrintTime(now);
+        fprintf(report, "OUT state  %s", StateMachine_GetStateName((EVSE_State_t)state));
+        Replay_PrintReaction(now);
+        fprintf(report, "\n");
+        last_state = state;
+    }
+
+    int relay = (int)Relay_GetState(0);
+    if (relay != last_relay)
+    {
+        Replay_PrintTime(now);
+        fprintf(report, "OUT relay  0x%02X", relay);
+        Replay_PrintReaction(now);
+        fprintf(report, "\n");
+        last_relay = relay;
+    }
+}
+
+// --- Task Bodies (Mirror App_ControlLoop / App_OCPPLoop, one iteration) ---
+static void Replay_ControlStep(void)
+{
+    static uint32_t last_ocpp_meter = 0;
+
+    PowerAlloc_Process(); // CAN task (higher priority) sweeps first
+    Infy_Process();
+    Thermal_Process();
+    PowerReg_Tick();
+
+    StateMachine_Loop();
+
+    Infy_SystemStatus_t pwr;
+    Infy_GetSystemStatus(&pwr);
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        Infy_OutletStatus_t out;
+        Infy_GetOutletStatus(c, &out);
+        SECC_TxData_t tx = {0};
+
+        tx.cp_volts = CP_ReadVoltage(c);
+        tx.relay_state = Relay_GetState(c);
+        tx.ac_volts = Meter_ReadVoltage(c);
+        tx.ac_amps = Meter_ReadCurrent(c);
+        tx.temp_c = Thermal_GetTemperature(c);
+        tx.dc_volts = out.voltage;
+        tx.dc_amps = out.current;
+        tx.active_modules = (uint8_t)out.alive_modules;
+        tx.power_fault = (pwr.fault_mask & out.modules) != 0;
+        SECC_SetTxData(c, &tx);
+    }
+
+    if ((HAL_GetTick() - last_ocpp_meter) >= 5000)
+    {
+        for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+        {
+            OCPP_SendMeterValues(EVSE_CONNECTOR_ID(c), Meter_ReadEnergy(c), Meter_ReadPower(c), (int)Thermal_GetTemperature(c));
+        }
+        last_ocpp_meter = HAL_GetTick();
+    }
+
+    Modbus_SetRate(StateMachine_IsSessionActive() ? MODBUS_RATE_ACTIVE : MODBUS_RATE_IDLE);
+    Modbus_Process();
+    Meter_Process();
+    OCPP_Process();
+    CAN_ProcessRx(); // CAN task wakes at least every CAN_HEALTH_PERIOD_MS
+}
+
+// --- Inputs ---
+static void Replay_Input(const Replay_Event_t *ev)
+{
+    stats.inputs++;
+    last_input = ev;
+    last_input_us = ev->t_us;
+
+    if (ev->src <= REC_SRC_CAN2)
+    {
+        CAN_Message_t msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.timestamp_us = ev->t_us;
+        msg.id = ev->id;
+        msg.bus = (uint8_t)(ev->src - REC_SRC_CAN0);
+        msg.id_type = ev->ext ? CAN_ID_EXT : CAN_ID_STD;
+        msg.fd = ev->fd;
+        msg.brs = ev->brs;
+        msg.len = (uint8_t)((ev->len > CAN_FD_MAX_LEN) ? CAN_FD_MAX_LEN : ev->len);
+        memcpy(msg.data, ev->data, msg.len);
+
+        // The CAN task runs at the highest priority: dispatch right away
+        if (!CAN_InjectRx(&msg)) stats.unrouted++;
+        CAN_ProcessRx();
+    }
+    else if (ev->src == REC_SRC_MODBUS)
+    {
+        uint16_t expected = 0;
+        uint8_t *buf = Host_GetUartRxBuffer(&huart3, &expected);
+        if (buf == NULL)
+        {
+            stats.modbus_unsolicited++; // No request pending in the replayed meter
+            return;
+        }
+
+        uint16_t n = (ev->len < expected) ? ev->len : expected;
+        memcpy(buf, ev->data, n);
+        Host_ClearUartRx(&huart3);
+        Modbus_RxEventCallback(&huart3, n);
+    }
+    else if (ev->src == REC_SRC_OCPP)
+    {
+        // OCPP_Process() only passes JSON arrays to the call handler
+        if (ev->len > 0 && ev->data[0] == '[')
+        {
+            OCPP_HandleCallMessage((const char *)ev->data, ev->len);
+        }
+    }
+}
+
+static void Replay_Init(void)
+{
+    Host_Init();
+    Crc_Init();
+
+    CAN_Driver_Init(&hfdcan1);
+    CAN_Driver_Init(&hfdcan2);
+    CAN_Driver_Init(&hfdcan3);
+    CAN_AddTap(Replay_CanTap);
+    host_uart_tx_hook = Replay_UartTx;
+    host_ocpp_tx_hook = Replay_OcppTx;
+
+    // Same order as App_Init()
+    CP_Init();
+    Relay_Init();
+    Safety_Init();
+    SECC_Init(&hfdcan1);
+    Modbus_Init(&huart3);
+    Meter_Init();
+    Config_Init();
+    Infy_Init(&hfdcan2);
+    PowerReg_Init();
+    Thermal_Init();
+    PowerAlloc_Init();
+    IMD_Init(&hfdcan3);
+    OCPP_Init();
+    StateMachine_Init();
+}
+
+static void Usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-v | -q] [-w warmup_ms] [-t tail_ms] recording.jsonl\n", prog);
+    fprintf(stderr, "  -v  Show firmware log output and every input\n");
+    fprintf(stderr, "  -q  Show only differences and state / relay changes\n");
+    fprintf(stderr, "  -w  Run the firmware this long before the first record (default 0)\n");
+    fprintf(stderr, "  -t  Keep running this long after the last record (default 1000)\n");
+}
+
+int main(int argc, char **argv)
+{
+    bool verbose = false;
+    uint64_t warmup_us = 0;
+    uint64_t tail_us = 1000U * TIMEBASE_US_PER_MS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "vqw:t:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'v': verbose = true; break;
+            case 'q': quiet = true; break;
+            case 'w': warmup_us = strtoull(optarg, NULL, 10) * TIMEBASE_US_PER_MS; break;
+            case 't': tail_us = strtoull(optarg, NULL, 10) * TIMEBASE_US_PER_MS; break;
+            default: Usage(argv[0]); return 2;
+        }
+    }
+    if (optind >= argc)
+    {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    // Report on the real stdout; firmware printf goes to /dev/null unless -v
+    report = fdopen(dup(fileno(stdout)), "w");
+    if (report == NULL) return 1;
+    if (!verbose && freopen("/dev/null", "w", stdout) == NULL) return 1;
+
+    if (!Replay_Load(argv[optind])) return 1;
+    if (event_count == 0)
+    {
+        fprintf(stderr, "No records in %s\n", argv[optind]);
+        return 1;
+    }
+
+    t_origin = events[0].t_us;
+    uint64_t start = (t_origin > warmup_us) ? t_origin - warmup_us : 0;
+    uint64_t end = events[event_count - 1].t_us + tail_us;
+
+    Replay_Init();
+    Host_SetMicros(start);
+
+    // Event loop on the virtual clock: periodic task steps interleaved with inputs
+    uint64_t next_step = start;
+    uint32_t step = 0;
+    size_t next_event = 0;
+
+    while (next_event < event_count || next_step <= end)
+    {
+        bool event_first = (next_event < event_count) && (events[next_event].t_us < next_step);
+
+        if (event_first)
+        {
+            const Replay_Event_t *ev = &events[next_event++];
+            if (ev->tx) continue; // Expected output, compared in Replay_Output()
+
+            Host_SetMicros(ev->t_us);
+            if (verbose)
+            {
+                Replay_PrintTime(ev->t_us);
+                fprintf(report, "IN  %-6s ", src_names[ev->src]);
+                if (ev->src <= REC_SRC_CAN2) fprintf(report, "0x%03lX [%u] ", (unsigned long)ev->id, ev->len);
+                Replay_PrintData(ev->data, ev->len, ev->src == REC_SRC_OCPP);
+                fprintf(report, "\n");
+            }
+            Replay_Input(ev);
+        }
+        else
+        {
+            if (next_step > end) break;
+            Host_SetMicros(next_step);
+
+            // Timer task outranks the control task at the same tick
+            CAN_Sched_Tick();
+            if ((step++ % (REPLAY_LOOP_PERIOD_US / REPLAY_TICK_US)) == 0) Replay_ControlStep();
+            next_step += REPLAY_TICK_US;
+        }
+        Replay_CheckOutputs();
+    }
+
+    for (size_t i = 0; i < event_count; i++)
+    {
+        if (events[i].tx && !events[i].matched) stats.missing++;
+    }
+
+    fprintf(report, "\n--- Replay Summary ---\n");
+    fprintf(report, "Records: %zu, Inputs: %u, Outputs: %u\n", event_count, stats.inputs, stats.outputs);
+    fprintf(report, "Matched: %u (max offset %lld us), Diff: %u, Extra: %u, Missing: %u\n",
+            stats.matched, (long long)stats.offset_max_us, stats.diff, stats.extra, stats.missing);
+    if (stats.unrouted > 0) fprintf(report, "CAN RX without route: %u\n", stats.unrouted);
+    if (stats.modbus_unsolicited > 0) fprintf(report, "Modbus RX without pending request: %u\n", stats.modbus_unsolicited);
+    fflush(report);
+
+    return (stats.diff == 0) ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file    plant.c
+ * @brief   Power Stage / EV Battery Plant Model Implementation
+ *
+ * @details
+ * Per substep the module lags are advanced first (explicit, they are tens
+ * of milliseconds). Each module is then either limited (0 A below the link
+ * voltage, i_lim when (v_int - v) / r_out would exceed it, judged on the
+ * previous link voltage) or a Norton source v_int / r_out || r_out, and the
+ * link voltage is solved implicitly from
+ *     C dv/dt = I_limited + sum((v_int - v) / r_out) - v / R_bleed
+ *               - (v - OCV) / (R_int + R_cable)
+ * (the last term only with the contactor closed). That stays stable for
+ * 2 mF behind 50 mOhm (0.1 ms) at a 50 us substep. The pack current may go
+ * negative: closing onto a link below the pack voltage discharges the pack
+ * into it, which is the inrush the pre-charge is there to avoid.
+ */
+
+#include "plant.h"
+#include <string.h>
+
+// Cell OCV (NMC) at 0, 10, ... 100 % SoC
+static const float plant_cell_ocv[PLANT_OCV_POINTS] = {
+    3.30f, 3.55f, 3.62f, 3.68f, 3.74f, 3.80f, 3.87f, 3.95f, 4.03f, 4.10f, 4.18f,
+};
+
+void Plant_Init(Plant_t *p, int modules, int cells, double soc)
+{
+    memset(p, 0, sizeof(*p));
+
+    if (modules < 1) modules = 1;
+    if (modules > PLANT_MAX_MODULES) modules = PLANT_MAX_MODULES;
+    p->module_count = modules;
+    for (int m = 0; m < modules; m++)
+    {
+        Plant_Module_t *mod = &p->module[m];
+        mod->rated_kw = 40.0f;
+        mod->max_current = 100.0f;
+        mod->gain = 1.0f;
+        mod->r_out = 0.050f;
+        mod->tau_v = 0.050f;
+        mod->tau_i = 0.020f;
+    }
+
+    p->c_link = 2e-3f;
+    p->r_bleed = 100e3f;
+    p->r_cable = 0.020f;
+
+    Plant_Battery_t *b = &p->bat;
+    b->capacity_ah = 200.0f;
+    b->r_int = 0.080f;
+    for (int k = 0; k < PLANT_OCV_POINTS; k++) b->ocv[k] = plant_cell_ocv[k] * cells;
+    b->soc = soc;
+    b->v_max = 4.15f * cells;
+    b->i_max = 400.0f;
+    b->taper_soc = 0.50f;
+    b->taper_min = 0.10f;
+    b->soc_stop = 0.80f;
+    b->v_term = Plant_BatteryOcv(b);
+
+    p->meter.gain = 1.0f;
+    Plant_SetAmbient(p, PLANT_AMBIENT_C);
+}
+
+void Plant_SetAmbient(Plant_t *p, float ambient_c)
+{
+    p->ambient_c = ambient_c;
+    p->t_pin[0] = ambient_c;
+    p->t_pin[1] = ambient_c;
+    p->t_cable = ambient_c;
+    for (int m = 0; m < p->module_count; m++) p->module[m].t_dcdc = ambient_c;
+}
+
+float Plant_BatteryOcv(const Plant_Battery_t *b)
+{
+    float x = b->soc * (PLANT_OCV_POINTS - 1);
+    if (x <= 0.0f) return b->ocv[0];
+    if (x >= PLANT_OCV_POINTS - 1) return b->ocv[PLANT_OCV_POINTS - 1];
+
+    int k = (int)x;
+    float f = x - k;
+    return b->ocv[k] + f * (b->ocv[k + 1] - b->ocv[k]);
+}
+
+float Plant_BatteryRequest(const Plant_Battery_t *b)
+{
+    if (b->soc >= b->soc_stop) return 0.0f;
+    if (b->soc <= b->taper_soc) return b->i_max;
+
+    float f = 1.0f - (1.0f - b->taper_min) * (b->soc - b->taper_soc) / (1.0f - b->taper_soc);
+    return b->i_max * f;
+}
+
+float Plant_TotalCurrent(const Plant_t *p)
+{
+    float sum = 0.0f;
+    for (int m = 0; m < p->module_count; m++) sum += p->module[m].i_out;
+    return sum;
+}
+
+static float Plant_Lag(float x, float target, float dt, float tau)
+{
+    float k = (tau > dt) ? dt / tau : 1.0f;
+    return x + (target - x) * k;
+}
+
+static void Plant_Substep(Plant_t *p, float dt)
+{
+    Plant_Battery_t *b = &p->bat;
+    float ocv = Plant_BatteryOcv(b);
+    float r = b->r_int + p->r_cable;
+    float g = p->c_link / dt + 1.0f / p->r_bleed;
+    float rhs = p->c_link / dt * p->v_link;
+
+    // Modules: lags, then off, limited (fixed current) or linear (into the solve)
+    enum { MOD_OFF, MOD_LIMITED, MOD_LINEAR };
+    uint8_t mode[PLANT_MAX_MODULES];
+    for (int m = 0; m < p->module_count; m++)
+    {
+        Plant_Module_t *mod = &p->module[m];
+        bool run = mod->enable && !(mod->fault & (PLANT_FAULT_OV | PLANT_FAULT_DEAD | PLANT_FAULT_SILENT));
+
+        // Range: switched only while off, caps the voltage, current and power
+        if (!mod->enable) mod->range_high = mod->range_cmd;
+        float v_max = mod->range_high ? PLANT_RANGE_HIGH_V_MAX : PLANT_RANGE_LOW_V_MAX;
+        float i_max = mod->max_current * (mod->range_high ? PLANT_RANGE_HIGH_CURRENT : 1.0f);
+        if (p->v_link > 1.0f && mod->rated_kw * 1000.0f / p->v_link < i_max) i_max = mod->rated_kw * 1000.0f / p->v_link;
+        float v_cmd = (mod->v_set < v_max) ? mod->v_set : v_max;
+        float i_cmd = (mod->i_set < i_max) ? mod->i_set : i_max;
+
+        mod->v_int = Plant_Lag(mod->v_int, run ? v_cmd : 0.0f, dt, mod->tau_v);
+        mod->i_lim = Plant_Lag(mod->i_lim, run ? i_cmd * mod->gain : 0.0f, dt, mod->tau_i);
+        if (mod->i_lim < 0.0f) mod->i_lim = 0.0f;
+
+        float i_lin = (mod->v_int - p->v_link) / mod->r_out;
+        if (!run || i_lin <= 0.0f) mode[m] = MOD_OFF; // Reverse blocked
+        else if (i_lin >= mod->i_lim)
+        {
+            mode[m] = MOD_LIMITED;
+            rhs += mod->i_lim;
+        }
+        else
+        {
+            mode[m] = MOD_LINEAR;
+            g += 1.0f / mod->r_out;
+            rhs += mod->v_int / mod->r_out;
+        }
+    }
+
+    // Link (implicit), pack through cable and contactor
+    if (p->contactor)
+    {
+        g += 1.0f / r;
+        rhs += ocv / r;
+    }
+    p->v_link = rhs / g;
+
+    float sum_i = 0.0f;
+    for (int m = 0; m < p->module_count; m++)
+    {
+        Plant_Module_t *mod = &p->module[m];
+        if (mode[m] == MOD_OFF) mod->i_out = 0.0f;
+        else if (mode[m] == MOD_LIMITED) mod->i_out = mod->i_lim;
+        else mod->i_out = (mod->v_int - p->v_link) / mod->r_out;
+        sum_i += mod->i_out;
+    }
+
+    b->i = p->contactor ? (p->v_link - ocv) / r : 0.0f;
+    b->v_term = ocv + b->i * b->r_int;
+    b->soc += b->i * dt / (3600.0f * b->capacity_ah);
+
+    // Inrush window after a close
+    if (p->contactor && !p->contactor_was)
+    {
+        p->closed_us = 0;
+        p->i_peak_inrush = 0.0f;
+    }
+    p->contactor_was = p->contactor;
+    if (p->contactor && p->closed_us < PLANT_INRUSH_US)
+    {
+        float mag = (b->i < 0.0f) ? -b->i : b->i;
+        if (mag > p->i_peak_inrush) p->i_peak_inrush = mag;
+        p->closed_us += PLANT_SUBSTEP_US;
+    }
+
+    // Meter (charger output, EV side of the contactor)
+    Plant_Meter_t *mt = &p->meter;
+    mt->v = p->contactor ? p->v_link * mt->gain : 0.0f;
+    mt->i = b->i * mt->gain;
+    mt->energy_kwh += (double)mt->v * mt->i * dt / 3.6e6;
+
+    p->energy_out_kwh += (double)p->v_link * sum_i * dt / 3.6e6;
+    p->energy_bat_kwh += (double)ocv * b->i * dt / 3.6e6;
+}
+
+static void Plant_Thermal(Plant_t *p, float dt)
+{
+    float gun = p->bat.i / PLANT_GUN_RATED_A;
+    float rise_pin = PLANT_PIN_RISE_C * gun * gun;
+    p->t_pin[0] = Plant_Lag(p->t_pin[0], p->ambient_c + rise_pin, dt, PLANT_PIN_TAU_S);
+    p->t_pin[1] = Plant_Lag(p->t_pin[1], p->ambient_c + rise_pin * PLANT_PIN_MINUS_PCT / 100.0f, dt, PLANT_PIN_TAU_S);
+    p->t_cable = Plant_Lag(p->t_cable, p->ambient_c + PLANT_CABLE_RISE_C * gun * gun, dt, PLANT_CABLE_TAU_S);
+
+    for (int m = 0; m < p->module_count; m++)
+    {
+        Plant_Module_t *mod = &p->module[m];
+        float load = (mod->max_current > 0.0f) ? mod->i_out / mod->max_current : 0.0f;
+        mod->t_dcdc = Plant_Lag(mod->t_dcdc, p->ambient_c + PLANT_MODULE_RISE_C * load * load, dt, PLANT_MODULE_TAU_S);
+    }
+}
+
+void Plant_Step(Plant_t *p, uint32_t dt_us)
+{
+    uint32_t n = (dt_us + PLANT_SUBSTEP_US / 2) / PLANT_SUBSTEP_US;
+    for (uint32_t k = 0; k < n; k++)
+    {
+        Plant_Substep(p, PLANT_SUBSTEP_US * 1e-6f);
+        p->t_us += PLANT_SUBSTEP_US;
+    }
+    Plant_Thermal(p, n * PLANT_SUBSTEP_US * 1e-6f);
+}
@@ -0,0 +1,180 @@
+/**
+ * @file    plant.h
+ * @brief   Power Stage / EV Battery Plant Model (Host Simulation)
+ *
+ * @note    Plain C, no firmware headers: the harness (sim.c) translates
+ *          between the plant and the firmware's CAN frames and Modbus
+ *          registers. All times are virtual, Plant_Step() integrates with a
+ *          fixed substep (PLANT_SUBSTEP_US), so results do not depend on how
+ *          fast the host runs.
+ *
+ * @note    Model:
+ *          - Rectifier module: CV/CC source. An internal voltage follows
+ *            the setpoint and the current limit (control share + trim,
+ *            capped at the rating) follows its command, both with a
+ *            first-order lag; the output is (internal - link voltage) /
+ *            r_out, clamped to 0..limit (no reverse current). Gain error
+ *            and faults (over-voltage trip, dead output, silent) are
+ *            injectable. Output range: LOW up to PLANT_RANGE_LOW_V_MAX at
+ *            the full current, HIGH up to PLANT_RANGE_HIGH_V_MAX at
+ *            PLANT_RANGE_HIGH_CURRENT of it, both within the rated power;
+ *            the range follows its command only while the output is off.
+ *          - DC link: one capacitance with a bleeder, fed by all modules.
+ *          - Cable + main contactor to the EV: series resistance. The link
+ *            is solved implicitly with the modules that are not limited
+ *            (the RC time constants are below the substep).
+ *          - EV battery: OCV(SoC) table, internal resistance, capacity. Its
+ *            BMS requests the lower of the pack limit and an SoC taper and
+ *            nothing from soc_stop on.
+ *          - Meter at the output terminals (EV side of the contactor):
+ *            voltage, current and energy with a gain error; it reads 0 V
+ *            while the contactor is open.
+ *          - Temperatures: gun pins, cable and each module's DC-DC hot spot
+ *            follow ambient + RISE * (I / I_rated)^2 with a first-order lag
+ *            (per Plant_Step, they are minutes). Deliberately not the
+ *            firmware's derating parameters (thermal_derate.h).
+ */
+
+#ifndef TOOLS_SIM_PLANT_H_
+#define TOOLS_SIM_PLANT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PLANT_MAX_MODULES   64
+#define PLANT_SUBSTEP_US    50
+#define PLANT_OCV_POINTS    11      // OCV table at 0, 10, ... 100 % SoC
+#define PLANT_INRUSH_US     20000   // Window after a contactor close for i_peak_inrush
+#define PLANT_CELLS_400V    96      // Pack sizes (series cells)
+#define PLANT_CELLS_800V    192
+
+// Module Output Ranges (as the firmware assumes them, infy_power.h)
+#define PLANT_RANGE_LOW_V_MAX     500.0f
+#define PLANT_RANGE_HIGH_V_MAX    1000.0f
+#define PLANT_RANGE_HIGH_CURRENT  0.5f  // Fraction of max_current in HIGH
+
+// Thermal Model
+#define PLANT_AMBIENT_C       25.0f
+#define PLANT_GUN_RATED_A     400.0f
+#define PLANT_PIN_RISE_C      42.0f   // DC+ at the rated current (DC- PLANT_PIN_MINUS_PCT of it)
+#define PLANT_PIN_MINUS_PCT   90
+#define PLANT_PIN_TAU_S       500.0f
+#define PLANT_CABLE_RISE_C    28.0f
+#define PLANT_CABLE_TAU_S     900.0f
+#define PLANT_MODULE_RISE_C   45.0f   // DC-DC hot spot at full load (PFC 80 % of the rise)
+#define PLANT_MODULE_TAU_S    200.0f
+
+// Module Faults (Plant_Module_t fault)
+#define PLANT_FAULT_OV      0x01U   // Trips: output off, OV flag in its status
+#define PLANT_FAULT_DEAD    0x02U   // Output stuck at 0 A, status still sent
+#define PLANT_FAULT_SILENT  0x04U   // Output off and no status frames
+
+typedef struct
+{
+    // Parameters
+    float rated_kw;
+    float max_current;        // A
+    float gain;               // Delivered / commanded current (calibration)
+    float r_out;              // Ohm (CV droop)
+    float tau_v;              // Voltage setpoint lag (s)
+    float tau_i;              // Current limit lag (s)
+    // Commands (from the control / stage / trim frames)
+    bool  enable;
+    float v_set;              // V
+    float i_set;              // A (share + trim)
+    bool  range_cmd;          // HIGH range requested (range frame)
+    // State
+    float v_int;              // V
+    float i_lim;              // A
+    float i_out;              // A
+    bool  range_high;         // Range in use
+    float t_dcdc;             // DC-DC hot spot (degC)
+    uint8_t fault;
+} Plant_Module_t;
+
+typedef struct
+{
+    // Pack
+    float capacity_ah;
+    float r_int;              // Ohm
+    float ocv[PLANT_OCV_POINTS]; // V
+    double soc;               // 0..1 (double: a 50 us step adds ~1e-8)
+    // BMS
+    float v_max;              // Charge voltage limit (CV)
+    float i_max;              // Pack current limit (A)
+    float taper_soc;          // SoC where the current taper starts
+    float taper_min;          // Fraction of i_max left at 100 % SoC
+    float soc_stop;           // Charging complete
+    // Terminal state
+    float i;                  // A, into the pack
+    float v_term;             // V
+} Plant_Battery_t;
+
+typedef struct
+{
+    float gain;               // Reading / true value
+    float v;                  // Readings (V / A)
+    float i;
+    double energy_kwh;
+} Plant_Meter_t;
+
+typedef struct
+{
+    int   module_count;
+    Plant_Module_t module[PLANT_MAX_MODULES];
+    float c_link;             // F
+    float r_bleed;            // Ohm
+    float r_cable;            // Ohm (cable + contactor)
+    bool  contactor;          // Main relay closed
+    float v_link;             // V
+    Plant_Battery_t bat;
+    Plant_Meter_t meter;
+    // Temperatures (degC)
+    float ambient_c;
+    float t_pin[2];           // DC+ / DC-
+    float t_cable;
+    uint64_t t_us;
+    // Statistics
+    bool  contactor_was;      // Contactor state of the previous substep
+    uint32_t closed_us;       // Time since the last close (inrush window)
+    float i_peak_inrush;      // Largest |pack current| within PLANT_INRUSH_US of a close
+    double energy_out_kwh;    // Delivered by the modules
+    double energy_bat_kwh;    // Stored in the pack (after losses)
+} Plant_t;
+
+/**
+ * @brief Default cabinet and EV
+ * @param modules Rectifier modules (40 kW / 100 A each, LOW range)
+ * @param cells   Series cells of the pack (PLANT_CELLS_400V / _800V)
+ * @param soc     Initial state of charge (0..1)
+ * @note  NMC pack of 200 Ah (96s: ~75 kWh, 398 V / 400 A limits; 192s:
+ *        ~150 kWh, 797 V), 2 mF link, 20 mOhm cable.
+ */
+void Plant_Init(Plant_t *p, int modules, int cells, double soc);
+
+/**
+ * @brief Set the ambient temperature, every part starts at it
+ */
+void Plant_SetAmbient(Plant_t *p, float ambient_c);
+
+/**
+ * @brief Advance by dt_us (rounded to the substep)
+ */
+void Plant_Step(Plant_t *p, uint32_t dt_us);
+
+/**
+ * @brief Open-circuit voltage at the current SoC
+ */
+float Plant_BatteryOcv(const Plant_Battery_t *b);
+
+/**
+ * @brief Current the BMS asks for (limit and SoC taper, 0 once complete)
+ */
+float Plant_BatteryRequest(const Plant_Battery_t *b);
+
+/**
+ * @brief Total module output current
+ */
+float Plant_TotalCurrent(const Plant_t *p);
+
+#endif /* TOOLS_SIM_PLANT_H_ */
@@ -0,0 +1,925 @@
+/**
+ * @file    sim.c
+ * @brief   Closed-Loop Host Simulation of a Charging Session
+ *
+ * @details
+ * Runs the unchanged firmware modules against the plant model (plant.c) on
+ * a virtual clock, as the replay tool does against a recording:
+ *   - Power bus: the control, stage, range and trim frames the firmware
+ *     sends (CAN tap) set the plant modules; every module answers with a
+ *     status frame every 100 ms (staggered), an info frame every 5 s and
+ *     the extended status queries on the next tick.
+ *   - SECC bus: an EV model sends the SECC command (100 ms), DC demand
+ *     (50 ms) and DC limits (100 ms) frames, the SECC board the gun pin
+ *     and cable temperatures (1 s).
+ *   - Modbus: the meter answers the firmware's register reads (any block
+ *     of its holding registers) 15 ms later with the plant's output
+ *     voltage, current and energy.
+ * The CAN TX scheduler ticks every 1 ms and the control loop body every
+ * 10 ms; the plant integrates 1 ms per tick after the firmware has run.
+ *
+ * Session: the EV plugs in (state CONNECTED; there is no CP path into it
+ * in the firmware), a RemoteStartTransaction starts the pre-charge with the
+ * EV asking for its pack voltage at 2 A, and once the main relay is closed
+ * the EV asks for its charge voltage limit and the BMS current (limit and
+ * SoC taper). It clears allow_power when its BMS is done. The EV trips the
+ * session (allow_power off) if its current stays above the limit frame by
+ * more than SIM_TRIP_PCT for SIM_TRIP_HOLD_US, or on a terminal voltage
+ * above its limit.
+ *
+ * The EV has a 400 V pack, or an 800 V one with -x (the firmware should pick
+ * the modules' LOW or HIGH output range at the pre-charge). The ambient
+ * temperature (-a) sets where the gun and the modules heat up from: on a
+ * hot day the firmware should derate the current and finish the session.
+ *
+ * The session runs on connector 1. A multi-connector build
+ * (EVSE_CONNECTOR_COUNT) connects the plant's link to the groups the
+ * allocation matrix has switched onto connector 1; the others stay idle, so
+ * connector 1 should end up with the whole pool.
+ *
+ * Module faults can be injected at a virtual time (-F). The report lists
+ * state / relay / staging / EV events and a summary; the exit code is 0 if
+ * the EV completed the session without a trip or a FAULT state.
+ *
+ * Usage: sim [-v] [-x] [-a degC] [-n modules] [-s soc] [-e soc] [-F m:kind@s]... [-p s] [-c file] [-T s]
+ */
+
+#include "host_hal.h"
+#include "can_driver.h"
+#include "can_sched.h"
+#include "can_db_power.h"
+#include "can_db_secc.h"
+#include "app_state.h"
+#include "relay_driver.h"
+#include "safety_monitor.h"
+#include "secc_driver.h"
+#include "crc_service.h"
+#include "modbus_master.h"
+#include "meter_driver.h"
+#include "infy_power.h"
+#include "power_reg.h"
+#include "power_alloc.h"
+#include "thermal_derate.h"
+#include "imd_driver.h"
+#include "ocpp_app.h"
+#include "config_manager.h"
+#include "control_pilot.h"
+#include "plant.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+
+#define SIM_TICK_US             (CAN_SCHED_TICK_MS * 1000U) // CAN TX scheduler timer
+#define SIM_LOOP_PERIOD_US      10000U  // App_ControlLoop / App_OCPPLoop osDelay(10)
+#define SIM_STATUS_PERIOD_MS    100     // Module status frame
+#define SIM_INFO_EVERY          50      // Info frame with every n-th status frame
+#define SIM_COMMAND_PERIOD_MS   100     // SECC command / limits frames
+#define SIM_DEMAND_PERIOD_MS    50      // SECC DC demand frame
+#define SIM_TEMPS_PERIOD_MS     1000    // SECC gun temperatures frame
+#define SIM_METER_REPLY_US      15000U  // Modbus response time
+#define SIM_METER_MAX_REGS      125     // Modbus read holding registers limit
+#define SIM_PLUG_US             (1 * TIMEBASE_US_PER_SEC)
+#define SIM_START_US            (3 * TIMEBASE_US_PER_SEC)
+#define SIM_TAIL_US             (5 * TIMEBASE_US_PER_SEC) // Keep running after the end
+#define SIM_PRECHARGE_A         2.0f    // EV current request during the pre-charge
+#define SIM_EV_MAX_V_MARGIN     8.0f    // EV voltage limit above its charge voltage
+#define SIM_TRIP_PCT            10      // EV trips above its current limit + this %
+#define SIM_TRIP_HOLD_US        100000U
+#define SIM_MAX_FAULTS          16
+
+typedef enum
+{
+    SIM_EV_UNPLUGGED = 0,
+    SIM_EV_PLUGGED,
+    SIM_EV_PRECHARGE,
+    SIM_EV_CHARGING,
+    SIM_EV_DONE,
+    SIM_EV_STOPPED,   // The charger opened the relay
+    SIM_EV_TRIPPED,
+} Sim_EvPhase_t;
+
+static const char *const ev_phase_names[] = {
+    "UNPLUGGED", "PLUGGED", "PRECHARGE", "CHARGING", "DONE", "STOPPED", "TRIPPED",
+};
+
+typedef struct
+{
+    uint64_t t_us;
+    int      module;
+    char     kind[8];
+    bool     applied;
+} Sim_Fault_t;
+
+typedef struct
+{
+    // Power bus commands as last sent by the firmware (per group: an outlet's
+    // control frame addresses its groups, group_mask 0 all of them)
+    float    v_set[INFY_GROUP_COUNT];
+    float    share[INFY_GROUP_COUNT];
+    bool     enable[INFY_GROUP_COUNT];
+    uint8_t  stage_mask;
+    uint8_t  range_mask;        // Groups commanded to the HIGH range
+    float    trim[PLANT_MAX_MODULES];
+    uint32_t status_count[PLANT_MAX_MODULES];
+    uint8_t  query_pending[PLANT_MAX_MODULES]; // Bit k = Infy_Query item k + 1
+    // EV
+    Sim_EvPhase_t phase;
+    bool     allow_power;
+    float    demand_v;
+    float    demand_i;
+    float    demand_i_prev;     // Previous demand frame (firmware reaction time)
+    uint64_t phase_us;
+    uint64_t trip_us;           // Over-current since (0 = no)
+    // Modbus
+    bool     meter_pending;
+    uint16_t meter_reg;
+    uint16_t meter_regs;
+    uint64_t meter_due_us;
+} Sim_State_t;
+
+typedef struct
+{
+    uint64_t precharge_start_us;
+    uint64_t precharge_end_us;
+    uint64_t close_us;
+    uint64_t reach_us;          // Pack current reached 95 % of the request
+    float    i_peak_inrush;
+    float    i_excess_max;      // Pack current above the EV request
+    float    v_excess_max;      // Output voltage above the EV target
+    float    v_term_max;
+    bool     fault_seen;
+    uint32_t meter_replies;
+    float    t_pin_max;         // Hottest gun pin
+    float    t_cable_max;
+    float    t_module_max;      // Hottest module hot spot
+    float    limit_min;         // Lowest thermal current limit while charging
+} Sim_Stats_t;
+
+static Plant_t plant;
+static Sim_State_t sim;
+static Sim_Stats_t stats;
+static Sim_Fault_t faults[SIM_MAX_FAULTS];
+static int fault_count = 0;
+static FILE *report = NULL;
+static FILE *csv = NULL;
+
+// --- Report ---
+static void Sim_PrintTime(void)
+{
+    uint64_t t = Host_GetMicros();
+    fprintf(report, "[%9.3f] ", t / 1e6);
+}
+
+static void Sim_SetPhase(Sim_EvPhase_t phase)
+{
+    if (sim.phase == phase) return;
+    sim.phase = phase;
+    sim.phase_us = Host_GetMicros();
+    Sim_PrintTime();
+    fprintf(report, "EV     %-9s SoC %.1f %%, pack %.1f V\n", ev_phase_names[phase], plant.bat.soc * 100.0f,
+            plant.bat.v_term);
+}
+
+// --- Power Bus (firmware -> modules) ---
+static void Sim_ApplyModules(void)
+{
+    // The plant's link is connector 1's output bus: a group switched onto
+    // another connector by the matrix does not feed it
+    uint8_t bus = Relay_GetMatrix(0);
+
+    for (int m = 0; m < plant.module_count; m++)
+    {
+        Plant_Module_t *mod = &plant.module[m];
+        int g = m / INFY_GROUP_SIZE;
+        float i = sim.share[g] + sim.trim[m];
+        mod->enable = sim.enable[g] && (sim.stage_mask & (1U << g)) && (bus & (1U << g));
+        mod->range_cmd = (sim.range_mask & (1U << g)) != 0;
+        mod->v_set = sim.v_set[g];
+        mod->i_set = (i > 0.0f) ? i : 0.0f;
+    }
+}
+
+static void Sim_CanTap(const CAN_Message_t *msg, bool tx)
+{
+    if (!tx || msg->bus != CAN_BUS_POWER) return;
+
+    if (msg->id == INFY_CONTROL_ID)
+    {
+        Infy_Control_t ctl;
+        Infy_Control_Unpack(msg->data, &ctl);
+        for (int g = 0; g < INFY_GROUP_COUNT; g++)
+        {
+            if (ctl.group_mask != 0 && !(ctl.group_mask & (1U << g))) continue;
+            sim.v_set[g] = ctl.voltage * 0.1f;
+            sim.share[g] = ctl.current * 0.1f;
+            sim.enable[g] = ctl.enable != 0;
+            if (sim.enable[g]) continue;
+            for (int m = g * INFY_GROUP_SIZE; m < (g + 1) * INFY_GROUP_SIZE && m < PLANT_MAX_MODULES; m++)
+            {
+                sim.trim[m] = 0.0f; // Trims end with the output
+            }
+        }
+    }
+    else if (msg->id == INFY_STAGE_ID)
+    {
+        Infy_Stage_t stage;
+        Infy_Stage_Unpack(msg->data, &stage);
+        if (stage.group_mask != sim.stage_mask)
+        {
+            Sim_PrintTime();
+            fprintf(report, "STAGE  0x%02X -> 0x%02X\n", sim.stage_mask, stage.group_mask);
+        }
+        sim.stage_mask = stage.group_mask;
+    }
+    else if (msg->id == INFY_RANGE_ID)
+    {
+        Infy_Range_t range;
+        Infy_Range_Unpack(msg->data, &range);
+        if (range.high_mask != sim.range_mask)
+        {
+            Sim_PrintTime();
+            fprintf(report, "RANGE  HIGH 0x%02X -> 0x%02X\n", sim.range_mask, range.high_mask);
+        }
+        sim.range_mask = range.high_mask;
+    }
+    else if (msg->id >= INFY_QUERY_ID && msg->id < INFY_QUERY_ID + PLANT_MAX_MODULES)
+    {
+        Infy_Query_t query;
+        Infy_Query_Unpack(msg->data, &query);
+        if (query.item >= 1 && query.item <= INFY_POLL_ITEMS)
+        {
+            sim.query_pending[msg->id - INFY_QUERY_ID] |= (uint8_t)(1U << (query.item - 1));
+        }
+        return;
+    }
+    else if (msg->id >= INFY_TRIM_ID && msg->id < INFY_TRIM_ID + PLANT_MAX_MODULES)
+    {
+        Infy_Trim_t trim;
+        Infy_Trim_Unpack(msg->data, &trim);
+        sim.trim[msg->id - INFY_TRIM_ID] = trim.current_trim * 0.1f;
+    }
+    else
+    {
+        return;
+    }
+    Sim_ApplyModules();
+}
+
+// --- Power Bus (modules -> firmware) ---
+static void Sim_Inject(uint8_t bus, uint32_t id, CAN_IdType_t type, const uint8_t *data, uint8_t len)
+{
+    CAN_Message_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.timestamp_us = Host_GetMicros();
+    msg.id = id;
+    msg.bus = bus;
+    msg.id_type = type;
+    msg.len = len;
+    memcpy(msg.data, data, len);
+    CAN_InjectRx(&msg);
+}
+
+// Extended status replies (temperatures rise with the load, no derating)
+static void Sim_QueryReplies(int m)
+{
+    const Plant_Module_t *mod = &plant.module[m];
+    uint8_t data[8];
+    float amb = plant.ambient_c;
+
+    if (sim.query_pending[m] & (1U << INFY_POLL_TEMPS))
+    {
+        Infy_Temps_t t = {
+            .temp_inlet = (int8_t)lroundf(amb),
+            .temp_pfc = (int8_t)lroundf(amb + 0.8f * (mod->t_dcdc - amb)),
+            .temp_dcdc = (int8_t)lroundf(mod->t_dcdc),
+        };
+        memset(data, 0, sizeof(data));
+        Infy_Temps_Pack(&t, data);
+        Sim_Inject(CAN_BUS_POWER, INFY_TEMPS_ID + (uint32_t)m, CAN_ID_EXT, data, INFY_TEMPS_LEN);
+    }
+    if (sim.query_pending[m] & (1U << INFY_POLL_AC))
+    {
+        Infy_AcInput_t ac = { .v_ab = 4000, .v_bc = 4000, .v_ca = 4000 };
+        memset(data, 0, sizeof(data));
+        Infy_AcInput_Pack(&ac, data);
+        Sim_Inject(CAN_BUS_POWER, INFY_ACINPUT_ID + (uint32_t)m, CAN_ID_EXT, data, INFY_ACINPUT_LEN);
+    }
+    if (sim.query_pending[m] & (1U << INFY_POLL_FAULTS))
+    {
+        Infy_Faults_t f = { .fault_word = mod->fault };
+        memset(data, 0, sizeof(data));
+        Infy_Faults_Pack(&f, data);
+        Sim_Inject(CAN_BUS_POWER, INFY_FAULTS_ID + (uint32_t)m, CAN_ID_EXT, data, INFY_FAULTS_LEN);
+    }
+    if (sim.query_pending[m] & (1U << INFY_POLL_DERATE))
+    {
+        Infy_Derate_t d = { .power_limit = 100, .reason = 0 };
+        memset(data, 0, sizeof(data));
+        Infy_Derate_Pack(&d, data);
+        Sim_Inject(CAN_BUS_POWER, INFY_DERATE_ID + (uint32_t)m, CAN_ID_EXT, data, INFY_DERATE_LEN);
+    }
+    sim.query_pending[m] = 0;
+}
+
+static void Sim_ModuleFrames(uint32_t tick_ms)
+{
+    uint8_t data[8];
+
+    for (int m = 0; m < plant.module_count; m++)
+    {
+        const Plant_Module_t *mod = &plant.module[m];
+        if (sim.query_pending[m] != 0 && !(mod->fault & PLANT_FAULT_SILENT)) Sim_QueryReplies(m);
+        if ((int)(tick_ms % SIM_STATUS_PERIOD_MS) != m * SIM_STATUS_PERIOD_MS / plant.module_count) continue;
+        if (mod->fault & PLANT_FAULT_SILENT) continue;
+
+        if ((sim.status_count[m]++ % SIM_INFO_EVERY) == 0)
+        {
+            Infy_Info_t info = {
+                .rated_power = (uint16_t)(mod->rated_kw * 10.0f),
+                .max_current = (uint16_t)(mod->max_current * 10.0f),
+                .sweet_spot = INFY_MODULE_SWEET_PCT,
+            };
+            memset(data, 0, sizeof(data));
+            Infy_Info_Pack(&info, data);
+            Sim_Inject(CAN_BUS_POWER, INFY_INFO_ID + (uint32_t)m, CAN_ID_EXT, data, INFY_INFO_LEN);
+        }
+
+        Infy_Status_t st = {
+            .voltage = (uint16_t)(plant.v_link * 10.0f),
+            .current = (uint16_t)(mod->i_out * 10.0f),
+            .is_on = (uint8_t)(mod->enable && mod->fault == 0),
+            .fault_ov = (uint8_t)((mod->fault & PLANT_FAULT_OV) != 0),
+            .range_high = (uint8_t)mod->range_high,
+        };
+        memset(data, 0, sizeof(data));
+        Infy_Status_Pack(&st, data);
+        Sim_Inject(CAN_BUS_POWER, INFY_STATUS_ID + (uint32_t)m, CAN_ID_EXT, data, INFY_STATUS_LEN);
+    }
+}
+
+// --- EV / SECC ---
+static void Sim_EvFrames(uint32_t tick_ms)
+{
+    uint8_t data[8];
+    const Plant_Battery_t *b = &plant.bat;
+
+    if ((tick_ms % SIM_COMMAND_PERIOD_MS) == 0)
+    {
+        SECC_Command_t cmd = {
+            .target_pwm_duty = (sim.phase >= SIM_EV_PLUGGED) ? 5 : 100, // 5 % = digital communication
+            .allow_power = sim.allow_power,
+            .reset_fault = 0,
+        };
+        memset(data, 0, sizeof(data));
+        SECC_Command_Pack(&cmd, data);
+        Sim_Inject(CAN_BUS_SECC, SECC_COMMAND_ID, CAN_ID_STD, data, SECC_COMMAND_LEN);
+
+        SECC_DcLimits_t lim = {
+            .ev_max_voltage = (uint16_t)((b->v_max + SIM_EV_MAX_V_MARGIN) * 10.0f),
+            .ev_max_current = (uint16_t)(b->i_max * 10.0f),
+        };
+        memset(data, 0, sizeof(data));
+        SECC_DcLimits_Pack(&lim, data);
+        Sim_Inject(CAN_BUS_SECC, SECC_DCLIMITS_ID, CAN_ID_STD, data, SECC_DCLIMITS_LEN);
+    }
+
+    if ((tick_ms % SIM_DEMAND_PERIOD_MS) == 0)
+    {
+        float v = 0.0f;
+        float i = 0.0f;
+        if (sim.phase == SIM_EV_PRECHARGE)
+        {
+            v = b->v_term;
+            i = SIM_PRECHARGE_A;
+        }
+        else if (sim.phase == SIM_EV_CHARGING)
+        {
+            v = b->v_max;
+            i = Plant_BatteryRequest(b);
+        }
+        sim.demand_i_prev = sim.demand_i;
+        sim.demand_v = v;
+        sim.demand_i = i;
+
+        SECC_DcDemand_t dem = {
+            .target_voltage = (uint16_t)(v * 10.0f),
+            .target_current = (uint16_t)(i * 10.0f),
+            .soc = (uint8_t)(b->soc * 100.0f),
+        };
+        memset(data, 0, sizeof(data));
+        SECC_DcDemand_Pack(&dem, data);
+        Sim_Inject(CAN_BUS_SECC, SECC_DCDEMAND_ID, CAN_ID_STD, data, SECC_DCDEMAND_LEN);
+    }
+
+    if ((tick_ms % SIM_TEMPS_PERIOD_MS) == 0)
+    {
+        SECC_Temps_t t = {
+            .temp_dc_plus = (int16_t)lroundf(plant.t_pin[0] * 10.0f),
+            .temp_dc_minus = (int16_t)lroundf(plant.t_pin[1] * 10.0f),
+            .temp_cable = (int16_t)lroundf(plant.t_cable * 10.0f),
+        };
+        memset(data, 0, sizeof(data));
+        SECC_Temps_Pack(&t, data);
+        Sim_Inject(CAN_BUS_SECC, SECC_TEMPS_ID, CAN_ID_STD, data, SECC_TEMPS_LEN);
+    }
+}
+
+static void Sim_EvStep(void)
+{
+    static const char start[] = "[2, \"sim\", \"RemoteStartTransaction\", {\"idTag\": \"SIM\"}]";
+    uint64_t now = Host_GetMicros();
+    const Plant_Battery_t *b = &plant.bat;
+    bool closed = (Relay_GetState(0) & 0x01) != 0;
+
+    switch (sim.phase)
+    {
+        case SIM_EV_UNPLUGGED:
+            if (now >= SIM_PLUG_US)
+            {
+                Sim_SetPhase(SIM_EV_PLUGGED);
+                StateMachine_SetState(0, STATE_CONNECTED);
+            }
+            break;
+
+        case SIM_EV_PLUGGED:
+            if (now >= SIM_START_US)
+            {
+                sim.allow_power = true;
+                Sim_SetPhase(SIM_EV_PRECHARGE);
+                OCPP_HandleCallMessage(start, sizeof(start) - 1);
+            }
+            break;
+
+        case SIM_EV_PRECHARGE:
+            if (closed) Sim_SetPhase(SIM_EV_CHARGING);
+            break;
+
+        case SIM_EV_CHARGING:
+        {
+            if (!closed)
+            {
+                sim.allow_power = false;
+                Sim_SetPhase(SIM_EV_STOPPED);
+                break;
+            }
+            if (Plant_BatteryRequest(b) <= 0.0f)
+            {
+                sim.allow_power = false;
+                Sim_SetPhase(SIM_EV_DONE);
+                break;
+            }
+
+            // BMS protection
+            float i_trip = b->i_max * (100 + SIM_TRIP_PCT) / 100.0f;
+            if (b->i > i_trip)
+            {
+                if (sim.trip_us == 0) sim.trip_us = now;
+            }
+            else
+            {
+                sim.trip_us = 0;
+            }
+            if ((sim.trip_us != 0 && now - sim.trip_us >= SIM_TRIP_HOLD_US) ||
+                b->v_term > b->v_max + SIM_EV_MAX_V_MARGIN)
+            {
+                sim.allow_power = false;
+                Sim_PrintTime();
+                fprintf(report, "EV     trip: %.1f A, %.1f V\n", b->i, b->v_term);
+                Sim_SetPhase(SIM_EV_TRIPPED);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+// --- Modbus Meter ---
+static void Sim_UartTx(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len)
+{
+    if (huart != &huart3 || len < 6 || data[0] != METER_MODBUS_ADDR || data[1] != 0x03) return;
+
+    sim.meter_reg = (uint16_t)((data[2] << 8) | data[3]);
+    sim.meter_regs = (uint16_t)((data[4] << 8) | data[5]);
+    sim.meter_due_us = Host_GetMicros() + SIM_METER_REPLY_US;
+    sim.meter_pending = true;
+}
+
+static uint16_t Sim_Crc16(const uint8_t *buf, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint16_t k = 0; k < len; k++)
+    {
+        crc ^= buf[k];
+        for (int b = 0; b < 8; b++) crc = (crc & 1U) ? (crc >> 1) ^ 0xA001U : crc >> 1;
+    }
+    return crc;
+}
+
+// Holding register of the meter image (0 outside the known values)
+static uint16_t Sim_MeterRegister(uint16_t reg)
+{
+    float kwh = (float)plant.meter.energy_kwh;
+    uint32_t raw;
+    memcpy(&raw, &kwh, 4);
+
+    if (reg == METER_REG_VOLTAGE) return (uint16_t)(plant.meter.v * 10.0f);
+    if (reg == METER_REG_CURRENT) return (uint16_t)(((plant.meter.i < 0.0f) ? -plant.meter.i : plant.meter.i) * 10.0f);
+    if (reg == METER_REG_ENERGY) return (uint16_t)(raw >> 16);
+    if (reg == METER_REG_ENERGY + 1) return (uint16_t)raw;
+    return 0;
+}
+
+static void Sim_MeterReply(void)
+{
+    if (!sim.meter_pending || Host_GetMicros() < sim.meter_due_us) return;
+    sim.meter_pending = false;
+
+    uint16_t expected = 0;
+    uint8_t *buf = Host_GetUartRxBuffer(&huart3, &expected);
+    if (buf == NULL || sim.meter_regs > SIM_METER_MAX_REGS) return;
+
+    uint8_t frame[5 + 2 * SIM_METER_MAX_REGS];
+    uint16_t n = 3;
+    frame[0] = METER_MODBUS_ADDR;
+    frame[1] = 0x03;
+    for (uint16_t k = 0; k < sim.meter_regs; k++)
+    {
+        uint16_t val = Sim_MeterRegister((uint16_t)(sim.meter_reg + k));
+        frame[n++] = (uint8_t)(val >> 8);
+        frame[n++] = (uint8_t)val;
+    }
+    frame[2] = (uint8_t)(n - 3);
+    uint16_t crc = Sim_Crc16(frame, n);
+    frame[n++] = (uint8_t)crc;
+    frame[n++] = (uint8_t)(crc >> 8);
+
+    n = (n < expected) ? n : expected;
+    memcpy(buf, frame, n);
+    Host_ClearUartRx(&huart3);
+    Modbus_RxEventCallback(&huart3, n); // Line idle after the frame
+    stats.meter_replies++;
+}
+
+// --- Faults ---
+static bool Sim_ParseFault(const char *arg)
+{
+    Sim_Fault_t f = {0};
+    double sec = 0.0;
+    if (fault_count >= SIM_MAX_FAULTS || sscanf(arg, "%d:%7[a-z]@%lf", &f.module, f.kind, &sec) != 3) return false;
+    if (strcmp(f.kind, "ov") && strcmp(f.kind, "dead") && strcmp(f.kind, "silent") && strcmp(f.kind, "weak")) return false;
+    f.t_us = (uint64_t)(sec * 1e6);
+    faults[fault_count++] = f;
+    return true;
+}
+
+static void Sim_ApplyFaults(void)
+{
+    uint64_t now = Host_GetMicros();
+    for (int k = 0; k < fault_count; k++)
+    {
+        Sim_Fault_t *f = &faults[k];
+        if (f->applied || now < f->t_us) continue;
+        f->applied = true;
+        if (f->module < 0 || f->module >= plant.module_count) continue;
+
+        Plant_Module_t *mod = &plant.module[f->module];
+        if (!strcmp(f->kind, "ov")) mod->fault |= PLANT_FAULT_OV;
+        else if (!strcmp(f->kind, "dead")) mod->fault |= PLANT_FAULT_DEAD;
+        else if (!strcmp(f->kind, "silent")) mod->fault |= PLANT_FAULT_SILENT;
+        else mod->gain = 0.9f;
+        Sim_PrintTime();
+        fprintf(report, "FAULT  module %d %s\n", f->module, f->kind);
+    }
+}
+
+// --- Outputs ---
+static void Sim_CheckOutputs(void)
+{
+    static int last_state = -1;
+    static int last_relay = -1;
+    uint64_t now = Host_GetMicros();
+
+    int state = (int)StateMachine_GetState(0);
+    if (state != last_state)
+    {
+        Sim_PrintTime();
+        fprintf(report, "STATE  %s\n", StateMachine_GetStateName((EVSE_State_t)state));
+        if (state == STATE_PRECHARGE) stats.precharge_start_us = now;
+        if (state == STATE_CHARGING && last_state == STATE_PRECHARGE) stats.precharge_end_us = now;
+        if (state == STATE_FAULT) stats.fault_seen = true;
+        last_state = state;
+    }
+
+    int relay = (int)Relay_GetState(0);
+    if (relay != last_relay)
+    {
+        Sim_PrintTime();
+        fprintf(report, "RELAY  0x%02X, link %.1f V, pack %.1f V\n", relay, plant.v_link, plant.bat.v_term);
+        if ((relay & 0x01) && !(last_relay & 0x01) && stats.close_us == 0) stats.close_us = now;
+        last_relay = relay;
+    }
+}
+
+static void Sim_Measure(void)
+{
+    const Plant_Battery_t *b = &plant.bat;
+
+    for (int k = 0; k < 2; k++)
+    {
+        if (plant.t_pin[k] > stats.t_pin_max) stats.t_pin_max = plant.t_pin[k];
+    }
+    if (plant.t_cable > stats.t_cable_max) stats.t_cable_max = plant.t_cable;
+    for (int m = 0; m < plant.module_count; m++)
+    {
+        if (plant.module[m].t_dcdc > stats.t_module_max) stats.t_module_max = plant.module[m].t_dcdc;
+    }
+    if (sim.phase != SIM_EV_CHARGING) return;
+
+    float limit = Thermal_GetCurrentLimit(0);
+    if (limit < stats.limit_min) stats.limit_min = limit;
+
+    float demand = (sim.demand_i > sim.demand_i_prev) ? sim.demand_i : sim.demand_i_prev;
+    if (b->i - demand > stats.i_excess_max) stats.i_excess_max = b->i - demand;
+    if (plant.v_link - sim.demand_v > stats.v_excess_max) stats.v_excess_max = plant.v_link - sim.demand_v;
+    if (b->v_term > stats.v_term_max) stats.v_term_max = b->v_term;
+    if (stats.reach_us == 0 && sim.demand_i > 0.0f && b->i >= 0.95f * sim.demand_i) stats.reach_us = Host_GetMicros();
+    if (plant.i_peak_inrush > stats.i_peak_inrush) stats.i_peak_inrush = plant.i_peak_inrush;
+}
+
+static int Sim_ModulesOn(void)
+{
+    int on = 0;
+    for (int m = 0; m < plant.module_count; m++) on += (plant.module[m].i_out > 0.5f);
+    return on;
+}
+
+static void Sim_Trace(void)
+{
+    PowerReg_Status_t reg;
+    PowerReg_GetStatus(0, &reg);
+    Sim_PrintTime();
+    fprintf(report, "TRACE  %-9s SoC %5.1f %%  link %6.1f V  pack %6.1f V %6.1f A  req %6.1f A  cmd %6.1f V %6.1f A  on %d  pin %5.1f C\n",
+            StateMachine_GetStateName(StateMachine_GetState(0)), plant.bat.soc * 100.0f, plant.v_link,
+            plant.bat.v_term, plant.bat.i, sim.demand_i, reg.cmd_voltage, reg.cmd_current, Sim_ModulesOn(), plant.t_pin[0]);
+}
+
+static void Sim_Csv(void)
+{
+    PowerReg_Status_t reg;
+    PowerReg_GetStatus(0, &reg);
+    fprintf(csv, "%.3f,%d,%d,%d,%.4f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%.2f,%.2f\n",
+            Host_GetMicros() / 1e6, (int)StateMachine_GetState(0), (int)sim.phase, (int)Relay_GetState(0),
+            plant.bat.soc, Plant_BatteryOcv(&plant.bat), plant.v_link, plant.bat.v_term, plant.bat.i,
+            sim.demand_i, Plant_TotalCurrent(&plant), reg.cmd_voltage, reg.cmd_current,
+            reg.meas_voltage, Sim_ModulesOn(), Meter_ReadVoltage(0), Meter_ReadCurrent(0));
+}
+
+// --- Task Bodies (Mirror App_ControlLoop / App_OCPPLoop, one iteration) ---
+static void Sim_ControlStep(void)
+{
+    static uint32_t last_ocpp_meter = 0;
+
+    PowerAlloc_Process(); // CAN task (higher priority) sweeps first
+    Infy_Process();
+    Thermal_Process();
+    PowerReg_Tick();
+
+    StateMachine_Loop();
+
+    Infy_SystemStatus_t pwr;
+    Infy_GetSystemStatus(&pwr);
+    for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+    {
+        Infy_OutletStatus_t out;
+        Infy_GetOutletStatus(c, &out);
+        SECC_TxData_t tx = {0};
+
+        tx.cp_volts = CP_ReadVoltage(c);
+        tx.relay_state = Relay_GetState(c);
+        tx.ac_volts = Meter_ReadVoltage(c);
+        tx.ac_amps = Meter_ReadCurrent(c);
+        tx.temp_c = Thermal_GetTemperature(c);
+        tx.dc_volts = out.voltage;
+        tx.dc_amps = out.current;
+        tx.active_modules = (uint8_t)out.alive_modules;
+        tx.power_fault = (pwr.fault_mask & out.modules) != 0;
+        SECC_SetTxData(c, &tx);
+    }
+
+    if ((HAL_GetTick() - last_ocpp_meter) >= 5000)
+    {
+        for (uint8_t c = 0; c < EVSE_CONNECTOR_COUNT; c++)
+        {
+            OCPP_SendMeterValues(EVSE_CONNECTOR_ID(c), Meter_ReadEnergy(c), Meter_ReadPower(c), (int)Thermal_GetTemperature(c));
+        }
+        last_ocpp_meter = HAL_GetTick();
+    }
+
+    Modbus_SetRate(StateMachine_IsSessionActive() ? MODBUS_RATE_ACTIVE : MODBUS_RATE_IDLE);
+    Modbus_Process();
+    Meter_Process();
+    OCPP_Process();
+    CAN_ProcessRx(); // CAN task wakes at least every CAN_HEALTH_PERIOD_MS
+}
+
+static void Sim_Init(int modules, int cells, float soc, float soc_stop, float ambient_c)
+{
+    Host_Init();
+    Crc_Init();
+
+    Plant_Init(&plant, modules, cells, soc);
+    Plant_SetAmbient(&plant, ambient_c);
+    plant.bat.soc_stop = soc_stop;
+    memset(&sim, 0, sizeof(sim));
+    stats.limit_min = THERMAL_NO_LIMIT_A;
+
+    CAN_Driver_Init(&hfdcan1);
+    CAN_Driver_Init(&hfdcan2);
+    CAN_Driver_Init(&hfdcan3);
+    CAN_AddTap(Sim_CanTap);
+    host_uart_tx_hook = Sim_UartTx;
+
+    // Same order as App_Init()
+    CP_Init();
+    Relay_Init();
+    Safety_Init();
+    SECC_Init(&hfdcan1);
+    Modbus_Init(&huart3);
+    Meter_Init();
+    Config_Init();
+    Infy_Init(&hfdcan2);
+    PowerReg_Init();
+    Thermal_Init();
+    PowerAlloc_Init();
+    IMD_Init(&hfdcan3);
+    OCPP_Init();
+    StateMachine_Init();
+}
+
+static double Sim_WallSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void Usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-v] [-x] [-a degC] [-n modules] [-s soc] [-e soc] [-F m:kind@s]... [-p s] [-c file] [-T s]\n", prog);
+    fprintf(stderr, "  -n  Rectifier modules (default 10, max %d)\n", PLANT_MAX_MODULES);
+    fprintf(stderr, "  -x  800 V EV (%ds pack instead of %ds)\n", PLANT_CELLS_800V, PLANT_CELLS_400V);
+    fprintf(stderr, "  -a  Ambient temperature in C (default %.0f)\n", PLANT_AMBIENT_C);
+    fprintf(stderr, "  -s  Initial state of charge in %% (default 20)\n");
+    fprintf(stderr, "  -e  State of charge at which the EV stops in %% (default 80)\n");
+    fprintf(stderr, "  -F  Module fault at a time: ov, dead, silent or weak (-10 %% current), e.g. 3:ov@600\n");
+    fprintf(stderr, "  -p  Trace period in s (default 60, 0 = off)\n");
+    fprintf(stderr, "  -c  Write a CSV trace (100 ms) to file\n");
+    fprintf(stderr, "  -T  Virtual time limit in s (default 7200)\n");
+    fprintf(stderr, "  -v  Show firmware log output\n");
+}
+
+int main(int argc, char **argv)
+{
+    bool verbose = false;
+    int modules = 10;
+    int cells = PLANT_CELLS_400V;
+    float soc = 0.20f;
+    float soc_stop = 0.80f;
+    float ambient_c = PLANT_AMBIENT_C;
+    uint64_t trace_us = 60 * TIMEBASE_US_PER_SEC;
+    uint64_t max_us = 7200 * TIMEBASE_US_PER_SEC;
+    const char *csv_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "vxa:n:s:e:F:p:c:T:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'v': verbose = true; break;
+            case 'x': cells = PLANT_CELLS_800V; break;
+            case 'a': ambient_c = strtof(optarg, NULL); break;
+            case 'n': modules = atoi(optarg); break;
+            case 's': soc = strtof(optarg, NULL) / 100.0f; break;
+            case 'e': soc_stop = strtof(optarg, NULL) / 100.0f; break;
+            case 'F':
+                if (!Sim_ParseFault(optarg))
+                {
+                    fprintf(stderr, "Bad fault: %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'p': trace_us = (uint64_t)(strtod(optarg, NULL) * 1e6); break;
+            case 'c': csv_path = optarg; break;
+            case 'T': max_us = (uint64_t)(strtod(optarg, NULL) * 1e6); break;
+            default: Usage(argv[0]); return 2;
+        }
+    }
+    if (modules < 1 || modules > PLANT_MAX_MODULES || modules > INFY_MAX_MODULES || soc < 0.0f || soc >= soc_stop)
+    {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    // Report on the real stdout; firmware printf goes to /dev/null unless -v
+    report = fdopen(dup(fileno(stdout)), "w");
+    if (report == NULL) return 1;
+    if (!verbose && freopen("/dev/null", "w", stdout) == NULL) return 1;
+    if (csv_path != NULL)
+    {
+        csv = fopen(csv_path, "w");
+        if (csv == NULL)
+        {
+            fprintf(stderr, "Cannot write %s\n", csv_path);
+            return 1;
+        }
+        fprintf(csv, "t_s,state,ev_phase,relay,soc,ocv_v,link_v,pack_v,pack_a,request_a,module_a,"
+                     "cmd_v,cmd_a,meas_v,modules_on,meter_v,meter_a\n");
+    }
+
+    Sim_Init(modules, cells, soc, soc_stop, ambient_c);
+
+    fprintf(report, "Session: %d modules, SoC %.0f -> %.0f %%, pack %.1f V (limit %.1f V %.0f A), ambient %.0f C\n",
+            modules, soc * 100.0f, soc_stop * 100.0f, plant.bat.v_term, plant.bat.v_max, plant.bat.i_max, ambient_c);
+
+    double wall_start = Sim_WallSeconds();
+    uint64_t end_us = max_us;
+    uint32_t step = 0;
+
+    for (uint64_t now = 0; now < end_us; now += SIM_TICK_US, step++)
+    {
+        uint32_t tick_ms = (uint32_t)(now / TIMEBASE_US_PER_MS);
+        Host_SetMicros(now);
+
+        // Inputs due at this tick (ISR context: dispatched right away)
+        Sim_ApplyFaults();
+        Sim_ModuleFrames(tick_ms);
+        Sim_EvFrames(tick_ms);
+        Sim_MeterReply();
+
+        // Timer task outranks the control task at the same tick
+        CAN_Sched_Tick();
+        if ((step % (SIM_LOOP_PERIOD_US / SIM_TICK_US)) == 0)
+        {
+            Sim_ControlStep();
+            Sim_EvStep();
+        }
+        Sim_CheckOutputs();
+
+        plant.contactor = (Relay_GetState(0) & 0x01) != 0;
+        Sim_ApplyModules(); // Matrix contactors switch without a frame
+        Plant_Step(&plant, SIM_TICK_US);
+        Sim_Measure();
+
+        if (trace_us > 0 && (now % trace_us) == 0 && now > 0) Sim_Trace();
+        if (csv != NULL && (tick_ms % 100) == 0) Sim_Csv();
+
+        // Wind down after the EV is done or the charger faulted
+        bool over = (sim.phase >= SIM_EV_DONE) || (stats.fault_seen && sim.phase >= SIM_EV_PLUGGED);
+        if (over && end_us > now + SIM_TAIL_US) end_us = now + SIM_TAIL_US;
+    }
+    double wall = Sim_WallSeconds() - wall_start;
+    Sim_Trace();
+
+    bool ok = (sim.phase == SIM_EV_DONE) && !stats.fault_seen;
+    double virt = Host_GetMicros() / 1e6;
+
+    fprintf(report, "\n--- Session Summary ---\n");
+    fprintf(report, "Result: %s (EV %s)\n", ok ? "completed" : "FAILED", ev_phase_names[sim.phase]);
+    if (stats.precharge_end_us > stats.precharge_start_us)
+    {
+        fprintf(report, "Pre-charge: %.2f s, inrush peak %.1f A\n",
+                (stats.precharge_end_us - stats.precharge_start_us) / 1e6, stats.i_peak_inrush);
+    }
+    if (stats.reach_us > stats.close_us && stats.close_us != 0)
+    {
+        fprintf(report, "Relay close to 95 %% of the request: %.2f s\n", (stats.reach_us - stats.close_us) / 1e6);
+    }
+    fprintf(report, "Max above the EV request: %.1f A, %.1f V at the output; max pack voltage %.1f V (limit %.1f V)\n",
+            stats.i_excess_max, stats.v_excess_max, stats.v_term_max, plant.bat.v_max);
+    fprintf(report, "Energy: modules %.2f kWh, meter %.2f kWh (firmware %.2f kWh), pack %.2f kWh\n",
+            plant.energy_out_kwh, plant.meter.energy_kwh, Meter_ReadEnergy(0), plant.energy_bat_kwh);
+    fprintf(report, "SoC: %.1f %%, meter replies: %u\n", plant.bat.soc * 100.0f, stats.meter_replies);
+    Infy_PollStatus_t poll;
+    Infy_GetPollStatus(&poll);
+    fprintf(report, "Module polling: %u queries, %u replies, %u budget holds, wire %u of %u us/s, "
+                    "rounds %u/%u/%u/%u ms\n",
+            poll.queries, poll.replies, poll.budget_holds, poll.used_ns_per_s / 1000U, poll.budget_ns_per_s / 1000U,
+            poll.round_ms[INFY_POLL_TEMPS], poll.round_ms[INFY_POLL_AC], poll.round_ms[INFY_POLL_FAULTS],
+            poll.round_ms[INFY_POLL_DERATE]);
+    Thermal_Status_t th;
+    Thermal_GetStatus(0, &th);
+    fprintf(report, "Thermal: max pin %.1f C, cable %.1f C, module %.1f C; derating %u s",
+            stats.t_pin_max, stats.t_cable_max, stats.t_module_max, th.derating_ms / 1000U);
+    if (stats.limit_min < THERMAL_NO_LIMIT_A) fprintf(report, ", lowest limit %.0f A", stats.limit_min);
+    fprintf(report, "\n");
+    fprintf(report, "Virtual %.1f s in %.2f s wall (x%.0f)\n", virt, wall, (wall > 0.0) ? virt / wall : 0.0);
+    fflush(report);
+    if (csv != NULL) fclose(csv);
+
+    return ok ? 0 : 1;
+}